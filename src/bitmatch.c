@@ -0,0 +1,784 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Bit-parallel rule patterns matcher implementation.
+ *
+ * Every character position of the pattern gets its own bit.
+ * The set of active positions after reading the next character
+ * is obtained from the previous one by the follow table lookups
+ * (4 positions at a time) masked by the positions that accept
+ * this character. It is enough to find whether the pattern matches
+ * and where the leftmost-longest match is located.
+ *
+ * The subexpressions are located afterwards by walking the pattern
+ * program (Thompson's automaton) along the found match in the priority
+ * order: greedy repetitions and left alternatives go first. A backward
+ * pass over the match marks for every position the instructions
+ * that can still complete the match, so the walk never backtracks.
+ * This is the same choice regexec() of GNU C library makes.
+ *
+ * The patterns with nullable repeated subexpressions are rejected,
+ * as well as nullable optional ones inside repetitions, since their
+ * subexpression positions are reported by regexec() in a rather
+ * peculiar way. This also guarantees that the program contains
+ * no empty loops.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "bitmatch.h"
+
+
+/* Local constants */
+
+/* Maximum number of character positions in the pattern */
+#define MAX_POSITIONS 64
+
+/* Maximum number of the program instructions */
+#define MAX_PROGRAM 256
+
+/* Bitmap words for the program instructions set */
+#define PROGRAM_WORDS (MAX_PROGRAM / 64)
+
+/* Program instruction types */
+#define OP_SET 0 /* Consume a character accepted by the position */
+#define OP_SPLIT 1 /* Go to x preferably or to y otherwise */
+#define OP_JMP 2 /* Go to x */
+#define OP_SAVE 3 /* Record current offset in the register x */
+#define OP_BOL 4 /* Pass at the beginning of the string only */
+#define OP_EOL 5 /* Pass at the end of the string only */
+#define OP_MATCH 6 /* The match is completed */
+
+/* Empty match conditions (bit numbers are the anchors combinations) */
+#define EMPTY_FREE 1 /* No anchors */
+#define EMPTY_BOL 2 /* Only at the beginning */
+#define EMPTY_EOL 4 /* Only at the end */
+#define EMPTY_BOTH 8 /* Only in the empty string */
+
+/* Program instruction visiting marks */
+#define MARK_ACTIVE 1
+#define MARK_DONE 2
+
+
+/* Data structures */
+
+typedef struct /* Program instruction */
+{
+  int op; /* Instruction type */
+  int x; /* Argument (position, target or register number) */
+  int y; /* Alternative target for OP_SPLIT */
+} INSTRUCTION;
+
+typedef struct /* Subexpression analysis result */
+{
+  uint64_t first; /* Positions that can start it */
+  uint64_t first_bol; /* The same at the beginning of the string only */
+  uint64_t last; /* Positions that can finish it */
+  uint64_t last_eol; /* The same at the end of the string only */
+  int empty; /* Empty match conditions */
+} FRAGMENT;
+
+typedef struct /* Matcher builder state */
+{
+  const PATTERN *pattern; /* The source pattern */
+  int position[MAX_POSITIONS]; /* Character sets of the positions */
+  int npos; /* Number of positions */
+  int loops; /* Current repetitions nesting depth */
+  uint64_t follow[MAX_POSITIONS]; /* Positions following each one */
+  INSTRUCTION *prog; /* Program being built */
+  int nprog; /* Number of instructions */
+} BUILDER;
+
+/*
+ * The matcher occupies single memory block. Its variable size parts
+ * follow the header and are referenced by offsets, so the block
+ * can be copied or mapped anywhere as is.
+ */
+struct RULEX_BITMATCH
+{
+  uint64_t first; /* Start positions */
+  uint64_t first_bol; /* Start positions at the beginning only */
+  uint64_t last; /* Final positions */
+  uint64_t last_eol; /* Final positions at the end only */
+  unsigned int size; /* Total size of the block */
+  int empty; /* Empty match conditions */
+  int ngroups; /* Number of subexpressions */
+  int nclasses; /* Number of input classes */
+  int nfollow; /* Number of follow tables */
+  int nprog; /* Number of the program instructions */
+  unsigned int accept; /* Positions accepting each input class */
+  unsigned int follow; /* Follow tables for each 4 positions */
+  unsigned int prog; /* Subexpressions locating program */
+  unsigned int order; /* Instructions in the backward pass order */
+  unsigned char cls[256]; /* Input class for each character */
+};
+
+/* Access to the variable size parts */
+#define ACCEPT(m) ((const uint64_t *)((const char *)(m) + (m)->accept))
+#define FOLLOW(m) ((const uint64_t (*)[16])((const char *)(m) + (m)->follow))
+#define PROGRAM(m) ((const INSTRUCTION *)((const char *)(m) + (m)->prog))
+#define ORDER(m) ((const int *)((const char *)(m) + (m)->order))
+
+/* Align the part size within the block */
+#define ALIGNED(n) (((n) + 7) & ~(size_t)7)
+
+
+/* Local routines */
+
+static int analyze(BUILDER *builder, int n, FRAGMENT *fragment)
+     /*
+      * Assign positions to the subexpression rooted at node n
+      * and compute its first and last positions along with
+      * the follow sets of its positions.
+      *
+      * Returns 0 on success or -1 if the subexpression
+      * cannot be handled.
+      */
+{
+  const PATTERN_NODE *node = &builder->pattern->node[n];
+  FRAGMENT left, right;
+  int i, j;
+
+  (void)memset(fragment, 0, sizeof(FRAGMENT));
+  switch (node->type)
+    {
+      case PAT_SET:
+        if (builder->npos >= MAX_POSITIONS)
+          return -1;
+        builder->position[builder->npos] = node->arg;
+        fragment->first = fragment->last = (uint64_t)1 << builder->npos++;
+        break;
+      case PAT_BOL:
+        fragment->empty = EMPTY_BOL;
+        break;
+      case PAT_EOL:
+        fragment->empty = EMPTY_EOL;
+        break;
+      case PAT_CAT:
+        if (analyze(builder, node->left, &left) ||
+            analyze(builder, node->right, &right))
+          return -1;
+        for (i = 0; i < builder->npos; i++)
+          if (left.last & ((uint64_t)1 << i))
+            builder->follow[i] |= right.first;
+        fragment->first = left.first;
+        fragment->first_bol = left.first_bol;
+        if (left.empty & EMPTY_FREE)
+          {
+            fragment->first |= right.first;
+            fragment->first_bol |= right.first_bol;
+          }
+        if (left.empty & EMPTY_BOL)
+          fragment->first_bol |= right.first | right.first_bol;
+        fragment->last = right.last;
+        fragment->last_eol = right.last_eol;
+        if (right.empty & EMPTY_FREE)
+          {
+            fragment->last |= left.last;
+            fragment->last_eol |= left.last_eol;
+          }
+        if (right.empty & EMPTY_EOL)
+          fragment->last_eol |= left.last | left.last_eol;
+        for (i = 0; i < 4; i++)
+          if (left.empty & (1 << i))
+            for (j = 0; j < 4; j++)
+              if (right.empty & (1 << j))
+                fragment->empty |= 1 << (i | j);
+        break;
+      case PAT_ALT:
+        if (analyze(builder, node->left, &left) ||
+            analyze(builder, node->right, &right))
+          return -1;
+        fragment->first = left.first | right.first;
+        fragment->first_bol = left.first_bol | right.first_bol;
+        fragment->last = left.last | right.last;
+        fragment->last_eol = left.last_eol | right.last_eol;
+        fragment->empty = left.empty | right.empty;
+        break;
+      case PAT_STAR:
+      case PAT_PLUS:
+        builder->loops++;
+        if (analyze(builder, node->left, fragment) || fragment->empty)
+          return -1;
+        builder->loops--;
+        for (i = 0; i < builder->npos; i++)
+          if (fragment->last & ((uint64_t)1 << i))
+            builder->follow[i] |= fragment->first;
+        if (node->type == PAT_STAR)
+          fragment->empty = EMPTY_FREE;
+        break;
+      case PAT_QUEST:
+        if (analyze(builder, node->left, fragment))
+          return -1;
+        if (fragment->empty && builder->loops &&
+            (builder->pattern->node[node->left].type == PAT_GROUP))
+          return -1;
+        fragment->empty |= EMPTY_FREE;
+        break;
+      case PAT_GROUP:
+        return analyze(builder, node->left, fragment);
+      default: /* Empty alternatives change the priorities */
+        return -1;
+    }
+  return 0;
+}
+
+static int emit(BUILDER *builder, int op, int x, int y)
+     /*
+      * Append an instruction to the program.
+      * Returns its number or -1 if the program is too long.
+      */
+{
+  INSTRUCTION *instruction;
+
+  if (builder->nprog >= MAX_PROGRAM)
+    return -1;
+  instruction = &builder->prog[builder->nprog];
+  instruction->op = op;
+  instruction->x = x;
+  instruction->y = y;
+  return builder->nprog++;
+}
+
+static int generate(BUILDER *builder, int n)
+     /*
+      * Generate the program for the subexpression rooted at node n.
+      * Positions are numbered in the same order as by analyze().
+      *
+      * Returns 0 on success or -1 if the program is too long.
+      */
+{
+  const PATTERN_NODE *node = &builder->pattern->node[n];
+  int i, j;
+
+  switch (node->type)
+    {
+      case PAT_SET:
+        return (emit(builder, OP_SET, builder->npos++, 0) < 0) ? -1 : 0;
+      case PAT_BOL:
+        return (emit(builder, OP_BOL, 0, 0) < 0) ? -1 : 0;
+      case PAT_EOL:
+        return (emit(builder, OP_EOL, 0, 0) < 0) ? -1 : 0;
+      case PAT_CAT:
+        if (generate(builder, node->left))
+          return -1;
+        return generate(builder, node->right);
+      case PAT_ALT:
+        i = emit(builder, OP_SPLIT, builder->nprog + 1, 0);
+        if ((i < 0) || generate(builder, node->left))
+          return -1;
+        j = emit(builder, OP_JMP, 0, 0);
+        if (j < 0) return -1;
+        builder->prog[i].y = builder->nprog;
+        if (generate(builder, node->right))
+          return -1;
+        builder->prog[j].x = builder->nprog;
+        return 0;
+      case PAT_STAR:
+        i = emit(builder, OP_SPLIT, builder->nprog + 1, 0);
+        if ((i < 0) || generate(builder, node->left) ||
+            (emit(builder, OP_JMP, i, 0) < 0))
+          return -1;
+        builder->prog[i].y = builder->nprog;
+        return 0;
+      case PAT_PLUS:
+        i = builder->nprog;
+        if (generate(builder, node->left))
+          return -1;
+        return (emit(builder, OP_SPLIT, i, builder->nprog + 1) < 0) ? -1 : 0;
+      case PAT_QUEST:
+        i = emit(builder, OP_SPLIT, builder->nprog + 1, 0);
+        if ((i < 0) || generate(builder, node->left))
+          return -1;
+        builder->prog[i].y = builder->nprog;
+        return 0;
+      case PAT_GROUP:
+        if ((emit(builder, OP_SAVE, node->arg * 2, 0) < 0) ||
+            generate(builder, node->left))
+          return -1;
+        return (emit(builder, OP_SAVE, node->arg * 2 + 1, 0) < 0) ? -1 : 0;
+      default:
+        return -1;
+    }
+}
+
+static int arrange(const INSTRUCTION *prog, int pc, char *mark,
+                   int *order, int *n)
+     /*
+      * Put the instructions reachable from pc without consuming
+      * characters into the order list so that each instruction
+      * follows all the ones it can pass to.
+      *
+      * Returns 0 on success or -1 if an empty loop is detected.
+      */
+{
+  if (mark[pc] & MARK_DONE)
+    return 0;
+  if (mark[pc] & MARK_ACTIVE)
+    return -1;
+  mark[pc] |= MARK_ACTIVE;
+  switch (prog[pc].op)
+    {
+      case OP_SPLIT:
+        if (arrange(prog, prog[pc].x, mark, order, n) ||
+            arrange(prog, prog[pc].y, mark, order, n))
+          return -1;
+        break;
+      case OP_JMP:
+        if (arrange(prog, prog[pc].x, mark, order, n))
+          return -1;
+        break;
+      case OP_SAVE:
+      case OP_BOL:
+      case OP_EOL:
+        if (arrange(prog, pc + 1, mark, order, n))
+          return -1;
+        break;
+      default:
+        break;
+    }
+  mark[pc] = MARK_DONE;
+  order[(*n)++] = pc;
+  return 0;
+}
+
+static uint64_t follow(const RULEX_BITMATCH *matcher, uint64_t active)
+     /*
+      * Compute the set of positions following the active ones.
+      */
+{
+  const uint64_t (*table)[16] = FOLLOW(matcher);
+  uint64_t result = 0;
+
+  for (; active; table++, active >>= 4)
+    result |= (*table)[active & 15];
+  return result;
+}
+
+static int empty_match(const RULEX_BITMATCH *matcher, int i, int len)
+     /*
+      * Check whether the pattern matches empty string at offset i.
+      */
+{
+  if (matcher->empty & EMPTY_FREE)
+    return 1;
+  if ((matcher->empty & EMPTY_BOL) && !i)
+    return 1;
+  if ((matcher->empty & EMPTY_EOL) && (i == len))
+    return 1;
+  return (matcher->empty & EMPTY_BOTH) && !len;
+}
+
+static int locate(const RULEX_BITMATCH *matcher, const unsigned char *s,
+                  int len, int *start, int *end)
+     /*
+      * Find the leftmost-longest match.
+      * Returns 0 on success or REG_NOMATCH.
+      */
+{
+  const uint64_t *accept = ACCEPT(matcher);
+  uint64_t active = 0;
+  int i, j, found = 0;
+
+  /* Check whether the string matches at all */
+  for (i = 0; (i <= len) && !found; i++)
+    if (empty_match(matcher, i, len))
+      found = 1;
+  for (i = 0; (i < len) && !found; i++)
+    {
+      active = (follow(matcher, active) | matcher->first |
+                (i ? 0 : matcher->first_bol)) &
+        accept[matcher->cls[s[i]]];
+      if ((active & matcher->last) ||
+          ((i == len - 1) && (active & matcher->last_eol)))
+        found = 1;
+    }
+  if (!found)
+    return REG_NOMATCH;
+
+  /* Locate it */
+  for (i = 0; i <= len; i++)
+    {
+      *end = empty_match(matcher, i, len) ? i : -1;
+      active = matcher->first | (i ? 0 : matcher->first_bol);
+      for (j = i; active && (j < len); j++)
+        {
+          if (j > i)
+            active = follow(matcher, active);
+          active &= accept[matcher->cls[s[j]]];
+          if ((active & matcher->last) ||
+              ((j == len - 1) && (active & matcher->last_eol)))
+            *end = j + 1;
+        }
+      if (*end >= 0)
+        {
+          *start = i;
+          return 0;
+        }
+    }
+  return REG_NOMATCH;
+}
+
+
+/* Externally visible routines */
+
+RULEX_BITMATCH *bitmatch_compile(const PATTERN *pattern)
+     /*
+      * Build the matcher for the parsed pattern.
+      * Returns NULL if the pattern cannot be handled
+      * or memory allocation fails.
+      */
+{
+  RULEX_BITMATCH *matcher;
+  BUILDER builder;
+  FRAGMENT fragment;
+  INSTRUCTION prog[MAX_PROGRAM];
+  uint64_t accept[256], (*table)[16];
+  unsigned char cls[256];
+  char mark[MAX_PROGRAM];
+  unsigned int offset[4];
+  size_t size;
+  int i, j, k, c, nclasses;
+
+  (void)memset(&builder, 0, sizeof(builder));
+  builder.pattern = pattern;
+  builder.prog = prog;
+  if (analyze(&builder, pattern->root, &fragment))
+    return NULL;
+  if (!builder.npos && !fragment.empty)
+    return NULL;
+  k = builder.npos;
+  builder.npos = 0;
+  if (generate(&builder, pattern->root) ||
+      (emit(&builder, OP_MATCH, 0, 0) < 0))
+    return NULL;
+  builder.npos = k;
+
+  /* Split the alphabet into classes of equally accepted characters */
+  nclasses = 0;
+  for (c = 0; c < 256; c++)
+    {
+      accept[nclasses] = 0;
+      for (i = 0; i < builder.npos; i++)
+        if (pattern_set_has(&pattern->set[builder.position[i]],
+                            pattern_fold[c]))
+          accept[nclasses] |= (uint64_t)1 << i;
+      for (j = 0; accept[j] != accept[nclasses]; j++);
+      cls[c] = j;
+      if (j == nclasses)
+        nclasses++;
+    }
+  if (!pattern->ngroups) /* Positions are enough */
+    builder.nprog = 0;
+
+  /* Allocate the block */
+  size = ALIGNED(sizeof(RULEX_BITMATCH));
+  offset[0] = size;
+  size += ALIGNED(nclasses * sizeof(uint64_t));
+  offset[1] = size;
+  size += ALIGNED(((builder.npos + 3) / 4) * 16 * sizeof(uint64_t));
+  offset[2] = size;
+  size += ALIGNED(builder.nprog * sizeof(INSTRUCTION));
+  offset[3] = size;
+  size += ALIGNED(builder.nprog * sizeof(int));
+  matcher = calloc(1, size);
+  if (!matcher)
+    return NULL;
+  matcher->first = fragment.first;
+  matcher->first_bol = fragment.first_bol;
+  matcher->last = fragment.last;
+  matcher->last_eol = fragment.last_eol;
+  matcher->size = size;
+  matcher->empty = fragment.empty;
+  matcher->ngroups = pattern->ngroups;
+  matcher->nclasses = nclasses;
+  matcher->nfollow = (builder.npos + 3) / 4;
+  matcher->nprog = builder.nprog;
+  matcher->accept = offset[0];
+  matcher->follow = offset[1];
+  matcher->prog = offset[2];
+  matcher->order = offset[3];
+  (void)memcpy(matcher->cls, cls, sizeof(cls));
+  (void)memcpy((char *)matcher + offset[0], accept,
+               nclasses * sizeof(uint64_t));
+
+  /* Follow tables */
+  table = (uint64_t (*)[16])((char *)matcher + offset[1]);
+  for (k = 0; k < matcher->nfollow; k++)
+    for (j = 0; j < 16; j++)
+      for (i = 0; i < 4; i++)
+        if ((j & (1 << i)) && (k * 4 + i < builder.npos))
+          table[k][j] |= builder.follow[k * 4 + i];
+
+  /* Subexpressions locating program */
+  if (builder.nprog)
+    {
+      (void)memcpy((char *)matcher + offset[2], prog,
+                   builder.nprog * sizeof(INSTRUCTION));
+      (void)memset(mark, 0, sizeof(mark));
+      k = 0;
+      for (i = 0; i < builder.nprog; i++)
+        if (arrange(prog, i, mark, (int *)((char *)matcher + offset[3]), &k))
+          {
+            free(matcher);
+            return NULL;
+          }
+    }
+
+  return matcher;
+}
+
+int bitmatch_exec(const RULEX_BITMATCH *matcher, const char *s,
+                  size_t nmatch, regmatch_t *match)
+     /*
+      * Match string s against the pattern. Arguments nmatch and match
+      * have the same meaning as for regexec().
+      *
+      * Returns 0 on success, REG_NOMATCH when the string does not match
+      * or BITMATCH_UNSUPPORTED when the string is too long.
+      */
+{
+  const unsigned char *p = (const unsigned char *)s;
+  const uint64_t *accept = ACCEPT(matcher);
+  const INSTRUCTION *prog = PROGRAM(matcher);
+  const int *order = ORDER(matcher);
+  uint64_t alive[(BITMATCH_MAX_LENGTH + 1) * PROGRAM_WORDS];
+  uint64_t *cur, *next;
+  const INSTRUCTION *instruction;
+  regoff_t regs[MAX_PROGRAM + 2];
+  size_t len = strlen(s);
+  int i, k, pc, ok, start, end;
+  size_t n;
+
+  if (len > BITMATCH_MAX_LENGTH)
+    return BITMATCH_UNSUPPORTED;
+  if (locate(matcher, p, (int)len, &start, &end))
+    return REG_NOMATCH;
+  if (!nmatch)
+    return 0;
+
+  match[0].rm_so = start;
+  match[0].rm_eo = end;
+  for (n = 1; n < nmatch; n++)
+    match[n].rm_so = match[n].rm_eo = -1;
+  if ((nmatch < 2) || !matcher->ngroups)
+    return 0;
+
+  /* Mark the instructions that can complete the match at every offset */
+  for (i = end; i >= start; i--)
+    {
+      cur = alive + (i - start) * PROGRAM_WORDS;
+      next = cur + PROGRAM_WORDS;
+      (void)memset(cur, 0, PROGRAM_WORDS * sizeof(uint64_t));
+      for (k = 0; k < matcher->nprog; k++)
+        {
+          pc = order[k];
+          instruction = &prog[pc];
+          switch (instruction->op)
+            {
+              case OP_SET:
+                ok = (i < end) &&
+                  (accept[matcher->cls[p[i]]] &
+                   ((uint64_t)1 << instruction->x)) &&
+                  (next[(pc + 1) >> 6] & ((uint64_t)1 << ((pc + 1) & 63)));
+                break;
+              case OP_SPLIT:
+                ok = (cur[instruction->x >> 6] &
+                      ((uint64_t)1 << (instruction->x & 63))) ||
+                  (cur[instruction->y >> 6] &
+                   ((uint64_t)1 << (instruction->y & 63)));
+                break;
+              case OP_JMP:
+                ok = (cur[instruction->x >> 6] &
+                      ((uint64_t)1 << (instruction->x & 63))) != 0;
+                break;
+              case OP_BOL:
+                ok = !i && (cur[(pc + 1) >> 6] &
+                            ((uint64_t)1 << ((pc + 1) & 63)));
+                break;
+              case OP_EOL:
+                ok = (i == (int)len) &&
+                  (cur[(pc + 1) >> 6] & ((uint64_t)1 << ((pc + 1) & 63)));
+                break;
+              case OP_SAVE:
+                ok = (cur[(pc + 1) >> 6] &
+                      ((uint64_t)1 << ((pc + 1) & 63))) != 0;
+                break;
+              default:
+                ok = (i == end);
+                break;
+            }
+          if (ok)
+            cur[pc >> 6] |= (uint64_t)1 << (pc & 63);
+        }
+    }
+  if (!(alive[0] & 1))
+    return BITMATCH_UNSUPPORTED;
+
+  /* Walk along the match choosing the preferred ways */
+  for (k = 0; k < matcher->ngroups * 2 + 2; k++)
+    regs[k] = -1;
+  i = start;
+  pc = 0;
+  while (prog[pc].op != OP_MATCH)
+    {
+      instruction = &prog[pc];
+      switch (instruction->op)
+        {
+          case OP_SET:
+            i++;
+            pc++;
+            break;
+          case OP_SPLIT:
+            cur = alive + (i - start) * PROGRAM_WORDS;
+            if (cur[instruction->x >> 6] &
+                ((uint64_t)1 << (instruction->x & 63)))
+              pc = instruction->x;
+            else pc = instruction->y;
+            break;
+          case OP_JMP:
+            pc = instruction->x;
+            break;
+          case OP_SAVE:
+            regs[instruction->x] = i;
+            pc++;
+            break;
+          default:
+            pc++;
+            break;
+        }
+    }
+  for (n = 1; (n < nmatch) && ((int)n <= matcher->ngroups); n++)
+    if (regs[n * 2 + 1] >= 0)
+      {
+        match[n].rm_so = regs[n * 2];
+        match[n].rm_eo = regs[n * 2 + 1];
+      }
+  return 0;
+}
+
+size_t bitmatch_size(const RULEX_BITMATCH *matcher)
+     /*
+      * Get the matcher memory block size. The block is position
+      * independent, so it can be saved as is and mapped back
+      * by bitmatch_map() later.
+      */
+{
+  return matcher->size;
+}
+
+const RULEX_BITMATCH *bitmatch_map(const void *image, size_t size)
+     /*
+      * Check the saved matcher image and return pointer
+      * to the matcher that can be used directly. The image must be
+      * suitably aligned. Returns NULL if the image is not valid.
+      */
+{
+  const RULEX_BITMATCH *matcher = image;
+  const INSTRUCTION *prog;
+  const uint64_t *table;
+  uint64_t mask;
+  int i, regs;
+
+  if (((uintptr_t)image & 7) || (size < sizeof(RULEX_BITMATCH)) ||
+      (matcher->size != size))
+    return NULL;
+  if ((matcher->nclasses < 1) || (matcher->nclasses > 256) ||
+      (matcher->nfollow < 0) || (matcher->nfollow > MAX_POSITIONS / 4) ||
+      (matcher->nprog < 0) || (matcher->nprog > MAX_PROGRAM) ||
+      (matcher->ngroups < 0) || (matcher->ngroups * 2 > MAX_PROGRAM) ||
+      (matcher->ngroups && !matcher->nprog))
+    return NULL;
+  if ((matcher->accept & 7) || (matcher->follow & 7) ||
+      (matcher->prog & 7) || (matcher->order & 7) ||
+      (matcher->accept < sizeof(RULEX_BITMATCH)) ||
+      (matcher->follow < matcher->accept +
+       matcher->nclasses * sizeof(uint64_t)) ||
+      (matcher->prog < matcher->follow +
+       matcher->nfollow * 16 * sizeof(uint64_t)) ||
+      (matcher->order < matcher->prog +
+       matcher->nprog * sizeof(INSTRUCTION)) ||
+      (size < matcher->order + matcher->nprog * sizeof(int)))
+    return NULL;
+
+  /* All the positions must be covered by the follow tables */
+  mask = (matcher->nfollow < MAX_POSITIONS / 4) ?
+    ~(((uint64_t)1 << (matcher->nfollow * 4)) - 1) : 0;
+  if ((matcher->first | matcher->first_bol |
+       matcher->last | matcher->last_eol) & mask)
+    return NULL;
+  for (i = 0; i < 256; i++)
+    if (matcher->cls[i] >= matcher->nclasses)
+      return NULL;
+  for (i = 0; i < matcher->nclasses; i++)
+    if (ACCEPT(matcher)[i] & mask)
+      return NULL;
+  table = (const uint64_t *)FOLLOW(matcher);
+  for (i = 0; i < matcher->nfollow * 16; i++)
+    if (table[i] & mask)
+      return NULL;
+
+  /* Check the program */
+  prog = PROGRAM(matcher);
+  regs = matcher->ngroups * 2 + 2;
+  for (i = 0; i < matcher->nprog; i++)
+    {
+      if ((ORDER(matcher)[i] < 0) || (ORDER(matcher)[i] >= matcher->nprog))
+        return NULL;
+      switch (prog[i].op)
+        {
+          case OP_SPLIT:
+            if ((prog[i].y < 0) || (prog[i].y >= matcher->nprog))
+              return NULL;
+            /* Fall through */
+          case OP_JMP:
+            if ((prog[i].x < 0) || (prog[i].x >= matcher->nprog))
+              return NULL;
+            break;
+          case OP_SAVE:
+            if ((prog[i].x < 0) || (prog[i].x >= regs))
+              return NULL;
+            /* Fall through */
+          case OP_SET:
+          case OP_BOL:
+          case OP_EOL:
+            if ((prog[i].x < 0) || (prog[i].x >= MAX_POSITIONS) ||
+                (i + 1 >= matcher->nprog))
+              return NULL;
+            break;
+          case OP_MATCH:
+            break;
+          default:
+            return NULL;
+        }
+    }
+  return matcher;
+}
+
+void bitmatch_free(RULEX_BITMATCH *matcher)
+     /*
+      * Free all memory allocated for the matcher.
+      */
+{
+  free(matcher);
+  return;
+}
@@ -0,0 +1,108 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Bit-parallel rule patterns matcher.
+ *
+ * The pattern is turned into the position (Glushkov) automaton
+ * which states are kept in 64-bit masks, so a pattern may contain
+ * up to 64 character positions. The matcher follows POSIX
+ * leftmost-longest rules and reproduces subexpression positions
+ * exactly as regexec() does, thus it can be used instead of it.
+ * The patterns that cannot be handled are rejected at compile time.
+ */
+
+
+#ifndef BITMATCH_H
+#define BITMATCH_H
+
+#ifdef _WIN32
+#include <pcre2posix.h>
+#else
+#include <regex.h>
+#endif
+#include "pattern.h"
+
+/* BEGIN_C_DECLS should be used at the beginning of C declarations,
+   so that C++ compilers don't mangle their names.  Use END_C_DECLS at
+   the end of C declarations. */
+#undef BEGIN_C_DECLS
+#undef END_C_DECLS
+#ifdef __cplusplus
+# define BEGIN_C_DECLS extern "C" {
+# define END_C_DECLS }
+#else
+# define BEGIN_C_DECLS /* empty */
+# define END_C_DECLS /* empty */
+#endif
+
+BEGIN_C_DECLS
+
+/* Maximum length of the string the matcher can handle */
+#define BITMATCH_MAX_LENGTH 255
+
+/* Matcher memory image format version */
+#define BITMATCH_VERSION 1
+
+/* Special return code of bitmatch_exec() */
+#define BITMATCH_UNSUPPORTED -1
+
+typedef struct RULEX_BITMATCH RULEX_BITMATCH;
+
+
+extern RULEX_BITMATCH *bitmatch_compile(const PATTERN *pattern);
+/*
+ * Build the matcher for the parsed pattern.
+ * Returns NULL if the pattern cannot be handled
+ * or memory allocation fails.
+ */
+
+extern int bitmatch_exec(const RULEX_BITMATCH *matcher, const char *s,
+                         size_t nmatch, regmatch_t *match);
+/*
+ * Match string s against the pattern. Arguments nmatch and match
+ * have the same meaning as for regexec().
+ *
+ * Returns 0 on success, REG_NOMATCH when the string does not match
+ * or BITMATCH_UNSUPPORTED when the string is too long.
+ */
+
+extern size_t bitmatch_size(const RULEX_BITMATCH *matcher);
+/*
+ * Get the matcher memory block size. The block is position
+ * independent, so it can be saved as is and mapped back
+ * by bitmatch_map() later.
+ */
+
+extern const RULEX_BITMATCH *bitmatch_map(const void *image, size_t size);
+/*
+ * Check the saved matcher image and return pointer
+ * to the matcher that can be used directly. The image must be
+ * suitably aligned. Returns NULL if the image is not valid.
+ */
+
+extern void bitmatch_free(RULEX_BITMATCH *matcher);
+/*
+ * Free all memory allocated for the matcher.
+ * The mapped matchers must not be freed.
+ */
+
+END_C_DECLS
+
+#endif
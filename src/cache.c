@@ -0,0 +1,239 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ * Search results cache implementation.
+ *
+ * The slots are chained into the hash table buckets by their indices,
+ * so nothing is allocated or freed after the cache is created.
+ * A freshly stored result is not marked as referenced, thus
+ * the words occurred only once are evicted at the first turn
+ * of the clock hand, while the frequent ones survive.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+
+
+/* Data structures */
+
+typedef struct /* Cached search result */
+{
+  unsigned int hash; /* Hash value of the word and flags */
+  int next; /* The next slot in the same bucket or -1 */
+  int flags; /* Search flags */
+  int rc; /* Search return code */
+  int keylen; /* Length of the word */
+  int referenced; /* The result was hit since the last clock scan */
+  char text[CACHE_TEXT_SIZE]; /* The word followed by its result */
+} SLOT;
+
+struct RULEX_CACHE
+{
+  SLOT *slot; /* Array of the slots */
+  int *bucket; /* The first slot of every bucket or -1 */
+  unsigned int mask; /* Number of buckets minus one */
+  int hand; /* Current clock hand position */
+  CACHE_STATS stats; /* Usage counters */
+};
+
+
+/* Local routines */
+
+static unsigned int hash(const char *key, int len, int flags)
+     /*
+      * Compute FNV-1a hash value of the word and flags.
+      */
+{
+  unsigned int h = 2166136261U;
+  int i;
+
+  for (i = 0; i < len; i++)
+    h = (h ^ (unsigned char)key[i]) * 16777619U;
+  return (h ^ (unsigned int)flags) * 16777619U;
+}
+
+static int lookup(const RULEX_CACHE *cache, const char *key, int len,
+                  int flags, unsigned int h)
+     /*
+      * Find the slot holding the result for the word and flags.
+      * Returns slot index or -1 if not found.
+      */
+{
+  int i;
+
+  for (i = cache->bucket[h & cache->mask]; i >= 0;
+       i = cache->slot[i].next)
+    if ((cache->slot[i].hash == h) && (cache->slot[i].flags == flags)
+        && (cache->slot[i].keylen == len)
+        && !memcmp(cache->slot[i].text, key, len))
+      break;
+  return i;
+}
+
+static void unlink_slot(RULEX_CACHE *cache, int n)
+     /*
+      * Remove slot number n from its bucket chain.
+      */
+{
+  int *p = &cache->bucket[cache->slot[n].hash & cache->mask];
+
+  while (*p != n)
+    p = &cache->slot[*p].next;
+  *p = cache->slot[n].next;
+}
+
+static int victim(RULEX_CACHE *cache)
+     /*
+      * Choose the slot for a new result.
+      */
+{
+  int n;
+
+  if (cache->stats.entries < cache->stats.size)
+    return cache->stats.entries++;
+  while (cache->slot[cache->hand].referenced)
+    {
+      cache->slot[cache->hand].referenced = 0;
+      cache->hand = (cache->hand + 1) % cache->stats.size;
+    }
+  n = cache->hand;
+  cache->hand = (cache->hand + 1) % cache->stats.size;
+  unlink_slot(cache, n);
+  cache->stats.evictions++;
+  return n;
+}
+
+
+/* Global routines */
+
+RULEX_CACHE *cache_create(int size)
+     /*
+      * Allocate new empty cache of size slots.
+      * Returns NULL when memory allocation fails.
+      */
+{
+  RULEX_CACHE *cache;
+  unsigned int n;
+
+  if (size < 1)
+    return NULL;
+  cache = calloc(1, sizeof(RULEX_CACHE));
+  if (!cache)
+    return NULL;
+  for (n = 1; n < (unsigned int)size; n <<= 1);
+  cache->slot = malloc(size * sizeof(SLOT));
+  cache->bucket = malloc(n * sizeof(int));
+  if (!(cache->slot && cache->bucket))
+    {
+      cache_free(cache);
+      return NULL;
+    }
+  cache->mask = n - 1;
+  cache->stats.size = size;
+  cache_clear(cache);
+  cache->stats.invalidations = 0;
+  return cache;
+}
+
+int cache_get(RULEX_CACHE *cache, const char *key, int flags,
+              char *value, int *rc)
+     /*
+      * Find the result of searching the word key with specified flags.
+      * Returns 1 if the result is found or 0 otherwise.
+      */
+{
+  int len = strlen(key);
+  int i = lookup(cache, key, len, flags, hash(key, len, flags));
+
+  if (i < 0)
+    {
+      cache->stats.misses++;
+      return 0;
+    }
+  cache->stats.hits++;
+  cache->slot[i].referenced = 1;
+  (void)strcpy(value, cache->slot[i].text + len + 1);
+  *rc = cache->slot[i].rc;
+  return 1;
+}
+
+void cache_put(RULEX_CACHE *cache, const char *key, int flags,
+               const char *value, int rc)
+     /*
+      * Store the result of searching the word key with specified flags.
+      */
+{
+  int len = strlen(key), i;
+  unsigned int h;
+
+  if (len + strlen(value) + 2 > CACHE_TEXT_SIZE)
+    return;
+  h = hash(key, len, flags);
+  i = lookup(cache, key, len, flags, h);
+  if (i < 0)
+    {
+      i = victim(cache);
+      cache->slot[i].hash = h;
+      cache->slot[i].flags = flags;
+      cache->slot[i].keylen = len;
+      cache->slot[i].referenced = 0;
+      (void)memcpy(cache->slot[i].text, key, len + 1);
+      cache->slot[i].next = cache->bucket[h & cache->mask];
+      cache->bucket[h & cache->mask] = i;
+    }
+  cache->slot[i].rc = rc;
+  (void)strcpy(cache->slot[i].text + len + 1, value);
+}
+
+void cache_clear(RULEX_CACHE *cache)
+     /*
+      * Forget all the stored results.
+      */
+{
+  unsigned int i;
+
+  for (i = 0; i <= cache->mask; i++)
+    cache->bucket[i] = -1;
+  cache->stats.entries = 0;
+  cache->hand = 0;
+  cache->stats.invalidations++;
+}
+
+const CACHE_STATS *cache_stats(const RULEX_CACHE *cache)
+     /*
+      * Get the cache usage counters.
+      */
+{
+  return &cache->stats;
+}
+
+void cache_free(RULEX_CACHE *cache)
+     /*
+      * Free all memory allocated for the cache.
+      */
+{
+  if (!cache) return;
+  free(cache->slot);
+  free(cache->bucket);
+  free(cache);
+}
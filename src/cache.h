@@ -0,0 +1,109 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ * Search results cache.
+ *
+ * The words frequency in a real text is very uneven, so the same
+ * words are searched again and again. The cache keeps the results
+ * of the recent searches in a fixed number of slots allocated
+ * at once. When all the slots are occupied, the victim is chosen
+ * by the CLOCK algorithm: the slots are scanned cyclically
+ * and the first one which was not hit since the previous scan
+ * is reused.
+ */
+
+
+#ifndef CACHE_H
+#define CACHE_H
+
+/* BEGIN_C_DECLS should be used at the beginning of C declarations,
+   so that C++ compilers don't mangle their names.  Use END_C_DECLS at
+   the end of C declarations. */
+#undef BEGIN_C_DECLS
+#undef END_C_DECLS
+#ifdef __cplusplus
+# define BEGIN_C_DECLS extern "C" {
+# define END_C_DECLS }
+#else
+# define BEGIN_C_DECLS /* empty */
+# define END_C_DECLS /* empty */
+#endif
+
+BEGIN_C_DECLS
+
+/* Space for the word and its result in one slot */
+#define CACHE_TEXT_SIZE 128
+
+typedef struct RULEX_CACHE RULEX_CACHE;
+
+typedef struct /* Cache usage counters */
+{
+  unsigned long hits; /* Number of found results */
+  unsigned long misses; /* Number of absent results */
+  unsigned long evictions; /* Number of results replaced by others */
+  unsigned long invalidations; /* Number of the whole cache clearings */
+  int entries; /* Number of occupied slots */
+  int size; /* Total number of slots */
+} CACHE_STATS;
+
+
+extern RULEX_CACHE *cache_create(int size);
+/*
+ * Allocate new empty cache of size slots.
+ * Returns NULL when memory allocation fails.
+ */
+
+extern int cache_get(RULEX_CACHE *cache, const char *key, int flags,
+                     char *value, int *rc);
+/*
+ * Find the result of searching the word key with specified flags.
+ * When found, the result string is copied into the buffer
+ * pointed by value and the search return code is placed
+ * in the location pointed by rc.
+ *
+ * Returns 1 if the result is found or 0 otherwise.
+ */
+
+extern void cache_put(RULEX_CACHE *cache, const char *key, int flags,
+                      const char *value, int rc);
+/*
+ * Store the result of searching the word key with specified flags.
+ * The results which do not fit in a slot are not stored.
+ */
+
+extern void cache_clear(RULEX_CACHE *cache);
+/*
+ * Forget all the stored results. The counters are kept.
+ */
+
+extern const CACHE_STATS *cache_stats(const RULEX_CACHE *cache);
+/*
+ * Get the cache usage counters.
+ */
+
+extern void cache_free(RULEX_CACHE *cache);
+/*
+ * Free all memory allocated for the cache.
+ */
+
+END_C_DECLS
+
+#endif
@@ -26,23 +26,58 @@
  * In the database key fields are packed by the arithmetic coding algorithm
  * based on the static statistical model. Value fields are represented
  * by differences relative to the corresponding keys.
+ *
+ * There are two keys packing formats sharing the same model.
+ * The original one is the 16-bit arithmetic coder shifting out
+ * the code bit by bit. The range coder of the newer format keeps
+ * 32-bit low and range values and shifts out whole bytes, so the
+ * symbol intervals are rounded less, and the code is terminated
+ * by the shortest value within the final interval. The range is
+ * renormalized without carry propagation: when it gets too narrow
+ * while the leading byte of the interval is still unsettled,
+ * the interval is cut at the nearest boundary of 16-bit blocks.
+ *
+ * The third format uses the same range coder with the order-1 model
+ * conditioning every letter by the previous one. Its tables are
+ * generated by the mkkeymodel program from the shipped dictionaries.
  */
 
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "coder.h"
+#include "keymodel.h"
 
 #define index strchr
+#define takein(n) \
+{ \
+  while (avail < (n)) \
+    { \
+      bits = (bits << 8) | ((k < keylen) ? (unsigned char)key[k++] : 0); \
+      avail += 8; \
+    } \
+  avail -= (n); \
+  input = (bits >> avail) & ((1 << (n)) - 1); \
+}
+#define renormalize(shift) \
+{ \
+  while (((low ^ (low + range)) < RANGE_TOP) || \
+	 ((range < RANGE_BOTTOM) && \
+	  ((range = -low & (RANGE_BOTTOM - 1)), 1))) \
+    { \
+      shift; \
+      low <<= 8; \
+      range <<= 8; \
+    } \
+}
 #define turnout(bit) \
 { \
-  if (bit) \
-    t[l] |= mask; \
-  mask >>= 1; \
-  if (!mask) \
+  bits = (bits << 1) | ((bit) != 0); \
+  if (!(--room)) \
     { \
-      mask = 0x80; \
-      t[++l] = 0; \
+      t[l++] = (char)bits; \
+      room = 8; \
     } \
 }
 
@@ -64,18 +99,6 @@ static const char alphabet[] =
   };
 
 /* Special groups */
-static const char group1[] = { 0xD8, 0xDF, 0 }; /* ъ, ь */
-static const char group2[] =
-  {
-    '+', '-', '=',
-    0xC1, 0xC5, 0xA3, /* а, е, ё, */
-    0xC9, 0xCA, /* и, й, */
-    0xCF, 0xD5, /* о, у, */
-    0xDF, 0xD9, 0xD8, /* ъ, ы, ь, */
-    0xDC, 0xC0, 0xD1, /* э, ю, я */
-    0
-  };
-static const char group3[] = { 0xD8, 0xD9, 0xDF, 0 }; /* ь, ы, ъ */
 static const char group4[] = { 0xD8, '-', 0xDF, 0 }; /* ь, -, ъ */
 static const char vowels[] =
   {
@@ -84,6 +107,36 @@ static const char vowels[] =
     0
   };
 
+/*
+ * Letter classes for the key validation:
+ * SIGN - hard and soft signs (ъ, ь);
+ * NO_SIGN_AFTER - the symbols which cannot be followed by a sign
+ * (vowels, signs, ы, "+", "-" and "=");
+ * NO_KEY_START - the letters which cannot start a key (ъ, ы, ь).
+ */
+#define SIGN 0x01
+#define NO_SIGN_AFTER 0x02
+#define NO_KEY_START 0x04
+static const unsigned char letter_class[256] =
+  {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x00 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x10 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 2, 0, 0, /* 0x20 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, /* 0x30 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x40 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x50 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x60 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x70 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x80 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x90 */
+    0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0xA0 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0xB0 */
+    2, 2, 0, 0, 0, 2, 0, 0, 0, 2, 2, 0, 0, 0, 0, 2, /* 0xC0 */
+    0, 2, 0, 0, 0, 2, 0, 0, 7, 6, 0, 0, 2, 0, 0, 7, /* 0xD0 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0xE0 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 /* 0xF0 */
+  };
+
 /* Statistical model for keys packing */
 static const SYMBOL letter[] =
   {
@@ -123,6 +176,164 @@ static const SYMBOL letter[] =
     { 2162, 2390 } /* EOS */
   };
 static const unsigned short int scale = 2390;
+#define EOS 33 /* End of string symbol */
+
+/* Range coder renormalization thresholds */
+#define RANGE_TOP (1U << 24)
+#define RANGE_BOTTOM (1U << 16)
+
+/*
+ * Order-1 model for keys packing (see keymodel.h). Every symbol
+ * is coded in the context of the previous letter, and the first one
+ * is coded in the separate context of the key start.
+ */
+#define KEY_START EOS
+
+/* Model symbols by their counts for keys unpacking */
+static const unsigned char decode[2390] =
+  {
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 20 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 40 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 60 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 80 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 100 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 120 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 140 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 160 */
+     0,  0,  0,  0,  0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1, /* 180 */
+     1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  2, /* 200 */
+     2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2, /* 220 */
+     2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2, /* 240 */
+     2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2, /* 260 */
+     2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2, /* 280 */
+     2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2, /* 300 */
+     3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3, /* 320 */
+     3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  4,  4,  4,  4,  4,  4, /* 340 */
+     4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4, /* 360 */
+     4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4, /* 380 */
+     4,  4,  4,  4,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5, /* 400 */
+     5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5, /* 420 */
+     5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5, /* 440 */
+     5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5, /* 460 */
+     5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5, /* 480 */
+     5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5, /* 500 */
+     5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5, /* 520 */
+     5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5, /* 540 */
+     5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5, /* 560 */
+     6,  6,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  8,  8, /* 580 */
+     8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8, /* 600 */
+     8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  9,  9,  9, /* 620 */
+     9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, /* 640 */
+     9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, /* 660 */
+     9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, /* 680 */
+     9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, /* 700 */
+     9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, /* 720 */
+     9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, /* 740 */
+     9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, /* 760 */
+     9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, 10, 10, 10, /* 780 */
+    10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, /* 800 */
+    10, 10, 10, 10, 10, 10, 10, 10, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, /* 820 */
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, /* 840 */
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, /* 860 */
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, /* 880 */
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, /* 900 */
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, /* 920 */
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, /* 940 */
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, /* 960 */
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 13, 13, 13, 13, 13, /* 980 */
+    13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, /* 1000 */
+    13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, /* 1020 */
+    13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, /* 1040 */
+    13, 13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, /* 1060 */
+    14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, /* 1080 */
+    14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, /* 1100 */
+    14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, /* 1120 */
+    14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, /* 1140 */
+    14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, /* 1160 */
+    14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, /* 1180 */
+    14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15, 15, /* 1200 */
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, /* 1220 */
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, /* 1240 */
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, /* 1260 */
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, /* 1280 */
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, /* 1300 */
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, /* 1320 */
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, /* 1340 */
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, /* 1360 */
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, /* 1380 */
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 16, /* 1400 */
+    16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, /* 1420 */
+    16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, /* 1440 */
+    16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, /* 1460 */
+    16, 16, 16, 16, 16, 16, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, /* 1480 */
+    17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, /* 1500 */
+    17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, /* 1520 */
+    17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, /* 1540 */
+    17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, /* 1560 */
+    17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, /* 1580 */
+    17, 17, 17, 17, 17, 17, 17, 17, 17, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, /* 1600 */
+    18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, /* 1620 */
+    18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, /* 1640 */
+    18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, /* 1660 */
+    18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, /* 1680 */
+    18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, /* 1700 */
+    18, 18, 18, 18, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, /* 1720 */
+    19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, /* 1740 */
+    19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, /* 1760 */
+    19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, /* 1780 */
+    19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, /* 1800 */
+    19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 20, 20, /* 1820 */
+    20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, /* 1840 */
+    20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, /* 1860 */
+    20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, /* 1880 */
+    21, 21, 21, 21, 21, 21, 21, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, /* 1900 */
+    22, 22, 22, 22, 22, 22, 22, 22, 22, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 24, /* 1920 */
+    24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, /* 1940 */
+    24, 24, 24, 24, 24, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, /* 1960 */
+    25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 26, 26, 26, 26, 26, 26, 26, 26, 26, /* 1980 */
+    26, 26, 26, 26, 26, 27, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, /* 2000 */
+    28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, /* 2020 */
+    28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 29, 29, 29, 29, 29, 29, 29, /* 2040 */
+    29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, /* 2060 */
+    29, 29, 29, 29, 29, 29, 29, 29, 29, 30, 30, 31, 31, 31, 31, 31, 31, 31, 31, 31, /* 2080 */
+    31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 32, 32, 32, 32, 32, 32, /* 2100 */
+    32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, /* 2120 */
+    32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, /* 2140 */
+    32, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, /* 2160 */
+    33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, /* 2180 */
+    33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, /* 2200 */
+    33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, /* 2220 */
+    33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, /* 2240 */
+    33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, /* 2260 */
+    33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, /* 2280 */
+    33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, /* 2300 */
+    33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, /* 2320 */
+    33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, /* 2340 */
+    33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, /* 2360 */
+    33, 33, 33, 33, 33, 33, 33, 33, 33, 33 /* 2380 */
+  };
+
+/* Model symbols of the characters (-1 for invalid ones, EOS for zero) */
+static const signed char symbol[256] =
+  {
+    33, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0x00 */
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0x10 */
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0x20 */
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0x30 */
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0x40 */
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0x50 */
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0x60 */
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0x70 */
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0x80 */
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0x90 */
+    -1, -1, -1,  6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0xA0 */
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0xB0 */
+    31,  0,  1, 23,  4,  5, 21,  3, 22,  9, 10, 11, 12, 13, 14, 15, /* 0xC0 */
+    16, 32, 17, 18, 19, 20,  7,  2, 29, 28,  8, 25, 30, 26, 24, 27, /* 0xD0 */
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, /* 0xE0 */
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 /* 0xF0 */
+  };
 
 static int validate_pair(char prev, char next)
      /*
@@ -130,12 +341,36 @@ static int validate_pair(char prev, char next)
       * Returns 0 on valid pair or -1 otherwise.
       */
 {
-  if (next && index(group1, next))
-    if (index(group2, prev))
-      return -1;
+  if ((letter_class[(unsigned char)next] & SIGN) &&
+      (letter_class[(unsigned char)prev] & NO_SIGN_AFTER))
+    return -1;
   return 0;
 }
 
+static int range_flush(uint32_t low, uint32_t range, char *t, int l)
+     /*
+      * This routine terminates the range code by the value
+      * of the final interval having the least number of leading bytes,
+      * since the missing ones are taken as zeros when unpacking.
+      * The packed data already placed in t are l bytes long.
+      * Returns the whole packed data length.
+      */
+{
+  uint64_t value, mask = 0xffffffff;
+  int j, n;
+
+  for (n = 0; ((low + mask) & ~mask) >= (uint64_t)low + range; n++)
+    mask >>= 8;
+  value = (low + mask) & ~mask;
+  for (j = 0; j < n; j++)
+    t[l++] = (char)(value >> (24 - 8 * j));
+  while (l && !t[l - 1])
+    l--;
+  if (!l)
+    t[l++] = 0;
+  return l;
+}
+
 
 int pack_key(const char *s, char *t)
      /*
@@ -146,31 +381,23 @@ int pack_key(const char *s, char *t)
       */
 {
   long int range, underflow_bits = 0;
-  unsigned short int low = 0, high = 0xffff, mask = 0x80;
-  char table[256];
-  int i, j, l = 0;
-
-  /* Initialize symbol table */
-  for (i = 0; i < 256; i++)
-    table[i] = -1;
-  for (i = 0; i < strlen(alphabet) + 1; i++)
-    table[(unsigned char)alphabet[i]] = (char)i;
-
-  /* Packing data */
-  t[0] = 0;
-  for (i = 0; i <= strlen(s); i++)
+  unsigned short int low = 0, high = 0xffff;
+  unsigned int bits = 0, room = 8;
+  const unsigned char *p = (const unsigned char *)s;
+  int j, l = 0;
+
+  if ((!*p) || (letter_class[*p] & NO_KEY_START))
+    return -1;
+
+  /* Packing data in a single pass up to the EOS symbol inclusive */
+  do
     {
       /* Get the next symbol and check its validity */
-      if (i)
-	{
-	  if (validate_pair(s[i - 1], s[i]))
-	    return -1;
-	}
-      else if (index(group3, s[i]))
-	return -1;
-      j = (int)table[s[i] & 0xff];
+      j = symbol[*p];
       if (j < 0)
 	return -1;
+      if ((letter_class[*p] & SIGN) && (letter_class[p[-1]] & NO_SIGN_AFTER))
+	return -1;
 
       /* Rescale high and low for the new symbol */
       range = (long int)(high - low) + 1;
@@ -201,17 +428,70 @@ int pack_key(const char *s, char *t)
 	  high |= 1;
 	}
     }
+  while (*p++);
 
   /* Flush packed data */
   turnout(low & 0x4000);
   underflow_bits++;
   while (underflow_bits-- > 0)
     turnout(~low & 0x4000);
-  if (mask != 0x80)
-    l++;
+  if (room < 8)
+    t[l++] = (char)(bits << room);
   return l;
 }
 
+int pack_keys(const RULEX_KEYCODER *coder, const char * const *s, int n,
+	      char *t, int *len)
+     /*
+      * This routine packs n strings pointed by s[i] in specified format
+      * one after another into the memory pointed by t.
+      * The packed length of every string or -1 if it contains
+      * invalid characters is placed in len[i]. Nothing is stored
+      * for the invalid strings. The memory area must have room
+      * for PACKED_KEY_SIZE() bytes for every string.
+      * Returns total length of the packed data.
+      */
+{
+  int i, total = 0;
+
+  for (i = 0; i < n; i++)
+    {
+      len[i] = coder->pack(s[i], t + total);
+      if (len[i] > 0)
+	total += len[i];
+    }
+  return total;
+}
+
+int check_key(const char *s)
+     /*
+      * This routine checks whether string pointed by s
+      * can be packed as a key in any format.
+      * Returns 0 if it can or -1 if the string
+      * contains invalid characters.
+      */
+{
+  const unsigned char *p = (const unsigned char *)s;
+
+  if ((!*p) || (letter_class[*p] & NO_KEY_START))
+    return -1;
+  for (; *p; p++)
+    if ((symbol[*p] < 0) ||
+	((letter_class[*p] & SIGN) && (letter_class[p[-1]] & NO_SIGN_AFTER)))
+      return -1;
+  return 0;
+}
+
+int key_order(unsigned char c)
+     /*
+      * This routine returns position of the character
+      * in the packed keys order counting from 1,
+      * or 0 if it cannot occur in the keys.
+      */
+{
+  return (c && (symbol[c] >= 0)) ? symbol[c] + 1 : 0;
+}
+
 int unpack_key(const char *key, unsigned int keylen, char *t, unsigned int reslen)
      /*
       * This routine unpacks given key and stores the resulting string
@@ -221,30 +501,29 @@ int unpack_key(const char *key, unsigned int keylen, char *t, unsigned int resle
       * for result string.
       */
 {
-  long int range;
-  unsigned short int code, count, low = 0, high = 0xffff, mask = 0x80;
-  int i, k, l;
+  unsigned int range, bits = 0, avail = 0, input, k = 0;
+  unsigned short int code, count, low = 0, high = 0xffff, diff;
+  int i, n, l;
 
   l = 0;
   if (keylen)
     {
       /* Get initial portion of packed data */
-      code = key[0];
-      code <<= 8;
-      k = 1;
-      if (keylen > 1)
-	code += (unsigned char)key[k++];
+      takein(16);
+      code = (unsigned short int)input;
       while (l < reslen) /* Decoding loop */
 	{
 	  /* Calculate current count */
-	  range = (long int)(high - low) + 1;
-	  count = (short int)((((long int)(code - low) + 1) * scale - 1)
-			      / range);
+	  range = (unsigned int)(high - low) + 1;
+	  if (code >= low) /* Products fit 32 bits here */
+	    count = (unsigned short int)((((unsigned int)(code - low) + 1)
+					  * scale - 1) / range);
+	  else /* Broken key */
+	    count = (short int)((((long int)(code - low) + 1) * scale - 1)
+				/ (long int)range);
 	  /* Find the corresponding symbol */
-	  for (i = strlen(alphabet); i > 0; i--)
-	    if (count >= letter[i].low)
-	      break;
-	  if (!alphabet[i]) /* End of string */
+	  i = (count < scale) ? decode[count] : EOS;
+	  if (i == EOS) /* End of string */
 	    break; /* Finish decoding process */
 	  t[l++] = alphabet[i];
 	  /* Calculate new low and high values */
@@ -254,32 +533,204 @@ int unpack_key(const char *key, unsigned int keylen, char *t, unsigned int resle
 	  /* Get next bits of code */
 	  while (1)
 	    {
-	      if ((high ^ low) & 0x8000)
+	      diff = high ^ low;
+	      if (!(diff & 0x8000))
 		{
-		  if ((low & 0x4000) && !(high & 0x4000))
-		    {
-		      code ^= 0x4000;
-		      low &= 0x3fff;
-		      high |= 0x4000;
-		    }
-		  else break;
+		  /* Shift out all the leading bits that are settled */
+		  for (n = 1; (n < 16) && !((diff << n) & 0x8000); n++);
 		}
-	      low <<= 1;
-	      high <<= 1;
-	      high |= 1;
-	      code <<= 1;
-	      if (k < keylen)
+	      else if ((low & 0x4000) && !(high & 0x4000))
 		{
-		  if (key[k] & mask) code++;
-		  mask >>= 1;
-		  if (!mask)
-		    {
-		      k++;
-		      mask = 0x80;
-		    }
+		  code ^= 0x4000;
+		  low &= 0x3fff;
+		  high |= 0x4000;
+		  n = 1;
 		}
+	      else break;
+	      low <<= n;
+	      high = (high << n) | ((1 << n) - 1);
+	      takein(n);
+	      code = (code << n) | input;
+	    }
+	}
+    }
+
+  /* Finalization */
+  if (l < reslen)
+    {
+      t[l] = 0;
+      return 0;
+    }
+  else return -1;
+}
+
+int range_pack_key(const char *s, char *t)
+     /*
+      * This routine packs string pointed by s using range coding
+      * and places result to the string pointed by t.
+      * Returns packed data length on success or -1 if source string
+      * contains invalid characters.
+      */
+{
+  uint32_t low = 0, range = 0xffffffff;
+  const unsigned char *p = (const unsigned char *)s;
+  int j, l = 0;
+
+  if ((!*p) || (letter_class[*p] & NO_KEY_START))
+    return -1;
+
+  /* Packing data in a single pass up to the EOS symbol inclusive */
+  do
+    {
+      /* Get the next symbol and check its validity */
+      j = symbol[*p];
+      if (j < 0)
+	return -1;
+      if ((letter_class[*p] & SIGN) && (letter_class[p[-1]] & NO_SIGN_AFTER))
+	return -1;
+
+      /* Narrow the range to the symbol interval */
+      range /= scale;
+      low += letter[j].low * range;
+      range *= letter[j].high - letter[j].low;
+
+      /* Shift out settled bytes */
+      renormalize(t[l++] = (char)(low >> 24));
+    }
+  while (*p++);
+
+  return range_flush(low, range, t, l);
+}
+
+int range_unpack_key(const char *key, unsigned int keylen,
+		     char *t, unsigned int reslen)
+     /*
+      * This routine unpacks the key packed by range_pack_key()
+      * and stores the resulting string in memory pointed by t.
+      * The reslen holds the size of this area.
+      *
+      * Returns 0 on success, or -1 when allocated memory is insufficient
+      * for result string.
+      */
+{
+  uint32_t low = 0, range = 0xffffffff, code = 0, count;
+  unsigned int k;
+  int i, l = 0;
+
+  if (keylen)
+    {
+      /* Get initial portion of packed data */
+      for (k = 0; k < 4; k++)
+	code = (code << 8) | ((k < keylen) ? (unsigned char)key[k] : 0);
+      while (l < reslen) /* Decoding loop */
+	{
+	  /* Find the symbol by the current count */
+	  range /= scale;
+	  count = (code - low) / range;
+	  i = (count < scale) ? decode[count] : EOS;
+	  if (i == EOS) /* End of string */
+	    break; /* Finish decoding process */
+	  t[l++] = alphabet[i];
+	  /* Narrow the range to the symbol interval */
+	  low += letter[i].low * range;
+	  range *= letter[i].high - letter[i].low;
+	  /* Get next bytes of code */
+	  renormalize(code = (code << 8) |
+		      ((k < keylen) ? (unsigned char)key[k++] : 0));
+	}
+    }
+
+  /* Finalization */
+  if (l < reslen)
+    {
+      t[l] = 0;
+      return 0;
+    }
+  else return -1;
+}
+
+int context_pack_key(const char *s, char *t)
+     /*
+      * This routine packs string pointed by s using range coding
+      * by the order-1 model and places result to the string
+      * pointed by t.
+      * Returns packed data length on success or -1 if source string
+      * contains invalid characters.
+      */
+{
+  uint32_t low = 0, range = 0xffffffff;
+  const unsigned char *p = (const unsigned char *)s;
+  int j, context = KEY_START, l = 0;
+
+  if ((!*p) || (letter_class[*p] & NO_KEY_START))
+    return -1;
+
+  /* Packing data in a single pass up to the EOS symbol inclusive */
+  do
+    {
+      /* Get the next symbol and check its validity */
+      j = symbol[*p];
+      if (j < 0)
+	return -1;
+      if ((letter_class[*p] & SIGN) && (letter_class[p[-1]] & NO_SIGN_AFTER))
+	return -1;
+
+      /* Narrow the range to the symbol interval in its context */
+      range >>= CONTEXT_SCALE_BITS;
+      low += context_low[context][j] * range;
+      range *= context_low[context][j + 1] - context_low[context][j];
+      context = j;
+
+      /* Shift out settled bytes */
+      renormalize(t[l++] = (char)(low >> 24));
+    }
+  while (*p++);
+
+  return range_flush(low, range, t, l);
+}
+
+int context_unpack_key(const char *key, unsigned int keylen,
+		       char *t, unsigned int reslen)
+     /*
+      * This routine unpacks the key packed by context_pack_key()
+      * and stores the resulting string in memory pointed by t.
+      * The reslen holds the size of this area.
+      *
+      * Returns 0 on success, or -1 when allocated memory is insufficient
+      * for result string.
+      */
+{
+  uint32_t low = 0, range = 0xffffffff, code = 0, count;
+  unsigned int k;
+  int i, context = KEY_START, l = 0;
+
+  if (keylen)
+    {
+      /* Get initial portion of packed data */
+      for (k = 0; k < 4; k++)
+	code = (code << 8) | ((k < keylen) ? (unsigned char)key[k] : 0);
+      while (l < reslen) /* Decoding loop */
+	{
+	  /* Find the symbol by the current count in its context */
+	  range >>= CONTEXT_SCALE_BITS;
+	  count = (code - low) / range;
+	  if (count < (1U << CONTEXT_SCALE_BITS))
+	    {
+	      i = context_decode[context][count >> CONTEXT_DECODE_BITS];
+	      while (context_low[context][i + 1] <= count)
+		i++;
 	    }
-          code &= 0xffff;
+	  else i = EOS; /* Broken key */
+	  if (i == EOS) /* End of string */
+	    break; /* Finish decoding process */
+	  t[l++] = alphabet[i];
+	  /* Narrow the range to the symbol interval */
+	  low += context_low[context][i] * range;
+	  range *= context_low[context][i + 1] - context_low[context][i];
+	  context = i;
+	  /* Get next bytes of code */
+	  renormalize(code = (code << 8) |
+		      ((k < keylen) ? (unsigned char)key[k++] : 0));
 	}
     }
 
@@ -292,6 +743,28 @@ int unpack_key(const char *key, unsigned int keylen, char *t, unsigned int resle
   else return -1;
 }
 
+const RULEX_KEYCODER *key_coder(int format)
+     /*
+      * This routine finds the keys packing routines
+      * for specified format.
+      * Returns NULL if the format is unknown.
+      */
+{
+  static const RULEX_KEYCODER coders[] =
+    {
+      { KEY_FORMAT_ARITHMETIC, 0, pack_key, unpack_key },
+      { KEY_FORMAT_RANGE, 0, range_pack_key, range_unpack_key },
+      { KEY_FORMAT_CONTEXT, CONTEXT_MODEL_ID,
+	context_pack_key, context_unpack_key }
+    };
+  unsigned int i;
+
+  for (i = 0; i < sizeof(coders) / sizeof(coders[0]); i++)
+    if (coders[i].format == format)
+      return coders + i;
+  return NULL;
+}
+
 
 int pack_data(const char *s, const char *t, char *r)
      /*
@@ -26,6 +26,7 @@
  * In the database key fields are packed by the arithmetic coding algorithm
  * based on the static statistical model. Value fields are represented
  * by differences relative to the corresponding keys.
+ * Keys may be packed in several formats sharing the same model.
  */
 
 
@@ -56,12 +57,29 @@ BEGIN_C_DECLS
 #define INSERT_CHAR 0x80
 #define REMOVE_CHAR 0x40
 
+/* Keys packing formats */
+#define KEY_FORMAT_ARITHMETIC 1 /* 16-bit arithmetic coder (original one) */
+#define KEY_FORMAT_RANGE 2 /* 32-bit range coder */
+#define KEY_FORMAT_CONTEXT 3 /* 32-bit range coder with order-1 model */
+
+/* Room needed for the packed key of the string of len characters */
+#define PACKED_KEY_SIZE(len) (5 * (len) + 9)
+
 typedef struct /* Symbol description for statistical model */
 {
   unsigned short int low;
   unsigned short int high;
 } SYMBOL;
 
+typedef struct RULEX_KEYCODER /* Keys packing format */
+{
+  int format; /* Format tag */
+  unsigned int model; /* Trained model identifier (0 for built-in ones) */
+  int (*pack)(const char *s, char *t);
+  int (*unpack)(const char *key, unsigned int keylen,
+		char *t, unsigned int reslen);
+} RULEX_KEYCODER;
+
 
 extern int pack_key(const char *s, char *t);
 /*
@@ -71,6 +89,35 @@ extern int pack_key(const char *s, char *t);
  * contains invalid characters.
  */
 
+extern int pack_keys(const RULEX_KEYCODER *coder, const char * const *s,
+		     int n, char *t, int *len);
+/*
+ * This routine packs n strings pointed by s[i] in specified format
+ * one after another into the memory pointed by t.
+ * The packed length of every string or -1 if it contains
+ * invalid characters is placed in len[i]. Nothing is stored
+ * for the invalid strings. The memory area must have room
+ * for PACKED_KEY_SIZE() bytes for every string.
+ * Returns total length of the packed data.
+ */
+
+extern int check_key(const char *s);
+/*
+ * This routine checks whether string pointed by s
+ * can be packed as a key in any format.
+ * Returns 0 if it can or -1 if the string
+ * contains invalid characters.
+ */
+
+extern int key_order(unsigned char c);
+/*
+ * This routine returns position of the character
+ * in the packed keys order counting from 1,
+ * or 0 if it cannot occur in the keys.
+ * All the keys formats keep this order, and the key
+ * goes after all the keys it is a prefix of.
+ */
+
 extern int unpack_key(const char *key, unsigned int keylen,
 		      char *t, unsigned int reslen);
 /*
@@ -81,6 +128,52 @@ extern int unpack_key(const char *key, unsigned int keylen,
  * for result string.
  */
 
+extern int range_pack_key(const char *s, char *t);
+/*
+ * This routine packs string pointed by s using range coding
+ * and places result to the string pointed by t.
+ * Returns packed data length on success or -1 if source string
+ * contains invalid characters.
+ */
+
+extern int range_unpack_key(const char *key, unsigned int keylen,
+			    char *t, unsigned int reslen);
+/*
+ * This routine unpacks the key packed by range_pack_key()
+ * and stores the resulting string in memory pointed by t.
+ * The reslen holds the size of this area.
+ *
+ * Returns 0 on success, or -1 when allocated memory is insufficient
+ * for result string.
+ */
+
+extern int context_pack_key(const char *s, char *t);
+/*
+ * This routine packs string pointed by s using range coding
+ * by the order-1 model and places result to the string
+ * pointed by t.
+ * Returns packed data length on success or -1 if source string
+ * contains invalid characters.
+ */
+
+extern int context_unpack_key(const char *key, unsigned int keylen,
+			      char *t, unsigned int reslen);
+/*
+ * This routine unpacks the key packed by context_pack_key()
+ * and stores the resulting string in memory pointed by t.
+ * The reslen holds the size of this area.
+ *
+ * Returns 0 on success, or -1 when allocated memory is insufficient
+ * for result string.
+ */
+
+extern const RULEX_KEYCODER *key_coder(int format);
+/*
+ * This routine finds the keys packing routines
+ * for specified format.
+ * Returns NULL if the format is unknown.
+ */
+
 
 extern int pack_data(const char *s, const char *t, char *r);
 /*
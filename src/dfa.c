@@ -0,0 +1,1063 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Multi-pattern rules matching automaton implementation.
+ *
+ * Every pattern is compiled into the Thompson's nondeterministic
+ * automaton. All these automata share the same input alphabet
+ * that is split into equivalence classes, so the letters
+ * never distinguished by the rules are handled together.
+ *
+ * The deterministic automaton states are the sets of nondeterministic
+ * ones. They are constructed on demand and cached. Since the rules
+ * are not anchored at the beginning, the start states of all rules
+ * implicitly take part in every deterministic state. This part
+ * is not stored in the states themselves.
+ *
+ * When the cache grows too big, it is simply flushed
+ * and the construction starts from scratch.
+ *
+ * Since the cache is modified while searching, an automaton
+ * cannot be shared by parallel threads. Instead, each thread
+ * may use its own clone sharing only the nondeterministic part.
+ *
+ * The end of the first parenthesized subexpression of the matched rule
+ * is found by simulating the nondeterministic automaton of this rule
+ * alone. Every thread remembers where its match began and where
+ * it passed the end of the subexpression. When two threads meet
+ * in a state, they have the same future, so only the one beginning
+ * earlier or, for the same beginning, passing the end later
+ * is followed. So the longest match beginning leftmost is found,
+ * and the longest subexpression among its parses. That is what
+ * POSIX prescribes for the subexpression leading the pattern,
+ * so only such subexpressions are tracked.
+ *
+ * The same machinery serves for checking whether two patterns
+ * can match the same string. In this case the deterministic states
+ * keep track of the patterns already matched instead of the lowest
+ * matching rule, and all of them are explored exhaustively.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "dfa.h"
+
+
+/* Local constants */
+
+/* Maximum number of cached deterministic states */
+#define DFA_MAX_STATES 4096
+
+/* Nondeterministic automaton state types */
+#define NFA_SET 0 /* Consume a character from the set */
+#define NFA_SPLIT 1 /* Epsilon transitions to out and out1 */
+#define NFA_BOL 2 /* Epsilon transition at the beginning only */
+#define NFA_EOL 3 /* Epsilon transition at the end only */
+#define NFA_MATCH 4 /* The rule is matched */
+#define NFA_SAVE 5 /* Epsilon transition at the first subexpression end */
+
+/* Added rules flags */
+#define RULE_ADDED 1 /* The rule is added */
+#define RULE_TRACKED 2 /* Its first subexpression is tracked */
+
+/* Closure computation flags */
+#define CL_START 1 /* At the beginning of the string */
+#define CL_END 2 /* At the end of the string */
+#define CL_PROGRESS 4 /* Exclude the implicit restart part */
+
+/* Unknown value marker */
+#define UNKNOWN -1
+
+
+/* Data structures */
+
+typedef struct /* Nondeterministic automaton state */
+{
+  int type; /* State type */
+  int out; /* Next state */
+  int out1; /* Alternative next state for NFA_SPLIT */
+  int arg; /* Character set for NFA_SET */
+  int rule; /* Rule number this state belongs to */
+} NFA_STATE;
+
+typedef struct /* Deterministic automaton state */
+{
+  int *nfa; /* Sorted list of the nondeterministic states */
+  int n; /* Number of items in the list */
+  unsigned int hash; /* Hash value of the list */
+  int accept; /* The lowest rule matched here (INT_MAX if none) */
+  int accept_end; /* The same if the string ends here */
+  int *next; /* Transitions for each input class */
+} DFA_STATE;
+
+typedef struct /* Submatch tracking thread */
+{
+  int start; /* Where the match began */
+  int end; /* Where the first subexpression ended or -1 */
+} THREAD;
+
+struct RULEX_DFA
+{
+  NFA_STATE *nfa; /* Nondeterministic states */
+  int nnfa; /* Number of nondeterministic states */
+  PATTERN_SET *set; /* Character sets of all patterns */
+  int nsets; /* Number of character sets */
+  int *start; /* Start states of all rules */
+  int nstarts; /* Number of rules */
+  char *rules; /* Flags of added rules indexed by rule number */
+  int nrules; /* Size of the flags array */
+
+  /* The following fields are built when searching */
+  int ready; /* Input classes and restart part are computed */
+  unsigned char cls[256]; /* Input class for each character */
+  int nclasses; /* Number of input classes */
+  unsigned char *set_cls; /* Class bitmaps for every character set */
+  char *restart; /* Flags of the states in the restart part */
+  int **restart_next; /* Restart transitions for every input class */
+  int restart_accept; /* The lowest rule matched by the restart part */
+  int restart_accept_end; /* The same at the end of the string */
+
+  DFA_STATE *state; /* Cached deterministic states */
+  int nstates; /* Number of cached states */
+  int *table; /* Hash table of the cached states */
+  int initial; /* The initial state */
+
+  unsigned int *mark; /* Visiting marks for the closure computation */
+  unsigned int gen; /* Current mark generation */
+  int *stack; /* Working stack for the closure computation */
+  int *list; /* Working list of the nondeterministic states */
+  int *in; /* Working list of the transition targets */
+
+  /* The following fields are allocated when tracking submatches */
+  THREAD *thread[2]; /* Threads in the states by the position parity */
+  unsigned int *visit[2]; /* Positions marks of these threads */
+  int *active[2]; /* Lists of the states consuming input */
+  int nactive[2]; /* Numbers of states in these lists */
+  unsigned int tick; /* Current position mark */
+  int *pending; /* Working stack of the threads to follow */
+  int npending; /* Its size */
+
+  const RULEX_DFA *origin; /* Automaton sharing its rules with this one */
+};
+
+
+/* Local routines */
+
+static int nfa_new(RULEX_DFA *dfa, int type, int out, int out1,
+                   int arg, int rule)
+     /*
+      * Allocate new nondeterministic state.
+      * Returns its number or -1 when memory allocation fails.
+      */
+{
+  NFA_STATE *nfa;
+
+  if (!(dfa->nnfa & 255))
+    {
+      nfa = realloc(dfa->nfa, (dfa->nnfa + 256) * sizeof(NFA_STATE));
+      if (!nfa) return -1;
+      dfa->nfa = nfa;
+    }
+  nfa = &dfa->nfa[dfa->nnfa];
+  nfa->type = type;
+  nfa->out = out;
+  nfa->out1 = out1;
+  nfa->arg = arg;
+  nfa->rule = rule;
+  return dfa->nnfa++;
+}
+
+static int nfa_compile(RULEX_DFA *dfa, const PATTERN *pattern, int node,
+                       int out, int sets, int rule)
+     /*
+      * Compile the subtree of specified node continuing by the state out.
+      * The argument sets specifies the first pattern set number
+      * in the automaton.
+      *
+      * Returns the entry state number or -1 when memory allocation fails.
+      */
+{
+  const PATTERN_NODE *p = &pattern->node[node];
+  int l, r;
+
+  switch (p->type)
+    {
+      case PAT_SET:
+        return nfa_new(dfa, NFA_SET, out, -1, sets + p->arg, rule);
+      case PAT_BOL:
+        return nfa_new(dfa, NFA_BOL, out, -1, 0, rule);
+      case PAT_EOL:
+        return nfa_new(dfa, NFA_EOL, out, -1, 0, rule);
+      case PAT_CAT:
+        r = nfa_compile(dfa, pattern, p->right, out, sets, rule);
+        if (r < 0) return -1;
+        return nfa_compile(dfa, pattern, p->left, r, sets, rule);
+      case PAT_ALT:
+        l = nfa_compile(dfa, pattern, p->left, out, sets, rule);
+        if (l < 0) return -1;
+        r = nfa_compile(dfa, pattern, p->right, out, sets, rule);
+        if (r < 0) return -1;
+        return nfa_new(dfa, NFA_SPLIT, l, r, 0, rule);
+      case PAT_STAR:
+        r = nfa_new(dfa, NFA_SPLIT, -1, out, 0, rule);
+        if (r < 0) return -1;
+        l = nfa_compile(dfa, pattern, p->left, r, sets, rule);
+        if (l < 0) return -1;
+        dfa->nfa[r].out = l;
+        return r;
+      case PAT_PLUS:
+        r = nfa_new(dfa, NFA_SPLIT, -1, out, 0, rule);
+        if (r < 0) return -1;
+        l = nfa_compile(dfa, pattern, p->left, r, sets, rule);
+        if (l < 0) return -1;
+        dfa->nfa[r].out = l;
+        return l;
+      case PAT_QUEST:
+        l = nfa_compile(dfa, pattern, p->left, out, sets, rule);
+        if (l < 0) return -1;
+        return nfa_new(dfa, NFA_SPLIT, l, out, 0, rule);
+      case PAT_GROUP:
+        if (p->arg == 1)
+          {
+            out = nfa_new(dfa, NFA_SAVE, out, -1, 0, rule);
+            if (out < 0) return -1;
+          }
+        return nfa_compile(dfa, pattern, p->left, out, sets, rule);
+      default:
+        break;
+    }
+  return out;
+}
+
+static int group_leads(const PATTERN *pattern, int node)
+     /*
+      * Check whether the first parenthesized subexpression
+      * leads the subtree of specified node, being preceded
+      * by the anchors only.
+      */
+{
+  const PATTERN_NODE *p = &pattern->node[node];
+
+  switch (p->type)
+    {
+      case PAT_GROUP:
+        return p->arg == 1;
+      case PAT_CAT:
+        if ((pattern->node[p->left].type == PAT_BOL) ||
+            (pattern->node[p->left].type == PAT_EMPTY))
+          return group_leads(pattern, p->right);
+        return group_leads(pattern, p->left);
+      default:
+        break;
+    }
+  return 0;
+}
+
+static int closure(RULEX_DFA *dfa, const int *in, int nin, int flags)
+     /*
+      * Compute epsilon closure of the states listed in the array in.
+      * Only the states consuming input, the end anchors (when
+      * not at the end) and the final states are placed into
+      * the working list. Returns the number of states in this list.
+      */
+{
+  int i, s, sp = 0, n = 0;
+
+  if (!++dfa->gen)
+    {
+      (void)memset(dfa->mark, 0, dfa->nnfa * sizeof(unsigned int));
+      dfa->gen = 1;
+    }
+  for (i = 0; i < nin; i++)
+    dfa->stack[sp++] = in[i];
+  while (sp)
+    {
+      s = dfa->stack[--sp];
+      if (dfa->mark[s] == dfa->gen)
+        continue;
+      dfa->mark[s] = dfa->gen;
+      if ((flags & CL_PROGRESS) && dfa->restart[s])
+        continue;
+      switch (dfa->nfa[s].type)
+        {
+          case NFA_SPLIT:
+            dfa->stack[sp++] = dfa->nfa[s].out1;
+            dfa->stack[sp++] = dfa->nfa[s].out;
+            break;
+          case NFA_SAVE:
+            dfa->stack[sp++] = dfa->nfa[s].out;
+            break;
+          case NFA_BOL:
+            if (flags & CL_START)
+              dfa->stack[sp++] = dfa->nfa[s].out;
+            break;
+          case NFA_EOL:
+            if (flags & CL_END)
+              dfa->stack[sp++] = dfa->nfa[s].out;
+            else dfa->list[n++] = s;
+            break;
+          default:
+            dfa->list[n++] = s;
+            break;
+        }
+    }
+  return n;
+}
+
+static int lowest_match(const RULEX_DFA *dfa, const int *list, int n)
+     /*
+      * Find the lowest rule number among the final states in the list.
+      * Returns INT_MAX if there are no such states.
+      */
+{
+  int i, rule = INT_MAX;
+
+  for (i = 0; i < n; i++)
+    if ((dfa->nfa[list[i]].type == NFA_MATCH) &&
+        (dfa->nfa[list[i]].rule < rule))
+      rule = dfa->nfa[list[i]].rule;
+  return rule;
+}
+
+static int compare_states(const void *a, const void *b)
+{
+  return *(const int *)a - *(const int *)b;
+}
+
+static void flush(RULEX_DFA *dfa)
+     /*
+      * Flush the deterministic states cache.
+      */
+{
+  int i;
+
+  for (i = 0; i < dfa->nstates; i++)
+    {
+      free(dfa->state[i].nfa);
+      free(dfa->state[i].next);
+    }
+  dfa->nstates = 0;
+  dfa->initial = UNKNOWN;
+  if (dfa->table)
+    for (i = 0; i < 2 * DFA_MAX_STATES; i++)
+      dfa->table[i] = UNKNOWN;
+  return;
+}
+
+static int intern(RULEX_DFA *dfa, int n)
+     /*
+      * Find or create deterministic state for n nondeterministic states
+      * collected in the working list. The list is sorted
+      * and pruned in place.
+      *
+      * Returns the state number or -1 when memory allocation fails.
+      */
+{
+  DFA_STATE *d;
+  unsigned int hash = 2166136261U;
+  int i, k, rule;
+
+  /*
+   * When some rule is matched here, there is no need
+   * to keep track of it and of all the subsequent rules.
+   */
+  rule = lowest_match(dfa, dfa->list, n);
+  if (rule > dfa->restart_accept)
+    rule = dfa->restart_accept;
+  if (rule != INT_MAX)
+    {
+      for (i = k = 0; i < n; i++)
+        if (dfa->nfa[dfa->list[i]].rule < rule)
+          dfa->list[k++] = dfa->list[i];
+      n = k;
+    }
+  qsort(dfa->list, n, sizeof(int), compare_states);
+  for (i = 0; i < n; i++)
+    hash = (hash ^ (unsigned int)dfa->list[i]) * 16777619U;
+  hash = (hash ^ (unsigned int)rule) * 16777619U;
+
+  /* Look up the cache */
+  for (i = hash & (2 * DFA_MAX_STATES - 1); dfa->table[i] != UNKNOWN;
+       i = (i + 1) & (2 * DFA_MAX_STATES - 1))
+    {
+      d = &dfa->state[dfa->table[i]];
+      if ((d->hash == hash) && (d->n == n) && (d->accept == rule) &&
+          !memcmp(d->nfa, dfa->list, n * sizeof(int)))
+        return dfa->table[i];
+    }
+
+  /* Create new state */
+  if (dfa->nstates >= DFA_MAX_STATES)
+    return -1;
+  d = &dfa->state[dfa->nstates];
+  d->nfa = malloc((n ? n : 1) * sizeof(int));
+  if (!d->nfa) return -1;
+  d->next = malloc(dfa->nclasses * sizeof(int));
+  if (!d->next)
+    {
+      free(d->nfa);
+      return -1;
+    }
+  (void)memcpy(d->nfa, dfa->list, n * sizeof(int));
+  for (k = 0; k < dfa->nclasses; k++)
+    d->next[k] = UNKNOWN;
+  d->n = n;
+  d->hash = hash;
+  d->accept = rule;
+  d->accept_end = UNKNOWN;
+  dfa->table[i] = dfa->nstates;
+  return dfa->nstates++;
+}
+
+static int prepare(RULEX_DFA *dfa)
+     /*
+      * Compute input classes and the restart part of the automaton
+      * and allocate working storage. Returns 0 on success
+      * or -1 when memory allocation fails.
+      */
+{
+  int map[512];
+  unsigned char cls[256];
+  int i, k, c, n;
+
+  /* Split input alphabet into classes */
+  (void)memset(dfa->cls, 0, sizeof(dfa->cls));
+  dfa->nclasses = 1;
+  for (i = 0; i < dfa->nsets; i++)
+    {
+      for (k = 0; k < 2 * dfa->nclasses; k++)
+        map[k] = -1;
+      for (c = n = 0; c < 256; c++)
+        if (pattern_fold[c] == c)
+          {
+            k = 2 * dfa->cls[c] + (pattern_set_has(&dfa->set[i], c) ? 1 : 0);
+            if (map[k] < 0)
+              map[k] = n++;
+            cls[c] = map[k];
+          }
+      for (c = 0; c < 256; c++)
+        if (pattern_fold[c] == c)
+          dfa->cls[c] = cls[c];
+      dfa->nclasses = n;
+    }
+  for (c = 0; c < 256; c++)
+    dfa->cls[c] = dfa->cls[pattern_fold[c]];
+
+  /*
+   * Class bitmaps for the character sets. Only the folded
+   * characters are taken into account, since the input is folded
+   * before matching, while the negated sets contain upper case
+   * letters that never come here.
+   */
+  dfa->set_cls = calloc(dfa->nsets ? dfa->nsets : 1, 32);
+  if (!dfa->set_cls) return -1;
+  for (i = 0; i < dfa->nsets; i++)
+    for (c = 0; c < 256; c++)
+      if ((pattern_fold[c] == c) && pattern_set_has(&dfa->set[i], c))
+        dfa->set_cls[32 * i + (dfa->cls[c] >> 3)] |= 1 << (dfa->cls[c] & 7);
+
+  /* Working storage */
+  dfa->mark = calloc(dfa->nnfa, sizeof(unsigned int));
+  dfa->stack = malloc(4 * dfa->nnfa * sizeof(int));
+  dfa->list = malloc(dfa->nnfa * sizeof(int));
+  dfa->in = malloc(2 * dfa->nnfa * sizeof(int));
+  dfa->restart = calloc(dfa->nnfa, 1);
+  dfa->restart_next = calloc(dfa->nclasses, sizeof(int *));
+  dfa->state = malloc(DFA_MAX_STATES * sizeof(DFA_STATE));
+  dfa->table = malloc(2 * DFA_MAX_STATES * sizeof(int));
+  if (!(dfa->mark && dfa->stack && dfa->list && dfa->in && dfa->restart &&
+        dfa->restart_next && dfa->state && dfa->table))
+    return -1;
+  dfa->gen = 0;
+  flush(dfa);
+
+  /* The restart part */
+  n = closure(dfa, dfa->start, dfa->nstarts, 0);
+  for (i = 0; i < dfa->nnfa; i++)
+    if ((dfa->mark[i] == dfa->gen) && (dfa->nfa[i].type != NFA_BOL))
+      dfa->restart[i] = 1;
+  dfa->restart_accept = lowest_match(dfa, dfa->list, n);
+  for (c = 0; c < dfa->nclasses; c++)
+    {
+      dfa->restart_next[c] = malloc((n + 1) * sizeof(int));
+      if (!dfa->restart_next[c]) return -1;
+      for (i = k = 0; i < n; i++)
+        if ((dfa->nfa[dfa->list[i]].type == NFA_SET) &&
+            (dfa->set_cls[32 * dfa->nfa[dfa->list[i]].arg + (c >> 3)] &
+             (1 << (c & 7))))
+          dfa->restart_next[c][++k] = dfa->nfa[dfa->list[i]].out;
+      dfa->restart_next[c][0] = k;
+    }
+  n = closure(dfa, dfa->start, dfa->nstarts, CL_END);
+  dfa->restart_accept_end = lowest_match(dfa, dfa->list, n);
+
+  dfa->ready = 1;
+  return 0;
+}
+
+static int step(RULEX_DFA *dfa, int d, int c)
+     /*
+      * Construct transition from state d by the input class c.
+      * Returns the target state number or -1 when memory allocation fails.
+      */
+{
+  DFA_STATE *state = &dfa->state[d];
+  int i, n, s;
+
+  n = dfa->restart_next[c][0];
+  (void)memcpy(dfa->in, dfa->restart_next[c] + 1, n * sizeof(int));
+  for (i = 0; i < state->n; i++)
+    {
+      s = state->nfa[i];
+      if ((dfa->nfa[s].type == NFA_SET) &&
+          (dfa->set_cls[32 * dfa->nfa[s].arg + (c >> 3)] & (1 << (c & 7))))
+        dfa->in[n++] = dfa->nfa[s].out;
+    }
+  n = closure(dfa, dfa->in, n, CL_PROGRESS);
+  if (dfa->nstates >= DFA_MAX_STATES)
+    {
+      flush(dfa);
+      return intern(dfa, n);
+    }
+  s = intern(dfa, n);
+  if (s >= 0)
+    dfa->state[d].next[c] = s;
+  return s;
+}
+
+static int accept_end(RULEX_DFA *dfa, int d, int flags)
+     /*
+      * Compute the lowest rule matched when the string ends in state d.
+      * Additional closure flags may be specified.
+      */
+{
+  DFA_STATE *state = &dfa->state[d];
+  int i, n, rule;
+
+  for (i = n = 0; i < state->n; i++)
+    if (dfa->nfa[state->nfa[i]].type == NFA_EOL)
+      dfa->in[n++] = dfa->nfa[state->nfa[i]].out;
+  n = closure(dfa, dfa->in, n, CL_END | flags);
+  rule = lowest_match(dfa, dfa->list, n);
+  if (rule > state->accept)
+    rule = state->accept;
+  if (rule > dfa->restart_accept_end)
+    rule = dfa->restart_accept_end;
+  return rule;
+}
+
+static int match_mask(const RULEX_DFA *dfa, const int *list, int n)
+     /*
+      * Collect the bit mask of the rules matched by the final states
+      * in the list. Only the rules 0 and 1 are taken into account.
+      */
+{
+  int i, mask = 0;
+
+  for (i = 0; i < n; i++)
+    if ((dfa->nfa[list[i]].type == NFA_MATCH) &&
+        (dfa->nfa[list[i]].rule < 2))
+      mask |= 1 << dfa->nfa[list[i]].rule;
+  return mask;
+}
+
+static int intern_mask(RULEX_DFA *dfa, int n, int mask)
+     /*
+      * Find or create the exploration state for n nondeterministic
+      * states collected in the working list and the mask
+      * of the rules already matched. The states of these rules
+      * are dropped from the list as they cannot change anything.
+      *
+      * Returns the state number or -1 when memory allocation fails
+      * or there are too many states.
+      */
+{
+  DFA_STATE *d;
+  unsigned int hash = 2166136261U;
+  int i, k;
+
+  for (i = k = 0; i < n; i++)
+    if (!(mask & (1 << dfa->nfa[dfa->list[i]].rule)))
+      dfa->list[k++] = dfa->list[i];
+  n = k;
+  qsort(dfa->list, n, sizeof(int), compare_states);
+  for (i = 0; i < n; i++)
+    hash = (hash ^ (unsigned int)dfa->list[i]) * 16777619U;
+  hash = (hash ^ (unsigned int)mask) * 16777619U;
+
+  for (i = hash & (2 * DFA_MAX_STATES - 1); dfa->table[i] != UNKNOWN;
+       i = (i + 1) & (2 * DFA_MAX_STATES - 1))
+    {
+      d = &dfa->state[dfa->table[i]];
+      if ((d->hash == hash) && (d->n == n) && (d->accept == mask) &&
+          !memcmp(d->nfa, dfa->list, n * sizeof(int)))
+        return dfa->table[i];
+    }
+
+  if (dfa->nstates >= DFA_MAX_STATES)
+    return -1;
+  d = &dfa->state[dfa->nstates];
+  d->nfa = malloc((n ? n : 1) * sizeof(int));
+  if (!d->nfa) return -1;
+  (void)memcpy(d->nfa, dfa->list, n * sizeof(int));
+  d->next = NULL;
+  d->n = n;
+  d->hash = hash;
+  d->accept = mask;
+  d->accept_end = UNKNOWN;
+  dfa->table[i] = dfa->nstates;
+  return dfa->nstates++;
+}
+
+static int restart_states(const RULEX_DFA *dfa, int mask, int *in)
+     /*
+      * Place the start states of the rules not matched yet
+      * into the array in. Returns the number of placed states.
+      */
+{
+  int i, n = 0;
+
+  for (i = 0; i < dfa->nstarts; i++)
+    if (!(mask & (1 << dfa->nfa[dfa->start[i]].rule)))
+      in[n++] = dfa->start[i];
+  return n;
+}
+
+static int explore(RULEX_DFA *dfa)
+     /*
+      * Explore all the strings looking for one matched
+      * by both rules 0 and 1.
+      *
+      * Returns 1 if such a string is found, 0 if it does not exist
+      * or DFA_FAILURE when the exploration cannot be completed.
+      */
+{
+  DFA_STATE *d;
+  int i, k, n, c, mask;
+
+  n = closure(dfa, dfa->start, dfa->nstarts, CL_START);
+  mask = match_mask(dfa, dfa->list, n);
+  if (mask == 3) return 1;
+  if (intern_mask(dfa, n, mask) < 0)
+    return DFA_FAILURE;
+
+  for (k = 0; k < dfa->nstates; k++)
+    {
+      /* Check the string ending here */
+      d = &dfa->state[k];
+      for (i = n = 0; i < d->n; i++)
+        if (dfa->nfa[d->nfa[i]].type == NFA_EOL)
+          dfa->in[n++] = dfa->nfa[d->nfa[i]].out;
+      n += restart_states(dfa, d->accept, dfa->in + n);
+      n = closure(dfa, dfa->in, n, k ? CL_END : CL_START | CL_END);
+      if ((d->accept | match_mask(dfa, dfa->list, n)) == 3)
+        return 1;
+
+      /* Continue by every input class */
+      for (c = 0; c < dfa->nclasses; c++)
+        {
+          d = &dfa->state[k];
+          for (i = n = 0; i < d->n; i++)
+            if ((dfa->nfa[d->nfa[i]].type == NFA_SET) &&
+                (dfa->set_cls[32 * dfa->nfa[d->nfa[i]].arg + (c >> 3)] &
+                 (1 << (c & 7))))
+              dfa->in[n++] = dfa->nfa[d->nfa[i]].out;
+          n += restart_states(dfa, d->accept, dfa->in + n);
+          n = closure(dfa, dfa->in, n, 0);
+          mask = d->accept | match_mask(dfa, dfa->list, n);
+          if (mask == 3) return 1;
+          if (intern_mask(dfa, n, mask) < 0)
+            return DFA_FAILURE;
+        }
+    }
+  return 0;
+}
+
+
+static int track_init(RULEX_DFA *dfa)
+     /*
+      * Allocate the submatch tracking storage.
+      * Returns 0 on success or -1 when memory allocation fails.
+      */
+{
+  int k;
+
+  for (k = 0; k < 2; k++)
+    {
+      dfa->thread[k] = malloc(dfa->nnfa * sizeof(THREAD));
+      dfa->visit[k] = calloc(dfa->nnfa, sizeof(unsigned int));
+      dfa->active[k] = malloc(dfa->nnfa * sizeof(int));
+      if (!(dfa->thread[k] && dfa->visit[k] && dfa->active[k]))
+        return -1;
+    }
+  dfa->npending = 3 * dfa->nnfa;
+  dfa->pending = malloc(dfa->npending * sizeof(int));
+  if (!dfa->pending) return -1;
+  dfa->tick = 0;
+  return 0;
+}
+
+static int track_add(RULEX_DFA *dfa, int s, int start, int end,
+                     const char *str, int pos, THREAD *best, int *best_pos)
+     /*
+      * Put the thread which began at start and passed the end
+      * of the first subexpression at end into state s at position pos
+      * of the string str and follow its epsilon transitions.
+      * The best match found so far is kept in the locations
+      * pointed by best and best_pos.
+      *
+      * Returns 0 on success or -1 when memory allocation fails.
+      */
+{
+  THREAD *t;
+  int *pending, sp = 0, k = pos & 1;
+
+  dfa->pending[sp++] = s;
+  dfa->pending[sp++] = start;
+  dfa->pending[sp++] = end;
+  while (sp)
+    {
+      end = dfa->pending[--sp];
+      start = dfa->pending[--sp];
+      s = dfa->pending[--sp];
+      t = &dfa->thread[k][s];
+      if (dfa->visit[k][s] == dfa->tick)
+        {
+          if ((start > t->start) || ((start == t->start) && (end <= t->end)))
+            continue;
+        }
+      else
+        {
+          dfa->visit[k][s] = dfa->tick;
+          if (dfa->nfa[s].type == NFA_SET)
+            dfa->active[k][dfa->nactive[k]++] = s;
+        }
+      t->start = start;
+      t->end = end;
+      if (sp + 6 > dfa->npending)
+        {
+          pending = realloc(dfa->pending, 2 * dfa->npending * sizeof(int));
+          if (!pending) return -1;
+          dfa->pending = pending;
+          dfa->npending *= 2;
+        }
+      switch (dfa->nfa[s].type)
+        {
+          case NFA_SPLIT:
+            dfa->pending[sp++] = dfa->nfa[s].out1;
+            dfa->pending[sp++] = start;
+            dfa->pending[sp++] = end;
+            dfa->pending[sp++] = dfa->nfa[s].out;
+            dfa->pending[sp++] = start;
+            dfa->pending[sp++] = end;
+            break;
+          case NFA_BOL:
+          case NFA_EOL:
+            if ((dfa->nfa[s].type == NFA_BOL) ? pos : str[pos])
+              break;
+            dfa->pending[sp++] = dfa->nfa[s].out;
+            dfa->pending[sp++] = start;
+            dfa->pending[sp++] = end;
+            break;
+          case NFA_SAVE:
+            dfa->pending[sp++] = dfa->nfa[s].out;
+            dfa->pending[sp++] = start;
+            dfa->pending[sp++] = pos;
+            break;
+          case NFA_MATCH:
+            if ((best->start < 0) || (start < best->start) ||
+                ((start == best->start) &&
+                 ((pos > *best_pos) ||
+                  ((pos == *best_pos) && (end > best->end)))))
+              {
+                best->start = start;
+                best->end = end;
+                *best_pos = pos;
+              }
+            break;
+          default:
+            break;
+        }
+    }
+  return 0;
+}
+
+
+/* Externally visible routines */
+
+RULEX_DFA *dfa_create(void)
+     /*
+      * Allocate new empty automaton.
+      * Returns NULL when memory allocation fails.
+      */
+{
+  return calloc(1, sizeof(RULEX_DFA));
+}
+
+int dfa_add(RULEX_DFA *dfa, const PATTERN *pattern, int n)
+     /*
+      * Add parsed pattern to the automaton as rule number n.
+      * Rules may be added in any order, but each number
+      * must be used only once.
+      *
+      * Returns 0 on success or -1 when memory allocation fails.
+      */
+{
+  PATTERN_SET *set;
+  int *start;
+  char *rules;
+  int s;
+
+  if ((n < 0) || dfa->ready || dfa->origin)
+    return -1;
+  if (n >= dfa->nrules)
+    {
+      rules = realloc(dfa->rules, n + 1);
+      if (!rules) return -1;
+      (void)memset(rules + dfa->nrules, 0, n + 1 - dfa->nrules);
+      dfa->rules = rules;
+      dfa->nrules = n + 1;
+    }
+  start = realloc(dfa->start, (dfa->nstarts + 1) * sizeof(int));
+  if (!start) return -1;
+  dfa->start = start;
+  set = realloc(dfa->set, (dfa->nsets + pattern->nsets) * sizeof(PATTERN_SET));
+  if (!set) return -1;
+  dfa->set = set;
+  (void)memcpy(dfa->set + dfa->nsets, pattern->set,
+               pattern->nsets * sizeof(PATTERN_SET));
+
+  s = nfa_new(dfa, NFA_MATCH, -1, -1, 0, n);
+  if (s < 0) return -1;
+  s = nfa_compile(dfa, pattern, pattern->root, s, dfa->nsets, n);
+  if (s < 0) return -1;
+  dfa->nsets += pattern->nsets;
+  dfa->start[dfa->nstarts++] = s;
+  dfa->rules[n] = group_leads(pattern, pattern->root) ?
+    RULE_ADDED | RULE_TRACKED : RULE_ADDED;
+  return 0;
+}
+
+RULEX_DFA *dfa_clone(const RULEX_DFA *dfa)
+     /*
+      * Create new automaton sharing the rules with specified one.
+      * Returns NULL when memory allocation fails.
+      */
+{
+  RULEX_DFA *clone = calloc(1, sizeof(RULEX_DFA));
+
+  if (!clone)
+    return NULL;
+  clone->nfa = dfa->nfa;
+  clone->nnfa = dfa->nnfa;
+  clone->set = dfa->set;
+  clone->nsets = dfa->nsets;
+  clone->start = dfa->start;
+  clone->nstarts = dfa->nstarts;
+  clone->rules = dfa->rules;
+  clone->nrules = dfa->nrules;
+  clone->origin = dfa;
+  return clone;
+}
+
+int dfa_contains(const RULEX_DFA *dfa, int n)
+     /*
+      * Check whether rule number n was added to the automaton.
+      */
+{
+  return dfa && (n >= 0) && (n < dfa->nrules) && dfa->rules[n];
+}
+
+int dfa_search(RULEX_DFA *dfa, const char *s)
+     /*
+      * Find the lowest numbered rule matching string s.
+      *
+      * Returns the rule number, DFA_NOMATCH when no rule matches
+      * or DFA_FAILURE when memory allocation fails.
+      */
+{
+  int d, n, best;
+
+  if (!dfa->nstarts)
+    return DFA_NOMATCH;
+  if (!dfa->ready && prepare(dfa))
+    return DFA_FAILURE;
+  if (dfa->initial == UNKNOWN)
+    {
+      n = closure(dfa, dfa->start, dfa->nstarts, CL_START | CL_PROGRESS);
+      dfa->initial = intern(dfa, n);
+      if (dfa->initial < 0)
+        {
+          dfa->initial = UNKNOWN;
+          return DFA_FAILURE;
+        }
+    }
+  d = dfa->initial;
+  best = dfa->state[d].accept;
+  if (!*s) /* Empty string is matched at the beginning */
+    {
+      n = accept_end(dfa, d, CL_START);
+      return (n == INT_MAX) ? DFA_NOMATCH : n;
+    }
+  for (; *s; s++)
+    {
+      n = dfa->state[d].next[dfa->cls[(unsigned char)*s]];
+      if (n == UNKNOWN)
+        {
+          n = step(dfa, d, dfa->cls[(unsigned char)*s]);
+          if (n < 0) return DFA_FAILURE;
+        }
+      d = n;
+      if (dfa->state[d].accept < best)
+        best = dfa->state[d].accept;
+    }
+  if (dfa->state[d].accept_end == UNKNOWN)
+    dfa->state[d].accept_end = accept_end(dfa, d, 0);
+  if (dfa->state[d].accept_end < best)
+    best = dfa->state[d].accept_end;
+  return (best == INT_MAX) ? DFA_NOMATCH : best;
+}
+
+int dfa_group_end(RULEX_DFA *dfa, int n, const char *s)
+     /*
+      * Find the end offset of the first parenthesized subexpression
+      * of rule number n in its match of string s.
+      *
+      * Returns the offset, DFA_NOMATCH when the rule does not match
+      * or DFA_FAILURE when the subexpression is not tracked
+      * or memory allocation fails.
+      */
+{
+  THREAD best, *t;
+  int i, k, c, pos, s0, best_pos = 0;
+
+  if (!(dfa_contains(dfa, n) && (dfa->rules[n] & RULE_TRACKED)))
+    return DFA_FAILURE;
+  if (!dfa->ready && prepare(dfa))
+    return DFA_FAILURE;
+  if (!dfa->pending && track_init(dfa))
+    return DFA_FAILURE;
+  for (s0 = 0; dfa->nfa[dfa->start[s0]].rule != n; s0++);
+  s0 = dfa->start[s0];
+
+  best.start = -1;
+  best.end = -1;
+  for (pos = 0; ; pos++)
+    {
+      k = pos & 1;
+      if (!++dfa->tick)
+        {
+          (void)memset(dfa->visit[0], 0, dfa->nnfa * sizeof(unsigned int));
+          (void)memset(dfa->visit[1], 0, dfa->nnfa * sizeof(unsigned int));
+          dfa->tick = 1;
+        }
+      dfa->nactive[k] = 0;
+
+      /* Continue the threads by the preceding character */
+      if (pos)
+        {
+          c = dfa->cls[(unsigned char)s[pos - 1]];
+          for (i = 0; i < dfa->nactive[!k]; i++)
+            {
+              t = &dfa->thread[!k][dfa->active[!k][i]];
+              if (((best.start < 0) || (t->start <= best.start)) &&
+                  (dfa->set_cls[32 * dfa->nfa[dfa->active[!k][i]].arg +
+                                (c >> 3)] & (1 << (c & 7))) &&
+                  track_add(dfa, dfa->nfa[dfa->active[!k][i]].out,
+                            t->start, t->end, s, pos, &best, &best_pos))
+                return DFA_FAILURE;
+            }
+        }
+
+      /* Begin new match here unless one is found already */
+      if ((best.start < 0) &&
+          track_add(dfa, s0, pos, -1, s, pos, &best, &best_pos))
+        return DFA_FAILURE;
+
+      if ((!s[pos]) || ((best.start >= 0) && !dfa->nactive[k]))
+        break;
+    }
+  if (best.start < 0)
+    return DFA_NOMATCH;
+  return (best.end < 0) ? DFA_FAILURE : best.end;
+}
+
+int dfa_overlap(const PATTERN *a, const PATTERN *b)
+     /*
+      * Check whether some string is matched by both patterns.
+      *
+      * Returns 1 if such a string exists, 0 if there is no one
+      * or DFA_FAILURE when memory allocation fails or the check
+      * appears too complex.
+      */
+{
+  RULEX_DFA *dfa = dfa_create();
+  int rc;
+
+  if (!dfa)
+    return DFA_FAILURE;
+  if (dfa_add(dfa, a, 0) || dfa_add(dfa, b, 1) || prepare(dfa))
+    rc = DFA_FAILURE;
+  else rc = explore(dfa);
+  dfa_free(dfa);
+  return rc;
+}
+
+void dfa_free(RULEX_DFA *dfa)
+     /*
+      * Free all memory allocated for the automaton.
+      */
+{
+  int c;
+
+  if (!dfa) return;
+  if (dfa->state)
+    flush(dfa);
+  if (dfa->restart_next)
+    for (c = 0; c < dfa->nclasses; c++)
+      free(dfa->restart_next[c]);
+  free(dfa->restart_next);
+  free(dfa->restart);
+  free(dfa->state);
+  free(dfa->table);
+  free(dfa->mark);
+  free(dfa->stack);
+  free(dfa->list);
+  free(dfa->in);
+  free(dfa->set_cls);
+  free(dfa->thread[0]);
+  free(dfa->thread[1]);
+  free(dfa->visit[0]);
+  free(dfa->visit[1]);
+  free(dfa->active[0]);
+  free(dfa->active[1]);
+  free(dfa->pending);
+  if (!dfa->origin)
+    {
+      free(dfa->start);
+      free(dfa->rules);
+      free(dfa->set);
+      free(dfa->nfa);
+    }
+  free(dfa);
+  return;
+}
@@ -0,0 +1,128 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Multi-pattern rules matching automaton.
+ *
+ * All patterns of a ruleset are merged into one nondeterministic
+ * automaton, which is lazily turned into the deterministic one
+ * while matching the words. The automaton answers a single question:
+ * which is the first rule in the ruleset order matching the word.
+ * The end of the first parenthesized subexpression of that rule
+ * can be found as well when it leads the pattern. Other subexpressions
+ * positions are not tracked here, so the caller should apply
+ * the regular expression of the rule to get them.
+ */
+
+
+#ifndef DFA_H
+#define DFA_H
+
+#include "pattern.h"
+
+/* BEGIN_C_DECLS should be used at the beginning of C declarations,
+   so that C++ compilers don't mangle their names.  Use END_C_DECLS at
+   the end of C declarations. */
+#undef BEGIN_C_DECLS
+#undef END_C_DECLS
+#ifdef __cplusplus
+# define BEGIN_C_DECLS extern "C" {
+# define END_C_DECLS }
+#else
+# define BEGIN_C_DECLS /* empty */
+# define END_C_DECLS /* empty */
+#endif
+
+BEGIN_C_DECLS
+
+/* Return codes of dfa_search() */
+#define DFA_NOMATCH -1
+#define DFA_FAILURE -2
+
+typedef struct RULEX_DFA RULEX_DFA;
+
+
+extern RULEX_DFA *dfa_create(void);
+/*
+ * Allocate new empty automaton.
+ * Returns NULL when memory allocation fails.
+ */
+
+extern int dfa_add(RULEX_DFA *dfa, const PATTERN *pattern, int n);
+/*
+ * Add parsed pattern to the automaton as rule number n.
+ * Rules may be added in any order, but each number
+ * must be used only once.
+ *
+ * Returns 0 on success or -1 when memory allocation fails.
+ */
+
+extern RULEX_DFA *dfa_clone(const RULEX_DFA *dfa);
+/*
+ * Create new automaton sharing the rules with specified one,
+ * but having its own deterministic states cache, so both
+ * can be searched in parallel threads. No rules can be added
+ * to the clone. The original automaton must not be modified
+ * or freed while the clone is in use.
+ *
+ * Returns NULL when memory allocation fails.
+ */
+
+extern int dfa_contains(const RULEX_DFA *dfa, int n);
+/*
+ * Check whether rule number n was added to the automaton.
+ */
+
+extern int dfa_search(RULEX_DFA *dfa, const char *s);
+/*
+ * Find the lowest numbered rule matching string s.
+ *
+ * Returns the rule number, DFA_NOMATCH when no rule matches
+ * or DFA_FAILURE when memory allocation fails.
+ */
+
+extern int dfa_group_end(RULEX_DFA *dfa, int n, const char *s);
+/*
+ * Find the end offset of the first parenthesized subexpression
+ * of rule number n in its match of string s as regexec() reports it.
+ * The subexpression is tracked only when it is preceded
+ * by the anchors only in the pattern.
+ *
+ * Returns the offset, DFA_NOMATCH when the rule does not match
+ * or DFA_FAILURE when the subexpression is not tracked
+ * or memory allocation fails.
+ */
+
+extern int dfa_overlap(const PATTERN *a, const PATTERN *b);
+/*
+ * Check whether some string is matched by both patterns.
+ *
+ * Returns 1 if such a string exists, 0 if there is no one
+ * or DFA_FAILURE when memory allocation fails or the check
+ * appears too complex.
+ */
+
+extern void dfa_free(RULEX_DFA *dfa);
+/*
+ * Free all memory allocated for the automaton.
+ */
+
+END_C_DECLS
+
+#endif
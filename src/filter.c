@@ -0,0 +1,204 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ * Dictionary keys membership filter implementation.
+ *
+ * The image begins with the header followed by the blocks of bits.
+ * The key hash value chooses the block and the positions
+ * of the bits within it. With 12 bits per key and 8 bits
+ * set for every key less than one percent of the absent keys
+ * pass the filter.
+ */
+
+
+#include <stdint.h>
+#include <string.h>
+#include "filter.h"
+
+
+/* Local constants */
+
+/* Filter image format stamp */
+#define FILTER_MAGIC 0x52554c46
+#define FILTER_VERSION 3
+
+/* Block size in bytes */
+#define FILTER_BLOCK 64
+
+/* Number of bits per key */
+#define FILTER_BITS_PER_KEY 12
+
+/* Number of bits set for every key */
+#define FILTER_PROBES 8
+
+
+/* Data structures */
+
+typedef struct /* Filter image header */
+{
+  uint32_t magic; /* FILTER_MAGIC */
+  uint32_t version; /* FILTER_VERSION */
+  uint32_t nblocks; /* Number of the blocks */
+  uint32_t nkeys; /* Number of keys the filter was built for */
+  uint32_t source; /* Generation of the dictionary it was built for */
+  uint32_t reserved;
+} HEADER;
+
+
+/* Local routines */
+
+static uint64_t hash(const void *key, size_t len)
+     /*
+      * Compute 64-bit hash value of the key.
+      */
+{
+  const unsigned char *s = key;
+  uint64_t h = 14695981039346656037ULL;
+  size_t i;
+
+  for (i = 0; i < len; i++)
+    h = (h ^ s[i]) * 1099511628211ULL;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+static void header_get(const void *image, HEADER *header)
+     /*
+      * Fetch the header from possibly misaligned image.
+      */
+{
+  (void)memcpy(header, image, sizeof(HEADER));
+}
+
+
+/* Global routines */
+
+size_t filter_size(unsigned int nkeys)
+     /*
+      * Get the image size needed for the filter of nkeys keys.
+      */
+{
+  size_t nblocks = ((size_t)nkeys * FILTER_BITS_PER_KEY
+                    + FILTER_BLOCK * 8 - 1) / (FILTER_BLOCK * 8);
+
+  if (!nblocks)
+    nblocks = 1;
+  return sizeof(HEADER) + nblocks * FILTER_BLOCK;
+}
+
+void filter_init(void *image, size_t size, unsigned int nkeys,
+                 unsigned int source)
+     /*
+      * Initialize empty filter in the memory area of specified size.
+      */
+{
+  HEADER header;
+
+  header.magic = FILTER_MAGIC;
+  header.version = FILTER_VERSION;
+  header.nblocks = (size - sizeof(HEADER)) / FILTER_BLOCK;
+  header.nkeys = nkeys;
+  header.source = source;
+  header.reserved = 0;
+  (void)memset(image, 0, size);
+  (void)memcpy(image, &header, sizeof(HEADER));
+}
+
+void filter_add(void *image, const void *key, size_t len)
+     /*
+      * Add the key of len bytes to the filter.
+      */
+{
+  HEADER header;
+  uint64_t h = hash(key, len);
+  unsigned char *block;
+  unsigned int i, a, b;
+
+  header_get(image, &header);
+  block = (unsigned char *)image + sizeof(HEADER)
+    + (size_t)((h >> 32) % header.nblocks) * FILTER_BLOCK;
+  a = (unsigned int)h;
+  b = ((unsigned int)h >> 9) | 1;
+  for (i = 0; i < FILTER_PROBES; i++, a += b)
+    block[(a >> 3) & (FILTER_BLOCK - 1)] |= 1 << (a & 7);
+}
+
+int filter_valid(const void *image, size_t size)
+     /*
+      * Check the format of the filter image of specified size.
+      */
+{
+  HEADER header;
+
+  if ((!image) || (size < sizeof(HEADER)))
+    return 0;
+  header_get(image, &header);
+  return (header.magic == FILTER_MAGIC) &&
+    (header.version == FILTER_VERSION) && header.nblocks &&
+    ((size - sizeof(HEADER)) / FILTER_BLOCK == header.nblocks);
+}
+
+unsigned int filter_keys(const void *image)
+     /*
+      * Get the number of keys stored in the filter image.
+      */
+{
+  HEADER header;
+
+  header_get(image, &header);
+  return header.nkeys;
+}
+
+unsigned int filter_source(const void *image)
+     /*
+      * Get the dictionary generation stamped in the filter image.
+      */
+{
+  HEADER header;
+
+  header_get(image, &header);
+  return header.source;
+}
+
+int filter_check(const void *image, const void *key, size_t len)
+     /*
+      * Check whether the key of len bytes may be present.
+      */
+{
+  HEADER header;
+  uint64_t h = hash(key, len);
+  const unsigned char *block;
+  unsigned int i, a, b;
+
+  header_get(image, &header);
+  block = (const unsigned char *)image + sizeof(HEADER)
+    + (size_t)((h >> 32) % header.nblocks) * FILTER_BLOCK;
+  a = (unsigned int)h;
+  b = ((unsigned int)h >> 9) | 1;
+  for (i = 0; i < FILTER_PROBES; i++, a += b)
+    if (!(block[(a >> 3) & (FILTER_BLOCK - 1)] & (1 << (a & 7))))
+      return 0;
+  return 1;
+}
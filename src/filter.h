@@ -0,0 +1,103 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ * Dictionary keys membership filter.
+ *
+ * Most of the searched words are absent in the dictionaries,
+ * but each miss costs a full tree descent. The filter is a compact
+ * summary of all the dictionary keys stored in the database along
+ * with it. When the filter says a key is absent, it is absent
+ * for sure, so the tree is not touched at all. Present keys
+ * and a small share of the absent ones pass the filter.
+ *
+ * The filter is a blocked Bloom filter: all the bits of a key fall
+ * into the same block of one cache line. The image is a plain byte
+ * array which can be stored and used in place without decoding.
+ */
+
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stddef.h>
+
+/* BEGIN_C_DECLS should be used at the beginning of C declarations,
+   so that C++ compilers don't mangle their names.  Use END_C_DECLS at
+   the end of C declarations. */
+#undef BEGIN_C_DECLS
+#undef END_C_DECLS
+#ifdef __cplusplus
+# define BEGIN_C_DECLS extern "C" {
+# define END_C_DECLS }
+#else
+# define BEGIN_C_DECLS /* empty */
+# define END_C_DECLS /* empty */
+#endif
+
+BEGIN_C_DECLS
+
+
+extern size_t filter_size(unsigned int nkeys);
+/*
+ * Get the image size needed for the filter of nkeys keys.
+ */
+
+extern void filter_init(void *image, size_t size, unsigned int nkeys,
+                        unsigned int source);
+/*
+ * Initialize empty filter in the memory area of specified size
+ * obtained by filter_size(). The number of keys and the generation
+ * (modification counter) of the source dictionary are stored
+ * in the image to check its consistency later.
+ */
+
+extern void filter_add(void *image, const void *key, size_t len);
+/*
+ * Add the key of len bytes to the filter.
+ */
+
+extern int filter_valid(const void *image, size_t size);
+/*
+ * Check the format of the filter image of specified size.
+ * Returns 1 if it can be used or 0 otherwise.
+ */
+
+extern unsigned int filter_keys(const void *image);
+/*
+ * Get the number of keys stored in the filter image.
+ */
+
+extern unsigned int filter_source(const void *image);
+/*
+ * Get the generation of the source dictionary
+ * stamped in the filter image.
+ */
+
+extern int filter_check(const void *image, const void *key, size_t len);
+/*
+ * Check whether the key of len bytes may be present.
+ * Returns 0 if the key was not added to the filter for sure
+ * or 1 otherwise.
+ */
+
+END_C_DECLS
+
+#endif
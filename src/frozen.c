@@ -0,0 +1,250 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Frozen search results table implementation.
+ *
+ * The image begins with the header followed by the slots array
+ * and the text area. Every slot holds the word hash value
+ * and the offset of its entry in the text area, zero offset
+ * marking an empty slot. The entry consists of the return code
+ * byte followed by the word and its result as zero terminated
+ * strings. Collisions are resolved by linear probing and
+ * the slots are never more than half filled.
+ */
+
+
+#include <stdint.h>
+#include <string.h>
+#include "frozen.h"
+
+
+/* Local constants */
+
+/* Table image format stamp */
+#define FROZEN_MAGIC 0x52554c5a
+#define FROZEN_VERSION 3
+
+
+/* Data structures */
+
+typedef struct /* Table image header */
+{
+  uint32_t magic; /* FROZEN_MAGIC */
+  uint32_t version; /* FROZEN_VERSION */
+  uint32_t nslots; /* Number of the slots (a power of two) */
+  uint32_t nwords; /* Number of the stored words */
+  uint32_t text_size; /* Size of the text area */
+  uint32_t text_used; /* Used part of the text area */
+  uint32_t source; /* Generation of the data the table is built for */
+  uint32_t reserved;
+} HEADER;
+
+typedef struct /* Hash table slot */
+{
+  uint32_t hash; /* Hash value of the word */
+  uint32_t offset; /* Entry offset in the text area */
+} SLOT;
+
+
+/* Local routines */
+
+static uint32_t hash(const char *key)
+     /*
+      * Compute FNV-1a hash value of the word.
+      */
+{
+  uint32_t h = 2166136261U;
+
+  while (*key)
+    h = (h ^ (unsigned char)*key++) * 16777619U;
+  return h;
+}
+
+static void header_get(const void *image, HEADER *header)
+     /*
+      * Fetch the header from possibly misaligned image.
+      */
+{
+  (void)memcpy(header, image, sizeof(HEADER));
+}
+
+static unsigned char *slot_ptr(const void *image, uint32_t n)
+     /*
+      * Get pointer to the slot number n.
+      */
+{
+  return (unsigned char *)image + sizeof(HEADER) + (size_t)n * sizeof(SLOT);
+}
+
+static int lookup(const void *image, const HEADER *header,
+                  const char *key, uint32_t h, SLOT *slot)
+     /*
+      * Find the slot for the word key having hash value h.
+      * The slot contents is placed in the location pointed by slot.
+      * Returns the slot number where the word is stored
+      * or the empty slot where it could be placed.
+      */
+{
+  const char *text = (const char *)slot_ptr(image, header->nslots);
+  uint32_t mask = header->nslots - 1;
+  uint32_t n = h & mask;
+
+  for (;;)
+    {
+      (void)memcpy(slot, slot_ptr(image, n), sizeof(SLOT));
+      if ((!slot->offset) ||
+          ((slot->hash == h) && !strcmp(text + slot->offset + 1, key)))
+        return n;
+      n = (n + 1) & mask;
+    }
+}
+
+
+/* Global routines */
+
+size_t frozen_size(unsigned int nwords, size_t text)
+     /*
+      * Get the image size needed for the table of nwords words.
+      * Every entry takes the return code byte and two string
+      * terminators besides the text itself.
+      */
+{
+  size_t nslots = 2;
+
+  while (nslots < 2 * (size_t)nwords)
+    nslots <<= 1;
+  return sizeof(HEADER) + nslots * sizeof(SLOT)
+    + text + 3 * (size_t)nwords + 1;
+}
+
+void frozen_init(void *image, size_t size, unsigned int nwords,
+                 unsigned int source)
+     /*
+      * Initialize empty table in the memory area of specified size.
+      */
+{
+  HEADER header;
+  size_t nslots = 2;
+
+  while (nslots < 2 * (size_t)nwords)
+    nslots <<= 1;
+  header.magic = FROZEN_MAGIC;
+  header.version = FROZEN_VERSION;
+  header.nslots = nslots;
+  header.nwords = 0;
+  header.text_size = size - sizeof(HEADER) - nslots * sizeof(SLOT);
+  header.text_used = 1; /* Zero offset is reserved */
+  header.source = source;
+  header.reserved = 0;
+  (void)memset(image, 0, size);
+  (void)memcpy(image, &header, sizeof(HEADER));
+}
+
+int frozen_add(void *image, const char *key, const char *value, int rc)
+     /*
+      * Store the search result for the word.
+      */
+{
+  HEADER header;
+  SLOT slot;
+  uint32_t h = hash(key), n;
+  size_t klen = strlen(key) + 1, vlen = strlen(value) + 1;
+  char *text;
+
+  header_get(image, &header);
+  n = lookup(image, &header, key, h, &slot);
+  if (slot.offset)
+    return 0;
+  if ((header.nwords >= header.nslots / 2) ||
+      (header.text_used + 1 + klen + vlen > header.text_size))
+    return -1;
+  text = (char *)slot_ptr(image, header.nslots) + header.text_used;
+  *text = (char)rc;
+  (void)memcpy(text + 1, key, klen);
+  (void)memcpy(text + 1 + klen, value, vlen);
+  slot.hash = h;
+  slot.offset = header.text_used;
+  (void)memcpy(slot_ptr(image, n), &slot, sizeof(SLOT));
+  header.text_used += 1 + klen + vlen;
+  header.nwords++;
+  (void)memcpy(image, &header, sizeof(HEADER));
+  return 1;
+}
+
+int frozen_valid(const void *image, size_t size)
+     /*
+      * Check the format of the table image of specified size.
+      */
+{
+  HEADER header;
+
+  if ((!image) || (size < sizeof(HEADER)))
+    return 0;
+  header_get(image, &header);
+  return (header.magic == FROZEN_MAGIC) &&
+    (header.version == FROZEN_VERSION) && (header.nslots >= 2) &&
+    !(header.nslots & (header.nslots - 1)) &&
+    (header.nwords < header.nslots) &&
+    ((size - sizeof(HEADER)) / sizeof(SLOT) >= header.nslots) &&
+    (size - sizeof(HEADER) - (size_t)header.nslots * sizeof(SLOT)
+     == header.text_size) &&
+    (header.text_used <= header.text_size);
+}
+
+unsigned int frozen_words(const void *image)
+     /*
+      * Get the number of words stored in the table image.
+      */
+{
+  HEADER header;
+
+  header_get(image, &header);
+  return header.nwords;
+}
+
+unsigned int frozen_source(const void *image)
+     /*
+      * Get the source data generation stamped in the table image.
+      */
+{
+  HEADER header;
+
+  header_get(image, &header);
+  return header.source;
+}
+
+int frozen_get(const void *image, const char *key, char *value, int *rc)
+     /*
+      * Look up the word in the table.
+      */
+{
+  HEADER header;
+  SLOT slot;
+  const char *entry;
+
+  header_get(image, &header);
+  (void)lookup(image, &header, key, hash(key), &slot);
+  if (!slot.offset)
+    return 0;
+  entry = (const char *)slot_ptr(image, header.nslots) + slot.offset;
+  *rc = (signed char)entry[0];
+  (void)strcpy(value, entry + strlen(entry + 1) + 2);
+  return 1;
+}
@@ -0,0 +1,107 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Frozen search results table.
+ *
+ * A database that is never edited in production gives the same
+ * search result for a word every time, so the results for all
+ * the words of interest can be computed once and stored along
+ * with the database. The table maps the words to their full search
+ * results and return codes, so the typical lookup is a single
+ * hash probe instead of the dictionaries and rules walk.
+ *
+ * The table is an open addressing hash with the strings kept
+ * in the same image, so it can be stored and used in place
+ * without decoding.
+ */
+
+
+#ifndef FROZEN_H
+#define FROZEN_H
+
+#include <stddef.h>
+
+/* BEGIN_C_DECLS should be used at the beginning of C declarations,
+   so that C++ compilers don't mangle their names.  Use END_C_DECLS at
+   the end of C declarations. */
+#undef BEGIN_C_DECLS
+#undef END_C_DECLS
+#ifdef __cplusplus
+# define BEGIN_C_DECLS extern "C" {
+# define END_C_DECLS }
+#else
+# define BEGIN_C_DECLS /* empty */
+# define END_C_DECLS /* empty */
+#endif
+
+BEGIN_C_DECLS
+
+
+extern size_t frozen_size(unsigned int nwords, size_t text);
+/*
+ * Get the image size needed for the table of nwords words
+ * where text is the total length of the words and their results.
+ */
+
+extern void frozen_init(void *image, size_t size, unsigned int nwords,
+                        unsigned int source);
+/*
+ * Initialize empty table in the memory area of specified size
+ * obtained by frozen_size(). The generation of the dictionaries
+ * and rules the results are computed from is stored
+ * in the image to check its consistency later.
+ */
+
+extern int frozen_add(void *image, const char *key, const char *value, int rc);
+/*
+ * Store the search result value and return code rc for the word key.
+ * Returns 1 when the word is added, 0 if it is already there
+ * or -1 if there is no room for it.
+ */
+
+extern int frozen_valid(const void *image, size_t size);
+/*
+ * Check the format of the table image of specified size.
+ * Returns 1 if it can be used or 0 otherwise.
+ */
+
+extern unsigned int frozen_words(const void *image);
+/*
+ * Get the number of words stored in the table image.
+ */
+
+extern unsigned int frozen_source(const void *image);
+/*
+ * Get the generation of the dictionaries and rules
+ * stamped in the table image.
+ */
+
+extern int frozen_get(const void *image, const char *key,
+                      char *value, int *rc);
+/*
+ * Look up the word key in the table. If found, its search result
+ * is copied to the value buffer and the return code is placed
+ * in the location pointed by rc.
+ * Returns 1 if the word is found or 0 otherwise.
+ */
+
+END_C_DECLS
+
+#endif
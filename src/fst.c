@@ -0,0 +1,996 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Dictionary transducer implementation.
+ *
+ * The minimal transducer is built by the incremental algorithm
+ * for sorted input: the path of the last added word is kept
+ * unfinished, and when the next word departs from it, the states
+ * left behind are replaced by the equivalent ones registered
+ * before or registered themselves. So only the states
+ * of the resulting transducer are ever stored.
+ *
+ * The image begins with the header followed by the characters
+ * order table, the hubs table, the encoded states, the value numbers
+ * of the words in the order of their ranks packed at the minimal
+ * bit width, the values offsets and the values data.
+ *
+ * The states are laid out in the order of their registration,
+ * so every transition leads backwards, and a state is referred to
+ * by the offset of its encoding. A state is encoded as the number
+ * of its transitions doubled plus its final flag, followed by
+ * the transitions sorted by their labels in the characters order.
+ * A transition is encoded as its label and its reference doubled
+ * plus the flag of the single word in its subtree, followed by
+ * the number of words in the subtree unless the flag is set.
+ * The reference is either the number of the target in the hubs table
+ * holding the offsets of the states most often led to, or the hubs
+ * number plus the distance back to the target less one. All the numbers
+ * are stored in the variable length form by 7 bits per byte, lowest
+ * first, with the high bit set in all bytes but the last one.
+ * The chains of states registered one after another lie just behind
+ * their parents and the common endings mostly go to the hubs, so
+ * a transition usually takes two to four bytes. The word ending
+ * in a state goes after the words in all its subtrees.
+ */
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fst.h"
+
+
+/* Local constants */
+
+/* Transducer image format stamp */
+#define FST_MAGIC 0x52554c54
+#define FST_VERSION 4
+
+/* Characters order table size */
+#define FST_ORDER_SIZE 256
+
+/* Maximum number of hubs */
+#define FST_HUBS 32
+
+/* Maximum number of states addressed by the transitions */
+#define FST_MAX_STATES 0x1000000
+
+/* Initial size of the builder arrays (a power of two) */
+#define BUILDER_CHUNK 1024
+
+
+/* Data structures */
+
+typedef struct /* Transducer image header */
+{
+  uint32_t magic; /* FST_MAGIC */
+  uint32_t version; /* FST_VERSION */
+  uint32_t nstates; /* Number of states */
+  uint32_t ntrans; /* Number of transitions */
+  uint32_t nhubs; /* Number of hubs */
+  uint32_t states_size; /* Encoded states size */
+  uint32_t root; /* Initial state offset */
+  uint32_t nwords; /* Number of words */
+  uint32_t nvalues; /* Number of distinct values */
+  uint32_t bits; /* Bits per value number */
+  uint32_t values_size; /* Values data size */
+  uint32_t source; /* Generation of the source dictionary */
+} HEADER;
+
+typedef struct /* Transducer image layout */
+{
+  HEADER header;
+  const unsigned char *order; /* Characters positions in the order */
+  const unsigned char *hubs; /* Offsets of the hub states */
+  const unsigned char *states; /* Encoded states */
+  const unsigned char *ids; /* Value numbers of the words */
+  const unsigned char *offsets; /* Values offsets */
+  const unsigned char *values; /* Values data */
+} LAYOUT;
+
+typedef struct /* Decoded transition */
+{
+  unsigned char label;
+  uint32_t words; /* Number of words in the subtree */
+  uint32_t target; /* Target state offset */
+} ARC;
+
+typedef struct /* Unfinished state on the path of the last word */
+{
+  int final;
+  unsigned int n; /* Number of transitions */
+  unsigned char label[256];
+  uint32_t target[256];
+} PATH_STATE;
+
+typedef struct /* Transducer under construction */
+{
+  uint32_t *first; /* First transitions of the registered states */
+  unsigned char *final; /* Their final flags */
+  uint32_t *words; /* Numbers of words accepted from them */
+  unsigned int nstates, states_size;
+  unsigned char *label; /* Transitions labels */
+  uint32_t *target; /* Transitions targets */
+  unsigned int ntrans, trans_size;
+  uint32_t *registry; /* Hash table of state numbers + 1 */
+  unsigned int registry_size;
+  PATH_STATE *path; /* Path of the last word */
+  unsigned int path_size, len;
+  const unsigned char *order; /* Characters order */
+  unsigned char *hub; /* Hub numbers of the states plus one or 0 */
+  uint32_t hubs[FST_HUBS]; /* Hub states */
+  unsigned int nhubs;
+} BUILDER;
+
+
+/* Local routines */
+
+static uint32_t get32(const unsigned char *p)
+     /*
+      * Fetch 32-bit value from possibly misaligned location.
+      */
+{
+  uint32_t v;
+
+  (void)memcpy(&v, p, sizeof(uint32_t));
+  return v;
+}
+
+static void put32(unsigned char *p, uint32_t v)
+     /*
+      * Store 32-bit value into possibly misaligned location.
+      */
+{
+  (void)memcpy(p, &v, sizeof(uint32_t));
+}
+
+static unsigned int varint_put(unsigned char *p, uint32_t v)
+     /*
+      * Store the number in the variable length form unless p is NULL.
+      *
+      * Returns the number of bytes taken.
+      */
+{
+  unsigned int n;
+
+  for (n = 1; v > 0x7f; n++, v >>= 7)
+    if (p)
+      *p++ = (unsigned char)(v | 0x80);
+  if (p)
+    *p = (unsigned char)v;
+  return n;
+}
+
+static uint32_t varint_get(const unsigned char **p)
+     /*
+      * Fetch the number stored in the variable length form
+      * and advance the pointer beyond it.
+      */
+{
+  const unsigned char *s = *p;
+  uint32_t v = 0;
+  unsigned int shift = 0;
+  unsigned char c;
+
+  do
+    {
+      c = *s++;
+      v |= (uint32_t)(c & 0x7f) << shift;
+      shift += 7;
+    }
+  while (c & 0x80);
+  *p = s;
+  return v;
+}
+
+static int varint_check(const unsigned char **p, const unsigned char *end,
+                        uint32_t *v)
+     /*
+      * Fetch the number stored in the variable length form
+      * checking that it fits in 32 bits and ends before end.
+      *
+      * Returns 1 on success or 0 otherwise.
+      */
+{
+  const unsigned char *s = *p;
+  unsigned int n;
+
+  for (n = 1; (s + n <= end) && (s[n - 1] & 0x80); n++)
+    if (n >= 5)
+      return 0;
+  if ((s + n > end) || ((n == 5) && (s[4] > 0x0f)))
+    return 0;
+  *v = varint_get(p);
+  return 1;
+}
+
+static uint64_t mix(uint64_t h)
+     /*
+      * Finalize 64-bit hash value.
+      */
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+static uint64_t hash(const void *data, size_t len)
+     /*
+      * Compute 64-bit hash value of the data.
+      */
+{
+  const unsigned char *s = data;
+  uint64_t h = 14695981039346656037ULL;
+  size_t i;
+
+  for (i = 0; i < len; i++)
+    h = (h ^ s[i]) * 1099511628211ULL;
+  return mix(h);
+}
+
+static uint64_t state_hash(const PATH_STATE *state)
+     /*
+      * Compute hash value of the state by its finality
+      * and transitions.
+      */
+{
+  uint64_t h = state->final ? 1099511628211ULL : 14695981039346656037ULL;
+  unsigned int i;
+
+  for (i = 0; i < state->n; i++)
+    h = (h ^ ((uint64_t)state->target[i] << 8 | state->label[i]))
+      * 1099511628211ULL;
+  return mix(h);
+}
+
+static int state_equal(const BUILDER *builder, uint32_t k,
+                       const PATH_STATE *state)
+     /*
+      * Check whether the registered state k is equivalent
+      * to the unfinished one.
+      */
+{
+  unsigned int first = builder->first[k];
+  unsigned int next = (k + 1 < builder->nstates) ?
+    builder->first[k + 1] : builder->ntrans;
+
+  return (builder->final[k] == (state->final ? 1 : 0)) &&
+    (next - first == state->n) &&
+    !memcmp(builder->label + first, state->label, state->n) &&
+    !memcmp(builder->target + first, state->target,
+            state->n * sizeof(uint32_t));
+}
+
+static int registry_grow(BUILDER *builder)
+     /*
+      * Double the registry hash table size.
+      */
+{
+  uint32_t *registry;
+  unsigned int i, k, mask, size = builder->registry_size * 2;
+
+  registry = calloc(size, sizeof(uint32_t));
+  if (!registry) return -1;
+  mask = size - 1;
+  for (k = 0; k < builder->nstates; k++)
+    {
+      PATH_STATE state;
+      unsigned int first = builder->first[k];
+      unsigned int next = (k + 1 < builder->nstates) ?
+        builder->first[k + 1] : builder->ntrans;
+
+      state.final = builder->final[k];
+      state.n = next - first;
+      (void)memcpy(state.label, builder->label + first, state.n);
+      (void)memcpy(state.target, builder->target + first,
+                   state.n * sizeof(uint32_t));
+      for (i = state_hash(&state) & mask; registry[i]; i = (i + 1) & mask);
+      registry[i] = k + 1;
+    }
+  free(builder->registry);
+  builder->registry = registry;
+  builder->registry_size = size;
+  return 0;
+}
+
+static int state_register(BUILDER *builder, const PATH_STATE *state,
+                          uint32_t *id)
+     /*
+      * Find the registered state equivalent to the unfinished one
+      * or register it. The state number is placed in the location
+      * pointed by id.
+      *
+      * Returns 0 on success or -1 on failure.
+      */
+{
+  unsigned int i, j, mask;
+  void *p;
+
+  mask = builder->registry_size - 1;
+  for (i = state_hash(state) & mask; builder->registry[i];
+       i = (i + 1) & mask)
+    if (state_equal(builder, builder->registry[i] - 1, state))
+      {
+        *id = builder->registry[i] - 1;
+        return 0;
+      }
+
+  /* New state */
+  if (builder->nstates >= FST_MAX_STATES)
+    return -1;
+  if (builder->nstates == builder->states_size)
+    {
+      builder->states_size *= 2;
+      p = realloc(builder->first, builder->states_size * sizeof(uint32_t));
+      if (!p) return -1;
+      builder->first = p;
+      p = realloc(builder->final, builder->states_size);
+      if (!p) return -1;
+      builder->final = p;
+      p = realloc(builder->words, builder->states_size * sizeof(uint32_t));
+      if (!p) return -1;
+      builder->words = p;
+    }
+  while (builder->ntrans + state->n > builder->trans_size)
+    {
+      builder->trans_size *= 2;
+      p = realloc(builder->label, builder->trans_size);
+      if (!p) return -1;
+      builder->label = p;
+      p = realloc(builder->target, builder->trans_size * sizeof(uint32_t));
+      if (!p) return -1;
+      builder->target = p;
+    }
+  *id = builder->nstates++;
+  builder->first[*id] = builder->ntrans;
+  builder->final[*id] = state->final ? 1 : 0;
+  builder->words[*id] = builder->final[*id];
+  for (j = 0; j < state->n; j++)
+    builder->words[*id] += builder->words[state->target[j]];
+  (void)memcpy(builder->label + builder->ntrans, state->label, state->n);
+  (void)memcpy(builder->target + builder->ntrans, state->target,
+               state->n * sizeof(uint32_t));
+  builder->ntrans += state->n;
+  builder->registry[i] = *id + 1;
+  if (builder->nstates * 2 > builder->registry_size)
+    return registry_grow(builder);
+  return 0;
+}
+
+static int path_finish(BUILDER *builder, unsigned int len)
+     /*
+      * Finish the states of the last word path beyond len characters
+      * replacing them by the registered ones.
+      */
+{
+  PATH_STATE *parent;
+
+  for (; builder->len > len; builder->len--)
+    {
+      parent = &builder->path[builder->len - 1];
+      if (state_register(builder, &builder->path[builder->len],
+                         &parent->target[parent->n - 1]))
+        return -1;
+    }
+  return 0;
+}
+
+static int builder_add(BUILDER *builder, const char *word,
+                       const char *previous)
+     /*
+      * Add the word following the previous one to the transducer.
+      */
+{
+  unsigned int i, common, len = strlen(word);
+  PATH_STATE *state;
+  void *p;
+
+  for (common = 0; previous && (common < builder->len) &&
+         (word[common] == previous[common]); common++);
+  if (previous && (fst_compare(builder->order, previous, word) >= 0))
+    return -1;
+  for (i = common; i < len; i++)
+    if (!builder->order[(unsigned char)word[i]])
+      return -1;
+  if (path_finish(builder, common))
+    return -1;
+  if (len >= builder->path_size)
+    {
+      p = realloc(builder->path, (len + 1) * sizeof(PATH_STATE));
+      if (!p) return -1;
+      builder->path = p;
+      builder->path_size = len + 1;
+    }
+  for (i = common; i < len; i++)
+    {
+      state = &builder->path[i];
+      state->label[state->n] = (unsigned char)word[i];
+      state->target[state->n] = 0;
+      state->n++;
+      builder->path[i + 1].final = 0;
+      builder->path[i + 1].n = 0;
+    }
+  builder->path[len].final = 1;
+  builder->len = len;
+  return 0;
+}
+
+static void builder_free(BUILDER *builder)
+     /*
+      * Release memory used by the builder.
+      */
+{
+  free(builder->first);
+  free(builder->final);
+  free(builder->words);
+  free(builder->label);
+  free(builder->target);
+  free(builder->registry);
+  free(builder->path);
+  free(builder->hub);
+}
+
+static int builder_init(BUILDER *builder)
+     /*
+      * Prepare empty transducer for construction.
+      */
+{
+  (void)memset(builder, 0, sizeof(BUILDER));
+  builder->states_size = BUILDER_CHUNK;
+  builder->trans_size = BUILDER_CHUNK;
+  builder->registry_size = BUILDER_CHUNK * 2;
+  builder->path_size = 1;
+  builder->first = malloc(builder->states_size * sizeof(uint32_t));
+  builder->final = malloc(builder->states_size);
+  builder->words = malloc(builder->states_size * sizeof(uint32_t));
+  builder->label = malloc(builder->trans_size);
+  builder->target = malloc(builder->trans_size * sizeof(uint32_t));
+  builder->registry = calloc(builder->registry_size, sizeof(uint32_t));
+  builder->path = malloc(sizeof(PATH_STATE));
+  if (!(builder->first && builder->final && builder->words &&
+        builder->label && builder->target && builder->registry &&
+        builder->path))
+    {
+      builder_free(builder);
+      return -1;
+    }
+  builder->path[0].final = 0;
+  builder->path[0].n = 0;
+  return 0;
+}
+
+static int hubs_choose(BUILDER *builder)
+     /*
+      * Choose the states most often led to as the hubs.
+      */
+{
+  uint32_t *refs;
+  unsigned int i, k, best;
+
+  refs = calloc(builder->nstates, sizeof(uint32_t));
+  builder->hub = calloc(builder->nstates, 1);
+  if (!(refs && builder->hub))
+    {
+      free(refs);
+      return -1;
+    }
+  for (i = 0; i < builder->ntrans; i++)
+    refs[builder->target[i]]++;
+  for (builder->nhubs = 0; builder->nhubs < FST_HUBS; builder->nhubs++)
+    {
+      for (k = 0, best = 0; k < builder->nstates; k++)
+        if ((!builder->hub[k]) &&
+            ((refs[k] > refs[best]) || builder->hub[best]))
+          best = k;
+      if (builder->hub[best] || (refs[best] < 2))
+        break;
+      builder->hubs[builder->nhubs] = best;
+      builder->hub[best] = builder->nhubs + 1;
+    }
+  free(refs);
+  return 0;
+}
+
+static size_t state_encode(const BUILDER *builder, uint32_t k,
+                           const uint32_t *offsets, unsigned char *p)
+     /*
+      * Encode the registered state k at p unless p is NULL.
+      * The offsets of the states up to k are given.
+      *
+      * Returns the encoding size.
+      */
+{
+  unsigned int i, next = (k + 1 < builder->nstates) ?
+    builder->first[k + 1] : builder->ntrans;
+  uint32_t ref, words;
+  size_t n;
+
+  n = varint_put(p, (next - builder->first[k]) << 1 | builder->final[k]);
+  for (i = builder->first[k]; i < next; i++)
+    {
+      if (p)
+        p[n] = builder->label[i];
+      n++;
+      ref = builder->hub[builder->target[i]] ?
+        builder->hub[builder->target[i]] - 1U :
+        builder->nhubs + offsets[k] - offsets[builder->target[i]] - 1;
+      words = builder->words[builder->target[i]];
+      n += varint_put(p ? p + n : NULL, ref << 1 | (words == 1));
+      if (words != 1)
+        n += varint_put(p ? p + n : NULL, words);
+    }
+  return n;
+}
+
+static size_t id_offset(const HEADER *header)
+     /*
+      * Get the offset of the value numbers in the image.
+      */
+{
+  return sizeof(HEADER) + FST_ORDER_SIZE
+    + (size_t)header->nhubs * sizeof(uint32_t) + header->states_size;
+}
+
+static size_t offsets_offset(const HEADER *header)
+     /*
+      * Get the offset of the values offsets in the image.
+      */
+{
+  size_t ids_size = ((uint64_t)header->nwords * header->bits + 7) / 8;
+
+  return id_offset(header) + ((ids_size + 3) & ~(size_t)3);
+}
+
+static size_t image_size(const HEADER *header)
+     /*
+      * Get the image size by its header.
+      */
+{
+  return offsets_offset(header)
+    + ((size_t)header->nvalues + 1) * sizeof(uint32_t)
+    + header->values_size;
+}
+
+static void layout_get(const void *image, LAYOUT *layout)
+     /*
+      * Locate the parts of the image.
+      */
+{
+  const unsigned char *p = image;
+
+  (void)memcpy(&layout->header, image, sizeof(HEADER));
+  layout->order = p + sizeof(HEADER);
+  layout->hubs = layout->order + FST_ORDER_SIZE;
+  layout->states = layout->hubs
+    + (size_t)layout->header.nhubs * sizeof(uint32_t);
+  layout->ids = p + id_offset(&layout->header);
+  layout->offsets = p + offsets_offset(&layout->header);
+  layout->values = layout->offsets
+    + ((size_t)layout->header.nvalues + 1) * sizeof(uint32_t);
+}
+
+static uint32_t value_id(const LAYOUT *layout, uint32_t rank)
+     /*
+      * Get the value number of the word.
+      */
+{
+  uint64_t bit = (uint64_t)rank * layout->header.bits, id = 0;
+  const unsigned char *p = layout->ids + (size_t)(bit / 8);
+  unsigned int i, shift = (unsigned int)(bit % 8);
+
+  for (i = 0; i * 8 < shift + layout->header.bits; i++)
+    id |= (uint64_t)p[i] << (i * 8);
+  return (uint32_t)((id >> shift) &
+                    (((uint64_t)1 << layout->header.bits) - 1));
+}
+
+static void value_get(const LAYOUT *layout, uint32_t rank,
+                      const char **value, unsigned int *size)
+     /*
+      * Get the value of the word.
+      */
+{
+  uint32_t id = value_id(layout, rank);
+  uint32_t offset = get32(layout->offsets + id * sizeof(uint32_t));
+
+  *value = (const char *)layout->values + offset;
+  *size = get32(layout->offsets + (id + 1) * sizeof(uint32_t)) - offset;
+}
+
+static const unsigned char *arc_get(const LAYOUT *layout,
+                                    const unsigned char *p, uint32_t state,
+                                    ARC *arc)
+     /*
+      * Decode the transition of the state at p.
+      *
+      * Returns the pointer to the next transition.
+      */
+{
+  uint32_t ref;
+
+  arc->label = *p++;
+  ref = varint_get(&p);
+  arc->words = (ref & 1) ? 1 : varint_get(&p);
+  ref >>= 1;
+  arc->target = (ref < layout->header.nhubs) ?
+    get32(layout->hubs + ref * sizeof(uint32_t)) :
+    state + layout->header.nhubs - ref - 1;
+  return p;
+}
+
+static int arc_find(const LAYOUT *layout, uint32_t state, unsigned char c,
+                    uint32_t *before, ARC *arc)
+     /*
+      * Find the transition of the state by its label.
+      * The number of words in the subtrees of the preceding
+      * transitions is placed in the location pointed by before.
+      *
+      * Returns 1 if found or 0 otherwise.
+      */
+{
+  const unsigned char *p = layout->states + state;
+  uint32_t n;
+
+  if (!layout->order[c])
+    return 0;
+  *before = 0;
+  for (n = varint_get(&p) >> 1; n > 0; n--)
+    {
+      p = arc_get(layout, p, state, arc);
+      if (arc->label == c)
+        return 1;
+      if (layout->order[arc->label] > layout->order[c])
+        break;
+      *before += arc->words;
+    }
+  return 0;
+}
+
+/* Global routines */
+
+int fst_compare(const unsigned char *order, const char *a, const char *b)
+     /*
+      * Compare the words in the transducer order.
+      */
+{
+  const unsigned char *s = (const unsigned char *)a;
+  const unsigned char *t = (const unsigned char *)b;
+
+  for (; *s && (*s == *t); s++, t++);
+  if (*s == *t)
+    return 0;
+  if (!*s) /* The word a is a prefix of b */
+    return 1;
+  if (!*t)
+    return -1;
+  return (int)order[*s] - (int)order[*t];
+}
+
+void *fst_build(const FST_RECORD *records, unsigned int n,
+                const unsigned char *order,
+                unsigned int source, size_t *size)
+     /*
+      * Build the transducer image for n records.
+      */
+{
+  BUILDER builder;
+  HEADER header;
+  unsigned char *image = NULL, *p;
+  uint32_t *ids, *vtable = NULL, *vrec = NULL, *offsets = NULL;
+  uint32_t root, output;
+  uint64_t bit;
+  unsigned int i, j, k, mask, vsize;
+  int rc;
+
+  if (builder_init(&builder))
+    return NULL;
+  builder.order = order;
+  for (i = 0, rc = 0; (i < n) && !rc; i++)
+    rc = builder_add(&builder, records[i].word,
+                     i ? records[i - 1].word : NULL);
+  if ((!rc) && !path_finish(&builder, 0) &&
+      !state_register(&builder, &builder.path[0], &root))
+    {
+      /* Number the distinct values */
+      for (vsize = BUILDER_CHUNK; vsize < 2 * n; vsize *= 2);
+      mask = vsize - 1;
+      ids = malloc((n ? n : 1) * sizeof(uint32_t));
+      vtable = calloc(vsize, sizeof(uint32_t));
+      vrec = malloc((n ? n : 1) * sizeof(uint32_t));
+      offsets = malloc(builder.nstates * sizeof(uint32_t));
+      (void)memset(&header, 0, sizeof(HEADER));
+      if (ids && vtable && vrec && offsets && !hubs_choose(&builder))
+        {
+          for (i = 0; i < n; i++)
+            {
+              for (j = hash(records[i].value, records[i].size) & mask;
+                   vtable[j]; j = (j + 1) & mask)
+                {
+                  k = vrec[vtable[j] - 1];
+                  if ((records[k].size == records[i].size) &&
+                      !memcmp(records[k].value, records[i].value,
+                              records[i].size))
+                    break;
+                }
+              if (!vtable[j])
+                {
+                  vrec[header.nvalues++] = i;
+                  vtable[j] = header.nvalues;
+                  header.values_size += records[i].size;
+                }
+              ids[i] = vtable[j] - 1;
+            }
+
+          /* Assemble the image */
+          header.magic = FST_MAGIC;
+          header.version = FST_VERSION;
+          header.nstates = builder.nstates;
+          header.ntrans = builder.ntrans;
+          header.nhubs = builder.nhubs;
+          for (k = 0, output = 0; k < builder.nstates; k++)
+            {
+              offsets[k] = output;
+              output += state_encode(&builder, k, offsets, NULL);
+            }
+          header.states_size = output;
+          header.root = offsets[root];
+          header.nwords = n;
+          header.source = source;
+          for (header.bits = 0;
+               (header.bits < 32) &&
+                 (header.nvalues > (1U << header.bits));
+               header.bits++);
+          *size = image_size(&header);
+          image = calloc(1, *size);
+        }
+      if (image)
+        {
+          (void)memcpy(image, &header, sizeof(HEADER));
+          p = image + sizeof(HEADER);
+          (void)memcpy(p, order, FST_ORDER_SIZE);
+          p += FST_ORDER_SIZE;
+          for (k = 0; k < builder.nhubs; k++, p += sizeof(uint32_t))
+            put32(p, offsets[builder.hubs[k]]);
+          for (k = 0; k < builder.nstates; k++)
+            p += state_encode(&builder, k, offsets, p);
+          for (i = 0, bit = 0; i < n; i++)
+            for (j = 0; j < header.bits; j++, bit++)
+              if (ids[i] & (1U << j))
+                p[bit / 8] |= (unsigned char)(1 << (bit % 8));
+          p = image + offsets_offset(&header);
+          for (i = 0, output = 0; i < header.nvalues; i++)
+            {
+              put32(p + i * sizeof(uint32_t), output);
+              (void)memcpy(p + (header.nvalues + 1) * sizeof(uint32_t) + output,
+                           records[vrec[i]].value, records[vrec[i]].size);
+              output += records[vrec[i]].size;
+            }
+          put32(p + header.nvalues * sizeof(uint32_t), output);
+        }
+      free(ids);
+      free(vtable);
+      free(vrec);
+      free(offsets);
+    }
+  builder_free(&builder);
+  return image;
+}
+
+int fst_valid(const void *image, size_t size)
+     /*
+      * Check the format of the transducer image of specified size.
+      */
+{
+  LAYOUT layout;
+  const unsigned char *p, *end;
+  unsigned char *starts;
+  uint32_t i, n, v, ref, prev, state, target, nstates = 0, ntrans = 0;
+  int ok = 1;
+
+  if (size < sizeof(HEADER))
+    return 0;
+  layout_get(image, &layout);
+  if ((layout.header.magic != FST_MAGIC) ||
+      (layout.header.version != FST_VERSION) ||
+      (layout.header.bits > 32) || (layout.header.nhubs > FST_HUBS) ||
+      (layout.header.nstates > FST_MAX_STATES) ||
+      (layout.header.root >= layout.header.states_size) ||
+      (image_size(&layout.header) != size))
+    return 0;
+
+  /* Decode the states marking their offsets */
+  starts = calloc(layout.header.states_size / 8 + 1, 1);
+  if (!starts)
+    return 0;
+  end = layout.states + layout.header.states_size;
+  for (p = layout.states; ok && (p < end); nstates++)
+    {
+      state = p - layout.states;
+      starts[state / 8] |= (unsigned char)(1 << (state % 8));
+      ok = varint_check(&p, end, &n);
+      for (n >>= 1; ok && (n > 0); n--, ntrans++)
+        {
+          ok = (p++ < end) && varint_check(&p, end, &ref) &&
+            ((ref & 1) || varint_check(&p, end, &v));
+          if (!ok)
+            break;
+          ref >>= 1;
+          if (ref < layout.header.nhubs)
+            target = get32(layout.hubs + ref * sizeof(uint32_t));
+          else if (ref - layout.header.nhubs < state)
+            target = state + layout.header.nhubs - ref - 1;
+          else target = state;
+          ok = (target < state) &&
+            (starts[target / 8] & (1 << (target % 8)));
+        }
+    }
+  ok = ok && (nstates == layout.header.nstates) &&
+    (ntrans == layout.header.ntrans) &&
+    (starts[layout.header.root / 8] & (1 << (layout.header.root % 8)));
+  free(starts);
+  if (!ok)
+    return 0;
+
+  for (i = 0; i < layout.header.nwords; i++)
+    if (value_id(&layout, i) >= layout.header.nvalues)
+      return 0;
+  for (i = 0, prev = 0; i <= layout.header.nvalues; i++, prev = v)
+    {
+      v = get32(layout.offsets + i * sizeof(uint32_t));
+      if ((v < prev) || (v > layout.header.values_size))
+        return 0;
+    }
+  return prev == layout.header.values_size;
+}
+
+unsigned int fst_words(const void *image)
+     /*
+      * Get the number of words in the transducer.
+      */
+{
+  HEADER header;
+
+  (void)memcpy(&header, image, sizeof(HEADER));
+  return header.nwords;
+}
+
+unsigned int fst_source(const void *image)
+     /*
+      * Get the source dictionary generation stamped in the transducer.
+      */
+{
+  HEADER header;
+
+  (void)memcpy(&header, image, sizeof(HEADER));
+  return header.source;
+}
+
+int fst_lookup(const void *image, const char *word,
+               const char **value, unsigned int *size)
+     /*
+      * Look the word up in the transducer.
+      */
+{
+  LAYOUT layout;
+  ARC arc;
+  uint32_t state, rank = 0, before, n;
+  const unsigned char *s, *p;
+
+  layout_get(image, &layout);
+  state = layout.header.root;
+  for (s = (const unsigned char *)word; *s; s++)
+    {
+      if (!arc_find(&layout, state, *s, &before, &arc))
+        return 0;
+      rank += before;
+      state = arc.target;
+    }
+  p = layout.states + state;
+  n = varint_get(&p);
+  if (!(n & 1))
+    return 0;
+  for (n >>= 1; n > 0; n--)
+    {
+      p = arc_get(&layout, p, state, &arc);
+      rank += arc.words;
+    }
+  if (rank >= layout.header.nwords)
+    return 0;
+  value_get(&layout, rank, value, size);
+  return 1;
+}
+
+unsigned int fst_prefix(const void *image, const char *prefix,
+                        unsigned int *first)
+     /*
+      * Find the words starting with specified prefix.
+      */
+{
+  LAYOUT layout;
+  ARC arc;
+  uint32_t state, begin = 0, end, before;
+  const unsigned char *s;
+
+  layout_get(image, &layout);
+  state = layout.header.root;
+  end = layout.header.nwords;
+  for (s = (const unsigned char *)prefix; *s; s++)
+    {
+      if (!arc_find(&layout, state, *s, &before, &arc))
+        return 0;
+      begin += before;
+      end = begin + arc.words;
+      state = arc.target;
+    }
+  if ((begin > end) || (end > layout.header.nwords))
+    return 0;
+  *first = begin;
+  return end - begin;
+}
+
+int fst_fetch(const void *image, unsigned int rank,
+              char *word, size_t len,
+              const char **value, unsigned int *size)
+     /*
+      * Fetch the word of specified rank and its value.
+      */
+{
+  LAYOUT layout;
+  ARC arc;
+  uint32_t state, r = rank, h, n;
+  const unsigned char *p;
+  size_t i;
+
+  layout_get(image, &layout);
+  if (rank >= layout.header.nwords)
+    return 0;
+  state = layout.header.root;
+  for (i = 0; ; i++)
+    {
+      p = layout.states + state;
+      h = varint_get(&p);
+      /* The first transition beyond the rank */
+      for (n = h >> 1; n > 0; n--)
+        {
+          p = arc_get(&layout, p, state, &arc);
+          if (r < arc.words)
+            break;
+          r -= arc.words;
+        }
+      /* The word ending here goes after the longer ones */
+      if (!n)
+        {
+          if ((h & 1) && !r)
+            break;
+          return 0;
+        }
+      if (i + 1 >= len)
+        return 0;
+      word[i] = (char)arc.label;
+      state = arc.target;
+    }
+  word[i] = 0;
+  value_get(&layout, rank, value, size);
+  return 1;
+}
@@ -0,0 +1,138 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Dictionary transducer.
+ *
+ * The dictionary keys share long prefixes and suffixes, so the minimal
+ * acyclic transducer over the words takes a small part of the space
+ * needed by the tree. Every transition carries the number of words
+ * in its subtree, so the rank of a word in the keys order is summed up
+ * from the outputs of the transitions preceding the ones along its path.
+ * The rank selects the value from the table of distinct values, since
+ * the same values are shared by many words. The characters are ordered
+ * by the table stored in the image, and a word goes after all the words
+ * it is a prefix of, as the packed dictionary keys do. So the words
+ * with a common prefix occupy a range of ranks and can be enumerated
+ * in the same order as the dictionary itself.
+ *
+ * The image is a plain byte array which can be stored
+ * and used in place without decoding.
+ */
+
+
+#ifndef FST_H
+#define FST_H
+
+#include <stddef.h>
+
+/* BEGIN_C_DECLS should be used at the beginning of C declarations,
+   so that C++ compilers don't mangle their names.  Use END_C_DECLS at
+   the end of C declarations. */
+#undef BEGIN_C_DECLS
+#undef END_C_DECLS
+#ifdef __cplusplus
+# define BEGIN_C_DECLS extern "C" {
+# define END_C_DECLS }
+#else
+# define BEGIN_C_DECLS /* empty */
+# define END_C_DECLS /* empty */
+#endif
+
+BEGIN_C_DECLS
+
+typedef struct /* Transducer record */
+{
+  const char *word; /* Null terminated word */
+  const char *value; /* Value data */
+  unsigned int size; /* Value data size */
+} FST_RECORD;
+
+
+extern int fst_compare(const unsigned char *order,
+                       const char *a, const char *b);
+/*
+ * Compare the words in the transducer order specified by the table
+ * of 256 character positions, where 0 stands for the characters
+ * that cannot appear in the words. Returns negative value, 0
+ * or positive value when the word a goes before, is equal
+ * or goes after the word b respectively.
+ */
+
+extern void *fst_build(const FST_RECORD *records, unsigned int n,
+                       const unsigned char *order,
+                       unsigned int source, size_t *size);
+/*
+ * Build the transducer image for n records. The words must be
+ * distinct and sorted by fst_compare() with specified order table,
+ * which is stored in the image together with the generation
+ * of the source dictionary (source) to check its consistency later.
+ * The image size is placed in the location pointed by size.
+ *
+ * Returns pointer to the allocated image or NULL when memory
+ * allocation fails or the words are not sorted properly.
+ */
+
+extern int fst_valid(const void *image, size_t size);
+/*
+ * Check the format of the transducer image of specified size.
+ * Returns 1 if it can be used or 0 otherwise.
+ */
+
+extern unsigned int fst_words(const void *image);
+/*
+ * Get the number of words in the transducer.
+ */
+
+extern unsigned int fst_source(const void *image);
+/*
+ * Get the generation of the source dictionary
+ * stamped in the transducer image.
+ */
+
+extern int fst_lookup(const void *image, const char *word,
+                      const char **value, unsigned int *size);
+/*
+ * Look the word up in the transducer. If found, the pointer
+ * to its value and the value size are placed in the locations
+ * pointed by value and size.
+ * Returns 1 if the word is found or 0 otherwise.
+ */
+
+extern unsigned int fst_prefix(const void *image, const char *prefix,
+                               unsigned int *first);
+/*
+ * Find the words starting with specified prefix. The rank
+ * of the first one is placed in the location pointed by first.
+ * Returns the number of such words.
+ */
+
+extern int fst_fetch(const void *image, unsigned int rank,
+                     char *word, size_t len,
+                     const char **value, unsigned int *size);
+/*
+ * Fetch the word of specified rank (counting from 0) into the buffer
+ * of len bytes and its value as fst_lookup() does.
+ * Returns 1 on success or 0 if there is no such word
+ * or it does not fit the buffer.
+ */
+
+END_C_DECLS
+
+#endif
@@ -0,0 +1,670 @@
+/*
+ * Order-1 keys packing model.
+ *
+ * This file is generated by mkkeymodel, do not edit it.
+ */
+
+/* Total of the symbols frequencies in every context */
+#define CONTEXT_SCALE_BITS 12
+
+/* Decoding table granularity */
+#define CONTEXT_DECODE_BITS 4
+
+/* Model identifier stamped in the databases */
+#define CONTEXT_MODEL_ID 0xA3596193U
+
+/* Symbols intervals low bounds in every context */
+static const unsigned short int context_low[34][35] =
+  {
+    {    0,    4,   86,  235,  318,  459,  488,  489,  532,  660,  682,  741,
+      874, 1168, 1948, 2398, 2402, 2490, 2821, 3040, 3359, 3391, 3422, 3470,
+     3490, 3545, 3587, 3605, 3606, 3607, 3608, 3614, 3836, 3870, 4096 },
+    {    0,  632,  648,  665,  671,  684, 1480, 1481, 1493, 1502, 1854, 1855,
+     1893, 2197, 2227, 2314, 2973, 2977, 3437, 3475, 3484, 3770, 3772, 3780,
+     3795, 3807, 3815, 3846, 3861, 3966, 3990, 4003, 4020, 4053, 4096 },
+    {    0,  734,  738,  750,  757,  777, 1265, 1266, 1268, 1301, 1655, 1656,
+     1745, 1821, 1832, 1924, 2492, 2515, 2577, 2651, 2688, 2766, 2767, 2770,
+     2797, 2813, 2833, 2854, 2856, 3282, 3302, 3305, 3307, 3356, 4096 },
+    {    0,  689,  695,  722,  739,  766, 1087, 1089, 1091, 1093, 1557, 1558,
+     1579, 1895, 1913, 2087, 3153, 3157, 3673, 3694, 3713, 3963, 3964, 3966,
+     3968, 3982, 4005, 4006, 4007, 4010, 4011, 4022, 4026, 4027, 4096 },
+    {    0,  565,  576,  709,  719,  744, 1386, 1387, 1483, 1522, 2047, 2048,
+     2116, 2174, 2202, 2440, 3063, 3085, 3326, 3407, 3423, 3636, 3639, 3651,
+     3705, 3728, 3748, 3750, 3756, 3842, 3895, 3904, 3932, 4007, 4096 },
+    {    0,   11,   71,  332,  405,  562,  603,  604,  657,  782,  808,  925,
+     1060, 1395, 1547, 2158, 2192, 2281, 2915, 3180, 3535, 3543, 3563, 3605,
+     3631, 3697, 3742, 3759, 3760, 3761, 3762, 3763, 3780, 3792, 4096 },
+    {    0,    1,    2,   47,   48,   71,   72,   73,  118,  141,  142,  143,
+      144,  434,  768, 1013, 1014, 1015, 1283, 1483, 1951, 1952, 1953, 4063,
+     4064, 4065, 4066, 4067, 4068, 4069, 4070, 4071, 4072, 4073, 4096 },
+    {    0,  638,  656,  662,  673,  895, 2053, 2059, 2085, 2087, 2962, 2963,
+     3112, 3132, 3156, 3476, 3632, 3633, 3651, 3685, 3692, 3873, 3874, 3875,
+     3890, 3899, 3900, 3901, 3902, 3913, 3965, 3972, 3976, 3977, 4096 },
+    {    0, 1148, 1225, 1481, 1575, 1825, 2080, 2081, 2112, 2131, 2426, 2427,
+     2480, 2619, 2736, 3053, 3457, 3462, 3545, 3558, 3579, 3741, 3742, 3745,
+     3752, 3767, 3783, 3784, 3803, 3917, 3952, 3955, 3971, 4025, 4096 },
+    {    0,   53,  103,  301,  364,  455,  522,  523,  543,  659,  700,  814,
+     1168, 1342, 1463, 1995, 2051, 2110, 2252, 2481, 2903, 2914, 2944, 2990,
+     3066, 3181, 3223, 3253, 3254, 3255, 3256, 3260, 3346, 3363, 4096 },
+    {    0,    7,   19,   30,   37,   89,  107,  108,  109,  123,  127,  128,
+      168,  203,  242,  316,  341,  348,  364,  416,  473,  474,  484,  491,
+      502,  518,  633,  642,  643,  644,  645,  646,  648,  654, 4096 },
+    {    0,  535,  539,  580,  583,  586,  680,  681,  682,  690, 1750, 1751,
+     1768, 1923, 1929, 1994, 2865, 2868, 3102, 3200, 3290, 3495, 3497, 3500,
+     3505, 3507, 3523, 3524, 3525, 3527, 3529, 3535, 3539, 3540, 4096 },
+    {    0,  588,  603,  611,  626,  649, 1300, 1303, 1314, 1325, 1936, 1937,
+     2016, 2121, 2132, 2159, 2839, 2847, 2849, 2876, 2908, 3049, 3052, 3055,
+     3056, 3069, 3072, 3074, 3075, 3157, 3703, 3710, 3830, 4013, 4096 },
+    {    0,  536,  583,  588,  592,  595, 1037, 1038, 1040, 1045, 1339, 1340,
+     1368, 1400, 1435, 1523, 1917, 1979, 1990, 2029, 2034, 2164, 2175, 2177,
+     2188, 2198, 2203, 2208, 2209, 2310, 2321, 2329, 2333, 2378, 4096 },
+    {    0,  454,  463,  470,  534,  645, 1007, 1008, 1016, 1029, 1489, 1490,
+     1601, 1604, 1606, 1958, 2419, 2423, 2428, 2554, 2683, 2814, 2827, 2832,
+     2889, 2925, 2932, 2941, 2942, 3680, 3768, 3772, 3788, 3869, 4096 },
+    {    0,    7,  191,  889, 1022, 1240, 1273, 1274, 1334, 1429, 1455, 1565,
+     1700, 2040, 2219, 2501, 2521, 2673, 3058, 3342, 3592, 3612, 3642, 3688,
+     3704, 3791, 3833, 3847, 3848, 3849, 3850, 3855, 3861, 3878, 4096 },
+    {    0,  480,  482,  483,  487,  489,  998,  999, 1000, 1001, 1314, 1315,
+     1343, 1619, 1622, 1674, 2750, 2784, 3623, 3676, 3727, 3891, 3896, 3897,
+     3901, 3921, 3931, 3934, 3935, 3984, 4009, 4013, 4015, 4069, 4096 },
+    {    0,  715,  746,  787,  856,  927, 1501, 1510, 1534, 1550, 2018, 2019,
+     2102, 2134, 2203, 2326, 3068, 3092, 3110, 3223, 3339, 3533, 3547, 3580,
+     3602, 3629, 3660, 3672, 3673, 3754, 3790, 3800, 3827, 3927, 4096 },
+    {    0,  313,  331,  440,  450,  462,  704,  705,  708,  709,  950,  951,
+     1546, 1716, 1794, 1918, 2230, 2390, 2418, 2564, 3549, 3672, 3684, 3701,
+     3724, 3752, 3767, 3770, 3774, 3829, 3910, 3919, 3928, 4023, 4096 },
+    {    0,  505,  514,  667,  673,  683, 1167, 1169, 1171, 1173, 1549, 1550,
+     1624, 1663, 1679, 1813, 2335, 2348, 2722, 2779, 2811, 2942, 2947, 2951,
+     2960, 2985, 2990, 2993, 2996, 3162, 3634, 3642, 3662, 3714, 4096 },
+    {    0,   50,  246,  304,  421,  679,  800,  801,  927, 1039, 1065, 1086,
+     1260, 1527, 1719, 1936, 1947, 2129, 2453, 2782, 3260, 3264, 3290, 3442,
+     3455, 3603, 3787, 3847, 3848, 3849, 3850, 3875, 3905, 3916, 4096 },
+    {    0,  639,  640,  641,  654,  655, 1205, 1206, 1207, 1208, 1986, 1987,
+     2001, 2239, 2264, 2300, 3079, 3082, 3445, 3486, 3621, 3837, 3930, 3931,
+     3932, 3936, 3943, 3944, 3945, 3959, 3998, 4007, 4018, 4034, 4096 },
+    {    0,  871,  883, 1019, 1039, 1060, 1195, 1196, 1199, 1208, 1593, 1594,
+     1629, 1898, 2009, 2253, 3159, 3199, 3447, 3536, 3653, 3783, 3792, 3801,
+     3808, 3824, 3855, 3856, 3863, 3864, 3868, 3893, 3894, 3895, 4096 },
+    {    0,  458,  464,  579,  587,  593, 2821, 2822, 2824, 2832, 3352, 3353,
+     3610, 3630, 3653, 3664, 3741, 3752, 3758, 3766, 3776, 3841, 3842, 3843,
+     3859, 3860, 3866, 3867, 3868, 3966, 3967, 3970, 3975, 3976, 4096 },
+    {    0,  684,  685,  693,  694,  695, 1758, 1766, 1770, 1771, 2760, 2761,
+     3074, 3103, 3119, 3377, 3432, 3437, 3449, 3453, 3511, 3731, 3732, 3735,
+     3736, 3748, 3754, 3755, 3756, 3757, 3855, 3857, 3860, 3861, 4096 },
+    {    0,  591,  596,  657,  659,  660, 1341, 1345, 1346, 1347, 2031, 2032,
+     2530, 2655, 2718, 2981, 3080, 3152, 3170, 3195, 3386, 3512, 3514, 3517,
+     3522, 3524, 3526, 3527, 3528, 3532, 3603, 3607, 3616, 3617, 4096 },
+    {    0,  399,  400,  406,  407,  409, 1369, 1371, 1372, 1373, 2552, 2553,
+     2554, 2555, 2557, 2635, 2660, 2661, 2679, 2680, 2683, 2880, 2882, 2883,
+     2884, 2885, 2886, 2889, 2890, 2891, 2905, 2906, 2918, 2921, 4096 },
+    {    0,    1,   20,   21,   22,   41, 2593, 2594, 2595, 2596, 2615, 2616,
+     2617, 2618, 2619, 2620, 2639, 2640, 2641, 2642, 2643, 2644, 2645, 2646,
+     2647, 2648, 2649, 2650, 2651, 2652, 2653, 2672, 2965, 3877, 4096 },
+    {    0,    1,   42,  291,  328,  355,  401,  402,  428,  464,  467, 3128,
+     3217, 3314, 3363, 3422, 3423, 3489, 3598, 3726, 3791, 3794, 3795, 3846,
+     3853, 3906, 3987, 3996, 3997, 3998, 3999, 4000, 4002, 4006, 4096 },
+    {    0,    1,   45,   73,   96,  167,  404,  405,  407,  434,  477,  478,
+      737,  738,  845, 1170, 1190, 1204, 1207, 1400, 1531, 1532, 1559, 1566,
+     1617, 1663, 1699, 1761, 1762, 1763, 1764, 1766, 1855, 2060, 4096 },
+    {    0,    7,   64,  165,  227,  403,  418,  419,  430,  474,  485,  713,
+     1243, 1805, 2004, 2628, 2639, 2822, 3223, 3510, 3782, 3789, 3863, 3886,
+     3901, 3902, 3955, 3956, 3957, 3958, 3959, 3980, 3981, 3988, 4096 },
+    {    0,   10,  145,  163,  208,  288,  296,  297,  330,  373,  382,  406,
+      484,  533,  580,  669,  673,  688,  790,  863, 1025, 1026, 1036, 1082,
+     1095, 1182, 1275, 1333, 1334, 1335, 1336, 1340, 1345, 1346, 4096 },
+    {    0,    1,   63,  133,  246,  395,  425,  426,  522,  638,  649,  666,
+      824,  904, 1635, 2046, 2047, 2086, 2191, 2330, 2652, 2660, 2661, 2714,
+     2736, 2825, 2850, 3053, 3054, 3055, 3056, 3057, 3073, 3077, 4096 },
+    {    0,  143,  416,  690,  861, 1047, 1072, 1073, 1111, 1252, 1342, 1345,
+     1663, 1778, 1993, 2155, 2388, 2911, 3079, 3449, 3620, 3706, 3777, 3843,
+     3867, 3931, 4009, 4019, 4020, 4021, 4022, 4067, 4076, 4095, 4096 }
+  };
+
+/* Symbols by the counts blocks of 16 in every context */
+static const unsigned char context_decode[34][256] =
+  {
+    {  0,  1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,  2,  2,  3,
+      3,  3,  3,  3,  4,  4,  4,  4,  4,  4,  4,  4,  4,  5,  5,  7,
+      7,  7,  8,  8,  8,  8,  8,  8,  8,  8,  9, 10, 10, 10, 10, 11,
+     11, 11, 11, 11, 11, 11, 11, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+     12, 12, 12, 12, 12, 12, 12, 12, 12, 13, 13, 13, 13, 13, 13, 13,
+     13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+     13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+     13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 15, 16, 16, 16, 16, 16, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 19, 19,
+     19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 19, 20, 20, 21, 21, 22, 22, 22, 23, 23, 24, 24, 24, 25, 25,
+     25, 26, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31,
+     32, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  1,  2,  4,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  7,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9, 11, 11, 11, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+     12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 13, 13, 14, 14, 14, 14,
+     14, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 16, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 18, 18, 18, 20, 20, 20, 20, 20, 20,
+     20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 22, 23, 25, 26,
+     26, 27, 28, 28, 28, 28, 28, 28, 29, 29, 30, 31, 32, 32, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  3,
+      4,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      8,  8,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9, 11, 11, 11, 11, 11, 11, 12, 12,
+     12, 12, 13, 14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 16, 16, 17, 17,
+     17, 17, 18, 18, 18, 18, 19, 19, 20, 20, 20, 20, 20, 22, 23, 24,
+     25, 25, 26, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+     28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 29, 32,
+     32, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  2,  2,  3,  4,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  6,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9, 11, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+     12, 12, 12, 12, 12, 12, 12, 13, 14, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 18, 19, 19, 20, 20, 20, 20, 20, 20, 20,
+     20, 20, 20, 20, 20, 20, 20, 20, 24, 25, 25, 30, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  2,  2,  2,  2,  2,  2,  2,  2,  2,  4,  4,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  7,  7,  7,  7,  7,  7,  8,  8,  8,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+     11, 11, 11, 11, 11, 12, 12, 12, 13, 13, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     16, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     18, 18, 18, 18, 18, 19, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+     20, 20, 20, 20, 22, 23, 23, 23, 24, 25, 25, 28, 28, 28, 28, 28,
+     28, 29, 29, 29, 31, 31, 32, 32, 32, 32, 32, 33, 33, 33, 33, 33 },
+    {  0,  1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+      2,  2,  2,  2,  2,  3,  3,  3,  3,  3,  4,  4,  4,  4,  4,  4,
+      4,  4,  4,  4,  5,  5,  7,  7,  7,  7,  8,  8,  8,  8,  8,  8,
+      8,  9,  9, 10, 10, 10, 10, 10, 10, 10, 11, 11, 11, 11, 11, 11,
+     11, 11, 11, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+     12, 12, 12, 12, 12, 12, 12, 12, 13, 13, 13, 13, 13, 13, 13, 13,
+     13, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 15, 15, 16, 16, 16, 16, 16, 16, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 18, 18, 18, 18, 18, 18, 18, 18, 18,
+     18, 18, 18, 18, 18, 18, 18, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 20, 21, 22,
+     22, 22, 23, 24, 24, 24, 24, 24, 25, 25, 26, 28, 31, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  2,  2,  4,  4,  7,  7,  7,  8, 12, 12, 12, 12, 12, 12, 12,
+     12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 13, 13, 13, 13,
+     13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 19, 19, 19,
+     19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 21, 22, 22, 22, 22, 22,
+     22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22,
+     22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22,
+     22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22,
+     22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22,
+     22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22,
+     22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22,
+     22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22,
+     22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 24, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  1,  2,  3,  4,  4,  4,  4,  4,
+      4,  4,  4,  4,  4,  4,  4,  4,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  7,  7,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9, 11, 11, 11, 11, 11, 11,
+     11, 11, 11, 12, 13, 13, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 16, 17, 18, 18, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+     20, 20, 20, 23, 28, 29, 29, 29, 30, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,  1,  2,  2,  2,
+      2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  3,  3,  3,
+      3,  3,  3,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,
+      4,  4,  4,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  6,  7,  8,  8,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9, 11, 11, 11, 12, 12, 12, 12, 12,
+     12, 12, 12, 12, 13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 17, 17, 17, 17, 17, 18, 19,
+     20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 22, 24, 25, 27, 28, 28,
+     28, 28, 28, 28, 28, 29, 29, 30, 31, 32, 32, 32, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+      2,  2,  2,  3,  3,  3,  3,  4,  4,  4,  4,  4,  4,  5,  5,  5,
+      5,  7,  8,  8,  8,  8,  8,  8,  8,  8,  9,  9, 10, 10, 10, 10,
+     10, 10, 10, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+     11, 11, 11, 11, 11, 11, 11, 11, 11, 12, 12, 12, 12, 12, 12, 12,
+     12, 12, 12, 12, 13, 13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 15, 15,
+     15, 16, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17, 17, 18, 18, 18,
+     18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 19, 19, 19, 19,
+     19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 19, 19, 19, 19, 19, 20, 21, 22, 22, 22, 23, 23, 23, 23, 23,
+     24, 24, 24, 24, 24, 24, 24, 25, 25, 25, 26, 26, 31, 31, 31, 31,
+     31, 31, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  1,  3,  4,  4,  4,  5,  8, 11, 11, 11, 12, 12, 13, 13, 13,
+     14, 14, 14, 14, 15, 15, 17, 18, 18, 18, 19, 19, 19, 19, 21, 23,
+     24, 25, 25, 25, 25, 25, 25, 25, 26, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  2,  2,  2,  5,  5,  5,  5,  5,  5,  8,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, 11, 12,
+     12, 12, 12, 12, 12, 12, 12, 12, 12, 14, 14, 14, 14, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 18, 18, 18, 18, 18, 18, 19, 19, 19, 19, 19, 19, 20, 20,
+     20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 23, 25, 31, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  1,  2,  3,  4,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  7,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9, 10, 11, 11, 11, 11, 12, 12,
+     12, 12, 12, 12, 12, 13, 14, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 17, 18, 19, 19, 20, 20, 20, 20, 20, 20, 20, 20, 20, 24,
+     26, 28, 28, 28, 28, 28, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29,
+     29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29,
+     29, 29, 29, 29, 29, 29, 29, 29, 31, 31, 31, 31, 31, 31, 31, 31,
+     32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  1,  1,  1,  4,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  8,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9, 11, 11, 12, 12, 13, 13, 14, 14, 14, 14, 14, 14,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 16, 16, 16, 16, 17, 18, 18, 19,
+     20, 20, 20, 20, 20, 20, 20, 20, 22, 24, 27, 28, 28, 28, 28, 28,
+     28, 29, 32, 32, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  2,  3,  3,
+      3,  3,  4,  4,  4,  4,  4,  4,  4,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  7,
+      8,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, 11, 11,
+     11, 11, 11, 11, 11, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 18, 18, 18, 18, 18, 18, 18, 18,
+     19, 19, 19, 19, 19, 19, 19, 19, 20, 20, 20, 20, 20, 20, 20, 20,
+     21, 23, 23, 23, 23, 24, 24, 25, 28, 28, 28, 28, 28, 28, 28, 28,
+     28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+     28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+     28, 28, 28, 28, 28, 28, 29, 29, 29, 29, 29, 29, 31, 32, 32, 32,
+     32, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  2,  2,  2,  2,
+      2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+      2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+      2,  2,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,  3,  3,  3,  3,
+      4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  5,  5,
+      7,  7,  7,  7,  8,  8,  8,  8,  8,  8,  9, 10, 10, 10, 10, 10,
+     10, 10, 11, 11, 11, 11, 11, 11, 11, 11, 11, 12, 12, 12, 12, 12,
+     12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+     13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 16, 16,
+     16, 16, 16, 16, 16, 16, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18,
+     18, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 20, 21, 21, 22, 22, 22, 23, 24, 24, 24, 24, 24, 25, 25, 25,
+     26, 31, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9, 11, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+     12, 12, 12, 12, 12, 12, 14, 14, 14, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 16, 16, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 18, 18, 18, 19, 19, 19, 20, 20, 20, 20, 20, 20, 20,
+     20, 20, 20, 20, 24, 24, 28, 28, 28, 29, 29, 32, 32, 32, 32, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  2,
+      2,  2,  3,  3,  3,  3,  4,  4,  4,  4,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  6,  7,
+      8,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, 11,
+     11, 11, 11, 11, 12, 12, 13, 13, 13, 13, 14, 14, 14, 14, 14, 14,
+     14, 14, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     16, 16, 17, 18, 18, 18, 18, 18, 18, 18, 19, 19, 19, 19, 19, 19,
+     19, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 21, 22, 22,
+     23, 23, 24, 25, 25, 26, 28, 28, 28, 28, 28, 29, 29, 30, 31, 31,
+     32, 32, 32, 32, 32, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  1,  2,  2,  2,  2,  2,  2,  2,  3,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  6,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, 11, 11, 11, 11,
+     11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+     11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+     11, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 13, 13, 13, 13,
+     13, 14, 14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 16, 16, 16, 16,
+     16, 16, 16, 16, 16, 16, 17, 17, 18, 18, 18, 18, 18, 18, 18, 18,
+     18, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 20, 20,
+     20, 20, 20, 20, 20, 20, 21, 22, 23, 24, 24, 25, 28, 28, 28, 28,
+     29, 29, 29, 29, 29, 31, 32, 32, 32, 32, 32, 32, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      1,  2,  2,  2,  2,  2,  2,  2,  2,  2,  3,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  6,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9, 11, 11, 11, 11, 11, 12, 12, 13, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 16, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 18, 18, 18, 19, 19,
+     20, 20, 20, 20, 20, 20, 20, 20, 21, 24, 24, 26, 28, 28, 28, 28,
+     28, 28, 28, 28, 28, 28, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29,
+     29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29, 29,
+     29, 29, 29, 29, 31, 32, 32, 32, 32, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+      2,  2,  2,  3,  3,  3,  3,  3,  3,  3,  3,  4,  4,  4,  4,  4,
+      4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  5,  5,  5,  5,  5,
+      5,  5,  6,  7,  7,  7,  7,  7,  7,  7,  8,  8,  8,  8,  8,  8,
+      8,  9,  9, 10, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 12,
+     12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+     13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 16, 16, 16, 16, 16, 16,
+     16, 16, 16, 16, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 18, 18, 18, 18, 18, 18,
+     18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 19, 19,
+     19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 21, 21, 22, 22,
+     22, 22, 22, 22, 22, 22, 22, 22, 24, 24, 24, 24, 24, 24, 24, 24,
+     24, 24, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 26, 26, 26,
+     26, 30, 30, 31, 31, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  2,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, 11, 12, 12,
+     12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 13, 13, 14, 14,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 18, 18, 19, 19, 19, 19, 19, 19,
+     19, 19, 19, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+     21, 21, 21, 21, 21, 21, 25, 28, 29, 29, 30, 31, 32, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  1,  2,  2,  2,  2,  2,  2,  2,  2,
+      3,  4,  4,  5,  5,  5,  5,  5,  5,  5,  5,  8,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9, 11, 11, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+     12, 12, 12, 12, 12, 12, 12, 13, 13, 13, 13, 13, 13, 13, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 18, 18, 18, 18, 18, 19, 19, 19,
+     19, 19, 19, 19, 19, 20, 20, 20, 20, 20, 20, 20, 20, 22, 24, 25,
+     25, 27, 30, 30, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  2,  2,  2,
+      2,  2,  2,  2,  2,  4,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+     11, 11, 12, 13, 13, 15, 15, 15, 15, 15, 16, 18, 20, 20, 20, 20,
+     20, 23, 28, 28, 28, 28, 28, 28, 30, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  2,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  6,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, 11, 11, 11,
+     11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+     11, 12, 13, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 15, 15, 15, 17, 19, 19, 19, 19, 20, 20, 20, 20,
+     20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 24, 29, 29, 29, 29, 29,
+     29, 30, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  1,  2,  2,  2,  2,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  6,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, 11,
+     11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+     11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 12,
+     12, 12, 12, 12, 12, 12, 13, 13, 13, 13, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15,
+     15, 16, 16, 16, 16, 17, 17, 18, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 19, 19, 19, 20, 20, 20, 20, 20, 20, 20, 20, 23, 29, 29, 29,
+     29, 29, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  2,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+      9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+     14, 14, 14, 14, 14, 15, 15, 17, 20, 20, 20, 20, 20, 20, 20, 20,
+     20, 20, 20, 20, 21, 29, 31, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  1,  4,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+      5,  5,  5,  9, 15, 17, 30, 31, 31, 31, 31, 31, 31, 31, 31, 31,
+     31, 31, 31, 31, 31, 31, 31, 31, 31, 31, 32, 32, 32, 32, 32, 32,
+     32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32,
+     32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32,
+     32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32,
+     32, 32, 32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  1,  1,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+      2,  2,  2,  3,  3,  4,  4,  5,  5,  5,  7,  8,  8,  9, 10, 10,
+     10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+     10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+     10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+     10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+     10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+     10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+     10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+     10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+     10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+     10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+     10, 10, 10, 10, 11, 11, 11, 11, 11, 11, 12, 12, 12, 12, 12, 12,
+     13, 13, 13, 14, 14, 14, 16, 16, 16, 16, 16, 17, 17, 17, 17, 17,
+     17, 18, 18, 18, 18, 18, 18, 18, 18, 19, 19, 19, 19, 20, 22, 22,
+     22, 24, 24, 24, 24, 25, 25, 25, 25, 25, 31, 33, 33, 33, 33, 33 },
+    {  0,  1,  1,  2,  2,  3,  4,  4,  4,  4,  4,  5,  5,  5,  5,  5,
+      5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  8,  8,  9,  9, 11, 11,
+     11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 13,
+     13, 13, 13, 13, 13, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15, 16, 18, 18, 18, 18,
+     18, 18, 18, 18, 18, 18, 18, 18, 19, 19, 19, 19, 19, 19, 19, 19,
+     21, 21, 23, 23, 23, 23, 24, 24, 25, 25, 25, 26, 26, 26, 26, 31,
+     31, 31, 31, 31, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32,
+     32, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,  4,
+      4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  5,  8,  8,  8,  9, 10,
+     10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 11, 11, 11,
+     11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+     11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 12, 12,
+     12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+     12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+     12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+     16, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 18, 18, 18, 18, 18, 18,
+     18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 19, 19, 19, 19,
+     19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 21, 21, 21,
+     21, 21, 22, 23, 25, 25, 25, 25, 30, 32, 33, 33, 33, 33, 33, 33 },
+    {  0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  2,  3,  3,  4,  4,  4,
+      4,  4,  5,  7,  7,  8,  8,  8, 10, 10, 11, 11, 11, 11, 11, 12,
+     12, 12, 13, 13, 13, 14, 14, 14, 14, 14, 15, 17, 17, 17, 17, 17,
+     17, 17, 18, 18, 18, 18, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 22, 22, 22, 23, 24, 24, 24, 24, 24, 25, 25, 25, 25, 25, 25,
+     26, 26, 26, 26, 31, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  1,  1,  1,  2,  2,  2,  2,  2,  3,  3,  3,  3,  3,  3,  3,
+      4,  4,  4,  4,  4,  4,  4,  4,  4,  5,  5,  7,  7,  7,  7,  7,
+      7,  8,  8,  8,  8,  8,  8,  8,  9, 10, 11, 11, 11, 11, 11, 11,
+     11, 11, 11, 11, 12, 12, 12, 12, 12, 13, 13, 13, 13, 13, 13, 13,
+     13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+     13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+     13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+     16, 16, 16, 17, 17, 17, 17, 17, 17, 18, 18, 18, 18, 18, 18, 18,
+     18, 18, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 19, 19, 19, 19, 19, 20, 22, 22, 22, 23, 24, 24, 24, 24, 24,
+     24, 25, 25, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 30,
+     31, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33,
+     33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33, 33 },
+    {  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,  1,  1,  1,
+      1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  2,
+      2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,
+      3,  3,  3,  3,  3,  3,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,
+      4,  4,  5,  6,  7,  7,  8,  8,  8,  8,  8,  8,  8,  8,  8,  9,
+      9,  9,  9,  9, 10, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+     11, 11, 11, 11, 11, 11, 11, 11, 12, 12, 12, 12, 12, 12, 12, 12,
+     13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 14, 14, 14,
+     14, 14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+     15, 15, 15, 15, 15, 15, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+     16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+     16, 16, 16, 16, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+     17, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18,
+     18, 18, 18, 18, 18, 18, 18, 18, 19, 19, 19, 19, 19, 19, 19, 19,
+     19, 19, 19, 20, 20, 20, 20, 20, 21, 21, 21, 21, 21, 22, 22, 22,
+     22, 23, 24, 24, 24, 24, 25, 25, 25, 25, 25, 26, 30, 30, 30, 32 }
+  };
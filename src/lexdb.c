@@ -22,33 +22,107 @@
  */
 
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#ifdef USE_BDB
-#include <fcntl.h>
-#else
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #include <stdint.h>
+#include <time.h>
+#include <sys/time.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
 #endif
 #include "lexdb.h"
 #include "coder.h"
+#include "bitmatch.h"
+#include "dfa.h"
+#include "suffix.h"
+#include "prefix.h"
+#include "cache.h"
+#include "filter.h"
+#include "frozen.h"
+#include "lexfile.h"
+#include "fst.h"
 
 
 /* Local constants */
 
-/* Internal flag for the recursive call of rulexdb_search() */
-#define RULEXDB_NOPREFIX 0x80
+/* Access mode bits in the rulexdb_open() mode argument */
+#define ACCESS_MODE_MASK 0x0f
+
+/* Number of lexical bases acquired at once */
+#define LEXBASES_CHUNK 16
+
+/* Initial number of dictionary lookups allocated for a batch search */
+#define BATCH_CHUNK 64
+
+/* Initial number of words allocated for the frozen results table */
+#define FREEZE_CHUNK 1024
+
+/* Maximum number of prefixes stripped from a word */
+#define MAX_PREFIXES 8
+
+/* Maximum number of subexpressions positions reported by rule matching */
+#define MAX_SUBMATCHES 10
+
+/* Bit-parallel matchers reproduce POSIX regex semantics only */
+#if !defined(_WIN32) && !defined(USE_PCRE2)
+#define USE_BITMATCH
+#endif
+
+/* Maximum number of threads loading a ruleset in parallel */
+#define LOAD_THREADS 4
+
+/* Modification counters kept in the generation record */
+#define GENERATION_EXCEPTIONS 0 /* Exceptions dictionary */
+#define GENERATION_LEXBASES 1 /* Lexical bases dictionary */
+#define GENERATION_RULES 2 /* All the rulesets */
+#define GENERATIONS 3
+
+/* Precompiled rulesets format stamp */
+#define RULES_IMAGE_MAGIC 0x52554c58
+#define RULES_IMAGE_VERSION 1
 
 /* Data storage methods */
 #ifdef USE_BDB
 #define LEXICON_DB_TYPE DB_BTREE
 #define RULES_DB_TYPE DB_RECNO
+#define COMPILED_DB_TYPE DB_BTREE
 #else
 #define LMDB_MAP_SIZE (64 * 1024 * 1024)
-#define LMDB_MAX_DBS 6
+#define LMDB_MAX_DBS 7
+
+/*
+ * Rules are stored in the integer keyed LMDB datasets. Originally
+ * the keys were the rule numbers themselves (dense format), so
+ * inserting or removing a rule in the middle of a ruleset
+ * meant rewriting all the following records. In the sparse format
+ * the keys only define the rules order and are spread with gaps,
+ * so a new rule usually gets a key between its neighbours
+ * and removal touches the only record. When there is no gap left,
+ * the nearest neighbourhood of the insertion point is respaced.
+ * The rule numbers are ranks of the keys then. Sparse rulesets
+ * are marked by the format stamp record. Dense rulesets have no stamp
+ * and are converted to the sparse format only by an insertion
+ * or removal in the middle, so they remain readable as before.
+ */
+
+/* Rulesets records ordering formats */
+#define RULES_FORMAT_DENSE 1 /* Records are keyed by the rule numbers */
+#define RULES_FORMAT_SPARSE 2 /* Records keys only define the rules order */
+
+/* Key of the ruleset format stamp record */
+#define RULES_FORMAT_KEY 0
+
+/* Distance between the keys of the rules appended to a sparse ruleset */
+#define RULES_KEY_STEP 0x10000
 #endif
 
 
@@ -61,6 +135,100 @@ static const char *rules_db_name = "General";
 static const char *lexclasses_db_name = "Lexclasses";
 static const char *prefixes_db_name = "Prefixes";
 static const char *corrections_db_name = "Corrections";
+static const char *compiled_db_name = "Compiled";
+
+/* All the rulesets in the compiled lexicon file order */
+static const int rule_types[4] =
+  {
+    RULEXDB_RULE, RULEXDB_LEXCLASS, RULEXDB_PREFIX, RULEXDB_CORRECTOR
+  };
+
+/* Frozen search results table record name */
+static const char *frozen_record_name = "Frozen";
+
+/* Dictionary keys packing format stamp record name */
+static const char *keys_format_record_name = "Keys format";
+
+/* Data modification counters record name */
+static const char *generation_record_name = "Generation";
+
+/* Dictionary transducers records names */
+static const char *lexicon_fst_name = "Lexbases transducer";
+static const char *exceptions_fst_name = "Exceptions transducer";
+
+/* Characters order of the transducer records being sorted */
+static const unsigned char *fst_order;
+
+
+/* Data structures */
+
+/*
+ * Precompiled ruleset is stored as a single record keyed by
+ * the ruleset name. The header is followed by the array
+ * of entries describing each rule and the matchers images
+ * aligned at 8 bytes boundary.
+ */
+
+typedef struct /* Precompiled ruleset header */
+{
+  uint32_t magic; /* RULES_IMAGE_MAGIC */
+  uint32_t version; /* RULES_IMAGE_VERSION */
+  uint32_t matcher_version; /* BITMATCH_VERSION */
+  uint32_t nrules; /* Number of rules in the ruleset */
+} RULES_IMAGE_HEADER;
+
+typedef struct /* Precompiled rule entry */
+{
+  uint32_t hash; /* Hash value of the rule pattern source */
+  uint32_t offset; /* Matcher image offset from the record beginning */
+  uint32_t size; /* Matcher image size or 0 if it is absent */
+  uint32_t reserved;
+} RULES_IMAGE_ENTRY;
+
+typedef struct /* Ruleset loading job shared by the threads */
+{
+  RULEXDB *rulexdb; /* Database handler */
+  RULEX_RULESET *rules; /* The ruleset to be loaded */
+  char **pattern; /* Pattern sources of the rules */
+  char **replacement; /* Replacement strings of the rules */
+  int next; /* Number of the next rule to be taken */
+  int rc; /* Error code of the first failure if any */
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t lock; /* Guards the next and rc fields */
+#endif
+} RULES_LOADER;
+
+typedef struct /* Dictionary lookup item of a batch search */
+{
+  size_t offset; /* Packed key offset in the keys pool */
+  const char *key; /* Packed key itself (when the pool is complete) */
+  int keylen; /* Packed key length or 0 if the key is invalid */
+  int len; /* Source string length */
+  int word; /* Number of the word in the batch */
+  int base; /* Number of the lexical base candidate for this word */
+  const void *data; /* Found data or NULL */
+  size_t size; /* Found data size */
+} BATCH_ITEM;
+
+typedef struct /* Dictionary lookups of a batch search */
+{
+  BATCH_ITEM *item; /* Array of the lookup items */
+  int n; /* Number of the items */
+  int size; /* Allocated size of the items array */
+  char *pool; /* Packed keys pool */
+  size_t pool_len; /* Used space in the pool */
+  size_t pool_size; /* Allocated size of the pool */
+  const RULEX_KEYCODER *coder; /* Keys packing format */
+} BATCH;
+
+/* Loading job access serialization */
+#ifdef HAVE_PTHREAD_H
+#define loader_lock(job) (void)pthread_mutex_lock(&(job)->lock)
+#define loader_unlock(job) (void)pthread_mutex_unlock(&(job)->lock)
+#else
+#define loader_lock(job)
+#define loader_unlock(job)
+#endif
 
 
 /* Local routines */
@@ -140,13 +308,18 @@ static void db_close(DB *db)
   return;
 }
 
-static int db_get(DB *db, const char *key, char *value)
+static int db_get(DB *db, const RULEX_KEYCODER *coder,
+		  const RULEX_IMAGE *filter,
+		  const char *key, char *value, unsigned int *probes)
      /*
       * Retrieve data from dictionary dataset.
       * This routine performs all the work concerning key and value coding.
       * The argument "value" must point to memory area where
       * the resulting string will be placed. This area must have
       * enough space. It will be a copy of key if search fails.
+      * The keys rejected by the membership filter (if any)
+      * are not looked up at all. The counter pointed by probes
+      * (if any) is incremented for every real lookup.
       *
       * This routine returns 0 in the case of success.
       * If specified key doesn't exist, then RULEXDB_SPECIAL is returned.
@@ -159,10 +332,13 @@ static int db_get(DB *db, const char *key, char *value)
 
   (void)memset(&inKey, 0, sizeof(DBT));
   (void)memset(&inVal, 0, sizeof(DBT));
-  inKey.size = pack_key(key, packed_key);
+  inKey.size = coder->pack(key, packed_key);
   if ((signed int)(inKey.size) <= 0)
     return RULEXDB_EINVKEY;
+  if (filter && !filter_check(filter->image, packed_key, inKey.size))
+    return RULEXDB_SPECIAL;
   inKey.data = packed_key;
+  if (probes) (*probes)++;
   rc = db->get(db, NULL, &inKey, &inVal, 0);
   switch (rc)
     {
@@ -227,16 +403,21 @@ static unsigned int lmdb_nrecs(MDB_txn *txn, MDB_dbi dbi)
   return (unsigned int)st.ms_entries;
 }
 
-static int lmdb_get(MDB_txn *txn, MDB_dbi dbi, const char *key, char *value)
+static int lmdb_get(MDB_txn *txn, MDB_dbi dbi, const RULEX_KEYCODER *coder,
+		    const RULEX_IMAGE *filter,
+		    const char *key, char *value, unsigned int *probes)
 {
   int rc;
   char packed_key[RULEXDB_BUFSIZE];
   MDB_val inKey, inVal;
 
-  inKey.mv_size = (size_t)pack_key(key, packed_key);
+  inKey.mv_size = (size_t)coder->pack(key, packed_key);
   if ((signed int)inKey.mv_size <= 0)
     return RULEXDB_EINVKEY;
+  if (filter && !filter_check(filter->image, packed_key, inKey.mv_size))
+    return RULEXDB_SPECIAL;
   inKey.mv_data = packed_key;
+  if (probes) (*probes)++;
   rc = mdb_get(txn, dbi, &inKey, &inVal);
   switch (rc)
     {
@@ -251,25 +432,464 @@ static int lmdb_get(MDB_txn *txn, MDB_dbi dbi, const char *key, char *value)
   return RULEXDB_FAILURE;
 }
 
-static char *lmdb_rule_get(MDB_txn *txn, MDB_dbi dbi, char *rule_buf, int n)
+static int lmdb_rules_format(RULEXDB *rulexdb, RULEX_RULESET *rules)
+     /*
+      * Determine records ordering format of the opened ruleset.
+      */
+{
+  uint32_t recno = RULES_FORMAT_KEY, format;
+  MDB_val key, data;
+
+  if (rules->format)
+    return rules->format;
+  rules->format = RULES_FORMAT_DENSE;
+  key.mv_data = &recno;
+  key.mv_size = sizeof(uint32_t);
+  if ((!mdb_get(rulexdb->txn, rules->dbi, &key, &data)) &&
+      (data.mv_size == sizeof(uint32_t)))
+    {
+      (void)memcpy(&format, data.mv_data, sizeof(uint32_t));
+      rules->format = (int)format;
+    }
+  return rules->format;
+}
+
+static unsigned int lmdb_rules_count(RULEXDB *rulexdb, RULEX_RULESET *rules)
+     /*
+      * Count rules in the opened ruleset.
+      */
+{
+  unsigned int n = lmdb_nrecs(rulexdb->txn, rules->dbi);
+
+  if (n && (lmdb_rules_format(rulexdb, rules) != RULES_FORMAT_DENSE))
+    n--;
+  return n;
+}
+
+static int lmdb_rules_index(RULEXDB *rulexdb, RULEX_RULESET *rules)
+     /*
+      * Load keys of all the records of the opened ruleset
+      * in the rules order if it is not done yet.
+      */
+{
+  int rc;
+  uint32_t recno;
+  unsigned int size;
+  MDB_cursor *cursor;
+  MDB_val key, data;
+
+  if (rules->keys)
+    return RULEXDB_SUCCESS;
+  size = lmdb_nrecs(rulexdb->txn, rules->dbi) + 1;
+  rules->keys = malloc(size * sizeof(unsigned int));
+  if (!rules->keys)
+    return RULEXDB_EMALLOC;
+  rules->nkeys = 0;
+  if (mdb_cursor_open(rulexdb->txn, rules->dbi, &cursor))
+    rc = RULEXDB_FAILURE;
+  else
+    {
+      while (!(rc = mdb_cursor_get(cursor, &key, &data, MDB_NEXT)))
+        {
+          if (key.mv_size != sizeof(uint32_t))
+            continue;
+          (void)memcpy(&recno, key.mv_data, sizeof(uint32_t));
+          if ((recno == RULES_FORMAT_KEY) || (rules->nkeys >= size))
+            continue;
+          rules->keys[rules->nkeys++] = recno;
+        }
+      mdb_cursor_close(cursor);
+      if (rc == MDB_NOTFOUND)
+        return RULEXDB_SUCCESS;
+      rc = RULEXDB_FAILURE;
+    }
+  free(rules->keys);
+  rules->keys = NULL;
+  rules->nkeys = 0;
+  return rc;
+}
+
+static int lmdb_rule_key(RULEXDB *rulexdb, RULEX_RULESET *rules,
+                         int n, uint32_t *recno)
+     /*
+      * Find record key of the rule number n (counting from 1).
+      */
+{
+  int rc;
+
+  if (n < 1)
+    return RULEXDB_EINVKEY;
+  if (lmdb_rules_format(rulexdb, rules) == RULES_FORMAT_DENSE)
+    {
+      *recno = (uint32_t)n;
+      return RULEXDB_SUCCESS;
+    }
+  rc = lmdb_rules_index(rulexdb, rules);
+  if (rc)
+    return rc;
+  if ((unsigned int)n > rules->nkeys)
+    return RULEXDB_EINVKEY;
+  *recno = rules->keys[n - 1];
+  return RULEXDB_SUCCESS;
+}
+
+static char *lmdb_rule_get(RULEXDB *rulexdb, RULEX_RULESET *rules, int n)
 {
-  uint32_t recno = (uint32_t)n;
+  uint32_t recno;
   MDB_val key, data;
   size_t len;
 
+  if (lmdb_rule_key(rulexdb, rules, n, &recno))
+    return NULL;
   key.mv_data = &recno;
   key.mv_size = sizeof(uint32_t);
-  if (mdb_get(txn, dbi, &key, &data))
+  if (mdb_get(rulexdb->txn, rules->dbi, &key, &data))
     return NULL;
   len = data.mv_size < (size_t)(RULEXDB_BUFSIZE - 1)
         ? data.mv_size : (size_t)(RULEXDB_BUFSIZE - 1);
-  memcpy(rule_buf, data.mv_data, len);
-  rule_buf[len] = '\0';
-  return rule_buf;
+  memcpy(rules->rule_buf, data.mv_data, len);
+  rules->rule_buf[len] = '\0';
+  return rules->rule_buf;
+}
+
+static int lmdb_rules_sparse(RULEXDB *rulexdb, RULEX_RULESET *rules)
+     /*
+      * Convert the opened ruleset to the sparse format.
+      * The records are not moved, only the format stamp is stored.
+      */
+{
+  int rc;
+  uint32_t recno = RULES_FORMAT_KEY, format = RULES_FORMAT_SPARSE;
+  MDB_val key, data;
+
+  if (lmdb_rules_format(rulexdb, rules) == RULES_FORMAT_SPARSE)
+    return RULEXDB_SUCCESS;
+  rc = lmdb_rules_index(rulexdb, rules);
+  if (rc)
+    return rc;
+  key.mv_data = &recno;
+  key.mv_size = sizeof(uint32_t);
+  data.mv_data = &format;
+  data.mv_size = sizeof(uint32_t);
+  if (mdb_put(rulexdb->txn, rules->dbi, &key, &data, 0))
+    return RULEXDB_FAILURE;
+  rules->format = RULES_FORMAT_SPARSE;
+  return RULEXDB_SUCCESS;
+}
+
+static int lmdb_rule_insert(RULEXDB *rulexdb, RULEX_RULESET *rules,
+                            unsigned int n, const char *src)
+     /*
+      * Insert new rule into the sparse format ruleset
+      * before the rule number n (counting from 0).
+      *
+      * The new record gets a key between its neighbours.
+      * If there is no room for it, the smallest neighbourhood
+      * where the gaps can be made wider than the number of records
+      * is respaced evenly, so the subsequent insertions
+      * in the same place are cheap.
+      */
+{
+  int rc = RULEXDB_SUCCESS;
+  unsigned int *keys, width, lo, hi, m, i, j;
+  uint64_t low, high, gap;
+  uint32_t recno;
+  MDB_val key, data, *saved;
+
+  keys = realloc(rules->keys, (rules->nkeys + 1) * sizeof(unsigned int));
+  if (!keys)
+    return RULEXDB_EMALLOC;
+  rules->keys = keys;
+  low = n ? keys[n - 1] : RULES_FORMAT_KEY;
+  high = (n < rules->nkeys) ? keys[n] : (uint64_t)UINT32_MAX + 1;
+  gap = (high - low) / 2;
+  if ((n == rules->nkeys) && (gap > RULES_KEY_STEP))
+    gap = RULES_KEY_STEP;
+  recno = (uint32_t)(low + gap);
+  if (!gap)
+    {
+      /* Find the neighbourhood to respace */
+      for (width = 1; ; width *= 2)
+        {
+          lo = (n > width) ? n - width : 0;
+          hi = (rules->nkeys - n > width) ? n + width : rules->nkeys;
+          low = lo ? keys[lo - 1] : RULES_FORMAT_KEY;
+          high = (hi < rules->nkeys) ? keys[hi] : (uint64_t)UINT32_MAX + 1;
+          m = hi - lo + 1;
+          gap = (high - low) / (m + 1);
+          if (gap > m)
+            break;
+          if ((!lo) && (hi == rules->nkeys))
+            {
+              if (gap > 1)
+                break;
+              return RULEXDB_FAILURE;
+            }
+        }
+
+      /* Save the records and remove them from their places */
+      saved = calloc(m - 1, sizeof(MDB_val));
+      if (!saved)
+        return RULEXDB_EMALLOC;
+      for (i = lo; i < hi; i++)
+        {
+          key.mv_data = &keys[i];
+          key.mv_size = sizeof(uint32_t);
+          if (mdb_get(rulexdb->txn, rules->dbi, &key, &data))
+            {
+              rc = RULEXDB_FAILURE;
+              break;
+            }
+          saved[i - lo].mv_data = malloc(data.mv_size);
+          if (!saved[i - lo].mv_data)
+            {
+              rc = RULEXDB_EMALLOC;
+              break;
+            }
+          (void)memcpy(saved[i - lo].mv_data, data.mv_data, data.mv_size);
+          saved[i - lo].mv_size = data.mv_size;
+        }
+      for (i = lo; (i < hi) && !rc; i++)
+        {
+          key.mv_data = &keys[i];
+          key.mv_size = sizeof(uint32_t);
+          if (mdb_del(rulexdb->txn, rules->dbi, &key, NULL))
+            rc = RULEXDB_FAILURE;
+        }
+
+      /* Store them back with new keys leaving a slot for the new rule */
+      for (j = 0; (j < m) && !rc; j++)
+        {
+          if (j == n - lo)
+            {
+              recno = (uint32_t)(low + (j + 1) * (high - low) / (m + 1));
+              continue;
+            }
+          i = (j < n - lo) ? j : j - 1;
+          keys[lo + i] = (uint32_t)(low + (j + 1) * (high - low) / (m + 1));
+          key.mv_data = &keys[lo + i];
+          key.mv_size = sizeof(uint32_t);
+          if (mdb_put(rulexdb->txn, rules->dbi, &key, &saved[i], 0))
+            rc = RULEXDB_FAILURE;
+        }
+      for (i = 0; i < m - 1; i++)
+        free(saved[i].mv_data);
+      free(saved);
+      if (rc)
+        return rc;
+    }
+
+  key.mv_data = &recno;
+  key.mv_size = sizeof(uint32_t);
+  data.mv_data = (char *)src;
+  data.mv_size = strlen(src) + 1;
+  if (mdb_put(rulexdb->txn, rules->dbi, &key, &data, 0))
+    return RULEXDB_FAILURE;
+  (void)memmove(keys + n + 1, keys + n,
+                (rules->nkeys - n) * sizeof(unsigned int));
+  keys[n] = recno;
+  rules->nkeys++;
+  return RULEXDB_SUCCESS;
 }
 
 #endif /* USE_BDB */
 
+static uint32_t rule_hash(const char *s)
+     /*
+      * Compute hash value of the rule pattern source
+      * (32-bit FNV-1a).
+      */
+{
+  uint32_t h = 2166136261U;
+
+  while (*s)
+    {
+      h ^= (unsigned char)*s++;
+      h *= 16777619U;
+    }
+  return h;
+}
+
+static const void *lexfile_rules(RULEXDB *rulexdb, RULEX_RULESET *rules,
+				 int precompiled, size_t *size)
+     /*
+      * Get the rules list of the ruleset or, if precompiled
+      * is non-zero, its precompiled form from the compiled
+      * lexicon file. Returns NULL if it is absent.
+      */
+{
+  int n;
+
+  if (rules == &rulexdb->lexclasses)
+    n = LEXFILE_LEXCLASSES;
+  else if (rules == &rulexdb->prefixes)
+    n = LEXFILE_PREFIXES;
+  else if (rules == &rulexdb->correctors)
+    n = LEXFILE_CORRECTIONS;
+  else n = LEXFILE_RULES;
+  if (precompiled)
+    n += LEXFILE_IMAGES - LEXFILE_RULES;
+  return lexfile_section(rulexdb->lexfile.image, n, size);
+}
+
+#ifdef USE_BITMATCH
+static void rules_image_fetch(RULEXDB *rulexdb, RULEX_RULESET *rules)
+     /*
+      * Fetch the precompiled form of the ruleset from the database
+      * if it is there.
+      */
+{
+#ifdef USE_BDB
+  DB *db;
+  DBT inKey, inVal;
+
+  if (rulexdb->mode != RULEXDB_SEARCH)
+    return;
+  db = db_open(rules->env, compiled_db_name, COMPILED_DB_TYPE, RULEXDB_SEARCH);
+  if (!db) return;
+  (void)memset(&inKey, 0, sizeof(DBT));
+  (void)memset(&inVal, 0, sizeof(DBT));
+  inKey.data = (char *)rules->db_name;
+  inKey.size = strlen(rules->db_name) + 1;
+  inVal.flags = DB_DBT_MALLOC;
+  if (!db->get(db, NULL, &inKey, &inVal, 0))
+    {
+      rules->image = rules->image_buf = inVal.data;
+      rules->image_size = inVal.size;
+    }
+  db_close(db);
+#else
+  MDB_dbi dbi;
+  MDB_val key, data;
+
+  /* Mapped data may be moved by updates */
+  if (rulexdb->mode != RULEXDB_SEARCH)
+    return;
+  if (mdb_dbi_open(rulexdb->txn, compiled_db_name, 0, &dbi))
+    return;
+  key.mv_data = (char *)rules->db_name;
+  key.mv_size = strlen(rules->db_name) + 1;
+  if (mdb_get(rulexdb->txn, dbi, &key, &data))
+    return;
+  if ((uintptr_t)data.mv_data & 7) /* Copy misaligned image */
+    {
+      rules->image_buf = malloc(data.mv_size);
+      if (!rules->image_buf) return;
+      (void)memcpy(rules->image_buf, data.mv_data, data.mv_size);
+      rules->image = rules->image_buf;
+    }
+  else rules->image = data.mv_data;
+  rules->image_size = data.mv_size;
+#endif
+}
+
+static void rules_image_load(RULEXDB *rulexdb, RULEX_RULESET *rules)
+     /*
+      * Look for the precompiled form of the ruleset in the database.
+      * The image is used only if its format and the number of rules
+      * match. Any failure here is not fatal: the rules will be
+      * compiled from their sources in this case.
+      *
+      * The ruleset itself must be initialized before.
+      */
+{
+  const RULES_IMAGE_HEADER *header;
+
+  /* The compiled lexicon file sections are aligned */
+  if (rulexdb->lexfile.image)
+    rules->image = lexfile_rules(rulexdb, rules, 1, &rules->image_size);
+  else rules_image_fetch(rulexdb, rules);
+
+  /* Check the format stamp */
+  header = rules->image;
+  if ((rules->image_size < sizeof(RULES_IMAGE_HEADER)) ||
+      (header->magic != RULES_IMAGE_MAGIC) ||
+      (header->version != RULES_IMAGE_VERSION) ||
+      (header->matcher_version != BITMATCH_VERSION) ||
+      (header->nrules != (uint32_t)rules->nrules) ||
+      ((rules->image_size - sizeof(RULES_IMAGE_HEADER)) /
+       sizeof(RULES_IMAGE_ENTRY) < (size_t)rules->nrules))
+    {
+      free(rules->image_buf);
+      rules->image_buf = NULL;
+      rules->image = NULL;
+      rules->image_size = 0;
+    }
+  return;
+}
+
+static RULEX_BITMATCH *rule_image(RULEX_RULESET *rules, int n,
+				  const char *rule_src)
+     /*
+      * Get the precompiled matcher for the rule number n
+      * if it is available and corresponds to the rule source.
+      * Returns NULL otherwise.
+      */
+{
+  const RULES_IMAGE_ENTRY *entry;
+
+  if (!rules->image)
+    return NULL;
+  entry = (const RULES_IMAGE_ENTRY *)
+    ((const RULES_IMAGE_HEADER *)rules->image + 1) + n;
+  if ((!entry->size) || (entry->hash != rule_hash(rule_src)) ||
+      (entry->offset > rules->image_size) ||
+      (entry->size > rules->image_size - entry->offset))
+    return NULL;
+  return (RULEX_BITMATCH *)bitmatch_map((const char *)rules->image +
+					entry->offset, entry->size);
+}
+#endif
+
+static int rule_mapped(RULEX_RULESET *rules, int n)
+     /*
+      * Check whether the matcher of the rule number n
+      * belongs to the precompiled ruleset image.
+      */
+{
+  const char *p = (const char *)rules->bitmatch[n];
+
+  return rules->image && (p >= (const char *)rules->image) &&
+    (p < (const char *)rules->image + rules->image_size);
+}
+
+static int rules_alloc(RULEXDB *rulexdb, RULEX_RULESET *rules)
+     /*
+      * Allocate the arrays indexed by the rule numbers
+      * for the ruleset which size is already known
+      * and look for its precompiled form.
+      *
+      * On failure the ruleset is smudged for future.
+      */
+{
+  if (rules->nrules <= 0) /* Empty */
+    return RULEXDB_SUCCESS;
+  rules->pattern = calloc((size_t)rules->nrules, sizeof(*rules->pattern));
+  rules->replacement = calloc((size_t)rules->nrules, sizeof(char *));
+  rules->bitmatch = calloc((size_t)rules->nrules,
+			   sizeof(struct RULEX_BITMATCH *));
+  if (rulexdb->options & RULEXDB_STATS)
+    rules->stats = calloc((size_t)rules->nrules, sizeof(RULEXDB_RULE_STATS));
+  if (!(rules->pattern && rules->replacement && rules->bitmatch &&
+	(rules->stats || !(rulexdb->options & RULEXDB_STATS))))
+    {
+      free(rules->stats);
+      rules->stats = NULL;
+      free(rules->bitmatch);
+      rules->bitmatch = NULL;
+      free(rules->replacement);
+      rules->replacement = NULL;
+      free(rules->pattern);
+      rules->pattern = NULL;
+      rules->nrules = -1;
+      return RULEXDB_EMALLOC;
+    }
+#ifdef USE_BITMATCH
+  rules_image_load(rulexdb, rules);
+#endif
+  return RULEXDB_SUCCESS;
+}
+
 static int rules_init(RULEXDB *rulexdb, RULEX_RULESET *rules)
      /*
       * Initialize ruleset for subsequent fetching and loading
@@ -281,8 +901,25 @@ static int rules_init(RULEXDB *rulexdb, RULEX_RULESET *rules)
       * RULEXDB_EACCESS error code will be returned.
       */
 {
+  size_t size;
+#ifdef USE_BDB
+  int rc;
+#else
+  unsigned int flags;
+#endif
+
+  if (rulexdb->lexfile.image) /* Compiled lexicon file */
+    {
+      if (rules->nrules < 0)
+	return RULEXDB_EACCESS;
+      if (rules->list)
+	return RULEXDB_SUCCESS;
+      rules->list = lexfile_rules(rulexdb, rules, 0, &size);
+      rules->nrules = rules->list ? (int)lexfile_list_count(rules->list) : 0;
+      return rules_alloc(rulexdb, rules);
+    }
+
 #ifdef USE_BDB
-  (void)rulexdb;
   if (rules->nrules < 0) /* Cannot be initialized for loading */
     return RULEXDB_EACCESS;
   if (rules->db) /* Already initialized */
@@ -295,34 +932,17 @@ static int rules_init(RULEXDB *rulexdb, RULEX_RULESET *rules)
       return RULEXDB_FAILURE;
     }
   rules->nrules = db_nrecs(rules->db);
-  if (rules->nrules > 0) /* Not empty */
+  rc = rules_alloc(rulexdb, rules);
+  if (rc)
     {
-      /* Allocate memory for pointers */
-      rules->pattern = calloc(rules->nrules, sizeof(regex_t *));
-      if (!rules->pattern)
-	{
-	  db_close(rules->db);
-	  rules->db = NULL;
-	  rules->nrules = -1;
-	  return RULEXDB_EMALLOC;
-	}
-      rules->replacement = calloc(rules->nrules, sizeof(char *));
-      if (!rules->replacement)
-	{
-	  free(rules->pattern);
-	  db_close(rules->db);
-	  rules->db = NULL;
-	  rules->nrules = -1;
-	  return RULEXDB_EMALLOC;
-	}
+      db_close(rules->db);
+      rules->db = NULL;
     }
-  return RULEXDB_SUCCESS;
+  return rc;
 #else
-  unsigned int flags;
-
   if (rules->nrules < 0)
     return RULEXDB_EACCESS;
-  if (rules->dbi_open)
+  if (rules->dbi_open || rulexdb->shared)
     return RULEXDB_SUCCESS;
 
   flags = MDB_INTEGERKEY;
@@ -335,56 +955,243 @@ static int rules_init(RULEXDB *rulexdb, RULEX_RULESET *rules)
       return RULEXDB_SUCCESS;
     }
   rules->dbi_open = 1;
-  rules->nrules = (int)lmdb_nrecs(rulexdb->txn, rules->dbi);
-
-  if (rules->nrules > 0)
-    {
-      rules->pattern = calloc((size_t)rules->nrules, sizeof(regex_t *));
-      if (!rules->pattern)
-        {
-          rules->nrules = -1;
-          return RULEXDB_EMALLOC;
-        }
-      rules->replacement = calloc((size_t)rules->nrules, sizeof(char *));
-      if (!rules->replacement)
-        {
-          free(rules->pattern);
-          rules->pattern = NULL;
-          rules->nrules = -1;
-          return RULEXDB_EMALLOC;
-        }
-    }
-  return RULEXDB_SUCCESS;
+  rules->nrules = (int)lmdb_rules_count(rulexdb, rules);
+  return rules_alloc(rulexdb, rules);
 #endif
 }
 
-static int rule_load(RULEXDB *rulexdb, RULEX_RULESET *rules, int n)
+static char *rule_text(RULEXDB *rulexdb, RULEX_RULESET *rules, int n)
      /*
-      * Preload specified rule and turn it into internal representation.
-      *
-      * This routine at first checks if specified rule is already loaded
-      * and exits successfully if so.
+      * Fetch the rule number n (counting from 0) and return pointer
+      * to its text representation or NULL when failure.
+      * This pointer is valid only until the next database operation.
       *
-      * The ruleset itself must be initialized before.
+      * The ruleset itself must be initialized or opened before.
       */
 {
-  int rc;
-  char *s, *rule_src;
-
-  if (n >= rules->nrules) /* Specified rule number validation */
-    return RULEXDB_EPARM;
-  if (rules->pattern[n]) /* Already loaded */
-    return RULEXDB_SUCCESS;
+  if (rules->list)
+    {
+      if ((n < 0) || (n >= rules->nrules))
+	return NULL;
+      (void)strncpy(rules->rule_buf, lexfile_list_get(rules->list, n),
+		    RULEXDB_BUFSIZE - 1);
+      rules->rule_buf[RULEXDB_BUFSIZE - 1] = 0;
+      return rules->rule_buf;
+    }
+#ifdef USE_BDB
+  (void)rulexdb;
+  return rule_get(rules->db, n + 1);
+#else
+  return lmdb_rule_get(rulexdb, rules, n + 1);
+#endif
+}
 
-  /* Get rule source */
+static int rule_put(RULEXDB *rulexdb, RULEX_RULESET *rules, int n,
+		    const char *src)
+     /*
+      * Replace the rule number n (counting from 0)
+      * by the one specified by its text representation.
+      *
+      * The ruleset must be opened for updating before.
+      */
+{
 #ifdef USE_BDB
+  DBT inKey, inVal;
+  db_recno_t recno = n + 1;
+
   (void)rulexdb;
-  rule_src = rule_get(rules->db, n + 1);
+  (void)memset(&inKey, 0, sizeof(DBT));
+  (void)memset(&inVal, 0, sizeof(DBT));
+  inKey.data = &recno;
+  inKey.size = sizeof(db_recno_t);
+  inVal.data = (char *)src;
+  inVal.size = strlen(src) + 1;
+  if (rules->db->put(rules->db, NULL, &inKey, &inVal, 0))
+    return RULEXDB_FAILURE;
 #else
-  rule_src = lmdb_rule_get(rulexdb->txn, rules->dbi, rules->rule_buf, n + 1);
+  uint32_t recno;
+  MDB_val key, data;
+
+  if (lmdb_rule_key(rulexdb, rules, n + 1, &recno))
+    return RULEXDB_FAILURE;
+  key.mv_data = &recno;
+  key.mv_size = sizeof(uint32_t);
+  data.mv_data = (char *)src;
+  data.mv_size = strlen(src) + 1;
+  if (mdb_put(rulexdb->txn, rules->dbi, &key, &data, 0))
+    return RULEXDB_FAILURE;
 #endif
+  return RULEXDB_SUCCESS;
+}
+
+static char *rule_source(RULEXDB *rulexdb, RULEX_RULESET *rules, int n)
+     /*
+      * Fetch the rule number n (counting from 0) and return pointer
+      * to its pattern or NULL when failure. The replacement string
+      * if any can be obtained then by subsequent strtok(NULL, " ") call.
+      *
+      * The ruleset itself must be initialized before.
+      */
+{
+  char *rule_src = rule_text(rulexdb, rules, n);
+
   if (!rule_src)
+    return NULL;
+  return strtok(rule_src, " ");
+}
+
+static int rules_scan(RULEXDB *rulexdb, RULEX_RULESET *rules, char **source)
+     /*
+      * Fetch all the rules of the ruleset by a single pass
+      * over the dataset. Copies of their text representations
+      * are placed into the array pointed by source and indexed
+      * by the rule numbers (counting from 0). The entries for absent
+      * rules are left untouched, so the array should be zeroed before.
+      *
+      * The ruleset itself must be initialized before.
+      */
+{
+  int i, rc;
+  size_t len;
+#ifdef USE_BDB
+  DBC *dbc;
+  DBT inKey, inVal;
+  db_recno_t n;
+#else
+  uint32_t recno, n = 0;
+  MDB_cursor *cursor;
+  MDB_val key, data;
+#endif
+
+  if (rules->list)
+    {
+      for (i = 0; i < rules->nrules; i++)
+	if (!source[i])
+	  {
+	    source[i] = strdup(lexfile_list_get(rules->list, i));
+	    if (!source[i])
+	      return RULEXDB_EMALLOC;
+	  }
+      return RULEXDB_SUCCESS;
+    }
+
+#ifdef USE_BDB
+  (void)rulexdb;
+  if (rules->db->cursor(rules->db, NULL, &dbc, 0))
     return RULEXDB_FAILURE;
+  (void)memset(&inKey, 0, sizeof(DBT));
+  (void)memset(&inVal, 0, sizeof(DBT));
+  while (!(rc = dbc->c_get(dbc, &inKey, &inVal, DB_NEXT)))
+    {
+      n = *(db_recno_t *)inKey.data;
+      if ((n < 1) || (n > (db_recno_t)rules->nrules) || source[n - 1])
+	continue;
+      len = inVal.size;
+      source[n - 1] = malloc(len + 1);
+      if (!source[n - 1])
+	{
+	  rc = RULEXDB_EMALLOC;
+	  break;
+	}
+      (void)memcpy(source[n - 1], inVal.data, len);
+      source[n - 1][len] = 0;
+    }
+  (void)dbc->c_close(dbc);
+  if (rc == DB_NOTFOUND)
+    return RULEXDB_SUCCESS;
+#else
+  if (mdb_cursor_open(rulexdb->txn, rules->dbi, &cursor))
+    return RULEXDB_FAILURE;
+  while (!(rc = mdb_cursor_get(cursor, &key, &data, MDB_NEXT)))
+    {
+      if (key.mv_size != sizeof(uint32_t))
+        continue;
+      (void)memcpy(&recno, key.mv_data, sizeof(uint32_t));
+      if (recno == RULES_FORMAT_KEY)
+        continue;
+      if ((++n > (uint32_t)rules->nrules) || source[n - 1])
+        continue;
+      len = data.mv_size < (size_t)(RULEXDB_BUFSIZE - 1)
+            ? data.mv_size : (size_t)(RULEXDB_BUFSIZE - 1);
+      source[n - 1] = malloc(len + 1);
+      if (!source[n - 1])
+        {
+          rc = RULEXDB_EMALLOC;
+          break;
+        }
+      (void)memcpy(source[n - 1], data.mv_data, len);
+      source[n - 1][len] = 0;
+    }
+  mdb_cursor_close(cursor);
+  if (rc == MDB_NOTFOUND)
+    return RULEXDB_SUCCESS;
+#endif
+  return (rc == RULEXDB_EMALLOC) ? rc : RULEXDB_FAILURE;
+}
+
+#ifdef USE_PCRE2
+static int rules_pcre2_init(RULEXDB *rulexdb, RULEX_RULESET *rules)
+     /*
+      * Prepare the data shared by all compiled patterns of the ruleset.
+      *
+      * This routine must be called before compiling rules
+      * in parallel threads.
+      */
+{
+  /* Prepare compiling context for the current locale */
+  if (!rulexdb->pcre2_context)
+    {
+      rulexdb->pcre2_context = pcre2_compile_context_create(NULL);
+      if (!rulexdb->pcre2_context)
+	return RULEXDB_EMALLOC;
+      rulexdb->pcre2_tables = pcre2_maketables(NULL);
+      if (!rulexdb->pcre2_tables)
+	{
+	  pcre2_compile_context_free(rulexdb->pcre2_context);
+	  rulexdb->pcre2_context = NULL;
+	  return RULEXDB_EMALLOC;
+	}
+      (void)pcre2_set_character_tables(rulexdb->pcre2_context,
+				       rulexdb->pcre2_tables);
+    }
+
+  /* Match data block is shared by all the rules */
+  if (!rules->match_data)
+    {
+      rules->match_data = pcre2_match_data_create(MAX_SUBMATCHES, NULL);
+      if (!rules->match_data)
+	return RULEXDB_EMALLOC;
+    }
+  return RULEXDB_SUCCESS;
+}
+#endif
+
+static int rule_compile(RULEXDB *rulexdb, RULEX_RULESET *rules, int n,
+			const char *rule_src)
+     /*
+      * Compile the pattern of the rule number n
+      * by the regular expressions engine.
+      */
+{
+  int rc;
+#ifdef USE_PCRE2
+  PCRE2_SIZE offset;
+
+  rc = rules_pcre2_init(rulexdb, rules);
+  if (rc) return rc;
+
+  /* Compile pattern */
+  rules->pattern[n] = pcre2_compile((PCRE2_SPTR)rule_src,
+				    PCRE2_ZERO_TERMINATED,
+				    PCRE2_CASELESS | PCRE2_DOLLAR_ENDONLY,
+				    &rc, &offset, rulexdb->pcre2_context);
+  if (!rules->pattern[n]) /* Pattern compiling failure */
+    return RULEXDB_FAILURE;
+
+  /* JIT compiling failure is not fatal */
+  (void)pcre2_jit_compile(rules->pattern[n], PCRE2_JIT_COMPLETE);
+#else
+  (void)rulexdb;
 
   /* Allocate memory for compiled pattern */
   rules->pattern[n] = calloc(1, sizeof(regex_t));
@@ -392,13 +1199,7 @@ static int rule_load(RULEXDB *rulexdb, RULEX_RULESET *rules, int n)
     return RULEXDB_EMALLOC;
 
   /* Compile pattern */
-#ifdef USE_BDB
-  rc = regcomp(rules->pattern[n], strtok(rule_src, " "),
-	       REG_EXTENDED | REG_ICASE);
-#else
-  rc = regcomp(rules->pattern[n], strtok(rules->rule_buf, " "),
-               REG_EXTENDED | REG_ICASE);
-#endif
+  rc = regcomp(rules->pattern[n], rule_src, REG_EXTENDED | REG_ICASE);
   if (rc) /* Pattern compiling failure */
     {
       regfree(rules->pattern[n]);
@@ -406,1461 +1207,4653 @@ static int rule_load(RULEXDB *rulexdb, RULEX_RULESET *rules, int n)
       rules->pattern[n] = NULL;
       return RULEXDB_FAILURE;
     }
-
-  /* Save replacement if needed */
-  s = strtok(NULL, " ");
-  if (s)
-    rules->replacement[n] = strdup(s);
-
+#endif
   return RULEXDB_SUCCESS;
 }
 
-static void rules_release(RULEX_RULESET *rules)
+static int rule_build(RULEXDB *rulexdb, RULEX_RULESET *rules, int n,
+		      const char *rule_src, const char *replacement)
      /*
-      * Release the ruleset and free all resources allocated
-      * for its sake.
+      * Turn the rule number n given by its pattern source
+      * and replacement string (if any) into internal representation.
+      *
+      * The precompiled matcher is taken when available. In this case
+      * the regular expression is compiled later only if needed.
+      *
+      * Only the data of the rule itself are touched here, so different
+      * rules of the same ruleset may be built in parallel threads.
       */
 {
-  int i;
+  int rc;
+#ifdef USE_BITMATCH
+  PATTERN *parsed;
 
-  for (i = 0; i < rules->nrules; i++)
+  rules->bitmatch[n] = rule_image(rules, n, rule_src);
+
+  /* Shared rulesets are not modified while searching */
+  if (rules->bitmatch[n] && (rulexdb->options & RULEXDB_SHARED))
+    (void)rule_compile(rulexdb, rules, n, rule_src);
+
+  if (!rules->bitmatch[n])
+#endif
     {
-      if (rules->pattern[i])
-	{
-	  regfree(rules->pattern[i]);
-	  free(rules->pattern[i]);
-	  rules->pattern[i] = NULL;
-	}
-      if (rules->replacement[i])
+      rc = rule_compile(rulexdb, rules, n, rule_src);
+      if (rc) return rc;
+
+#ifdef USE_BITMATCH
+      /* Build bit-parallel matcher when possible */
+      parsed = pattern_parse(rule_src);
+      if (parsed)
 	{
-	  free(rules->replacement[i]);
-	  rules->replacement[i] = NULL;
+	  rules->bitmatch[n] = bitmatch_compile(parsed);
+	  pattern_free(parsed);
 	}
-    }
-  free(rules->pattern);
-  rules->pattern = NULL;
-  free(rules->replacement);
-  rules->replacement = NULL;
-#ifdef USE_BDB
-  if (rules->db)
-    {
-      db_close(rules->db);
-      rules->db = NULL;
-    }
-#else
-  rules->dbi_open = 0;
 #endif
-  rules->nrules = 0;
-  return;
+    }
+
+  /* Save replacement if needed */
+  if (replacement)
+    rules->replacement[n] = strdup(replacement);
+
+  return RULEXDB_SUCCESS;
 }
 
-static int lexguess(RULEXDB *rulexdb, const char *s, char *t)
+static int rule_load(RULEXDB *rulexdb, RULEX_RULESET *rules, int n)
      /*
-      * This routine tries to guess stressing for the word
-      * pointed by s by general rules from the database. If success,
-      * the result is placed into memory area pointed by t,
-      * which must have enough space for it.
+      * Preload specified rule and turn it into internal representation.
       *
-      * Return value indicates whether the guessing succeeded or not.
-      * If no rule has matched, then RULEXDB_SPECIAL is returned.
+      * This routine at first checks if specified rule is already loaded
+      * and exits successfully if so.
+      *
+      * The ruleset itself must be initialized before.
       */
 {
-  int i;
-  regmatch_t match[2];
+  char *rule_src;
 
-  i = rules_init(rulexdb, &rulexdb->rules);
-  if (i) return i;
+  if (n >= rules->nrules) /* Specified rule number validation */
+    return RULEXDB_EPARM;
+  if (rules->pattern[n] || rules->bitmatch[n]) /* Already loaded */
+    return RULEXDB_SUCCESS;
+  if (rulexdb->options & RULEXDB_SHARED) /* Shared rulesets are immutable */
+    return RULEXDB_FAILURE;
 
-  for (i = 0; i < rulexdb->rules.nrules; i++)
-    if (!rule_load(rulexdb, &rulexdb->rules, i))
-      if (!regexec(rulexdb->rules.pattern[i], s, 2, match, 0))
-	{
-	  (void)strncpy(t, s, match[1].rm_eo);
-	  t[match[1].rm_eo] = '+';
-	  (void)strcpy(t + match[1].rm_eo + 1, s + match[1].rm_eo);
-	  return RULEXDB_SUCCESS;
-	}
-  return RULEXDB_SPECIAL;
+  /* Get rule source */
+  rule_src = rule_source(rulexdb, rules, n);
+  if (!rule_src)
+    return RULEXDB_FAILURE;
+
+  return rule_build(rulexdb, rules, n, rule_src, strtok(NULL, " "));
 }
 
-static int postcorrect(RULEXDB *rulexdb, char *s)
+static int rule_exec(RULEXDB *rulexdb, RULEX_RULESET *rules, int n,
+		     const char *s, size_t nmatch, regmatch_t *match)
      /*
-      * This routine performs some additional word corrections
-      * according to the correction rules from the database if needed.
+      * Match string s against the pattern of the rule number n
+      * in the same manner as regexec() does. Argument nmatch
+      * must not exceed MAX_SUBMATCHES.
+      *
+      * The rule itself must be loaded before.
       */
 {
-  int i, k, l;
-  char *r, *t, *orig;
-  regmatch_t match[10];
+#ifdef USE_PCRE2
+  PCRE2_SIZE *ovector;
+  size_t i;
+  int rc = pcre2_match(rules->pattern[n], (PCRE2_SPTR)s, PCRE2_ZERO_TERMINATED,
+		       0, 0, rules->match_data, NULL);
 
-  i = rules_init(rulexdb, &rulexdb->correctors);
-  if (i) return i;
+  (void)rulexdb;
+  if (rc < 0)
+    return REG_NOMATCH;
+  if (!rc) /* All the vector is filled up */
+    rc = (int)pcre2_get_ovector_count(rules->match_data);
+  ovector = pcre2_get_ovector_pointer(rules->match_data);
+  for (i = 0; i < nmatch; i++)
+    if ((i < (size_t)rc) && (ovector[2 * i] != PCRE2_UNSET))
+      {
+	match[i].rm_so = (regoff_t)ovector[2 * i];
+	match[i].rm_eo = (regoff_t)ovector[2 * i + 1];
+      }
+    else match[i].rm_so = match[i].rm_eo = -1;
+  return 0;
+#else
+#ifdef USE_BITMATCH
+  int rc;
+  char *rule_src;
 
-  for (i = 0; i < rulexdb->correctors.nrules; i++)
-    if (!rule_load(rulexdb, &rulexdb->correctors, i))
-      if (!regexec(rulexdb->correctors.pattern[i], s, 10, match, 0))
-	{
-	  t = s + match[0].rm_so;
-	  orig = strdup(t);
-	  if (!orig) return RULEXDB_EMALLOC;
-	  for (r = rulexdb->correctors.replacement[i]; *r; r++)
-	    if (((*r) >= '0') && ((*r) <= '9'))
-	      {
-		k = (*r) - '0';
-		l = match[k].rm_eo - match[k].rm_so;
-		if (l)
-		  {
-		    (void)strncpy(t, orig + match[k].rm_so - match[0].rm_so, l);
-		    t += l;
-		  }
-	      }
-	    else *t++ = *r;
-	  l = strlen(orig) + match[0].rm_so - match[0].rm_eo;
-	  if (l)
-	    {
-	      (void)strcpy(t, orig + match[0].rm_eo - match[0].rm_so);
-	      t += l;
-	    }
-	  *t = 0;
-	  free(orig);
-	}
-  return RULEXDB_SUCCESS;
+  if (rules->bitmatch[n])
+    {
+      rc = bitmatch_exec(rules->bitmatch[n], s, nmatch, match);
+      if (rc != BITMATCH_UNSUPPORTED)
+	return rc;
+    }
+
+  /* Precompiled rules have no regular expression yet */
+  if (!rules->pattern[n])
+    {
+      if (rulexdb->options & RULEXDB_SHARED) /* Not compilable */
+	return REG_NOMATCH;
+      rule_src = rule_source(rulexdb, rules, n);
+      if ((!rule_src) || rule_compile(rulexdb, rules, n, rule_src))
+	return REG_NOMATCH;
+    }
+#else
+  (void)rulexdb;
+#endif
+  return regexec(rules->pattern[n], s, nmatch, match, 0);
+#endif
 }
 
-#ifndef USE_BDB
-/*
- * Internal helper: reference to one of the two dictionaries.
- * Holds pointers to the related fields in RULEXDB so that
- * choose_dictionary() can return a single value callers dereference uniformly.
- */
-typedef struct
+static unsigned long long clock_ns(void)
+     /*
+      * Get current time in nanoseconds for measuring intervals.
+      */
 {
-  MDB_dbi    *dbi;
-  int        *dbi_open;
-  MDB_cursor **cursor;
-} DictHandle;
+#ifdef CLOCK_MONOTONIC
+  struct timespec t;
+
+  if (!clock_gettime(CLOCK_MONOTONIC, &t))
+    return t.tv_sec * 1000000000ULL + t.tv_nsec;
 #endif
+  {
+    struct timeval tv;
 
-#ifdef USE_BDB
-static DB **choose_dictionary(RULEXDB *rulexdb, const char *key, int item_type)
+    (void)gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000000ULL + tv.tv_usec * 1000ULL;
+  }
+}
+
+static void trace_stage(RULEXDB *rulexdb, int stage)
      /*
-      * Choose the dictionary and open it if necessary.
-      * If item_type specified as RULEXDB_DEFAULT, then choosing is based
-      * on key: if key is recognized as a lexical base,
-      * then the lexbases dictionary is chosen, otherwise exceptions
-      * dictionary is used.
-      *
-      * Returns pointer to the DB handler when success
-      * or NULL when failure.
+      * When the search is traced, account the time spent
+      * in the current stage and enter the specified one.
       */
 {
-  const char *db_name;
-  DB **db;
+  unsigned long long now;
+
+  if (!rulexdb->trace)
+    return;
+  now = clock_ns();
+  if (rulexdb->trace_stage != RULEXDB_STAGE_NONE)
+    rulexdb->trace->time[rulexdb->trace_stage] += now - rulexdb->trace_clock;
+  rulexdb->trace_stage = stage;
+  rulexdb->trace_clock = now;
+}
 
-  if (!rulexdb) return NULL;
-  switch (item_type)
-    {
-      case RULEXDB_EXCEPTION:
-      case RULEXDB_EXCEPTION_RAW:
-	db = &rulexdb->exceptions_db;
-	db_name = exceptions_db_name;
-	break;
-      case RULEXDB_LEXBASE:
-	db = &rulexdb->lexicon_db;
-	db_name = lexicon_db_name;
-	break;
-      case RULEXDB_DEFAULT:
-	if (key)
+static unsigned int *trace_probes(RULEXDB *rulexdb)
+     /*
+      * Get the dictionary lookups counter of the current
+      * search stage or NULL when the search is not traced.
+      */
+{
+  if ((!rulexdb->trace) || (rulexdb->trace_stage == RULEXDB_STAGE_NONE))
+    return NULL;
+  return &rulexdb->trace->probes[rulexdb->trace_stage];
+}
+
+static int rule_match(RULEXDB *rulexdb, RULEX_RULESET *rules, int n,
+		      const char *s, size_t nmatch, regmatch_t *match)
+     /*
+      * Match string s against the pattern of the rule number n
+      * as rule_exec() does and account the attempt
+      * in the ruleset statistics if they are collected.
+      */
+{
+  int rc;
+  unsigned long long start;
+
+  if (!rules->stats)
+    return rule_exec(rulexdb, rules, n, s, nmatch, match);
+  start = clock_ns();
+  rc = rule_exec(rulexdb, rules, n, s, nmatch, match);
+  rules->stats[n].time += clock_ns() - start;
+  rules->stats[n].attempts++;
+  if (!rc)
+    rules->stats[n].matches++;
+  return rc;
+}
+
+static int rules_dfa_init(RULEXDB *rulexdb, RULEX_RULESET *rules,
+			  char **patterns)
+     /*
+      * Build the combined automaton for the ruleset.
+      *
+      * All the rules are preloaded at first. Then the patterns
+      * that can be handled by the automaton are added to it.
+      * The rest ones are left for the regular expressions matching.
+      * Pattern sources are taken from the array pointed by patterns
+      * when specified, otherwise they are fetched from the database.
+      *
+      * The ruleset itself must be initialized before.
+      */
+{
+  int i;
+  char *rule_src;
+  PATTERN *pattern;
+
+  if (rules->dfa) /* Already built */
+    return RULEXDB_SUCCESS;
+  rules->dfa = dfa_create();
+  if (!rules->dfa)
+    return RULEXDB_EMALLOC;
+  for (i = 0; i < rules->nrules; i++)
+    if (!rule_load(rulexdb, rules, i))
+      {
+	rule_src = patterns ? patterns[i] : rule_source(rulexdb, rules, i);
+	if (!rule_src) continue;
+	pattern = pattern_parse(rule_src);
+	if (!pattern) continue;
+	if (dfa_add(rules->dfa, pattern, i))
 	  {
-	    if (rulexdb_classify(rulexdb, key) == RULEXDB_SPECIAL)
-	      {
-		db = &rulexdb->lexicon_db;
-		db_name = lexicon_db_name;
-	      }
-	    else
-	      {
-		db = &rulexdb->exceptions_db;
-		db_name = exceptions_db_name;
-	      }
+	    pattern_free(pattern);
+	    dfa_free(rules->dfa);
+	    rules->dfa = NULL;
+	    return RULEXDB_EMALLOC;
 	  }
-	else return NULL;
-	break;
-      default:
-	return NULL;
-    }
-  if (!(*db))
-    *db = db_open(rulexdb->env, db_name, LEXICON_DB_TYPE, rulexdb->mode);
-  return db;
+	pattern_free(pattern);
+      }
+  return RULEXDB_SUCCESS;
 }
-#else
-static DictHandle choose_dictionary(RULEXDB *rulexdb, const char *key, int item_type)
-{
-  DictHandle h = {NULL, NULL, NULL};
-  const char *db_name;
-  unsigned int flags;
 
-  if (!rulexdb)
-    return h;
+static int rules_suffix_init(RULEXDB *rulexdb, RULEX_RULESET *rules,
+			     char **patterns)
+     /*
+      * Build the word endings index for the ruleset.
+      *
+      * All the rules are preloaded at first. The rules which patterns
+      * cannot be parsed or failed to load are to be tried for every word.
+      * Pattern sources are taken from the array pointed by patterns
+      * when specified, otherwise they are fetched from the database.
+      *
+      * The ruleset itself must be initialized before.
+      */
+{
+  int i, rc;
+  char *rule_src;
+  PATTERN *pattern;
 
-  switch (item_type)
+  if (rules->suffix) /* Already built */
+    return RULEXDB_SUCCESS;
+  rules->suffix = suffix_create(rules->nrules);
+  if (!rules->suffix)
+    return RULEXDB_EMALLOC;
+  for (i = 0; i < rules->nrules; i++)
     {
-      case RULEXDB_EXCEPTION:
-      case RULEXDB_EXCEPTION_RAW:
-        h.dbi      = &rulexdb->exceptions_dbi;
-        h.dbi_open = &rulexdb->exceptions_dbi_open;
-        h.cursor   = &rulexdb->exceptions_cursor;
-        db_name    = exceptions_db_name;
-        break;
-      case RULEXDB_LEXBASE:
-        h.dbi      = &rulexdb->lexicon_dbi;
-        h.dbi_open = &rulexdb->lexicon_dbi_open;
-        h.cursor   = &rulexdb->lexicon_cursor;
-        db_name    = lexicon_db_name;
-        break;
-      case RULEXDB_DEFAULT:
-        if (key)
-          {
-            if (rulexdb_classify(rulexdb, key) == RULEXDB_SPECIAL)
-              {
-                h.dbi      = &rulexdb->lexicon_dbi;
-                h.dbi_open = &rulexdb->lexicon_dbi_open;
-                h.cursor   = &rulexdb->lexicon_cursor;
-                db_name    = lexicon_db_name;
-              }
-            else
-              {
-                h.dbi      = &rulexdb->exceptions_dbi;
-                h.dbi_open = &rulexdb->exceptions_dbi_open;
-                h.cursor   = &rulexdb->exceptions_cursor;
-                db_name    = exceptions_db_name;
-              }
-          }
-        else return h;
-        break;
-      default:
-        return h;
+      pattern = NULL;
+      if (!rule_load(rulexdb, rules, i))
+	{
+	  rule_src = patterns ? patterns[i] : rule_source(rulexdb, rules, i);
+	  if (rule_src)
+	    pattern = pattern_parse(rule_src);
+	}
+      rc = suffix_add(rules->suffix, pattern, i);
+      pattern_free(pattern);
+      if (rc)
+	{
+	  suffix_free(rules->suffix);
+	  rules->suffix = NULL;
+	  return RULEXDB_EMALLOC;
+	}
     }
+  return RULEXDB_SUCCESS;
+}
 
-  if (!*(h.dbi_open))
+static int rules_prefix_init(RULEXDB *rulexdb, RULEX_RULESET *rules,
+			     char **patterns)
+     /*
+      * Build the prefixes trie for the ruleset.
+      *
+      * All the rules are preloaded at first. The rules which patterns
+      * cannot be parsed or failed to load are to be tried for every word.
+      * Pattern sources are taken from the array pointed by patterns
+      * when specified, otherwise they are fetched from the database.
+      *
+      * The ruleset itself must be initialized before.
+      */
+{
+  int i, rc;
+  char *rule_src;
+  PATTERN *pattern;
+
+  if (rules->prefix) /* Already built */
+    return RULEXDB_SUCCESS;
+  rules->prefix = prefix_create(rules->nrules);
+  if (!rules->prefix)
+    return RULEXDB_EMALLOC;
+  for (i = 0; i < rules->nrules; i++)
     {
-      flags = (rulexdb->mode != RULEXDB_SEARCH) ? MDB_CREATE : 0;
-      if (!mdb_dbi_open(rulexdb->txn, db_name, flags, h.dbi))
-        *(h.dbi_open) = 1;
+      pattern = NULL;
+      if (!rule_load(rulexdb, rules, i))
+	{
+	  rule_src = patterns ? patterns[i] : rule_source(rulexdb, rules, i);
+	  if (rule_src)
+	    pattern = pattern_parse(rule_src);
+	}
+      rc = prefix_add(rules->prefix, pattern, i);
+      pattern_free(pattern);
+      if (rc)
+	{
+	  prefix_free(rules->prefix);
+	  rules->prefix = NULL;
+	  return RULEXDB_EMALLOC;
+	}
     }
-  return h;
+  return RULEXDB_SUCCESS;
 }
-#endif
 
-static RULEX_RULESET *get_ruleset_handler(RULEXDB *rulexdb, int rule_type)
+static int rules_candidates(RULEXDB *rulexdb, RULEX_RULESET *rules,
+			    const char *s, const int **list)
      /*
-      * Get ruleset handler pointer for specified rule type.
-      * Returns NULL for unknown type.
+      * Select the rules that can match the word pointed by s
+      * according to its ending. The pointer to the ascending list
+      * of their numbers is placed in the location pointed by list,
+      * or NULL if all the rules are to be tried.
+      *
+      * Returns the number of selected rules.
       */
 {
-  if (!rulexdb) return NULL;
-  switch (rule_type)
+  if (rules_suffix_init(rulexdb, rules, NULL))
     {
-      case RULEXDB_RULE:
-	return &rulexdb->rules;
-      case RULEXDB_LEXCLASS:
-	return &rulexdb->lexclasses;
-      case RULEXDB_PREFIX:
-	return &rulexdb->prefixes;
-      case RULEXDB_CORRECTOR:
-	return &rulexdb->correctors;
-      default:
-	break;
+      *list = NULL;
+      return rules->nrules;
     }
-  return NULL;
+  return suffix_search(rules->suffix, s, list);
 }
 
-static RULEX_RULESET *choose_ruleset(RULEXDB *rulexdb, int rule_type)
+static void *rules_loader(void *arg)
      /*
-      * Choose ruleset and open it if necessary.
-      *
-      * Returns opened ruleset handler pointer when success
-      * or NULL otherwise.
+      * Take the rules of the loading job pointed by arg one by one
+      * and turn them into internal representation until all of them
+      * are done. This routine may be executed by several threads
+      * simultaneously.
       */
 {
-  RULEX_RULESET *rules = get_ruleset_handler(rulexdb, rule_type);
+  RULES_LOADER *job = arg;
+  RULEX_RULESET *rules = job->rules;
+  int n, rc;
 
-  if (!rules) return NULL;
-#ifdef USE_BDB
-  if (!rules->db)
-    rules->db = db_open(rules->env, rules->db_name,
-			RULES_DB_TYPE, rulexdb->mode);
-  if (rules->db) rules->nrules = -1;
-#else
-  if (!rules->dbi_open)
+  for (;;)
     {
-      unsigned int flags = MDB_INTEGERKEY;
-      if (rulexdb->mode != RULEXDB_SEARCH)
-        flags |= MDB_CREATE;
-      if (!mdb_dbi_open(rulexdb->txn, rules->db_name, flags, &rules->dbi))
-        {
-          rules->dbi_open = 1;
-          rules->nrules = -1;
-        }
+      loader_lock(job);
+      n = job->next++;
+      loader_unlock(job);
+      if (n >= rules->nrules)
+	break;
+      if (rules->pattern[n] || rules->bitmatch[n]) /* Already loaded */
+	continue;
+      if (job->pattern[n])
+	rc = rule_build(job->rulexdb, rules, n,
+			job->pattern[n], job->replacement[n]);
+      else rc = RULEXDB_FAILURE;
+      if (rc)
+	{
+	  loader_lock(job);
+	  if (!job->rc)
+	    job->rc = rc;
+	  loader_unlock(job);
+	}
     }
-#endif
-  return rules;
+  return NULL;
 }
 
-
-/* Externally visible routines */
-
-RULEXDB *rulexdb_open(const char *path, int mode)
+static int rules_preload(RULEXDB *rulexdb, RULEX_RULESET *rules,
+			 int rule_type)
      /*
-      * Open lexical database.
-      *
-      * This routine does not actually open any dataset
-      * (the datasets are to be opened later by demand),
-      * but it allocates and initializes new RULEXDB structure
-      * and opens the database environment. By the way
-      * this routine checks accessibility of the database file.
+      * Load all the rules of the ruleset at once.
       *
-      * Arguments description:
-      * path - path to the database file;
-      * mode - Access mode: RULEXDB_SEARCH, RULEXDB_UPDATE or RULEXDB_CREATE.
+      * The rules are fetched by a single pass over the dataset
+      * and compiled by several threads in parallel when possible.
+      * Then the indexes used for matching words against the ruleset
+      * of specified type are built, so nothing is left
+      * to be done later. Time spent for all this work
+      * is stored in the ruleset handler.
       *
-      * Returns pointer to the new RULEXDB structure when success
-      * or NULL otherwise.
+      * Returns error code of the first failure if any.
       */
 {
-  RULEXDB *rulexdb = calloc(1, sizeof(RULEXDB));
+  int i, rc;
+  char **source;
+  RULES_LOADER job;
+  struct timeval start, stop;
+#ifdef HAVE_PTHREAD_H
+  pthread_t threads[LOAD_THREADS - 1];
+  int nthreads = 0;
+#ifdef _SC_NPROCESSORS_ONLN
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+  long ncpu = LOAD_THREADS;
+#endif
+#endif
 
-  if (!rulexdb)
-    return NULL;
+  (void)gettimeofday(&start, NULL);
+  rc = rules_init(rulexdb, rules);
+  if (rc || (rules->nrules <= 0))
+    return rc;
+#ifdef USE_PCRE2
+  rc = rules_pcre2_init(rulexdb, rules);
+  if (rc) return rc;
+#endif
 
-#ifdef USE_BDB
+  /* Fetch all the rules */
+  source = calloc((size_t)rules->nrules, sizeof(char *));
+  if (!source)
+    return RULEXDB_EMALLOC;
+  (void)memset(&job, 0, sizeof(job));
+  job.pattern = calloc((size_t)rules->nrules, sizeof(char *));
+  job.replacement = calloc((size_t)rules->nrules, sizeof(char *));
+  if (job.pattern && job.replacement)
+    rc = rules_scan(rulexdb, rules, source);
+  else rc = RULEXDB_EMALLOC;
 
-  /* Create database environment */
-  if (db_env_create(&rulexdb->env, 0))
-    {
-      free(rulexdb);
-      return NULL;
-    }
-  /* Open it */
-  if (rulexdb->env->open(rulexdb->env, NULL,
-		       DB_INIT_MPOOL | DB_INIT_LOCK | DB_PRIVATE | DB_CREATE,
-		       0))
+  if (!rc)
     {
-      (void)rulexdb->env->close(rulexdb->env, 0);
-      free(rulexdb);
-      return NULL;
+      /* Split the rules sources */
+      for (i = 0; i < rules->nrules; i++)
+	if (source[i])
+	  {
+	    job.pattern[i] = strtok(source[i], " ");
+	    job.replacement[i] = strtok(NULL, " ");
+	  }
+
+      /* Compile them */
+      job.rulexdb = rulexdb;
+      job.rules = rules;
+#ifdef HAVE_PTHREAD_H
+      (void)pthread_mutex_init(&job.lock, NULL);
+      while ((nthreads < LOAD_THREADS - 1) && (nthreads + 1 < ncpu) &&
+	     (nthreads + 1 < rules->nrules))
+	if (pthread_create(&threads[nthreads], NULL, rules_loader, &job))
+	  break;
+	else nthreads++;
+#endif
+      (void)rules_loader(&job);
+#ifdef HAVE_PTHREAD_H
+      for (i = 0; i < nthreads; i++)
+	(void)pthread_join(threads[i], NULL);
+      (void)pthread_mutex_destroy(&job.lock);
+#endif
+      rc = job.rc;
+
+      /* Build the indexes */
+      i = RULEXDB_SUCCESS;
+      switch (rule_type)
+	{
+	  case RULEXDB_RULE:
+	    if (rulexdb->options & RULEXDB_DFA)
+	      i = rules_dfa_init(rulexdb, rules, job.pattern);
+	    if (i) break;
+	    /* Fall through */
+	  case RULEXDB_LEXCLASS:
+	    i = rules_suffix_init(rulexdb, rules, job.pattern);
+	    break;
+	  case RULEXDB_PREFIX:
+	    i = rules_prefix_init(rulexdb, rules, job.pattern);
+	    break;
+	  case RULEXDB_CORRECTOR:
+	    i = rules_dfa_init(rulexdb, rules, job.pattern);
+	    break;
+	  default:
+	    break;
+	}
+      if (!rc) rc = i;
     }
 
-  /* Initialize necessary RULEXDB fields */
-  rulexdb->env->app_private = (char *)path;
-  rulexdb->rules.env = rulexdb->env;
-  rulexdb->rules.db_name = rules_db_name;
-  rulexdb->lexclasses.env = rulexdb->env;
-  rulexdb->lexclasses.db_name = lexclasses_db_name;
-  rulexdb->prefixes.env = rulexdb->env;
-  rulexdb->prefixes.db_name = prefixes_db_name;
-  rulexdb->correctors.env = rulexdb->env;
-  rulexdb->correctors.db_name = corrections_db_name;
-  rulexdb->mode = mode;
+  for (i = 0; i < rules->nrules; i++)
+    free(source[i]);
+  free(source);
+  free(job.pattern);
+  free(job.replacement);
+  (void)gettimeofday(&stop, NULL);
+  rules->load_time = (stop.tv_sec - start.tv_sec) * 1000000L +
+    (stop.tv_usec - start.tv_usec);
+  return rc;
+}
 
-  /* Check database file accessibility according to specified access mode */
-  switch (mode)
+static void rules_release(RULEX_RULESET *rules)
+     /*
+      * Release the ruleset and free all resources allocated
+      * for its sake.
+      */
+{
+  int i;
+
+  for (i = 0; i < rules->nrules; i++)
     {
-      case RULEXDB_SEARCH:
-	if (access(path, F_OK | R_OK))
+      if (rules->pattern[i])
+	{
+#ifdef USE_PCRE2
+	  pcre2_code_free(rules->pattern[i]);
+#else
+	  regfree(rules->pattern[i]);
+	  free(rules->pattern[i]);
+#endif
+	  rules->pattern[i] = NULL;
+	}
+      if (rules->bitmatch[i])
+	{
+	  if (!rule_mapped(rules, i))
+	    bitmatch_free(rules->bitmatch[i]);
+	  rules->bitmatch[i] = NULL;
+	}
+      if (rules->replacement[i])
+	{
+	  free(rules->replacement[i]);
+	  rules->replacement[i] = NULL;
+	}
+    }
+  free(rules->pattern);
+  rules->pattern = NULL;
+  free(rules->replacement);
+  rules->replacement = NULL;
+  free(rules->bitmatch);
+  rules->bitmatch = NULL;
+  free(rules->image_buf);
+  rules->image_buf = NULL;
+  rules->image = NULL;
+  rules->image_size = 0;
+#ifdef USE_PCRE2
+  pcre2_match_data_free(rules->match_data);
+  rules->match_data = NULL;
+#endif
+  dfa_free(rules->dfa);
+  rules->dfa = NULL;
+  suffix_free(rules->suffix);
+  rules->suffix = NULL;
+  prefix_free(rules->prefix);
+  rules->prefix = NULL;
+  rules->load_time = 0;
+  free(rules->stats);
+  rules->stats = NULL;
+  rules->list = NULL;
+#ifdef USE_BDB
+  if (rules->db)
+    {
+      db_close(rules->db);
+      rules->db = NULL;
+    }
+#else
+  rules->dbi_open = 0;
+  rules->format = 0;
+  free(rules->keys);
+  rules->keys = NULL;
+  rules->nkeys = 0;
+#endif
+  rules->nrules = 0;
+  return;
+}
+
+static int lexguess(RULEXDB *rulexdb, const char *s, char *t)
+     /*
+      * This routine tries to guess stressing for the word
+      * pointed by s by general rules from the database. If success,
+      * the result is placed into memory area pointed by t,
+      * which must have enough space for it.
+      *
+      * Return value indicates whether the guessing succeeded or not.
+      * If no rule has matched, then RULEXDB_SPECIAL is returned.
+      *
+      * When the combined automaton is in use, it points out
+      * the first matching rule among those it contains, so only
+      * the preceding rules it cannot handle are to be tried.
+      * The automaton also locates the stress by the end
+      * of the first subexpression of the matched rule,
+      * so no regular expression is applied to it.
+      */
+{
+  int i, k, l, nrules, n = 0;
+  const int *list;
+  regmatch_t match[2];
+
+  i = rules_init(rulexdb, &rulexdb->rules);
+  if (i) return i;
+
+  if ((rulexdb->options & RULEXDB_DFA) &&
+      !rules_dfa_init(rulexdb, &rulexdb->rules, NULL))
+    {
+      n = dfa_search(rulexdb->rules.dfa, s);
+      if (n == DFA_NOMATCH)
+	n = rulexdb->rules.nrules;
+      else if (n < 0) n = 0;
+    }
+
+  nrules = rules_candidates(rulexdb, &rulexdb->rules, s, &list);
+  for (k = 0; k < nrules; k++)
+    {
+      i = list ? list[k] : k;
+      if ((i < n) && dfa_contains(rulexdb->rules.dfa, i))
+	continue;
+      l = ((i == n) && dfa_contains(rulexdb->rules.dfa, i)) ?
+	dfa_group_end(rulexdb->rules.dfa, i, s) : -1;
+      if (l >= 0)
+	{
+	  if (rulexdb->rules.stats)
+	    {
+	      rulexdb->rules.stats[i].attempts++;
+	      rulexdb->rules.stats[i].matches++;
+	    }
+	}
+      else if (rule_load(rulexdb, &rulexdb->rules, i) ||
+	       rule_match(rulexdb, &rulexdb->rules, i, s, 2, match))
+	continue;
+      else l = match[1].rm_eo;
+      if (rulexdb->trace)
+	rulexdb->trace->rule = i + 1;
+      (void)strncpy(t, s, l);
+      t[l] = '+';
+      (void)strcpy(t + l + 1, s + l);
+      return RULEXDB_SUCCESS;
+    }
+  return RULEXDB_SPECIAL;
+}
+
+static int prefix_next(RULEXDB *rulexdb, const char *s, int n, int *len)
+     /*
+      * Find the first prefix rule beginning from n (counting from 0)
+      * that matches the beginning of the word pointed by s
+      * leaving some part of it unmatched. The length of matched prefix
+      * is placed in the location pointed by len.
+      *
+      * The candidates are taken from the prefixes trie, so only
+      * the rules it cannot handle are matched here.
+      *
+      * Returns the rule number or -1 if there is no such rule.
+      * The ruleset itself must be initialized before.
+      */
+{
+  RULEX_RULESET *rules = &rulexdb->prefixes;
+  const PREFIX_MATCH *list = NULL;
+  regmatch_t match;
+  int i, k, l, nrules, size = strlen(s);
+
+  if (rules_prefix_init(rulexdb, rules, NULL))
+    nrules = rules->nrules;
+  else nrules = prefix_search(rules->prefix, s, &list);
+  for (k = 0; k < nrules; k++)
+    {
+      i = list ? list[k].rule : k;
+      if ((i < n) || rule_load(rulexdb, rules, i))
+	continue;
+      l = list ? list[k].len : PREFIX_UNKNOWN;
+      if (l == PREFIX_UNKNOWN)
+	{
+	  if (rule_match(rulexdb, rules, i, s, 1, &match) || match.rm_so)
+	    continue;
+	  l = match.rm_eo;
+	}
+      else if (rules->stats)
+	{
+	  rules->stats[i].attempts++;
+	  rules->stats[i].matches++;
+	}
+      if (l < size)
+	{
+	  *len = l;
+	  return i;
+	}
+    }
+  return -1;
+}
+
+static int postcorrect(RULEXDB *rulexdb, char *s)
+     /*
+      * This routine performs some additional word corrections
+      * according to the correction rules from the database if needed.
+      *
+      * Every rule is applied to the result of the preceding ones.
+      * The combined automaton points out the first rule matching
+      * current string, so the rules preceding it are skipped
+      * and the words no rule can match are passed in one scan.
+      * The automaton is consulted again only when the string
+      * has been changed. The corrected string is assembled
+      * in a local buffer, so no memory is allocated here.
+      */
+{
+  int i, k, l, nrules, n = -1;
+  char *r, *t, buf[RULEXDB_BUFSIZE];
+  regmatch_t match[MAX_SUBMATCHES];
+  RULEX_DFA *dfa = NULL;
+
+  i = rules_init(rulexdb, &rulexdb->correctors);
+  if (i) return i;
+  if (!rules_dfa_init(rulexdb, &rulexdb->correctors, NULL))
+    dfa = rulexdb->correctors.dfa;
+
+  nrules = rulexdb->correctors.nrules;
+  for (i = 0; i < nrules; i++)
+    {
+      if (dfa_contains(dfa, i))
+	{
+	  if (n < 0) /* The string has been changed */
+	    {
+	      n = dfa_search(dfa, s);
+	      if (n == DFA_NOMATCH)
+		n = nrules;
+	      else if (n < 0) n = 0;
+	    }
+	  if (i < n) /* Surely does not match */
+	    continue;
+	}
+      if (rule_load(rulexdb, &rulexdb->correctors, i) ||
+	  rule_match(rulexdb, &rulexdb->correctors, i, s,
+		     MAX_SUBMATCHES, match))
+	continue;
+      if (rulexdb->trace)
+	{
+	  k = rulexdb->trace->ncorrections++;
+	  if (k < RULEXDB_TRACE_CORRECTIONS)
+	    rulexdb->trace->corrections[k] = i + 1;
+	}
+      t = buf;
+      (void)memcpy(t, s, match[0].rm_so);
+      t += match[0].rm_so;
+      for (r = rulexdb->correctors.replacement[i]; *r; r++)
+	if (((*r) >= '0') && ((*r) <= '9'))
 	  {
-	    (void)rulexdb->env->close(rulexdb->env, 0);
-	    free(rulexdb);
-	    rulexdb = NULL;
+	    k = (*r) - '0';
+	    l = match[k].rm_eo - match[k].rm_so;
+	    if (l > 0)
+	      {
+		if (t + l >= buf + RULEXDB_BUFSIZE)
+		  return RULEXDB_FAILURE;
+		(void)memcpy(t, s + match[k].rm_so, l);
+		t += l;
+	      }
 	  }
+	else if (t + 1 < buf + RULEXDB_BUFSIZE)
+	  *t++ = *r;
+	else return RULEXDB_FAILURE;
+      l = strlen(s + match[0].rm_eo);
+      if (t + l >= buf + RULEXDB_BUFSIZE)
+	return RULEXDB_FAILURE;
+      (void)memcpy(t, s + match[0].rm_eo, l + 1);
+      (void)strcpy(s, buf);
+      n = -1;
+    }
+  return RULEXDB_SUCCESS;
+}
+
+#ifndef USE_BDB
+/*
+ * Internal helper: reference to one of the two dictionaries.
+ * Holds pointers to the related fields in RULEXDB so that
+ * choose_dictionary() can return a single value callers dereference uniformly.
+ */
+typedef struct
+{
+  MDB_dbi    *dbi;
+  int        *dbi_open;
+  MDB_cursor **cursor;
+} DictHandle;
+#endif
+
+#ifdef USE_BDB
+static DB **choose_dictionary(RULEXDB *rulexdb, const char *key, int item_type)
+     /*
+      * Choose the dictionary and open it if necessary.
+      * If item_type specified as RULEXDB_DEFAULT, then choosing is based
+      * on key: if key is recognized as a lexical base,
+      * then the lexbases dictionary is chosen, otherwise exceptions
+      * dictionary is used.
+      *
+      * Returns pointer to the DB handler when success
+      * or NULL when failure.
+      */
+{
+  const char *db_name;
+  DB **db;
+
+  if (!rulexdb) return NULL;
+  switch (item_type)
+    {
+      case RULEXDB_EXCEPTION:
+      case RULEXDB_EXCEPTION_RAW:
+	db = &rulexdb->exceptions_db;
+	db_name = exceptions_db_name;
 	break;
-      case RULEXDB_UPDATE:
-	if (access(path, F_OK | R_OK | W_OK))
+      case RULEXDB_LEXBASE:
+	db = &rulexdb->lexicon_db;
+	db_name = lexicon_db_name;
+	break;
+      case RULEXDB_DEFAULT:
+	if (key)
 	  {
-	    (void)rulexdb->env->close(rulexdb->env, 0);
-	    free(rulexdb);
-	    rulexdb = NULL;
+	    if (rulexdb_classify(rulexdb, key) == RULEXDB_SPECIAL)
+	      {
+		db = &rulexdb->lexicon_db;
+		db_name = lexicon_db_name;
+	      }
+	    else
+	      {
+		db = &rulexdb->exceptions_db;
+		db_name = exceptions_db_name;
+	      }
 	  }
-	break;
-      case RULEXDB_CREATE:
-	if (!access(path, F_OK))
-	  if (access(path, R_OK | W_OK))
-	    {
-	      (void)rulexdb->env->close(rulexdb->env, 0);
-	      free(rulexdb);
-	      rulexdb = NULL;
-	    }
+	else return NULL;
 	break;
       default:
-	(void)rulexdb->env->close(rulexdb->env, 0);
-	free(rulexdb);
-	rulexdb = NULL;
-	break;
+	return NULL;
+    }
+  if ((!(*db)) && !rulexdb->lexfile.image)
+    *db = db_open(rulexdb->env, db_name, LEXICON_DB_TYPE, rulexdb->mode);
+  return db;
+}
+#else
+static DictHandle choose_dictionary(RULEXDB *rulexdb, const char *key, int item_type)
+{
+  DictHandle h = {NULL, NULL, NULL};
+  const char *db_name;
+  unsigned int flags;
+
+  if (!rulexdb)
+    return h;
+
+  switch (item_type)
+    {
+      case RULEXDB_EXCEPTION:
+      case RULEXDB_EXCEPTION_RAW:
+        h.dbi      = &rulexdb->exceptions_dbi;
+        h.dbi_open = &rulexdb->exceptions_dbi_open;
+        h.cursor   = &rulexdb->exceptions_cursor;
+        db_name    = exceptions_db_name;
+        break;
+      case RULEXDB_LEXBASE:
+        h.dbi      = &rulexdb->lexicon_dbi;
+        h.dbi_open = &rulexdb->lexicon_dbi_open;
+        h.cursor   = &rulexdb->lexicon_cursor;
+        db_name    = lexicon_db_name;
+        break;
+      case RULEXDB_DEFAULT:
+        if (key)
+          {
+            if (rulexdb_classify(rulexdb, key) == RULEXDB_SPECIAL)
+              {
+                h.dbi      = &rulexdb->lexicon_dbi;
+                h.dbi_open = &rulexdb->lexicon_dbi_open;
+                h.cursor   = &rulexdb->lexicon_cursor;
+                db_name    = lexicon_db_name;
+              }
+            else
+              {
+                h.dbi      = &rulexdb->exceptions_dbi;
+                h.dbi_open = &rulexdb->exceptions_dbi_open;
+                h.cursor   = &rulexdb->exceptions_cursor;
+                db_name    = exceptions_db_name;
+              }
+          }
+        else return h;
+        break;
+      default:
+        return h;
+    }
+
+  if ((!*(h.dbi_open)) && !(rulexdb->shared || rulexdb->lexfile.image))
+    {
+      flags = (rulexdb->mode != RULEXDB_SEARCH) ? MDB_CREATE : 0;
+      if (!mdb_dbi_open(rulexdb->txn, db_name, flags, h.dbi))
+        *(h.dbi_open) = 1;
+    }
+  return h;
+}
+#endif
+
+static int compiled_fetch(RULEXDB *rulexdb, const char *name,
+			  RULEX_IMAGE *image)
+     /*
+      * Fetch the named record of the compiled data. With LMDB
+      * the image points to the mapped data, otherwise the data
+      * are placed in allocated memory. Only the database opened
+      * for searching is looked up, since mapped data
+      * may be moved by updates. The compiled lexicon file
+      * holds no such records.
+      *
+      * Returns 0 on success or non-zero if there is no such record.
+      */
+{
+#ifdef USE_BDB
+  DB *db;
+  DBT inKey, inVal;
+  int rc;
+
+  if ((rulexdb->mode != RULEXDB_SEARCH) || rulexdb->lexfile.image)
+    return RULEXDB_SPECIAL;
+  db = db_open(rulexdb->env, compiled_db_name, COMPILED_DB_TYPE, RULEXDB_SEARCH);
+  if (!db) return RULEXDB_SPECIAL;
+  (void)memset(&inKey, 0, sizeof(DBT));
+  (void)memset(&inVal, 0, sizeof(DBT));
+  inKey.data = (char *)name;
+  inKey.size = strlen(name) + 1;
+  inVal.flags = DB_DBT_MALLOC;
+  rc = db->get(db, NULL, &inKey, &inVal, 0);
+  if (!rc)
+    {
+      image->buf = inVal.data;
+      image->image = inVal.data;
+      image->size = inVal.size;
+    }
+  db_close(db);
+  return rc ? RULEXDB_SPECIAL : RULEXDB_SUCCESS;
+#else
+  MDB_dbi dbi;
+  MDB_val key, data;
+
+  if ((rulexdb->mode != RULEXDB_SEARCH) || rulexdb->lexfile.image)
+    return RULEXDB_SPECIAL;
+  if (mdb_dbi_open(rulexdb->txn, compiled_db_name, 0, &dbi))
+    return RULEXDB_SPECIAL;
+  key.mv_data = (char *)name;
+  key.mv_size = strlen(name) + 1;
+  if (mdb_get(rulexdb->txn, dbi, &key, &data))
+    return RULEXDB_SPECIAL;
+  image->image = data.mv_data;
+  image->size = data.mv_size;
+  return RULEXDB_SUCCESS;
+#endif
+}
+
+static int compiled_store(RULEXDB *rulexdb, const char *name,
+			  const void *image, size_t size)
+     /*
+      * Store the named record of the compiled data
+      * replacing the previous one if any.
+      *
+      * Returns 0 on success or RULEXDB_FAILURE.
+      */
+{
+#ifdef USE_BDB
+  DB *db;
+  DBT inKey, inVal;
+  int rc;
+
+  db = db_open(rulexdb->env, compiled_db_name, COMPILED_DB_TYPE, RULEXDB_CREATE);
+  if (!db) return RULEXDB_FAILURE;
+  (void)memset(&inKey, 0, sizeof(DBT));
+  (void)memset(&inVal, 0, sizeof(DBT));
+  inKey.data = (char *)name;
+  inKey.size = strlen(name) + 1;
+  inVal.data = (void *)image;
+  inVal.size = size;
+  rc = db->put(db, NULL, &inKey, &inVal, 0);
+  db_close(db);
+#else
+  MDB_dbi dbi;
+  MDB_val key, data;
+  int rc;
+
+  if (mdb_dbi_open(rulexdb->txn, compiled_db_name, MDB_CREATE, &dbi))
+    return RULEXDB_FAILURE;
+  key.mv_data = (char *)name;
+  key.mv_size = strlen(name) + 1;
+  data.mv_data = (void *)image;
+  data.mv_size = size;
+  rc = mdb_put(rulexdb->txn, dbi, &key, &data, 0);
+#endif
+  return rc ? RULEXDB_FAILURE : RULEXDB_SUCCESS;
+}
+
+static void compiled_remove(RULEXDB *rulexdb, const char *name)
+     /*
+      * Remove the named record of the compiled data if any.
+      */
+{
+#ifdef USE_BDB
+  DB *db;
+  DBT inKey;
+
+  db = db_open(rulexdb->env, compiled_db_name, COMPILED_DB_TYPE, RULEXDB_UPDATE);
+  if (!db) return;
+  (void)memset(&inKey, 0, sizeof(DBT));
+  inKey.data = (char *)name;
+  inKey.size = strlen(name) + 1;
+  (void)db->del(db, NULL, &inKey, 0);
+  db_close(db);
+#else
+  MDB_dbi dbi;
+  MDB_val key;
+
+  if (mdb_dbi_open(rulexdb->txn, compiled_db_name, 0, &dbi))
+    return;
+  key.mv_data = (char *)name;
+  key.mv_size = strlen(name) + 1;
+  (void)mdb_del(rulexdb->txn, dbi, &key, NULL);
+#endif
+}
+
+static size_t compiled_copy(RULEXDB *rulexdb, const char *name,
+			    void *buf, size_t size)
+     /*
+      * Copy the named record of the compiled data into the buffer
+      * of specified size. Unlike compiled_fetch() it works in any
+      * access mode. The record is copied only when it fits.
+      *
+      * Returns the record size or 0 if there is no such record.
+      */
+{
+#ifdef USE_BDB
+  DB *db;
+  DBT inKey, inVal;
+  size_t len = 0;
+
+  if (rulexdb->lexfile.image)
+    return 0;
+  db = db_open(rulexdb->env, compiled_db_name, COMPILED_DB_TYPE, RULEXDB_SEARCH);
+  if (!db) return 0;
+  (void)memset(&inKey, 0, sizeof(DBT));
+  (void)memset(&inVal, 0, sizeof(DBT));
+  inKey.data = (char *)name;
+  inKey.size = strlen(name) + 1;
+  if (!db->get(db, NULL, &inKey, &inVal, 0))
+    {
+      len = inVal.size;
+      if (len <= size)
+	(void)memcpy(buf, inVal.data, len);
+    }
+  db_close(db);
+  return len;
+#else
+  MDB_dbi dbi;
+  MDB_val key, data;
+
+  if (rulexdb->lexfile.image)
+    return 0;
+  key.mv_data = (char *)name;
+  key.mv_size = strlen(name) + 1;
+  if (mdb_dbi_open(rulexdb->txn, compiled_db_name, 0, &dbi) ||
+      mdb_get(rulexdb->txn, dbi, &key, &data))
+    return 0;
+  if (data.mv_size <= size)
+    (void)memcpy(buf, data.mv_data, data.mv_size);
+  return data.mv_size;
+#endif
+}
+
+static void generation_get(RULEXDB *rulexdb)
+     /*
+      * Read the modification counters of the dictionaries
+      * and rules at the first request. Every change of the data
+      * bumps its counter, and the compiled data are stamped
+      * by the counters of their sources, so the stale ones
+      * are detected without looking at the sources themselves.
+      * The database having no generation record has all
+      * the counters zero.
+      */
+{
+  uint32_t counters[GENERATIONS];
+  int i;
+
+  if (rulexdb->generation_known)
+    return;
+  rulexdb->generation_known = 1;
+  if (compiled_copy(rulexdb, generation_record_name,
+		    counters, sizeof(counters)) != sizeof(counters))
+    (void)memset(counters, 0, sizeof(counters));
+  for (i = 0; i < GENERATIONS; i++)
+    rulexdb->generation[i] = counters[i];
+}
+
+static int generation_bump(RULEXDB *rulexdb, int counter)
+     /*
+      * Bump the modification counter of the data being changed
+      * within the same transaction. It is done only once
+      * per handler until the compiled data are stamped again.
+      *
+      * Returns 0 on success or RULEXDB_FAILURE.
+      */
+{
+  uint32_t counters[GENERATIONS];
+  int i;
+
+  if ((rulexdb->generation_bumped & (1 << counter)) ||
+      (rulexdb->mode == RULEXDB_SEARCH) || rulexdb->lexfile.image)
+    return RULEXDB_SUCCESS;
+  generation_get(rulexdb);
+  for (i = 0; i < GENERATIONS; i++)
+    counters[i] = rulexdb->generation[i];
+  counters[counter]++;
+  if (compiled_store(rulexdb, generation_record_name,
+		     counters, sizeof(counters)))
+    return RULEXDB_FAILURE;
+  rulexdb->generation[counter] = counters[counter];
+  rulexdb->generation_bumped |= 1 << counter;
+  return RULEXDB_SUCCESS;
+}
+
+static unsigned int generation_stamp(RULEXDB *rulexdb, int counter)
+     /*
+      * Get the modification counter to stamp the compiled data
+      * being built from the current data. Any further change
+      * will bump it again.
+      */
+{
+  generation_get(rulexdb);
+  rulexdb->generation_bumped &= ~(1 << counter);
+  return rulexdb->generation[counter];
+}
+
+static int keys_format_choose(RULEXDB *rulexdb, int fresh)
+     /*
+      * Choose the dictionary keys packing format by its stamp
+      * stored along with the compiled data or in the compiled
+      * lexicon file. The stamp holds the format tag optionally
+      * followed by the identifier of the trained model, which must
+      * match the built-in one. The dictionaries having no stamp
+      * are packed in the original format. The newly created database
+      * (when fresh is non-zero) is stamped for the range coder
+      * with the order-1 model.
+      *
+      * Returns 0 on success or RULEXDB_FAILURE if the format
+      * is unknown, the model differs or the stamp cannot be stored.
+      */
+{
+  uint32_t format[2] = { 0, 0 }; /* Format tag and model identifier */
+  const RULEX_KEYCODER *coder;
+  const void *stamp;
+  size_t size;
+
+  if (rulexdb->lexfile.image)
+    {
+      stamp = lexfile_section(rulexdb->lexfile.image,
+			      LEXFILE_KEYS_FORMAT, &size);
+      if (stamp && ((size == sizeof(uint32_t)) || (size == sizeof(format))))
+	(void)memcpy(format, stamp, size);
+    }
+  else
+    {
+      size = compiled_copy(rulexdb, keys_format_record_name,
+			   format, sizeof(format));
+      if ((size != sizeof(uint32_t)) && (size != sizeof(format)))
+	format[0] = format[1] = 0;
+      if ((!format[0]) && fresh)
+	{
+	  format[0] = KEY_FORMAT_CONTEXT;
+	  format[1] = key_coder(KEY_FORMAT_CONTEXT)->model;
+	  if (compiled_store(rulexdb, keys_format_record_name,
+			     format, sizeof(format)))
+	    return RULEXDB_FAILURE;
+	}
+    }
+  if (!format[0])
+    format[0] = KEY_FORMAT_ARITHMETIC;
+  coder = key_coder((int)format[0]);
+  if ((!coder) || (coder->model != format[1]))
+    return RULEXDB_FAILURE;
+  rulexdb->keycoder = coder;
+  return RULEXDB_SUCCESS;
+}
+
+static const RULEX_IMAGE *dictionary_filter(RULEXDB *rulexdb, int item_type)
+     /*
+      * Get the keys membership filter of the dictionary
+      * (RULEXDB_LEXBASE or RULEXDB_EXCEPTION) looking for it
+      * in the database at the first request. The filter is used
+      * only when the database is opened for searching.
+      *
+      * Returns NULL when there is no valid filter.
+      */
+{
+  RULEX_IMAGE *filter;
+  const char *db_name;
+  int counter;
+
+  if (item_type == RULEXDB_LEXBASE)
+    {
+      filter = &rulexdb->lexicon_filter;
+      db_name = lexicon_db_name;
+      counter = GENERATION_LEXBASES;
+    }
+  else
+    {
+      filter = &rulexdb->exceptions_filter;
+      db_name = exceptions_db_name;
+      counter = GENERATION_EXCEPTIONS;
+    }
+  if (filter->checked || (rulexdb->mode != RULEXDB_SEARCH) ||
+      rulexdb->shared)
+    return filter->image ? filter : NULL;
+  filter->checked = 1;
+
+  if (compiled_fetch(rulexdb, db_name, filter))
+    return NULL;
+  /* A filter left stale by other means is detected by the generation */
+  generation_get(rulexdb);
+  if ((!filter_valid(filter->image, filter->size)) ||
+      (filter_source(filter->image) != rulexdb->generation[counter]))
+    filter->image = NULL;
+  return filter->image ? filter : NULL;
+}
+
+static const RULEX_IMAGE *dictionary_fst(RULEXDB *rulexdb, int item_type)
+     /*
+      * Get the dictionary transducer (RULEXDB_LEXBASE
+      * or RULEXDB_EXCEPTION) as dictionary_filter() does.
+      *
+      * Returns NULL when there is no valid transducer.
+      */
+{
+  RULEX_IMAGE *fst;
+  const char *name;
+  int counter;
+
+  if (item_type == RULEXDB_LEXBASE)
+    {
+      fst = &rulexdb->lexicon_fst;
+      name = lexicon_fst_name;
+      counter = GENERATION_LEXBASES;
+    }
+  else
+    {
+      fst = &rulexdb->exceptions_fst;
+      name = exceptions_fst_name;
+      counter = GENERATION_EXCEPTIONS;
+    }
+  if (fst->checked || (rulexdb->mode != RULEXDB_SEARCH) ||
+      rulexdb->shared)
+    return fst->image ? fst : NULL;
+  fst->checked = 1;
+
+  if (compiled_fetch(rulexdb, name, fst))
+    return NULL;
+  generation_get(rulexdb);
+  if ((!fst_valid(fst->image, fst->size)) ||
+      (fst_source(fst->image) != rulexdb->generation[counter]))
+    fst->image = NULL;
+  return fst->image ? fst : NULL;
+}
+
+static void filter_drop(RULEXDB *rulexdb, int lexicon)
+     /*
+      * Remove the stored membership filter of the dictionary
+      * before it is changed. It is done only once per handler
+      * unless the filter is rebuilt.
+      */
+{
+  RULEX_IMAGE *filter = lexicon ?
+    &rulexdb->lexicon_filter : &rulexdb->exceptions_filter;
+
+  if (filter->checked || (rulexdb->mode == RULEXDB_SEARCH))
+    return;
+  filter->checked = 1;
+  compiled_remove(rulexdb, lexicon ? lexicon_db_name : exceptions_db_name);
+}
+
+static void fst_drop(RULEXDB *rulexdb, int lexicon)
+     /*
+      * Remove the stored transducer of the dictionary
+      * as filter_drop() does for the filter.
+      */
+{
+  RULEX_IMAGE *fst = lexicon ?
+    &rulexdb->lexicon_fst : &rulexdb->exceptions_fst;
+
+  if (fst->checked || (rulexdb->mode == RULEXDB_SEARCH))
+    return;
+  fst->checked = 1;
+  compiled_remove(rulexdb, lexicon ? lexicon_fst_name : exceptions_fst_name);
+}
+
+static void dictionary_changed(RULEXDB *rulexdb, int lexicon)
+     /*
+      * Drop the compiled data of the dictionary and bump
+      * its modification counter when it is changed.
+      */
+{
+  filter_drop(rulexdb, lexicon);
+  fst_drop(rulexdb, lexicon);
+  (void)generation_bump(rulexdb, lexicon ?
+			GENERATION_LEXBASES : GENERATION_EXCEPTIONS);
+}
+
+static unsigned int frozen_generation(RULEXDB *rulexdb, int stamp)
+     /*
+      * Get the generation of all the data the search results
+      * depend on: both dictionaries and all the rules. It is
+      * the sum of their modification counters, so it changes
+      * whenever any of them is bumped. Non-zero stamp means
+      * that the counters are taken to stamp the new table.
+      */
+{
+  unsigned int sum = 0;
+  int i;
+
+  generation_get(rulexdb);
+  for (i = 0; i < GENERATIONS; i++)
+    sum += stamp ? generation_stamp(rulexdb, i) : rulexdb->generation[i];
+  return sum;
+}
+
+static const void *frozen_table(RULEXDB *rulexdb)
+     /*
+      * Get the frozen search results table looking for it
+      * in the database at the first request. The table is used
+      * only when the database is opened for searching
+      * and the rules matching statistics are not collected.
+      *
+      * Returns NULL when there is no valid table.
+      */
+{
+  RULEX_IMAGE *frozen = &rulexdb->frozen;
+
+  if (frozen->checked || (rulexdb->mode != RULEXDB_SEARCH) ||
+      (rulexdb->options & RULEXDB_STATS) || rulexdb->shared)
+    return frozen->image;
+  frozen->checked = 1;
+
+  if (compiled_fetch(rulexdb, frozen_record_name, frozen))
+    return NULL;
+  /* A table left stale by other means is detected by the generation */
+  if ((!frozen_valid(frozen->image, frozen->size)) ||
+      (frozen_source(frozen->image) != frozen_generation(rulexdb, 0)))
+    frozen->image = NULL;
+  return frozen->image;
+}
+
+static void frozen_drop(RULEXDB *rulexdb)
+     /*
+      * Remove the stored frozen search results table before
+      * the dictionaries or rules are changed. It is done
+      * only once per handler unless the table is rebuilt.
+      */
+{
+  if (rulexdb->frozen.checked || (rulexdb->mode == RULEXDB_SEARCH))
+    return;
+  rulexdb->frozen.checked = 1;
+  compiled_remove(rulexdb, frozen_record_name);
+}
+
+static const void *lexfile_dictionary(RULEXDB *rulexdb, int item_type)
+     /*
+      * Get the dictionary table of the compiled lexicon file.
+      * Returns NULL if the table is absent.
+      */
+{
+  size_t size;
+
+  return lexfile_section(rulexdb->lexfile.image,
+			 (item_type == RULEXDB_LEXBASE) ?
+			 LEXFILE_LEXBASES : LEXFILE_EXCEPTIONS, &size);
+}
+
+static int lexfile_get(RULEXDB *rulexdb, int item_type,
+		       const char *key, char *value, unsigned int *probes)
+     /*
+      * Retrieve data from the dictionary of the compiled lexicon file
+      * as db_get() does for the database. No filter is needed here,
+      * since the slot fingerprint rejects absent keys in place.
+      */
+{
+  int keylen;
+  char packed_key[RULEXDB_BUFSIZE];
+  const void *table = lexfile_dictionary(rulexdb, item_type);
+  LEXFILE_RECORD record;
+
+  keylen = rulexdb->keycoder->pack(key, packed_key);
+  if (keylen <= 0)
+    return RULEXDB_EINVKEY;
+  if (!table)
+    return RULEXDB_SPECIAL;
+  if (probes) (*probes)++;
+  if (!lexfile_table_get(table, packed_key, keylen, &record))
+    return RULEXDB_SPECIAL;
+  unpack_data(value, record.value, (int)record.size);
+  return RULEXDB_SUCCESS;
+}
+
+static int lexfile_walk(RULEXDB *rulexdb, char *key, char *value,
+			int item_type, int mode)
+     /*
+      * Sequentially fetch the dictionary records
+      * of the compiled lexicon file as rulexdb_seq() does.
+      */
+{
+  int direction;
+  const void *table;
+  LEXFILE_RECORD record;
+
+  if ((item_type != RULEXDB_EXCEPTION) &&
+      (item_type != RULEXDB_EXCEPTION_RAW) &&
+      (item_type != RULEXDB_LEXBASE))
+    return RULEXDB_EPARM;
+  switch (mode)
+    {
+      case RULEXDB_SEQ_FIRST:
+	direction = LEXFILE_FIRST;
+	break;
+      case RULEXDB_SEQ_NEXT:
+	direction = LEXFILE_NEXT;
+	break;
+      case RULEXDB_SEQ_PREV:
+	direction = LEXFILE_PREV;
+	break;
+      case RULEXDB_SEQ_LAST:
+	direction = LEXFILE_LAST;
+	break;
+      default:
+	return RULEXDB_EPARM;
+    }
+  table = lexfile_dictionary(rulexdb, item_type);
+  if (!table)
+    return RULEXDB_FAILURE;
+  if (!lexfile_table_step(table,
+			  &rulexdb->lexfile_seq[item_type == RULEXDB_LEXBASE],
+			  direction, &record))
+    return RULEXDB_SPECIAL;
+  if (rulexdb->keycoder->unpack(record.key, record.keylen,
+				key, RULEXDB_MAX_KEY_SIZE))
+    return RULEXDB_FAILURE;
+  (void)strcpy(value, key);
+  unpack_data(value, record.value, (int)record.size);
+  if (item_type == RULEXDB_EXCEPTION)
+    return postcorrect(rulexdb, value);
+  return RULEXDB_SUCCESS;
+}
+
+static int fst_get(const RULEX_IMAGE *fst, const char *key, char *value,
+		   unsigned int *probes)
+     /*
+      * Retrieve data from the dictionary transducer
+      * as db_get() does for the database.
+      */
+{
+  const char *data;
+  unsigned int size;
+  int found = fst_lookup(fst->image, key, &data, &size);
+
+  /* Only the keys that could be packed are counted as absent */
+  if ((!found) && check_key(key))
+    return RULEXDB_EINVKEY;
+  if (probes) (*probes)++;
+  if (!found)
+    return RULEXDB_SPECIAL;
+  unpack_data(value, data, (int)size);
+  return RULEXDB_SUCCESS;
+}
+
+static int dictionary_check(RULEXDB *rulexdb, int item_type)
+     /*
+      * Check whether the dictionary (RULEXDB_LEXBASE
+      * or RULEXDB_EXCEPTION) can be looked up while searching
+      * opening it if necessary.
+      *
+      * Returns RULEXDB_SUCCESS when it can, RULEXDB_SPECIAL
+      * when the dictionary is absent or RULEXDB_EPARM.
+      */
+{
+#ifdef USE_BDB
+  DB **db;
+#else
+  DictHandle h;
+#endif
+
+  if (!rulexdb)
+    return RULEXDB_EPARM;
+  if (rulexdb->lexfile.image)
+    return RULEXDB_SUCCESS;
+#ifdef USE_BDB
+  db = choose_dictionary(rulexdb, NULL, item_type);
+  if (!db) return RULEXDB_EPARM;
+  return *db ? RULEXDB_SUCCESS : RULEXDB_SPECIAL;
+#else
+  h = choose_dictionary(rulexdb, NULL, item_type);
+  if (!h.dbi) return RULEXDB_EPARM;
+  return *(h.dbi_open) ? RULEXDB_SUCCESS : RULEXDB_SPECIAL;
+#endif
+}
+
+static int dictionary_get(RULEXDB *rulexdb, int item_type,
+			  const char *key, char *value)
+     /*
+      * Look the key up in the dictionary accepted by dictionary_check()
+      * while searching. The dictionary transducer is looked up
+      * instead of the database when it is stored, otherwise
+      * the dictionary membership filter is applied. The lookups
+      * are counted for the search trace. The compiled lexicon file
+      * is looked up instead of the database when it is opened.
+      */
+{
+  const RULEX_IMAGE *filter;
+#ifdef USE_BDB
+  DB **db;
+#else
+  DictHandle h;
+#endif
+
+  if (rulexdb->lexfile.image)
+    return lexfile_get(rulexdb, item_type, key, value,
+		       trace_probes(rulexdb));
+  filter = dictionary_fst(rulexdb, item_type);
+  if (filter)
+    return fst_get(filter, key, value, trace_probes(rulexdb));
+  filter = dictionary_filter(rulexdb, item_type);
+#ifdef USE_BDB
+  db = choose_dictionary(rulexdb, NULL, item_type);
+  return db_get(*db, rulexdb->keycoder, filter, key, value,
+		trace_probes(rulexdb));
+#else
+  h = choose_dictionary(rulexdb, NULL, item_type);
+  return lmdb_get(rulexdb->txn, *(h.dbi), rulexdb->keycoder, filter,
+		  key, value, trace_probes(rulexdb));
+#endif
+}
+
+static int rules_attach(RULEX_RULESET *rules)
+     /*
+      * Turn a copy of the shared ruleset handler into the private
+      * one for a session. The data modified while searching
+      * are duplicated, everything else is shared.
+      */
+{
+  rules->stats = NULL;
+  if (rules->dfa)
+    {
+      rules->dfa = dfa_clone(rules->dfa);
+      if (!rules->dfa)
+	return RULEXDB_EMALLOC;
+    }
+  if (rules->suffix)
+    {
+      rules->suffix = suffix_clone(rules->suffix);
+      if (!rules->suffix)
+	return RULEXDB_EMALLOC;
+    }
+  if (rules->prefix)
+    {
+      rules->prefix = prefix_clone(rules->prefix);
+      if (!rules->prefix)
+	return RULEXDB_EMALLOC;
+    }
+#ifdef USE_PCRE2
+  if (rules->match_data)
+    {
+      rules->match_data = pcre2_match_data_create(MAX_SUBMATCHES, NULL);
+      if (!rules->match_data)
+	return RULEXDB_EMALLOC;
+    }
+#endif
+  return RULEXDB_SUCCESS;
+}
+
+static void rules_detach(RULEX_RULESET *rules, const RULEX_RULESET *shared)
+     /*
+      * Free the data of the session's ruleset handler
+      * that are not shared with the origin one.
+      */
+{
+  if (rules->dfa != shared->dfa)
+    dfa_free(rules->dfa);
+  if (rules->suffix != shared->suffix)
+    suffix_free(rules->suffix);
+  if (rules->prefix != shared->prefix)
+    prefix_free(rules->prefix);
+#ifdef USE_PCRE2
+  if (rules->match_data != shared->match_data)
+    pcre2_match_data_free(rules->match_data);
+#endif
+#ifndef USE_BDB
+  if (rules->keys != shared->keys)
+    free(rules->keys);
+#endif
+  return;
+}
+
+static RULEX_RULESET *get_ruleset_handler(RULEXDB *rulexdb, int rule_type)
+     /*
+      * Get ruleset handler pointer for specified rule type.
+      * Returns NULL for unknown type.
+      */
+{
+  if (!rulexdb) return NULL;
+  switch (rule_type)
+    {
+      case RULEXDB_RULE:
+	return &rulexdb->rules;
+      case RULEXDB_LEXCLASS:
+	return &rulexdb->lexclasses;
+      case RULEXDB_PREFIX:
+	return &rulexdb->prefixes;
+      case RULEXDB_CORRECTOR:
+	return &rulexdb->correctors;
+      default:
+	break;
+    }
+  return NULL;
+}
+
+static RULEX_RULESET *choose_ruleset(RULEXDB *rulexdb, int rule_type)
+     /*
+      * Choose ruleset and open it if necessary.
+      *
+      * Returns opened ruleset handler pointer when success
+      * or NULL otherwise.
+      */
+{
+  RULEX_RULESET *rules = get_ruleset_handler(rulexdb, rule_type);
+
+  if (!rules) return NULL;
+  if (rulexdb->lexfile.image) /* Nothing can be changed there */
+    return rules;
+#ifdef USE_BDB
+  if (!rules->db)
+    rules->db = db_open(rules->env, rules->db_name,
+			RULES_DB_TYPE, rulexdb->mode);
+  if (rules->db) rules->nrules = -1;
+#else
+  if ((!rules->dbi_open) && !rulexdb->shared)
+    {
+      unsigned int flags = MDB_INTEGERKEY;
+      if (rulexdb->mode != RULEXDB_SEARCH)
+        flags |= MDB_CREATE;
+      if (!mdb_dbi_open(rulexdb->txn, rules->db_name, flags, &rules->dbi))
+        {
+          rules->dbi_open = 1;
+          rules->nrules = -1;
+        }
+    }
+#endif
+  return rules;
+}
+
+static void results_invalidate(RULEXDB *rulexdb)
+     /*
+      * Forget cached and frozen search results
+      * before the database is changed.
+      */
+{
+  if (!rulexdb)
+    return;
+  if (rulexdb->cache)
+    cache_clear(rulexdb->cache);
+  frozen_drop(rulexdb);
+}
+
+
+static int lexfile_map(RULEXDB *rulexdb, const char *path)
+     /*
+      * Map the compiled lexicon file into memory
+      * if specified path refers to it.
+      *
+      * Returns 0 on success or non-zero if it is not
+      * a compiled lexicon file or it cannot be mapped.
+      */
+{
+  int fd, rc = RULEXDB_FAILURE;
+  struct stat st;
+  void *image;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return RULEXDB_FAILURE;
+  if ((!fstat(fd, &st)) && (st.st_size > 0))
+    {
+#ifdef HAVE_SYS_MMAN_H
+      image = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (image != MAP_FAILED)
+	{
+	  if (lexfile_valid(image, st.st_size))
+	    rc = RULEXDB_SUCCESS;
+	  else (void)munmap(image, st.st_size);
+	}
+#else
+      image = malloc(st.st_size);
+      if (image)
+	{
+	  if ((read(fd, image, st.st_size) == st.st_size) &&
+	      lexfile_valid(image, st.st_size))
+	    {
+	      rulexdb->lexfile.buf = image;
+	      rc = RULEXDB_SUCCESS;
+	    }
+	  else free(image);
+	}
+#endif
+      if (!rc)
+	{
+	  rulexdb->lexfile.image = image;
+	  rulexdb->lexfile.size = st.st_size;
+	}
+    }
+  (void)close(fd);
+  return rc;
+}
+
+static void lexfile_unmap(RULEXDB *rulexdb)
+     /*
+      * Release the compiled lexicon file if it is mapped.
+      */
+{
+#ifdef HAVE_SYS_MMAN_H
+  if (rulexdb->lexfile.image)
+    (void)munmap((void *)rulexdb->lexfile.image, rulexdb->lexfile.size);
+#else
+  free(rulexdb->lexfile.buf);
+#endif
+  rulexdb->lexfile.image = NULL;
+  return;
+}
+
+
+/* Externally visible routines */
+
+RULEXDB *rulexdb_open(const char *path, int mode)
+     /*
+      * Open lexical database.
+      *
+      * This routine does not actually open any dataset
+      * (the datasets are to be opened later by demand),
+      * but it allocates and initializes new RULEXDB structure
+      * and opens the database environment. By the way
+      * this routine checks accessibility of the database file.
+      *
+      * Arguments description:
+      * path - path to the database file;
+      * mode - Access mode: RULEXDB_SEARCH, RULEXDB_UPDATE or RULEXDB_CREATE.
+      *        It may be or'ed with following options:
+      *        RULEXDB_DFA - match general rules by the combined deterministic
+      *        automaton instead of trying them one by one;
+      *        RULEXDB_PRELOAD - load all the rulesets at once, so no rule
+      *        is compiled while searching (for RULEXDB_SEARCH mode only);
+      *        RULEXDB_STATS - collect matching statistics for every rule;
+      *        RULEXDB_SHARED - prepare the handler to be shared by parallel
+      *        threads through sessions (for RULEXDB_SEARCH mode only,
+      *        implies RULEXDB_PRELOAD).
+      *
+      * Returns pointer to the new RULEXDB structure when success
+      * or NULL otherwise.
+      */
+{
+  RULEXDB *rulexdb = calloc(1, sizeof(RULEXDB));
+  int fresh = access(path, F_OK) != 0; /* No database file yet */
+
+  if (!rulexdb)
+    return NULL;
+  rulexdb->options = mode & ~ACCESS_MODE_MASK;
+  mode &= ACCESS_MODE_MASK;
+  if (rulexdb->options & RULEXDB_SHARED)
+    {
+      if (mode == RULEXDB_SEARCH)
+	rulexdb->options |= RULEXDB_PRELOAD;
+      else rulexdb->options &= ~RULEXDB_SHARED;
+    }
+
+  /* The compiled lexicon file needs no environment */
+  if ((mode == RULEXDB_SEARCH) && !lexfile_map(rulexdb, path))
+    {
+      rulexdb->rules.db_name       = rules_db_name;
+      rulexdb->lexclasses.db_name  = lexclasses_db_name;
+      rulexdb->prefixes.db_name    = prefixes_db_name;
+      rulexdb->correctors.db_name  = corrections_db_name;
+      rulexdb->mode = mode;
+      goto preload;
+    }
+
+#ifdef USE_BDB
+
+  /* Create database environment */
+  if (db_env_create(&rulexdb->env, 0))
+    {
+      free(rulexdb);
+      return NULL;
+    }
+  /* Open it */
+  if (rulexdb->env->open(rulexdb->env, NULL,
+		       DB_INIT_MPOOL | DB_INIT_LOCK | DB_PRIVATE | DB_CREATE,
+		       0))
+    {
+      (void)rulexdb->env->close(rulexdb->env, 0);
+      free(rulexdb);
+      return NULL;
+    }
+
+  /* Initialize necessary RULEXDB fields */
+  rulexdb->env->app_private = (char *)path;
+  rulexdb->rules.env = rulexdb->env;
+  rulexdb->rules.db_name = rules_db_name;
+  rulexdb->lexclasses.env = rulexdb->env;
+  rulexdb->lexclasses.db_name = lexclasses_db_name;
+  rulexdb->prefixes.env = rulexdb->env;
+  rulexdb->prefixes.db_name = prefixes_db_name;
+  rulexdb->correctors.env = rulexdb->env;
+  rulexdb->correctors.db_name = corrections_db_name;
+  rulexdb->mode = mode;
+
+  /* Check database file accessibility according to specified access mode */
+  switch (mode)
+    {
+      case RULEXDB_SEARCH:
+	if (access(path, F_OK | R_OK))
+	  {
+	    (void)rulexdb->env->close(rulexdb->env, 0);
+	    free(rulexdb);
+	    rulexdb = NULL;
+	  }
+	break;
+      case RULEXDB_UPDATE:
+	if (access(path, F_OK | R_OK | W_OK))
+	  {
+	    (void)rulexdb->env->close(rulexdb->env, 0);
+	    free(rulexdb);
+	    rulexdb = NULL;
+	  }
+	break;
+      case RULEXDB_CREATE:
+	if (!access(path, F_OK))
+	  if (access(path, R_OK | W_OK))
+	    {
+	      (void)rulexdb->env->close(rulexdb->env, 0);
+	      free(rulexdb);
+	      rulexdb = NULL;
+	    }
+	break;
+      default:
+	(void)rulexdb->env->close(rulexdb->env, 0);
+	free(rulexdb);
+	rulexdb = NULL;
+	break;
+    }
+
+#else /* LMDB */
+
+  /* Check file accessibility according to specified access mode */
+  switch (mode)
+    {
+      case RULEXDB_SEARCH:
+	if (access(path, F_OK | R_OK))
+	  {
+	    free(rulexdb);
+	    return NULL;
+	  }
+	break;
+      case RULEXDB_UPDATE:
+	if (access(path, F_OK | R_OK | W_OK))
+	  {
+	    free(rulexdb);
+	    return NULL;
+	  }
+	break;
+      case RULEXDB_CREATE:
+	if (!access(path, F_OK))
+	  if (access(path, R_OK | W_OK))
+	    {
+	      free(rulexdb);
+	      return NULL;
+	    }
+	break;
+      default:
+	free(rulexdb);
+	return NULL;
+    }
+
+  if (mdb_env_create(&rulexdb->env))
+    {
+      free(rulexdb);
+      return NULL;
+    }
+  if (mdb_env_set_mapsize(rulexdb->env, LMDB_MAP_SIZE) ||
+      mdb_env_set_maxdbs(rulexdb->env, LMDB_MAX_DBS))
+    {
+      mdb_env_close(rulexdb->env);
+      free(rulexdb);
+      return NULL;
+    }
+
+  {
+    unsigned int env_flags = MDB_NOSUBDIR | MDB_NOLOCK;
+    mdb_mode_t file_mode;
+    unsigned int txn_flags;
+
+    if (mode == RULEXDB_SEARCH)
+      {
+	env_flags |= MDB_RDONLY;
+	/* Sessions transactions are not bound to threads */
+	if (rulexdb->options & RULEXDB_SHARED)
+	  env_flags |= MDB_NOTLS;
+      }
+    file_mode = (mode == RULEXDB_CREATE) ? 0644 : 0;
+    if (mdb_env_open(rulexdb->env, path, env_flags, file_mode))
+      {
+	mdb_env_close(rulexdb->env);
+	free(rulexdb);
+	return NULL;
+      }
+
+    txn_flags = (mode == RULEXDB_SEARCH) ? MDB_RDONLY : 0;
+    if (mdb_txn_begin(rulexdb->env, NULL, txn_flags, &rulexdb->txn))
+      {
+	mdb_env_close(rulexdb->env);
+	free(rulexdb);
+	return NULL;
+      }
+  }
+
+  rulexdb->rules.db_name       = rules_db_name;
+  rulexdb->lexclasses.db_name  = lexclasses_db_name;
+  rulexdb->prefixes.db_name    = prefixes_db_name;
+  rulexdb->correctors.db_name  = corrections_db_name;
+  rulexdb->mode = mode;
+
+#endif /* USE_BDB */
+
+ preload:
+  /* Choose the dictionary keys packing format */
+  if (rulexdb &&
+      keys_format_choose(rulexdb, fresh && (rulexdb->mode == RULEXDB_CREATE)))
+    {
+      rulexdb_close(rulexdb);
+      return NULL;
+    }
+
+  /* Load all the rulesets if requested */
+  if (rulexdb && (rulexdb->mode == RULEXDB_SEARCH) &&
+      (rulexdb->options & RULEXDB_PRELOAD))
+    {
+      (void)rulexdb_load_ruleset(rulexdb, RULEXDB_RULE);
+      (void)rulexdb_load_ruleset(rulexdb, RULEXDB_LEXCLASS);
+      (void)rulexdb_load_ruleset(rulexdb, RULEXDB_PREFIX);
+      (void)rulexdb_load_ruleset(rulexdb, RULEXDB_CORRECTOR);
+
+      /* Sessions never open datasets by themselves */
+      if (rulexdb->options & RULEXDB_SHARED)
+	{
+	  (void)choose_dictionary(rulexdb, NULL, RULEXDB_LEXBASE);
+	  (void)choose_dictionary(rulexdb, NULL, RULEXDB_EXCEPTION);
+	  (void)dictionary_filter(rulexdb, RULEXDB_LEXBASE);
+	  (void)dictionary_filter(rulexdb, RULEXDB_EXCEPTION);
+	  (void)dictionary_fst(rulexdb, RULEXDB_LEXBASE);
+	  (void)dictionary_fst(rulexdb, RULEXDB_EXCEPTION);
+	  (void)frozen_table(rulexdb);
+	}
+    }
+
+  return rulexdb;
+}
+
+RULEXDB *rulexdb_session(RULEXDB *rulexdb)
+     /*
+      * Open new session for the database handler opened
+      * with RULEXDB_SHARED option.
+      *
+      * The session is a lightweight handler having its own
+      * read transaction and scratch buffers, while the datasets
+      * and loaded rulesets are shared with the origin one.
+      * Different sessions as well as the origin handler itself
+      * may be used in parallel threads. Every session must be closed
+      * by rulexdb_close() before closing the origin handler.
+      * Rules matching statistics are not collected through sessions.
+      *
+      * Returns pointer to the new RULEXDB structure when success
+      * or NULL otherwise.
+      */
+{
+#ifndef USE_BDB
+  RULEXDB *session;
+#endif
+
+  if ((!rulexdb) || rulexdb->shared ||
+      !(rulexdb->options & RULEXDB_SHARED))
+    return NULL;
+#ifdef USE_BDB
+  /* Berkeley DB handles are not opened as free-threaded ones */
+  return NULL;
+#else
+  session = malloc(sizeof(RULEXDB));
+  if (!session)
+    return NULL;
+  *session = *rulexdb;
+  session->shared = rulexdb;
+  session->options &= ~RULEXDB_STATS;
+  session->cache = NULL;
+  session->lexicon_cursor = NULL;
+  session->exceptions_cursor = NULL;
+  if ((!rulexdb->lexfile.image) &&
+      mdb_txn_begin(rulexdb->env, NULL, MDB_RDONLY, &session->txn))
+    {
+      free(session);
+      return NULL;
+    }
+  if (rules_attach(&session->rules) ||
+      rules_attach(&session->lexclasses) ||
+      rules_attach(&session->prefixes) ||
+      rules_attach(&session->correctors))
+    {
+      rulexdb_close(session);
+      return NULL;
+    }
+  return session;
+#endif
+}
+
+void rulexdb_close(RULEXDB *rulexdb)
+     /*
+      * Close lexical database or session and free all resources
+      * allocated for its sake.
+      */
+{
+  if (rulexdb->shared) /* Session */
+    {
+      rules_detach(&rulexdb->rules, &rulexdb->shared->rules);
+      rules_detach(&rulexdb->lexclasses, &rulexdb->shared->lexclasses);
+      rules_detach(&rulexdb->prefixes, &rulexdb->shared->prefixes);
+      rules_detach(&rulexdb->correctors, &rulexdb->shared->correctors);
+#ifndef USE_BDB
+      if (rulexdb->lexicon_cursor)
+	mdb_cursor_close(rulexdb->lexicon_cursor);
+      if (rulexdb->exceptions_cursor)
+	mdb_cursor_close(rulexdb->exceptions_cursor);
+      if (rulexdb->txn)
+	mdb_txn_abort(rulexdb->txn);
+#endif
+      cache_free(rulexdb->cache);
+      free(rulexdb);
+      return;
+    }
+  rules_release(&rulexdb->rules);
+  rules_release(&rulexdb->lexclasses);
+  rules_release(&rulexdb->prefixes);
+  rules_release(&rulexdb->correctors);
+#ifdef USE_BDB
+  if (rulexdb->lexicon_db)
+    db_close(rulexdb->lexicon_db);
+  if (rulexdb->exceptions_db)
+    db_close(rulexdb->exceptions_db);
+  if (rulexdb->env)
+    (void)rulexdb->env->close(rulexdb->env, 0);
+#else
+  if (rulexdb->lexicon_cursor)
+    mdb_cursor_close(rulexdb->lexicon_cursor);
+  if (rulexdb->exceptions_cursor)
+    mdb_cursor_close(rulexdb->exceptions_cursor);
+  if (rulexdb->txn)
+    {
+      if (rulexdb->mode == RULEXDB_SEARCH)
+	mdb_txn_abort(rulexdb->txn);
+      else
+	mdb_txn_commit(rulexdb->txn);
+    }
+  if (rulexdb->env)
+    mdb_env_close(rulexdb->env);
+#endif
+  lexfile_unmap(rulexdb);
+#ifdef USE_PCRE2
+  pcre2_compile_context_free(rulexdb->pcre2_context);
+  pcre2_maketables_free(NULL, rulexdb->pcre2_tables);
+#endif
+  free(rulexdb->lexicon_filter.buf);
+  free(rulexdb->exceptions_filter.buf);
+  free(rulexdb->lexicon_fst.buf);
+  free(rulexdb->exceptions_fst.buf);
+  free(rulexdb->frozen.buf);
+  cache_free(rulexdb->cache);
+  free(rulexdb);
+  return;
+}
+
+int rulexdb_subscribe_rule(RULEXDB *rulexdb, const char *src,
+			 int rule_type, unsigned int n)
+     /*
+      * Store new rule into the database.
+      *
+      * This routine adds new rule to the specified ruleset
+      * in the lexical database.
+      *
+      * Arguments description:
+      * rulexdb - pointer to the opened lexical database handler structure;
+      * src - text representation of the rule;
+      * rule_type - specifies the ruleset
+      *             (RULEXDB_LEXCLASS, RULEXDB_RULE, RULEXDB_PREFIX or RULEXDB_CORRECTOR);
+      * n - rule number. If 0, this rule is appended at the end of ruleset,
+      *     otherwise the new rule will be inserted at the specified position.
+      *
+      * Returns 0 (RULEXDB_SUCCESS) when success or non-zero
+      * error code otherwise.
+      */
+{
+  RULEX_RULESET *rules = choose_ruleset(rulexdb, rule_type);
+
+  if (!rules) return RULEXDB_EPARM;
+  results_invalidate(rulexdb);
+  (void)generation_bump(rulexdb, GENERATION_RULES);
+
+#ifdef USE_BDB
+  {
+    int rc;
+    DBT inKey, inVal;
+    db_recno_t recno;
+
+    if (!rules->db) return RULEXDB_EACCESS;
+    if (n) /* Explicit rule number */
+      {
+	rc = db_nrecs(rules->db);
+	if (n > (unsigned int)rc) /* Ruleset must be continuous */
+	  return RULEXDB_EINVKEY;
+      }
+    (void)memset(&inKey, 0, sizeof(DBT));
+    (void)memset(&inVal, 0, sizeof(DBT));
+    if (n)
+      {
+	recno = n;
+	inKey.data = &recno;
+	inKey.size = sizeof(db_recno_t);
+      }
+    inVal.data = (char *)src;
+    inVal.size = strlen(src) + 1;
+    rc = rules->db->put(rules->db, NULL, &inKey, &inVal, n ? 0 : DB_APPEND);
+    if (rc)
+      return RULEXDB_FAILURE;
+    return RULEXDB_SUCCESS;
+  }
+#else
+  {
+    int rc;
+    unsigned int count;
+    uint32_t recno;
+    MDB_val key, data;
+
+    if (!rules->dbi_open) return RULEXDB_EACCESS;
+    count = lmdb_rules_count(rulexdb, rules);
+    if (n > count) return RULEXDB_EINVKEY;
+
+    if (lmdb_rules_format(rulexdb, rules) == RULES_FORMAT_DENSE)
+      {
+	if (n == 0)
+	  {
+	    recno = count + 1;
+	    key.mv_data = &recno; key.mv_size = sizeof(uint32_t);
+	    data.mv_data = (char *)src; data.mv_size = strlen(src) + 1;
+	    rc = mdb_put(rulexdb->txn, rules->dbi, &key, &data, 0);
+	    return rc ? RULEXDB_FAILURE : RULEXDB_SUCCESS;
+	  }
+	rc = lmdb_rules_sparse(rulexdb, rules);
+	if (rc) return rc;
+      }
+    rc = lmdb_rules_index(rulexdb, rules);
+    if (rc) return rc;
+    return lmdb_rule_insert(rulexdb, rules, n ? n - 1 : count, src);
+  }
+#endif
+}
+
+char * rulexdb_fetch_rule(RULEXDB *rulexdb, int rule_type, int n)
+     /*
+      * Extract specified rule from lexical database.
+      *
+      * This routine retrieves rule in its text representation
+      * and return pointer to it or NULL when failure. This pointer
+      * remains valid only until next database operation.
+      *
+      * Arguments description:
+      * rulexdb - points to the opened lexical database handler structure;
+      * rule_type - specifies the ruleset
+      *             (RULEXDB_LEXCLASS, RULEXDB_RULE, RULEXDB_PREFIX or RULEXDB_CORRECTOR);
+      * n - rule number in the ruleset.
+      */
+{
+  RULEX_RULESET *rules = choose_ruleset(rulexdb, rule_type);
+
+  if (!rules) return NULL;
+  if (rulexdb->lexfile.image)
+    return rules_init(rulexdb, rules) ? NULL : rule_text(rulexdb, rules, n - 1);
+#ifdef USE_BDB
+  if (!rules->db) return NULL;
+  return rule_get(rules->db, n);
+#else
+  if (!rules->dbi_open) return NULL;
+  return lmdb_rule_get(rulexdb, rules, n);
+#endif
+}
+
+int rulexdb_remove_rule(RULEXDB *rulexdb, int rule_type, int n)
+     /*
+      * Remove specified rule from the database.
+      *
+      * Arguments description:
+      * rulexdb - points to the opened lexical database handler structure;
+      * rule_type - specifies the ruleset
+      *             (RULEXDB_LEXCLASS, RULEXDB_RULE, RULEXDB_PREFIX or RULEXDB_CORRECTOR);
+      * n - rule number in the ruleset.
+      *
+      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL when
+      * there is no rule with such number, or an appropriate
+      * error code when failure.
+      */
+{
+  RULEX_RULESET *rules = choose_ruleset(rulexdb, rule_type);
+
+  if (!rules) return RULEXDB_EPARM;
+  results_invalidate(rulexdb);
+  (void)generation_bump(rulexdb, GENERATION_RULES);
+
+#ifdef USE_BDB
+  {
+    int rc;
+    DBT inKey;
+    db_recno_t recno = n;
+
+    if (!rules->db) return RULEXDB_EACCESS;
+    (void)memset(&inKey, 0, sizeof(DBT));
+    inKey.data = &recno;
+    inKey.size = sizeof(db_recno_t);
+    rc = rules->db->del(rules->db, NULL, &inKey, 0);
+    if (rc)
+      {
+	if (rc == DB_NOTFOUND)
+	  return RULEXDB_SPECIAL;
+	return RULEXDB_FAILURE;
+      }
+    return RULEXDB_SUCCESS;
+  }
+#else
+  {
+    int rc;
+    unsigned int count;
+    uint32_t recno;
+    MDB_val key;
+
+    if (!rules->dbi_open) return RULEXDB_EACCESS;
+    count = lmdb_rules_count(rulexdb, rules);
+    if (n < 1 || (unsigned int)n > count) return RULEXDB_SPECIAL;
+    if ((unsigned int)n < count)
+      {
+	rc = lmdb_rules_sparse(rulexdb, rules);
+	if (rc) return rc;
+      }
+    rc = lmdb_rule_key(rulexdb, rules, n, &recno);
+    if (rc) return rc;
+    key.mv_data = &recno; key.mv_size = sizeof(uint32_t);
+    rc = mdb_del(rulexdb->txn, rules->dbi, &key, NULL);
+    if (rc == MDB_NOTFOUND) return RULEXDB_SPECIAL;
+    if (rc) return RULEXDB_FAILURE;
+    if (rules->keys)
+      {
+	rules->nkeys--;
+	(void)memmove(rules->keys + n - 1, rules->keys + n,
+		      (rules->nkeys - n + 1) * sizeof(unsigned int));
+      }
+    return RULEXDB_SUCCESS;
+  }
+#endif
+}
+
+int rulexdb_subscribe_item(RULEXDB *rulexdb, const char *key, const char * value,
+			 int item_type, int overwrite)
+     /*
+      * Put new item into the lexical database.
+      *
+      * Arguments description:
+      * rulexdb - points to the opened lexical database handler structure;
+      * key - the original word;
+      * value - its pronunciation;
+      * item_type - target dictionary specification
+      *             (RULEXDB_LEXBASE, RULEXDB_EXCEPTION or RULEXDB_DEFAULT);
+      * overwrite - if true (non-zero) the new item will replace
+      *             already existing one with the same key if any.
+      *             Otherwise the new item will not be stored.
+      *
+      * If item type is specified as RULEXDB_DEFAULT, then target dictionary
+      * will be guessed according to specified key: if it represents
+      * any lexical base, then lexbases dictionary will be chosen,
+      * otherwise the exceptions dictionary will be used.
+      *
+      * If item type is specified as RULEXDB_DEFAULT and key word is
+      * recognized as a lexical base, but the record for this key
+      * already exist in the Lexbases dictionary, then Exceptions
+      * dictionary will be tried instead.
+      *
+      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL when
+      * specified key already exists in the dictionary,
+      * or an appropriate error code when failure.
+      */
+{
+  int rc;
+  char packed_key[RULEXDB_BUFSIZE], packed_data[RULEXDB_BUFSIZE];
+
+#ifdef USE_BDB
+  DBT inKey, inVal;
+  DB **db = choose_dictionary(rulexdb, key, item_type);
+
+  if (!db) return RULEXDB_EPARM;
+  results_invalidate(rulexdb);
+  if (!(*db)) return RULEXDB_EACCESS;
+  (void)memset(&inKey, 0, sizeof(DBT));
+  (void)memset(&inVal, 0, sizeof(DBT));
+  inKey.size = rulexdb->keycoder->pack(key, packed_key);
+  if ((signed int)(inKey.size) <= 0)
+    return RULEXDB_EINVKEY;
+  inVal.size = pack_data(key, value, packed_data);
+  if ((signed int)(inVal.size) < 0)
+    return RULEXDB_EINVREC;
+  if (!inVal.size)
+    packed_data[inVal.size++] = 0;
+  inKey.data = packed_key;
+  inVal.data = packed_data;
+  rc = (*db)->put(*db, NULL, &inKey, &inVal, DB_NOOVERWRITE);
+  if ((item_type == RULEXDB_DEFAULT) && (rc == DB_KEYEXIST)
+      && (db == &rulexdb->lexicon_db))
+    {
+      db = choose_dictionary(rulexdb, NULL, RULEXDB_EXCEPTION);
+      if (!db) return RULEXDB_EPARM;
+      if (!(*db)) return RULEXDB_EACCESS;
+      rc = (*db)->put(*db, NULL, &inKey, &inVal, DB_NOOVERWRITE);
+    }
+  dictionary_changed(rulexdb, db == &rulexdb->lexicon_db);
+  switch (rc)
+    {
+      case 0:
+	return RULEXDB_SUCCESS;
+      case DB_KEYEXIST:
+	if (overwrite)
+	  {
+	    rc = (*db)->put(*db, NULL, &inKey, &inVal, 0);
+	    if (rc) break;
+	    else return RULEXDB_SPECIAL;
+	  }
+	else return RULEXDB_SPECIAL;
+      default:
+	break;
+    }
+#else
+  MDB_val inKey, inVal;
+  DictHandle h = choose_dictionary(rulexdb, key, item_type);
+
+  if (!h.dbi) return RULEXDB_EPARM;
+  results_invalidate(rulexdb);
+  if (!*(h.dbi_open)) return RULEXDB_EACCESS;
+  inKey.mv_size = (size_t)rulexdb->keycoder->pack(key, packed_key);
+  if ((signed int)inKey.mv_size <= 0)
+    return RULEXDB_EINVKEY;
+  inVal.mv_size = (size_t)pack_data(key, value, packed_data);
+  if ((signed int)inVal.mv_size < 0)
+    return RULEXDB_EINVREC;
+  if (!inVal.mv_size)
+    packed_data[inVal.mv_size++] = 0;
+  inKey.mv_data = packed_key;
+  inVal.mv_data = packed_data;
+  rc = mdb_put(rulexdb->txn, *(h.dbi), &inKey, &inVal, MDB_NOOVERWRITE);
+  if ((item_type == RULEXDB_DEFAULT) && (rc == MDB_KEYEXIST)
+      && (h.dbi == &rulexdb->lexicon_dbi))
+    {
+      h = choose_dictionary(rulexdb, NULL, RULEXDB_EXCEPTION);
+      if (!h.dbi) return RULEXDB_EPARM;
+      if (!*(h.dbi_open)) return RULEXDB_EACCESS;
+      rc = mdb_put(rulexdb->txn, *(h.dbi), &inKey, &inVal, MDB_NOOVERWRITE);
+    }
+  dictionary_changed(rulexdb, h.dbi == &rulexdb->lexicon_dbi);
+  switch (rc)
+    {
+      case 0:
+	return RULEXDB_SUCCESS;
+      case MDB_KEYEXIST:
+	if (overwrite)
+	  {
+	    rc = mdb_put(rulexdb->txn, *(h.dbi), &inKey, &inVal, 0);
+	    if (rc) break;
+	    else return RULEXDB_SPECIAL;
+	  }
+	else return RULEXDB_SPECIAL;
+      default:
+	break;
+    }
+#endif
+
+  return RULEXDB_FAILURE;
+}
+
+int rulexdb_retrieve_item(RULEXDB *rulexdb, const char *key, char *value, int item_type)
+     /*
+      * Retrieve an item from the lexical database.
+      *
+      * Arguments description:
+      * rulexdb - points to the opened lexical database handler structure;
+      * key - the word to retrieve item for;
+      * value - memory area for its pronunciation string;
+      * item_type - target dictionary specification
+      *             (RULEXDB_LEXBASE, RULEXDB_EXCEPTION or RULEXDB_DEFAULT);
+      *
+      * If item type is specified as RULEXDB_DEFAULT, then target dictionary
+      * will be guessed according to specified key: if it represents
+      * any lexical base, then lexbases dictionary will be chosen,
+      * otherwise the exceptions dictionary will be used.
+      *
+      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL when
+      * specified key does not exist in the dictionary,
+      * or an appropriate error code when failure.
+      */
+{
+#ifdef USE_BDB
+  DB **db = choose_dictionary(rulexdb, key, item_type);
+
+  if (!db) return RULEXDB_EPARM;
+  (void)strcpy(value, key);
+  if (rulexdb->lexfile.image)
+    return lexfile_get(rulexdb, (db == &rulexdb->lexicon_db) ?
+		       RULEXDB_LEXBASE : RULEXDB_EXCEPTION,
+		       key, value, NULL);
+  if (!(*db)) return RULEXDB_FAILURE;
+  return db_get(*db, rulexdb->keycoder, NULL, key, value, NULL);
+#else
+  DictHandle h = choose_dictionary(rulexdb, key, item_type);
+
+  if (!h.dbi) return RULEXDB_EPARM;
+  (void)strcpy(value, key);
+  if (rulexdb->lexfile.image)
+    return lexfile_get(rulexdb, (h.dbi == &rulexdb->lexicon_dbi) ?
+		       RULEXDB_LEXBASE : RULEXDB_EXCEPTION,
+		       key, value, NULL);
+  if (!*(h.dbi_open)) return RULEXDB_FAILURE;
+  return lmdb_get(rulexdb->txn, *(h.dbi), rulexdb->keycoder, NULL,
+		  key, value, NULL);
+#endif
+}
+
+int rulexdb_lexbase(RULEXDB *rulexdb, const char *s, char *t, int n)
+     /*
+      * Try to find lexical base for the specified word.
+      *
+      * This routine scans lexclasses ruleset beginning from n
+      * trying to match the word pointed by s. When match succeeds,
+      * the lexical base is constructed in memory area pointed by t,
+      * which must have enough space for it, and the number of matched rule
+      * is returned. If no match has occurred 0 is returned.
+      * In the case of error an appropriate error code is returned.
+      */
+{
+  int i, k, nrules, rc;
+  const int *list;
+  regmatch_t match[2];
+
+  if ((n < 1) || (!rulexdb) || (!s) || (!t)) return RULEXDB_EPARM;
+  rc = rules_init(rulexdb, &rulexdb->lexclasses);
+  if (rc) return rc;
+
+  nrules = rules_candidates(rulexdb, &rulexdb->lexclasses, s, &list);
+  for (k = 0; k < nrules; k++)
+    {
+      i = list ? list[k] : k;
+      if (i < n - 1) /* Not in the scanning range */
+	continue;
+      if ((rc = rule_load(rulexdb, &rulexdb->lexclasses, i)))
+	break;
+      if (!rule_match(rulexdb, &rulexdb->lexclasses, i, s, 2, match))
+	{
+	  (void)strncpy(t, s, match[1].rm_eo);
+	  t[match[1].rm_eo] = 0;
+	  if (rulexdb->lexclasses.replacement[i])
+	    (void)strcat(t, rulexdb->lexclasses.replacement[i]);
+	  rc = i + 1;
+	  break;
+	}
+    }
+  return rc;
+}
+
+int rulexdb_prefix(RULEXDB *rulexdb, const char *s, char *t,
+		   int *len, int n)
+     /*
+      * Strip a prefix from the word.
+      *
+      * This routine scans prefixes ruleset beginning from n
+      * trying to match the beginning of the word pointed by s.
+      * When match succeeds leaving some part of the word unmatched,
+      * the word stem is constructed in memory area pointed by t,
+      * which must have enough space for it, the length of the stripped
+      * prefix is placed in the location pointed by len unless it is NULL,
+      * and the number of matched rule is returned. If no match has occurred
+      * 0 is returned. In the case of error an appropriate error code
+      * is returned.
+      */
+{
+  int i, l;
+  const char *replacement;
+
+  if ((n < 1) || (!rulexdb) || (!s) || (!t)) return RULEXDB_EPARM;
+  i = rules_init(rulexdb, &rulexdb->prefixes);
+  if (i) return i;
+  i = prefix_next(rulexdb, s, n - 1, &l);
+  if (i < 0) return 0;
+  replacement = rulexdb->prefixes.replacement[i];
+  if ((replacement ? strlen(replacement) : 0) + strlen(s + l) >=
+      RULEXDB_BUFSIZE)
+    return RULEXDB_EINVKEY;
+  (void)strcpy(t, replacement ? replacement : "");
+  (void)strcat(t, s + l);
+  if (len) *len = l;
+  return i + 1;
+}
+
+int rulexdb_lexbases(RULEXDB *rulexdb, const char *s,
+		     RULEXDB_BASE *bases, int size, int n)
+     /*
+      * Find all lexical bases for the specified word in one pass.
+      *
+      * This routine scans lexclasses ruleset beginning from n
+      * and stores numbers of all rules matching the word pointed by s
+      * along with the lexical bases constructed by them in the array
+      * pointed by bases, which can hold up to size items. The items
+      * follow in the rules order. The number of stored items is returned.
+      * If it is equal to size, the scan may be continued from the rule
+      * following the last found one. In the case of error
+      * an appropriate error code is returned.
+      */
+{
+  int i, k, l, nrules, rc, found = 0;
+  const int *list;
+  regmatch_t match[2];
+
+  if ((n < 1) || (size < 1) || (!rulexdb) || (!s) || (!bases))
+    return RULEXDB_EPARM;
+  rc = rules_init(rulexdb, &rulexdb->lexclasses);
+  if (rc) return rc;
+
+  nrules = rules_candidates(rulexdb, &rulexdb->lexclasses, s, &list);
+  for (k = 0; (k < nrules) && (found < size); k++)
+    {
+      i = list ? list[k] : k;
+      if (i < n - 1) /* Not in the scanning range */
+	continue;
+      rc = rule_load(rulexdb, &rulexdb->lexclasses, i);
+      if (rc) return rc;
+      if (!rule_match(rulexdb, &rulexdb->lexclasses, i, s, 2, match))
+	{
+	  l = match[1].rm_eo;
+	  if (rulexdb->lexclasses.replacement[i])
+	    l += strlen(rulexdb->lexclasses.replacement[i]);
+	  if (l >= RULEXDB_BUFSIZE)
+	    return RULEXDB_EINVKEY;
+	  (void)strncpy(bases[found].base, s, match[1].rm_eo);
+	  bases[found].base[match[1].rm_eo] = 0;
+	  if (rulexdb->lexclasses.replacement[i])
+	    (void)strcat(bases[found].base, rulexdb->lexclasses.replacement[i]);
+	  bases[found++].rule = i + 1;
+	}
+    }
+  return found;
+}
+
+static int lexbase_lookup(RULEXDB *rulexdb, const char *key, char *value)
+     /*
+      * Treat the word as an implicit form and look up
+      * its lexical bases in the dictionary.
+      *
+      * The value buffer must contain the word itself.
+      * Returns RULEXDB_SUCCESS when pronunciation is found,
+      * RULEXDB_SPECIAL when it is not, or an error code.
+      */
+{
+  int i, j, k, n, rc;
+  RULEXDB_BASE bases[LEXBASES_CHUNK];
+
+  rc = dictionary_check(rulexdb, RULEXDB_LEXBASE);
+  if (rc) return rc;
+  for (rc = RULEXDB_SPECIAL, n = 1; rc == RULEXDB_SPECIAL;
+       n = bases[k - 1].rule + 1)
+    {
+      k = rulexdb_lexbases(rulexdb, key, bases, LEXBASES_CHUNK, n);
+      if (k < 0) return k;
+      for (i = 0; (rc == RULEXDB_SPECIAL) && (i < k); i++)
+	{
+	  if (strlen(key) < strlen(bases[i].base))
+	    {
+	      for (j = strlen(key); j < strlen(bases[i].base); j++)
+		value[j] ='_';
+	      value[strlen(bases[i].base)] = 0;
+	    }
+	  else value[strlen(key)] = 0;
+	  rc = dictionary_get(rulexdb, RULEXDB_LEXBASE, bases[i].base, value);
+	  if (rc < 0) return rc;
+	  if ((!rc) && rulexdb->trace)
+	    rulexdb->trace->lexclass = bases[i].rule;
+	}
+      if (k < LEXBASES_CHUNK) break;
+    }
+  return rc;
+}
+
+static int strip_prefixes(RULEXDB *rulexdb, const char *key, char *value)
+     /*
+      * Treat the word as an implicit form with prefixes.
+      *
+      * The prefixes are stripped one after another and every stem
+      * is looked up as an implicit form. When the stem is not found,
+      * further prefixes are stripped from it. The alternatives
+      * are explored in depth first order, the prefix rules being
+      * tried in their order at every level. The stems are kept
+      * in local buffers, so no more than MAX_PREFIXES prefixes
+      * can be stripped from a word.
+      *
+      * The value buffer must contain the word itself. On success
+      * the pronunciation with the prefixes restored is placed there.
+      * Returns RULEXDB_SPECIAL when nothing is found.
+      */
+{
+  char stem[MAX_PREFIXES][RULEXDB_BUFSIZE];
+  const char *word[MAX_PREFIXES + 1], *replacement;
+  char *result[MAX_PREFIXES + 1];
+  int next[MAX_PREFIXES + 1], len[MAX_PREFIXES + 1];
+  int i, j, d = 0, rc = RULEXDB_SPECIAL;
+
+  if (rules_init(rulexdb, &rulexdb->prefixes))
+    return RULEXDB_SPECIAL;
+  word[0] = key;
+  result[0] = value;
+  next[0] = 0;
+  for (;;)
+    {
+      i = (d < MAX_PREFIXES) ? prefix_next(rulexdb, word[d], next[d], &len[d]) : -1;
+      if (i < 0) /* Nothing more to strip from this word */
+	{
+	  if (!d) break;
+	  result[d][strlen(word[d])] = 0;
+	  d--;
+	}
+      else
+	{
+	  next[d] = i + 1;
+	  replacement = rulexdb->prefixes.replacement[i];
+	  j = replacement ? strlen(replacement) : 0;
+	  if ((j > len[d]) ||
+	      (j + strlen(word[d] + len[d]) >= RULEXDB_BUFSIZE))
+	    continue;
+	  (void)strcpy(stem[d], replacement ? replacement : "");
+	  (void)strcat(stem[d], word[d] + len[d]);
+	  word[d + 1] = stem[d];
+	  result[d + 1] = result[d] + len[d] - j;
+	  (void)strcpy(result[d + 1], word[d + 1]);
+	  rc = lexbase_lookup(rulexdb, word[d + 1], result[d + 1]);
+	  if (rc == RULEXDB_SPECIAL) /* Try to strip further */
+	    {
+	      next[++d] = 0;
+	      continue;
+	    }
+	}
+
+      /* Stem search is finished, restore the prefix */
+      if (rc == RULEXDB_EINVKEY)
+	rc = RULEXDB_SPECIAL;
+      (void)strncpy(result[d], word[d], len[d]);
+      if (rc != RULEXDB_SPECIAL)
+	{
+	  if ((!rc) && rulexdb->trace)
+	    {
+	      rulexdb->trace->nprefixes = d + 1;
+	      for (j = 0; (j <= d) && (j < RULEXDB_TRACE_PREFIXES); j++)
+		rulexdb->trace->prefixes[j] = next[j];
+	    }
+	  while (d--)
+	    (void)strncpy(result[d], word[d], len[d]);
+	  break;
+	}
+    }
+  return rc;
+}
+
+static int search_complete(RULEXDB *rulexdb, const char *key, char *value,
+			   int rc, int flags)
+     /*
+      * Complete the search of the word after the dictionaries
+      * lookup resulted in rc as rulexdb_search() does:
+      * strip prefixes, apply general rules and post-correction.
+      */
+{
+  /* Prefix detection stage */
+  if ((rc == RULEXDB_SPECIAL) && ((!flags) || (flags & RULEXDB_FORMS)))
+    {
+      trace_stage(rulexdb, RULEXDB_STAGE_PREFIXES);
+      rc = strip_prefixes(rulexdb, key, value);
+    }
+
+  /* The last resort: trying to use a general rule */
+  if (rc == RULEXDB_SPECIAL)
+    {
+      value[strlen(key)] = 0;
+      if ((!flags) || (flags & RULEXDB_RULES))
+	{
+	  trace_stage(rulexdb, RULEXDB_STAGE_RULES);
+	  rc = lexguess(rulexdb, key, value);
+	}
+    }
+
+  /* Applying a post-correction if needed */
+  if (!rc)
+    {
+      if (rulexdb->trace)
+	rulexdb->trace->stage = rulexdb->trace_stage;
+      trace_stage(rulexdb, RULEXDB_STAGE_CORRECTIONS);
+      rc = postcorrect(rulexdb, value);
+    }
+
+  return rc;
+}
+
+static int frozen_lookup(RULEXDB *rulexdb, const char *key, char *value,
+			 int flags, int *rc)
+     /*
+      * Look up the word in the frozen search results table.
+      * The table holds the full search results only,
+      * and it is not consulted when the search is traced.
+      *
+      * Returns 1 if the word is found or 0 otherwise.
+      */
+{
+  const void *table;
+
+  if (flags || rulexdb->trace)
+    return 0;
+  table = frozen_table(rulexdb);
+  return table && frozen_get(table, key, value, rc);
+}
+
+int rulexdb_search(RULEXDB *rulexdb, const char * key, char *value, int flags)
+     /*
+      * Search lexical database for specified word.
+      *
+      * This routine searches lexical database and tries to guess
+      * pronunciation of specified word according to the acquired info.
+      * The resulting string is placed into the buffer pointed
+      * by value. This buffer must have enough space for it.
+      * When no useful info is found, the original word (key)
+      * is copied to the value buffer and RULEXDB_SPECIAL code
+      * is returned.
+      *
+      * Searching is performed in the following order:
+      * Specified word is searched in the exceptions dictionary.
+      * If found, the result is returned and procedure
+      * exits successfully. Otherwise the word is treated
+      * as an implicit form and program tries to guess its base
+      * and find it in the lexbases dictionary. If this process
+      * succeeds, the pronunciation string is constructed
+      * according to the acquired data and procedure exits successfully.
+      * At last, the word is matched against general rules.
+      * If no match succeeds, then program exits with RULEXDB_SPECIAL code,
+      * returning original word as a result.
+      *
+      * If this process appears to be not fully unsuccessful and some
+      * information was found in the database, then the resulting string
+      * is matched against correction rules and the first matched one
+      * is applied if any.
+      *
+      * When no information is found, the word is matched against
+      * prefix rules and the process is repeated for the word stem
+      * with the matched prefix stripped off.
+      *
+      * The last argument specifies which steps of the described
+      * process are to be performed. It consists of following flags
+      * which may be joined by "or" operation:
+      * RULEXDB_EXCEPTIONS - search the word in the exceptions dictionary.
+      * RULEXDB_FORMS - try to treat specified word as an implicit form.
+      * RULEXDB_RULES - try to apply general rules.
+      * Zero value (no flags) means that full search (all stages)
+      * should be performed.
+      */
+{
+  int rc = RULEXDB_SPECIAL;
+
+  if (rulexdb && (frozen_lookup(rulexdb, key, value, flags, &rc) ||
+		  (rulexdb->cache &&
+		   cache_get(rulexdb->cache, key, flags, value, &rc))))
+    return rc;
+  (void)strcpy(value, key);
+
+  /* The first stage: looking up in the exceptions dictionary */
+  if ((!flags) || (flags & RULEXDB_EXCEPTIONS))
+    {
+      rc = dictionary_check(rulexdb, RULEXDB_EXCEPTION);
+      if (rc < 0) return rc;
+      trace_stage(rulexdb, RULEXDB_STAGE_EXCEPTIONS);
+      if (!rc)
+	{
+	  rc = dictionary_get(rulexdb, RULEXDB_EXCEPTION, key, value);
+	  if (rc < 0) return rc;
+	}
     }
 
-#else /* LMDB */
+  /* The second stage: treating the word as an implicit form */
+  if ((rc == RULEXDB_SPECIAL) && ((!flags) || (flags & RULEXDB_FORMS)))
+    {
+      trace_stage(rulexdb, RULEXDB_STAGE_FORMS);
+      rc = lexbase_lookup(rulexdb, key, value);
+    }
 
-  /* Check file accessibility according to specified access mode */
-  switch (mode)
+  rc = search_complete(rulexdb, key, value, rc, flags);
+  if ((rc >= 0) && rulexdb->cache)
+    cache_put(rulexdb->cache, key, flags, value, rc);
+  return rc;
+}
+
+int rulexdb_search_ex(RULEXDB *rulexdb, const char *key, char *value,
+		      int size, int *status, int flags)
+     /*
+      * Search lexical database for specified word
+      * placing no more than size bytes of the result
+      * into the buffer pointed by value.
+      *
+      * The result is assembled in the handler scratch buffer
+      * unless the value buffer is large enough for any result.
+      *
+      * Returns the length of the result or negative error code.
+      */
+{
+  int rc, len;
+  char *t;
+
+  if ((!rulexdb) || (!key) || (size < 0) || (size && !value))
+    return RULEXDB_EPARM;
+  if (strlen(key) >= RULEXDB_BUFSIZE)
+    return RULEXDB_EINVKEY;
+  t = (size >= RULEXDB_BUFSIZE) ? value : rulexdb->scratch;
+  rc = rulexdb_search(rulexdb, key, t, flags);
+  if (rc < 0) return rc;
+  if (status) *status = rc;
+  len = strlen(t);
+  if ((t != value) && size)
     {
-      case RULEXDB_SEARCH:
-	if (access(path, F_OK | R_OK))
-	  {
-	    free(rulexdb);
-	    return NULL;
-	  }
-	break;
-      case RULEXDB_UPDATE:
-	if (access(path, F_OK | R_OK | W_OK))
-	  {
-	    free(rulexdb);
-	    return NULL;
-	  }
-	break;
-      case RULEXDB_CREATE:
-	if (!access(path, F_OK))
-	  if (access(path, R_OK | W_OK))
-	    {
-	      free(rulexdb);
-	      return NULL;
-	    }
-	break;
-      default:
-	free(rulexdb);
-	return NULL;
+      if (len < size)
+	(void)memcpy(value, t, len + 1);
+      else
+	{
+	  (void)memcpy(value, t, size - 1);
+	  value[size - 1] = 0;
+	}
     }
+  return len;
+}
 
-  if (mdb_env_create(&rulexdb->env))
+int rulexdb_search_traced(RULEXDB *rulexdb, const char *key,
+			  char *value, int flags, RULEXDB_TRACE *trace)
+     /*
+      * Search lexical database for specified word
+      * and record the search path.
+      */
+{
+  int rc;
+  struct RULEX_CACHE *cache;
+
+  if ((!rulexdb) || (!trace)) return RULEXDB_EPARM;
+  (void)memset(trace, 0, sizeof(RULEXDB_TRACE));
+  trace->stage = RULEXDB_STAGE_NONE;
+
+  /* Cached results have no path to trace */
+  cache = rulexdb->cache;
+  rulexdb->cache = NULL;
+  rulexdb->trace = trace;
+  rulexdb->trace_stage = RULEXDB_STAGE_NONE;
+  rc = rulexdb_search(rulexdb, key, value, flags);
+  trace_stage(rulexdb, RULEXDB_STAGE_NONE);
+  rulexdb->trace = NULL;
+  rulexdb->cache = cache;
+  if (rc)
+    trace->stage = RULEXDB_STAGE_NONE;
+  return rc;
+}
+
+#ifndef USE_BDB
+static int batch_reserve(BATCH *batch, int n, size_t size)
+     /*
+      * Make room in the batch for n more items
+      * with packed keys of size bytes in total.
+      */
+{
+  int k;
+  void *p;
+
+  if (batch->n + n > batch->size)
     {
-      free(rulexdb);
-      return NULL;
+      k = 2 * batch->size;
+      if (k < batch->n + n)
+	k = batch->n + n;
+      p = realloc(batch->item, k * sizeof(BATCH_ITEM));
+      if (!p) return RULEXDB_EMALLOC;
+      batch->item = p;
+      batch->size = k;
     }
-  if (mdb_env_set_mapsize(rulexdb->env, LMDB_MAP_SIZE) ||
-      mdb_env_set_maxdbs(rulexdb->env, LMDB_MAX_DBS))
+  if (batch->pool_len + size > batch->pool_size)
     {
-      mdb_env_close(rulexdb->env);
-      free(rulexdb);
-      return NULL;
+      p = realloc(batch->pool, 2 * batch->pool_size + size);
+      if (!p) return RULEXDB_EMALLOC;
+      batch->pool = p;
+      batch->pool_size = 2 * batch->pool_size + size;
     }
+  return RULEXDB_SUCCESS;
+}
 
-  {
-    unsigned int env_flags = MDB_NOSUBDIR | MDB_NOLOCK;
-    mdb_mode_t file_mode;
-    unsigned int txn_flags;
+static void batch_item(BATCH *batch, const char *s, int len,
+		       int word, int base)
+     /*
+      * Append the lookup item of the string s which packed key
+      * of len bytes (negative for invalid key) is placed
+      * at the end of the pool.
+      */
+{
+  BATCH_ITEM *item = &batch->item[batch->n++];
+
+  if (len < 0)
+    len = 0;
+  (void)memset(item, 0, sizeof(BATCH_ITEM));
+  item->offset = batch->pool_len;
+  item->keylen = len;
+  item->len = strlen(s);
+  item->word = word;
+  item->base = base;
+  batch->pool_len += len;
+}
 
-    if (mode == RULEXDB_SEARCH)
-      env_flags |= MDB_RDONLY;
-    file_mode = (mode == RULEXDB_CREATE) ? 0644 : 0;
-    if (mdb_env_open(rulexdb->env, path, env_flags, file_mode))
-      {
-	mdb_env_close(rulexdb->env);
-	free(rulexdb);
-	return NULL;
-      }
+static int batch_add(BATCH *batch, const char *s, int word, int base)
+     /*
+      * Add dictionary lookup of the string s to the batch.
+      * When the string cannot be packed, the item is added anyway,
+      * but marked as invalid and RULEXDB_EINVKEY is returned.
+      */
+{
+  int len, rc = batch_reserve(batch, 1, PACKED_KEY_SIZE(strlen(s)));
 
-    txn_flags = (mode == RULEXDB_SEARCH) ? MDB_RDONLY : 0;
-    if (mdb_txn_begin(rulexdb->env, NULL, txn_flags, &rulexdb->txn))
-      {
-	mdb_env_close(rulexdb->env);
-	free(rulexdb);
-	return NULL;
-      }
-  }
+  if (rc) return rc;
+  len = batch->coder->pack(s, batch->pool + batch->pool_len);
+  batch_item(batch, s, len, word, base);
+  return (len > 0) ? RULEXDB_SUCCESS : RULEXDB_EINVKEY;
+}
 
-  rulexdb->rules.db_name       = rules_db_name;
-  rulexdb->lexclasses.db_name  = lexclasses_db_name;
-  rulexdb->prefixes.db_name    = prefixes_db_name;
-  rulexdb->correctors.db_name  = corrections_db_name;
-  rulexdb->mode = mode;
+static int batch_by_key(const void *a, const void *b)
+     /*
+      * Compare the batch items by their packed keys
+      * in the dictionary order.
+      */
+{
+  const BATCH_ITEM *x = a, *y = b;
+  int rc = memcmp(x->key, y->key,
+		  (x->keylen < y->keylen) ? x->keylen : y->keylen);
 
-#endif /* USE_BDB */
+  if (!rc)
+    rc = x->keylen - y->keylen;
+  if (!rc)
+    rc = x->word - y->word;
+  if (!rc)
+    rc = x->base - y->base;
+  return rc;
+}
 
-  return rulexdb;
+static int batch_by_word(const void *a, const void *b)
+     /*
+      * Compare the batch items by their places in the batch.
+      */
+{
+  const BATCH_ITEM *x = a, *y = b;
+
+  if (x->word != y->word)
+    return x->word - y->word;
+  return x->base - y->base;
 }
 
-void rulexdb_close(RULEXDB *rulexdb)
+static void batch_sort(BATCH *batch)
      /*
-      * Close lexical database and free all resources
-      * allocated for its sake.
+      * Sort the batch items by their keys when all of them are added.
+      */
+{
+  int i;
+
+  for (i = 0; i < batch->n; i++)
+    batch->item[i].key = batch->pool + batch->item[i].offset;
+  qsort(batch->item, batch->n, sizeof(BATCH_ITEM), batch_by_key);
+}
+
+static int batch_lookup(RULEXDB *rulexdb, MDB_dbi dbi,
+			const RULEX_IMAGE *filter, BATCH *batch)
+     /*
+      * Look up all the batch items in the dictionary.
+      *
+      * The items must be sorted by their keys, so the dictionary
+      * is walked by a single cursor from the beginning to the end.
+      * Every distinct key is searched only once, and the search
+      * mostly stays within the current leaf page. The keys rejected
+      * by the membership filter (if any) are skipped.
+      */
+{
+  int i, rc = MDB_NOTFOUND;
+  MDB_cursor *cursor;
+  MDB_val key, data;
+  BATCH_ITEM *item;
+
+  if (mdb_cursor_open(rulexdb->txn, dbi, &cursor))
+    return RULEXDB_FAILURE;
+  for (i = 0; i < batch->n; i++)
+    {
+      item = &batch->item[i];
+      if ((!item->keylen) ||
+	  (filter && !filter_check(filter->image, item->key, item->keylen)))
+	continue;
+      if (i && (item->keylen == item[-1].keylen) &&
+	  !memcmp(item->key, item[-1].key, item->keylen))
+	{
+	  item->data = item[-1].data;
+	  item->size = item[-1].size;
+	  continue;
+	}
+      if (!rc) /* The cursor may already be at or beyond the key */
+	{
+	  BATCH_ITEM current;
+
+	  current.key = key.mv_data;
+	  current.keylen = (int)key.mv_size;
+	  current.word = item->word;
+	  current.base = item->base;
+	  rc = batch_by_key(&current, item);
+	  if (rc >= 0)
+	    {
+	      if (!rc)
+		{
+		  item->data = data.mv_data;
+		  item->size = data.mv_size;
+		}
+	      rc = 0;
+	      continue;
+	    }
+	}
+      key.mv_data = (void *)item->key;
+      key.mv_size = item->keylen;
+      rc = mdb_cursor_get(cursor, &key, &data, MDB_SET_RANGE);
+      if (rc == MDB_NOTFOUND) /* All the rest keys are absent */
+	break;
+      if (rc)
+	{
+	  mdb_cursor_close(cursor);
+	  return RULEXDB_FAILURE;
+	}
+      if ((key.mv_size == (size_t)item->keylen) &&
+	  !memcmp(key.mv_data, item->key, item->keylen))
+	{
+	  item->data = data.mv_data;
+	  item->size = data.mv_size;
+	}
+    }
+  mdb_cursor_close(cursor);
+  return RULEXDB_SUCCESS;
+}
+#endif
+
+int rulexdb_search_batch(RULEXDB *rulexdb, const char * const *keys,
+			 char **values, int *results, int n, int flags)
+     /*
+      * Search lexical database for several words at once.
+      *
+      * This routine does the same as rulexdb_search() called
+      * for every word keys[i] with the result placed in values[i]
+      * and the return code in results[i], but the dictionaries
+      * are looked up for all the words together. The keys
+      * are sorted and deduplicated, so each dictionary is walked
+      * by a single cursor pass. Repeated words are searched only once.
+      *
+      * Returns the number of processed words or negative error code.
+      * The errors concerning particular words are reported
+      * in the results array.
       */
 {
-  rules_release(&rulexdb->rules);
-  rules_release(&rulexdb->lexclasses);
-  rules_release(&rulexdb->prefixes);
-  rules_release(&rulexdb->correctors);
 #ifdef USE_BDB
-  if (rulexdb->lexicon_db)
-    db_close(rulexdb->lexicon_db);
-  if (rulexdb->exceptions_db)
-    db_close(rulexdb->exceptions_db);
-  (void)rulexdb->env->close(rulexdb->env, 0);
+  int i;
+
+  if ((!rulexdb) || (n < 0) || (n && !(keys && values && results)))
+    return RULEXDB_EPARM;
+  for (i = 0; i < n; i++)
+    results[i] = rulexdb_search(rulexdb, keys[i], values[i], flags);
+  return n;
 #else
-  if (rulexdb->lexicon_cursor)
-    mdb_cursor_close(rulexdb->lexicon_cursor);
-  if (rulexdb->exceptions_cursor)
-    mdb_cursor_close(rulexdb->exceptions_cursor);
-  if (rulexdb->txn)
+  int i, j, k, m, rc;
+  int *same, *len;
+  size_t size;
+  const char **words;
+  BATCH batch;
+  DictHandle h;
+  RULEXDB_BASE bases[LEXBASES_CHUNK];
+  BATCH_ITEM *item;
+
+  if ((!rulexdb) || (n < 0) || (n && !(keys && values && results)))
+    return RULEXDB_EPARM;
+  /* Every lookup is cheap there anyway */
+  if (rulexdb->lexfile.image ||
+      (dictionary_fst(rulexdb, RULEXDB_EXCEPTION) &&
+       dictionary_fst(rulexdb, RULEXDB_LEXBASE)))
     {
-      if (rulexdb->mode == RULEXDB_SEARCH)
-	mdb_txn_abort(rulexdb->txn);
-      else
-	mdb_txn_commit(rulexdb->txn);
+      for (i = 0; i < n; i++)
+	results[i] = rulexdb_search(rulexdb, keys[i], values[i], flags);
+      return n;
+    }
+  if (!n)
+    return 0;
+  same = malloc(n * sizeof(int));
+  len = malloc(n * sizeof(int));
+  words = malloc(n * sizeof(char *));
+  (void)memset(&batch, 0, sizeof(batch));
+  batch.size = BATCH_CHUNK;
+  batch.coder = rulexdb->keycoder;
+  batch.item = malloc(batch.size * sizeof(BATCH_ITEM));
+  batch.pool_size = BATCH_CHUNK * RULEXDB_MAX_KEY_SIZE;
+  batch.pool = malloc(batch.pool_size);
+  rc = (same && len && words && batch.item && batch.pool) ?
+    RULEXDB_SUCCESS : RULEXDB_EMALLOC;
+
+  /* Pack the words at once and find the repeated ones */
+  for (i = 0, m = 0, size = 0; (i < n) && !rc; i++)
+    {
+      if (frozen_lookup(rulexdb, keys[i], values[i], flags, &results[i]) ||
+	  (rulexdb->cache &&
+	   cache_get(rulexdb->cache, keys[i], flags, values[i], &results[i])))
+	{
+	  same[i] = -2; /* Already known */
+	  continue;
+	}
+      (void)strcpy(values[i], keys[i]);
+      results[i] = RULEXDB_SPECIAL;
+      same[i] = i;
+      words[m++] = keys[i];
+      size += PACKED_KEY_SIZE(strlen(keys[i]));
+    }
+  if (!rc)
+    rc = batch_reserve(&batch, m, size);
+  if (!rc)
+    {
+      (void)pack_keys(batch.coder, words, m, batch.pool, len);
+      for (i = 0, m = 0; i < n; i++)
+	if (same[i] == i)
+	  {
+	    if (len[m] > 0)
+	      batch_item(&batch, keys[i], len[m], i, 0);
+	    else same[i] = -1; /* Will be searched as usual */
+	    m++;
+	  }
+    }
+  if (!rc)
+    {
+      batch_sort(&batch);
+      for (i = 1; i < batch.n; i++)
+	if ((batch.item[i].keylen == batch.item[i - 1].keylen) &&
+	    !memcmp(batch.item[i].key, batch.item[i - 1].key,
+		    batch.item[i].keylen))
+	  same[batch.item[i].word] = same[batch.item[i - 1].word];
+    }
+
+  /* Looking up in the exceptions dictionary */
+  if ((!rc) && ((!flags) || (flags & RULEXDB_EXCEPTIONS)))
+    {
+      h = choose_dictionary(rulexdb, NULL, RULEXDB_EXCEPTION);
+      if (!h.dbi)
+	rc = RULEXDB_EPARM;
+      else if (*(h.dbi_open))
+	rc = batch_lookup(rulexdb, *(h.dbi),
+			  dictionary_filter(rulexdb, RULEXDB_EXCEPTION),
+			  &batch);
+      for (i = 0; (i < batch.n) && !rc; i++)
+	if (batch.item[i].data && (same[batch.item[i].word] == batch.item[i].word))
+	  {
+	    unpack_data(values[batch.item[i].word], batch.item[i].data,
+			(int)batch.item[i].size);
+	    results[batch.item[i].word] = RULEXDB_SUCCESS;
+	  }
+    }
+
+  /* Treating the rest words as implicit forms */
+  if ((!rc) && ((!flags) || (flags & RULEXDB_FORMS)))
+    {
+      h = choose_dictionary(rulexdb, NULL, RULEXDB_LEXBASE);
+      if (!h.dbi)
+	rc = RULEXDB_EPARM;
+      else if (*(h.dbi_open))
+	{
+	  /* Collect the first chunks of the lexical bases candidates */
+	  batch.n = 0;
+	  batch.pool_len = 0;
+	  for (i = 0; (i < n) && !rc; i++)
+	    if ((same[i] == i) && (results[i] == RULEXDB_SPECIAL))
+	      {
+		k = rulexdb_lexbases(rulexdb, keys[i], bases, LEXBASES_CHUNK, 1);
+		if (k < 0)
+		  results[i] = k;
+		for (j = 0; (j < k) && !rc; j++)
+		  {
+		    rc = batch_add(&batch, bases[j].base, i, j);
+		    if (rc == RULEXDB_EINVKEY)
+		      rc = RULEXDB_SUCCESS;
+		  }
+		if ((!rc) && (k == LEXBASES_CHUNK)) /* There may be more */
+		  {
+		    rc = batch_add(&batch, "", i, k);
+		    if (rc == RULEXDB_EINVKEY)
+		      rc = RULEXDB_SUCCESS;
+		  }
+	      }
+	  if (!rc)
+	    {
+	      batch_sort(&batch);
+	      rc = batch_lookup(rulexdb, *(h.dbi),
+				dictionary_filter(rulexdb, RULEXDB_LEXBASE),
+				&batch);
+	      qsort(batch.item, batch.n, sizeof(BATCH_ITEM), batch_by_word);
+	    }
+
+	  /* Take the first found base for every word */
+	  for (i = 0; (i < batch.n) && !rc; i = j)
+	    {
+	      m = batch.item[i].word;
+	      for (j = i; (j < batch.n) && (batch.item[j].word == m); j++)
+		{
+		  item = &batch.item[j];
+		  if (results[m] != RULEXDB_SPECIAL)
+		    continue;
+		  if (item->base == LEXBASES_CHUNK) /* Search the rest as usual */
+		    results[m] = lexbase_lookup(rulexdb, keys[m], values[m]);
+		  else if (!item->keylen)
+		    results[m] = RULEXDB_EINVKEY;
+		  else if (item->data)
+		    {
+		      k = strlen(keys[m]);
+		      if (k < item->len)
+			{
+			  (void)memset(values[m] + k, '_', item->len - k);
+			  values[m][item->len] = 0;
+			}
+		      else values[m][k] = 0;
+		      unpack_data(values[m], item->data, (int)item->size);
+		      results[m] = RULEXDB_SUCCESS;
+		    }
+		}
+	    }
+	}
     }
-  mdb_env_close(rulexdb->env);
+
+  for (i = 0; (i < n) && !rc; i++)
+    if (same[i] == i)
+      {
+	results[i] = search_complete(rulexdb, keys[i], values[i],
+				     results[i], flags);
+	if ((results[i] >= 0) && rulexdb->cache)
+	  cache_put(rulexdb->cache, keys[i], flags, values[i], results[i]);
+      }
+    else if (same[i] == -1)
+      results[i] = rulexdb_search(rulexdb, keys[i], values[i], flags);
+  for (i = 0; (i < n) && !rc; i++)
+    if ((same[i] >= 0) && (same[i] != i))
+      {
+	(void)strcpy(values[i], values[same[i]]);
+	results[i] = results[same[i]];
+      }
+  free(batch.pool);
+  free(batch.item);
+  free(words);
+  free(len);
+  free(same);
+  return rc ? rc : n;
 #endif
-  free(rulexdb);
-  return;
 }
 
-int rulexdb_subscribe_rule(RULEXDB *rulexdb, const char *src,
-			 int rule_type, unsigned int n)
+int rulexdb_seq(RULEXDB *rulexdb, char *key, char *value, int item_type, int mode)
      /*
-      * Store new rule into the database.
+      * Sequential retrieving dictionary items.
       *
-      * This routine adds new rule to the specified ruleset
-      * in the lexical database.
+      * This routine sequentially fetches lexical records one by one.
+      * its operations are not disturbed by the key-based search.
       *
-      * Arguments description:
-      * rulexdb - pointer to the opened lexical database handler structure;
-      * src - text representation of the rule;
-      * rule_type - specifies the ruleset
-      *             (RULEXDB_LEXCLASS, RULEXDB_RULE, RULEXDB_PREFIX or RULEXDB_CORRECTOR);
-      * n - rule number. If 0, this rule is appended at the end of ruleset,
-      *     otherwise the new rule will be inserted at the specified position.
+      * Arguments key and value must point to the buffers with enough space
+      * for retrieved data. Argument item_type specifies the dictionary.
+      * The dictionary must be specified explicitly: RULEXDB_EXCEPTION
+      * or RULEXDB_LEXBASE (RULEXDB_DEFAULT is not allowed in this case).
+      * When fetching data from the exception dictionary the correction
+      * will be applied. To prevent this feature you can specify
+      * RULEXDB_EXCEPTION_RAW instead of RULEXDB_EXCEPTION.
+      * The last argument specifies direction of the dictionary scanning.
+      * Allowed values are: RULEXDB_SEQ_FIRST, RULEXDB_SEQ_NEXT,
+      * RULEXDB_SEQ_PREV or RULEXDB_SEQ_LAST.
       *
-      * Returns 0 (RULEXDB_SUCCESS) when success or non-zero
-      * error code otherwise.
+      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL when
+      * no more records can be fetched, or an appropriate error code
+      * in the case of absolute failure.
       */
 {
-  RULEX_RULESET *rules = choose_ruleset(rulexdb, rule_type);
-
-  if (!rules) return RULEXDB_EPARM;
+  int rc;
 
 #ifdef USE_BDB
-  {
-    int rc;
-    DBT inKey, inVal;
-    db_recno_t recno;
+  DBT inKey, inVal;
+  DBC *dbc;
+  int seq_mode;
+  DB **db;
 
-    if (!rules->db) return RULEXDB_EACCESS;
-    if (n) /* Explicit rule number */
-      {
-	rc = db_nrecs(rules->db);
-	if (n > (unsigned int)rc) /* Ruleset must be continuous */
-	  return RULEXDB_EINVKEY;
-      }
-    (void)memset(&inKey, 0, sizeof(DBT));
-    (void)memset(&inVal, 0, sizeof(DBT));
-    if (n)
-      {
-	recno = n;
-	inKey.data = &recno;
-	inKey.size = sizeof(db_recno_t);
-      }
-    inVal.data = (char *)src;
-    inVal.size = strlen(src) + 1;
-    rc = rules->db->put(rules->db, NULL, &inKey, &inVal, n ? 0 : DB_APPEND);
-    if (rc)
-      return RULEXDB_FAILURE;
-    return RULEXDB_SUCCESS;
-  }
-#else
-  {
-    int rc;
-    unsigned int count;
-    uint32_t recno;
-    MDB_val key, data;
-    char buf[RULEXDB_BUFSIZE];
+  if (rulexdb && rulexdb->lexfile.image)
+    return lexfile_walk(rulexdb, key, value, item_type, mode);
+  db = choose_dictionary(rulexdb, NULL, item_type);
+  if (!db) return RULEXDB_EPARM;
+  if (!(*db)) return RULEXDB_FAILURE;
 
-    if (!rules->dbi_open) return RULEXDB_EACCESS;
-    count = lmdb_nrecs(rulexdb->txn, rules->dbi);
+  switch (mode)
+    {
+      case RULEXDB_SEQ_FIRST:
+        seq_mode = DB_FIRST;
+        break;
+      case RULEXDB_SEQ_NEXT:
+        seq_mode = DB_NEXT;
+        break;
+      case RULEXDB_SEQ_PREV:
+        seq_mode = DB_PREV;
+        break;
+      case RULEXDB_SEQ_LAST:
+        seq_mode = DB_LAST;
+        break;
+      default:
+        return RULEXDB_EPARM;
+    }
 
-    if (n == 0)
-      {
-	recno = count + 1;
-	key.mv_data = &recno; key.mv_size = sizeof(uint32_t);
-	data.mv_data = (char *)src; data.mv_size = strlen(src) + 1;
-	rc = mdb_put(rulexdb->txn, rules->dbi, &key, &data, 0);
-	return rc ? RULEXDB_FAILURE : RULEXDB_SUCCESS;
-      }
+  dbc = (*db)->app_private;
+  /* Initialize cursor if it is not done already */
+  if (!dbc)
+    {
+      rc = (*db)->cursor(*db, NULL, &dbc, 0);
+      if (rc)
+	{
+	  dbc = NULL;
+	  return RULEXDB_FAILURE;
+	}
+      else (*db)->app_private = dbc;
+    }
+  (void)memset(&inKey, 0, sizeof(DBT));
+  (void)memset(&inVal, 0, sizeof(DBT));
+  rc = dbc->c_get(dbc, &inKey, &inVal, seq_mode);
+  switch (rc)
+    {
+      case 0:
+	if (rulexdb->keycoder->unpack(inKey.data, inKey.size,
+				      key, RULEXDB_MAX_KEY_SIZE))
+	  return RULEXDB_FAILURE;
+	(void)strcpy(value, key);
+	unpack_data(value, inVal.data, inVal.size);
+	if (item_type == RULEXDB_EXCEPTION)
+	  return postcorrect(rulexdb, value);
+	return RULEXDB_SUCCESS;
+      case DB_NOTFOUND:
+	return RULEXDB_SPECIAL;
+      default:
+	break;
+    }
+#else
+  MDB_val inKey, inVal;
+  MDB_cursor_op seq_mode;
+  DictHandle h;
 
-    if (n > count) return RULEXDB_EINVKEY;
+  if (rulexdb && rulexdb->lexfile.image)
+    return lexfile_walk(rulexdb, key, value, item_type, mode);
+  h = choose_dictionary(rulexdb, NULL, item_type);
+  if (!h.dbi) return RULEXDB_EPARM;
+  if (!*(h.dbi_open)) return RULEXDB_FAILURE;
 
-    /* Shift records n..count → n+1..count+1 (backward to avoid overwrite) */
+  switch (mode)
     {
-      uint32_t i;
-      for (i = count; i >= n; i--)
-        {
-          uint32_t sk = i, dk = i + 1;
-          MDB_val sv = {sizeof(uint32_t), &sk};
-          size_t len;
-          rc = mdb_get(rulexdb->txn, rules->dbi, &sv, &data);
-          if (rc) return RULEXDB_FAILURE;
-          len = data.mv_size < sizeof(buf) ? data.mv_size : sizeof(buf) - 1;
-          memcpy(buf, data.mv_data, len); buf[len] = '\0';
-          {
-            MDB_val dv = {sizeof(uint32_t), &dk};
-            MDB_val dd = {strlen(buf) + 1, buf};
-            rc = mdb_put(rulexdb->txn, rules->dbi, &dv, &dd, 0);
-            if (rc) return RULEXDB_FAILURE;
-          }
-          if (i == 0) break;
-        }
+      case RULEXDB_SEQ_FIRST:
+        seq_mode = MDB_FIRST;
+        break;
+      case RULEXDB_SEQ_NEXT:
+        seq_mode = MDB_NEXT;
+        break;
+      case RULEXDB_SEQ_PREV:
+        seq_mode = MDB_PREV;
+        break;
+      case RULEXDB_SEQ_LAST:
+        seq_mode = MDB_LAST;
+        break;
+      default:
+        return RULEXDB_EPARM;
+    }
+
+  if (!*(h.cursor))
+    {
+      rc = mdb_cursor_open(rulexdb->txn, *(h.dbi), h.cursor);
+      if (rc)
+	{
+	  *(h.cursor) = NULL;
+	  return RULEXDB_FAILURE;
+	}
+    }
+  rc = mdb_cursor_get(*(h.cursor), &inKey, &inVal, seq_mode);
+  switch (rc)
+    {
+      case 0:
+	if (rulexdb->keycoder->unpack(inKey.mv_data,
+				      (unsigned int)inKey.mv_size,
+				      key, RULEXDB_MAX_KEY_SIZE))
+	  return RULEXDB_FAILURE;
+	(void)strcpy(value, key);
+	unpack_data(value, inVal.mv_data, (int)inVal.mv_size);
+	if (item_type == RULEXDB_EXCEPTION)
+	  return postcorrect(rulexdb, value);
+	return RULEXDB_SUCCESS;
+      case MDB_NOTFOUND:
+	return RULEXDB_SPECIAL;
+      default:
+	break;
     }
-    recno = n;
-    key.mv_data = &recno; key.mv_size = sizeof(uint32_t);
-    data.mv_data = (char *)src; data.mv_size = strlen(src) + 1;
-    rc = mdb_put(rulexdb->txn, rules->dbi, &key, &data, 0);
-    return rc ? RULEXDB_FAILURE : RULEXDB_SUCCESS;
-  }
 #endif
+  return RULEXDB_FAILURE;
 }
 
-char * rulexdb_fetch_rule(RULEXDB *rulexdb, int rule_type, int n)
+int rulexdb_remove_item(RULEXDB *rulexdb, const char *key, int item_type)
      /*
-      * Extract specified rule from lexical database.
+      * Remove specified record from the dictionary.
       *
-      * This routine retrieves rule in its text representation
-      * and return pointer to it or NULL when failure. This pointer
-      * remains valid only until next database operation.
+      This routine removes lexical item for specified key.
+      * Item type must be specified explicitly:
+      * only RULEXDB_LEXBASE or RULEXDB_EXCEPTION are allowed.
       *
-      * Arguments description:
-      * rulexdb - points to the opened lexical database handler structure;
-      * rule_type - specifies the ruleset
-      *             (RULEXDB_LEXCLASS, RULEXDB_RULE, RULEXDB_PREFIX or RULEXDB_CORRECTOR);
-      * n - rule number in the ruleset.
+      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL
+      * when no record exists for specified key, or an appropriate
+      * error code when other failure.
       */
 {
-  RULEX_RULESET *rules = choose_ruleset(rulexdb, rule_type);
+  int rc;
+  char packed_key[RULEXDB_BUFSIZE];
 
-  if (!rules) return NULL;
 #ifdef USE_BDB
-  if (!rules->db) return NULL;
-  return rule_get(rules->db, n);
+  DBT inKey;
+  DB **db = choose_dictionary(rulexdb, key, item_type);
+
+  if (!db) return RULEXDB_EPARM;
+  results_invalidate(rulexdb);
+  dictionary_changed(rulexdb, db == &rulexdb->lexicon_db);
+  if (!(*db)) return RULEXDB_EACCESS;
+  (void)memset(&inKey, 0, sizeof(DBT));
+  inKey.size = rulexdb->keycoder->pack(key, packed_key);
+  if ((signed int)(inKey.size) <= 0)
+    return RULEXDB_EINVKEY;
+  inKey.data = packed_key;
+  rc = (*db)->del(*db, NULL, &inKey, 0);
+  if (rc)
+    {
+      if (rc == DB_NOTFOUND)
+	return RULEXDB_SPECIAL;
+      return RULEXDB_FAILURE;
+    }
 #else
-  if (!rules->dbi_open) return NULL;
-  return lmdb_rule_get(rulexdb->txn, rules->dbi, rules->rule_buf, n);
+  MDB_val inKey;
+  DictHandle h = choose_dictionary(rulexdb, key, item_type);
+
+  if (!h.dbi) return RULEXDB_EPARM;
+  results_invalidate(rulexdb);
+  dictionary_changed(rulexdb, h.dbi == &rulexdb->lexicon_dbi);
+  if (!*(h.dbi_open)) return RULEXDB_EACCESS;
+  inKey.mv_size = (size_t)rulexdb->keycoder->pack(key, packed_key);
+  if ((signed int)inKey.mv_size <= 0)
+    return RULEXDB_EINVKEY;
+  inKey.mv_data = packed_key;
+  rc = mdb_del(rulexdb->txn, *(h.dbi), &inKey, NULL);
+  if (rc)
+    {
+      if (rc == MDB_NOTFOUND)
+	return RULEXDB_SPECIAL;
+      return RULEXDB_FAILURE;
+    }
 #endif
+  return RULEXDB_SUCCESS;
 }
 
-int rulexdb_remove_rule(RULEXDB *rulexdb, int rule_type, int n)
+int rulexdb_remove_this_item(RULEXDB *rulexdb, int item_type)
      /*
-      * Remove specified rule from the database.
+      * Remove sequentially retrieved item.
       *
-      * Arguments description:
-      * rulexdb - points to the opened lexical database handler structure;
-      * rule_type - specifies the ruleset
-      *             (RULEXDB_LEXCLASS, RULEXDB_RULE, RULEXDB_PREFIX or RULEXDB_CORRECTOR);
-      * n - rule number in the ruleset.
+      * This routine removes from the dictionary the item retrieved
+      * by the rulexdb_seq() routine, that is the item
+      * pointed by cursor.
       *
-      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL when
-      * there is no rule with such number, or an appropriate
-      * error code when failure.
+      * The item type must be specified explicitly:
+      * only RULEXDB_LEXBASE or RULEXDB_EXCEPTION are allowed.
+      *
+      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL
+      * when pointed record is already deleted, or an appropriate
+      * error code when other failure. If specified dictionary
+      * never was accessed sequentially, so it has no initialized
+      * cursor, the code RULEXDB_EACCESS is returned.
       */
 {
-  RULEX_RULESET *rules = choose_ruleset(rulexdb, rule_type);
-
-  if (!rules) return RULEXDB_EPARM;
+  int rc;
 
 #ifdef USE_BDB
-  {
-    int rc;
-    DBT inKey;
-    db_recno_t recno = n;
-
-    if (!rules->db) return RULEXDB_EACCESS;
-    (void)memset(&inKey, 0, sizeof(DBT));
-    inKey.data = &recno;
-    inKey.size = sizeof(db_recno_t);
-    rc = rules->db->del(rules->db, NULL, &inKey, 0);
-    if (rc)
-      {
-	if (rc == DB_NOTFOUND)
-	  return RULEXDB_SPECIAL;
-	return RULEXDB_FAILURE;
-      }
-    return RULEXDB_SUCCESS;
-  }
-#else
-  {
-    int rc;
-    unsigned int count;
-    char buf[RULEXDB_BUFSIZE];
-    MDB_val data;
-
-    if (!rules->dbi_open) return RULEXDB_EACCESS;
-    count = lmdb_nrecs(rulexdb->txn, rules->dbi);
-    if (n < 1 || (unsigned int)n > count) return RULEXDB_SPECIAL;
+  DBC *dbc;
+  DB **db = choose_dictionary(rulexdb, NULL, item_type);
 
-    /* Shift n+1..count → n..count-1 */
+  if (!db) return RULEXDB_EPARM;
+  results_invalidate(rulexdb);
+  dictionary_changed(rulexdb, db == &rulexdb->lexicon_db);
+  if (!(*db)) return RULEXDB_EACCESS;
+  dbc = (*db)->app_private;
+  if(!dbc) return RULEXDB_EACCESS;
+  rc = dbc->c_del(dbc, 0);
+  if (rc)
     {
-      uint32_t i;
-      for (i = (uint32_t)n + 1; i <= count; i++)
-        {
-          uint32_t sk = i, dk = i - 1;
-          MDB_val sv = {sizeof(uint32_t), &sk};
-          size_t len;
-          rc = mdb_get(rulexdb->txn, rules->dbi, &sv, &data);
-          if (rc) return RULEXDB_FAILURE;
-          len = data.mv_size < sizeof(buf) ? data.mv_size : sizeof(buf) - 1;
-          memcpy(buf, data.mv_data, len); buf[len] = '\0';
-          {
-            MDB_val dv = {sizeof(uint32_t), &dk};
-            MDB_val dd = {strlen(buf) + 1, buf};
-            rc = mdb_put(rulexdb->txn, rules->dbi, &dv, &dd, 0);
-            if (rc) return RULEXDB_FAILURE;
-          }
-        }
+      if (rc == DB_NOTFOUND)
+	return RULEXDB_SPECIAL;
+      return RULEXDB_FAILURE;
     }
+#else
+  DictHandle h = choose_dictionary(rulexdb, NULL, item_type);
+
+  if (!h.dbi) return RULEXDB_EPARM;
+  results_invalidate(rulexdb);
+  dictionary_changed(rulexdb, h.dbi == &rulexdb->lexicon_dbi);
+  if (!*(h.dbi_open)) return RULEXDB_EACCESS;
+  if (!*(h.cursor)) return RULEXDB_EACCESS;
+  rc = mdb_cursor_del(*(h.cursor), 0);
+  if (rc)
     {
-      uint32_t last = count;
-      MDB_val lk = {sizeof(uint32_t), &last};
-      rc = mdb_del(rulexdb->txn, rules->dbi, &lk, NULL);
-      if (rc == MDB_NOTFOUND) return RULEXDB_SPECIAL;
-      if (rc) return RULEXDB_FAILURE;
+      if (rc == MDB_NOTFOUND)
+	return RULEXDB_SPECIAL;
+      return RULEXDB_FAILURE;
     }
-    return RULEXDB_SUCCESS;
-  }
 #endif
+  return RULEXDB_SUCCESS;
 }
 
-int rulexdb_subscribe_item(RULEXDB *rulexdb, const char *key, const char * value,
-			 int item_type, int overwrite)
+int rulexdb_classify(RULEXDB *rulexdb, const char *s)
      /*
-      * Put new item into the lexical database.
-      *
-      * Arguments description:
-      * rulexdb - points to the opened lexical database handler structure;
-      * key - the original word;
-      * value - its pronunciation;
-      * item_type - target dictionary specification
-      *             (RULEXDB_LEXBASE, RULEXDB_EXCEPTION or RULEXDB_DEFAULT);
-      * overwrite - if true (non-zero) the new item will replace
-      *             already existing one with the same key if any.
-      *             Otherwise the new item will not be stored.
-      *
-      * If item type is specified as RULEXDB_DEFAULT, then target dictionary
-      * will be guessed according to specified key: if it represents
-      * any lexical base, then lexbases dictionary will be chosen,
-      * otherwise the exceptions dictionary will be used.
+      * Test specified word whether it represents a lexical base.
       *
-      * If item type is specified as RULEXDB_DEFAULT and key word is
-      * recognized as a lexical base, but the record for this key
-      * already exist in the Lexbases dictionary, then Exceptions
-      * dictionary will be tried instead.
+      * Returns 0 (RULEXDB_SUCCESS) when the word does not represent
+      * a lexical base, RULEXDB_SPECIAL if it does, or an appropriate
+      * error code when failure.
+      */
+{
+  int i, k, n;
+  RULEXDB_BASE bases[LEXBASES_CHUNK];
+
+  for (n = 1; ; n = bases[k - 1].rule + 1)
+    {
+      k = rulexdb_lexbases(rulexdb, s, bases, LEXBASES_CHUNK, n);
+      if (k < 0) return k;
+      for (i = 0; i < k; i++)
+	if (!strcmp(s, bases[i].base))
+	  return RULEXDB_SPECIAL;
+      if (k < LEXBASES_CHUNK) break;
+    }
+  return RULEXDB_SUCCESS;
+}
+
+int rulexdb_discard_dictionary(RULEXDB *rulexdb, int item_type)
+     /*
+      * Discard the dictionary.
       *
-      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL when
-      * specified key already exists in the dictionary,
-      * or an appropriate error code when failure.
+      * This routine deletes all data from specified dictionary.
+      * Returns number of deleted records or negative error code.
+      * Item type specifies a dictionary
+      * (RULEXDB_EXCEPTION or RULEXDB_LEXBASE).
+      * RULEXDB_DEFAULT is not allowed here.
       */
 {
   int rc;
-  char packed_key[RULEXDB_BUFSIZE], packed_data[RULEXDB_BUFSIZE];
 
 #ifdef USE_BDB
-  DBT inKey, inVal;
-  DB **db = choose_dictionary(rulexdb, key, item_type);
+  u_int32_t n;
+  DB **db = choose_dictionary(rulexdb, NULL, item_type);
+  DBC *dbc;
 
   if (!db) return RULEXDB_EPARM;
+  results_invalidate(rulexdb);
+  dictionary_changed(rulexdb, db == &rulexdb->lexicon_db);
   if (!(*db)) return RULEXDB_EACCESS;
-  (void)memset(&inKey, 0, sizeof(DBT));
-  (void)memset(&inVal, 0, sizeof(DBT));
-  inKey.size = pack_key(key, packed_key);
-  if ((signed int)(inKey.size) <= 0)
-    return RULEXDB_EINVKEY;
-  inVal.size = pack_data(key, value, packed_data);
-  if ((signed int)(inVal.size) < 0)
-    return RULEXDB_EINVREC;
-  if (!inVal.size)
-    packed_data[inVal.size++] = 0;
-  inKey.data = packed_key;
-  inVal.data = packed_data;
-  rc = (*db)->put(*db, NULL, &inKey, &inVal, DB_NOOVERWRITE);
-  if ((item_type == RULEXDB_DEFAULT) && (rc == DB_KEYEXIST)
-      && (db == &rulexdb->lexicon_db))
-    {
-      db = choose_dictionary(rulexdb, NULL, RULEXDB_EXCEPTION);
-      if (!db) return RULEXDB_EPARM;
-      if (!(*db)) return RULEXDB_EACCESS;
-      rc = (*db)->put(*db, NULL, &inKey, &inVal, DB_NOOVERWRITE);
-    }
-  switch (rc)
+  dbc = (*db)->app_private;
+  if (dbc) /* Close cursor at first if it was opened */
     {
-      case 0:
-	return RULEXDB_SUCCESS;
-      case DB_KEYEXIST:
-	if (overwrite)
-	  {
-	    rc = (*db)->put(*db, NULL, &inKey, &inVal, 0);
-	    if (rc) break;
-	    else return RULEXDB_SPECIAL;
-	  }
-	else return RULEXDB_SPECIAL;
-      default:
-	break;
+      (void)dbc->c_close(dbc);
+      (*db)->app_private = NULL;
     }
+  rc = (*db)->truncate(*db, NULL, &n, 0);
+  if (rc)
+    return RULEXDB_FAILURE;
+  return n;
 #else
-  MDB_val inKey, inVal;
-  DictHandle h = choose_dictionary(rulexdb, key, item_type);
+  unsigned int n;
+  MDB_stat st;
+  DictHandle h = choose_dictionary(rulexdb, NULL, item_type);
 
   if (!h.dbi) return RULEXDB_EPARM;
+  results_invalidate(rulexdb);
+  dictionary_changed(rulexdb, h.dbi == &rulexdb->lexicon_dbi);
   if (!*(h.dbi_open)) return RULEXDB_EACCESS;
-  inKey.mv_size = (size_t)pack_key(key, packed_key);
-  if ((signed int)inKey.mv_size <= 0)
-    return RULEXDB_EINVKEY;
-  inVal.mv_size = (size_t)pack_data(key, value, packed_data);
-  if ((signed int)inVal.mv_size < 0)
-    return RULEXDB_EINVREC;
-  if (!inVal.mv_size)
-    packed_data[inVal.mv_size++] = 0;
-  inKey.mv_data = packed_key;
-  inVal.mv_data = packed_data;
-  rc = mdb_put(rulexdb->txn, *(h.dbi), &inKey, &inVal, MDB_NOOVERWRITE);
-  if ((item_type == RULEXDB_DEFAULT) && (rc == MDB_KEYEXIST)
-      && (h.dbi == &rulexdb->lexicon_dbi))
-    {
-      h = choose_dictionary(rulexdb, NULL, RULEXDB_EXCEPTION);
-      if (!h.dbi) return RULEXDB_EPARM;
-      if (!*(h.dbi_open)) return RULEXDB_EACCESS;
-      rc = mdb_put(rulexdb->txn, *(h.dbi), &inKey, &inVal, MDB_NOOVERWRITE);
-    }
-  switch (rc)
+  if (*(h.cursor))
     {
-      case 0:
-	return RULEXDB_SUCCESS;
-      case MDB_KEYEXIST:
-	if (overwrite)
-	  {
-	    rc = mdb_put(rulexdb->txn, *(h.dbi), &inKey, &inVal, 0);
-	    if (rc) break;
-	    else return RULEXDB_SPECIAL;
-	  }
-	else return RULEXDB_SPECIAL;
-      default:
-	break;
+      mdb_cursor_close(*(h.cursor));
+      *(h.cursor) = NULL;
     }
+  rc = mdb_stat(rulexdb->txn, *(h.dbi), &st);
+  n = rc ? 0 : (unsigned int)st.ms_entries;
+  rc = mdb_drop(rulexdb->txn, *(h.dbi), 0);
+  if (rc)
+    return RULEXDB_FAILURE;
+  return (int)n;
 #endif
-
-  return RULEXDB_FAILURE;
 }
 
-int rulexdb_retrieve_item(RULEXDB *rulexdb, const char *key, char *value, int item_type)
+int rulexdb_load_ruleset(RULEXDB *rulexdb, int rule_type)
      /*
-      * Retrieve an item from the lexical database.
+      * Load ruleset data.
       *
-      * Arguments description:
-      * rulexdb - points to the opened lexical database handler structure;
-      * key - the word to retrieve item for;
-      * value - memory area for its pronunciation string;
-      * item_type - target dictionary specification
-      *             (RULEXDB_LEXBASE, RULEXDB_EXCEPTION or RULEXDB_DEFAULT);
+      * This routine initializes specified ruleset
+      * and preloads all its data.
+      * Returns number of loaded records or negative error code.
+      * Rule type specifies target ruleset
+      * (RULEXDB_RULE, RULEXDB_LEXCLASS, RULEXDB_PREFIX or RULEXDB_CORRECTOR).
       *
-      * If item type is specified as RULEXDB_DEFAULT, then target dictionary
-      * will be guessed according to specified key: if it represents
-      * any lexical base, then lexbases dictionary will be chosen,
-      * otherwise the exceptions dictionary will be used.
+      * Loaded ruleset cannot be modified.
       *
-      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL when
-      * specified key does not exist in the dictionary,
-      * or an appropriate error code when failure.
+      * The rules are fetched by a single pass over the dataset
+      * and compiled by several threads in parallel when possible.
       */
 {
-#ifdef USE_BDB
-  DB **db = choose_dictionary(rulexdb, key, item_type);
-
-  if (!db) return RULEXDB_EPARM;
-  if (!(*db)) return RULEXDB_FAILURE;
-
-  (void)strcpy(value, key);
-  return db_get(*db, key, value);
-#else
-  DictHandle h = choose_dictionary(rulexdb, key, item_type);
-
-  if (!h.dbi) return RULEXDB_EPARM;
-  if (!*(h.dbi_open)) return RULEXDB_FAILURE;
+  int rc;
+  RULEX_RULESET *rules = get_ruleset_handler(rulexdb, rule_type);
 
-  (void)strcpy(value, key);
-  return lmdb_get(rulexdb->txn, *(h.dbi), key, value);
-#endif
+  if (!rules) return RULEXDB_EPARM;
+  if (rulexdb->shared) return RULEXDB_EACCESS;
+  rc = rules_preload(rulexdb, rules, rule_type);
+  return rc ? rc : rules->nrules;
 }
 
-int rulexdb_lexbase(RULEXDB *rulexdb, const char *s, char *t, int n)
+long rulexdb_load_time(RULEXDB *rulexdb, int rule_type)
      /*
-      * Try to find lexical base for the specified word.
+      * Get time spent for loading the ruleset.
       *
-      * This routine scans lexclasses ruleset beginning from n
-      * trying to match the word pointed by s. When match succeeds,
-      * the lexical base is constructed in memory area pointed by t,
-      * which must have enough space for it, and the number of matched rule
-      * is returned. If no match has occurred 0 is returned.
-      * In the case of error an appropriate error code is returned.
+      * Returns time in microseconds spent by rulexdb_load_ruleset()
+      * or by rulexdb_open() with RULEXDB_PRELOAD option
+      * for specified ruleset, 0 if the ruleset was not loaded
+      * this way or negative error code.
       */
 {
-  int i, rc;
-  regmatch_t match[2];
-
-  if ((n < 1) || (!rulexdb) || (!s) || (!t)) return RULEXDB_EPARM;
-  rc = rules_init(rulexdb, &rulexdb->lexclasses);
-  if (rc) return rc;
+  RULEX_RULESET *rules = get_ruleset_handler(rulexdb, rule_type);
 
-  for (i = n - 1; i < rulexdb->lexclasses.nrules; i++)
-    if ((rc = rule_load(rulexdb, &rulexdb->lexclasses, i)))
-      break;
-    else if (!regexec(rulexdb->lexclasses.pattern[i], s, 2, match, 0))
-      {
-	(void)strncpy(t, s, match[1].rm_eo);
-	t[match[1].rm_eo] = 0;
-	if (rulexdb->lexclasses.replacement[i])
-	  (void)strcat(t, rulexdb->lexclasses.replacement[i]);
-	rc = i + 1;
-	break;
-      }
-  return rc;
+  if (!rules) return RULEXDB_EPARM;
+  return rules->load_time;
 }
 
-int rulexdb_search(RULEXDB *rulexdb, const char * key, char *value, int flags)
+int rulexdb_ruleset_stats(RULEXDB *rulexdb, int rule_type,
+			  RULEXDB_RULE_STATS *stats, int size)
      /*
-      * Search lexical database for specified word.
-      *
-      * This routine searches lexical database and tries to guess
-      * pronunciation of specified word according to the acquired info.
-      * The resulting string is placed into the buffer pointed
-      * by value. This buffer must have enough space for it.
-      * When no useful info is found, the original word (key)
-      * is copied to the value buffer and RULEXDB_SPECIAL code
-      * is returned.
+      * Get rules matching statistics.
       *
-      * Searching is performed in the following order:
-      * Specified word is searched in the exceptions dictionary.
-      * If found, the result is returned and procedure
-      * exits successfully. Otherwise the word is treated
-      * as an implicit form and program tries to guess its base
-      * and find it in the lexbases dictionary. If this process
-      * succeeds, the pronunciation string is constructed
-      * according to the acquired data and procedure exits successfully.
-      * At last, the word is matched against general rules.
-      * If no match succeeds, then program exits with RULEXDB_SPECIAL code,
-      * returning original word as a result.
+      * This routine copies statistics collected for the rules
+      * of specified ruleset into the array pointed by stats,
+      * which must have space for size elements. The element i
+      * corresponds to the rule number i + 1. The statistics
+      * are collected only when the database is opened
+      * with RULEXDB_STATS option.
+      * Rule type specifies target ruleset
+      * (RULEXDB_RULE, RULEXDB_LEXCLASS, RULEXDB_PREFIX or RULEXDB_CORRECTOR).
       *
-      * If this process appears to be not fully unsuccessful and some
-      * information was found in the database, then the resulting string
-      * is matched against correction rules and the first matched one
-      * is applied if any.
+      * Returns number of rules in the ruleset or negative error code.
+      */
+{
+  int rc;
+  RULEX_RULESET *rules = get_ruleset_handler(rulexdb, rule_type);
+
+  if ((!rules) || (size < 0) || (size && !stats))
+    return RULEXDB_EPARM;
+  if (!(rulexdb->options & RULEXDB_STATS))
+    return RULEXDB_EACCESS;
+  rc = rules_init(rulexdb, rules);
+  if (rc) return rc;
+  if (size > rules->nrules)
+    size = rules->nrules;
+  if (size)
+    (void)memcpy(stats, rules->stats, size * sizeof(RULEXDB_RULE_STATS));
+  return rules->nrules;
+}
+
+int rulexdb_cache(RULEXDB *rulexdb, int size)
+     /*
+      * Enable search results cache.
       *
-      * When no information is found, the word is matched against
-      * prefix rules and the process is repeated for the word stem
-      * with the matched prefix stripped off.
+      * This routine allocates the cache for up to size results
+      * of rulexdb_search() keyed by the word and search flags.
+      * Previously enabled cache is dropped. Zero size disables
+      * the cache.
       *
-      * The last argument specifies which steps of the described
-      * process are to be performed. It consists of following flags
-      * which may be joined by "or" operation:
-      * RULEXDB_EXCEPTIONS - search the word in the exceptions dictionary.
-      * RULEXDB_FORMS - try to treat specified word as an implicit form.
-      * RULEXDB_RULES - try to apply general rules.
-      * Zero value (no flags) means that full search (all stages)
-      * should be performed.
+      * Returns 0 (RULEXDB_SUCCESS) on success or negative error code.
+      */
+{
+  if ((!rulexdb) || (size < 0))
+    return RULEXDB_EPARM;
+  cache_free(rulexdb->cache);
+  rulexdb->cache = NULL;
+  if (size)
+    {
+      rulexdb->cache = cache_create(size);
+      if (!rulexdb->cache)
+	return RULEXDB_EMALLOC;
+    }
+  return RULEXDB_SUCCESS;
+}
+
+int rulexdb_cache_stats(RULEXDB *rulexdb, RULEXDB_CACHE_STATS *stats)
+     /*
+      * Get search results cache statistics.
       *
-      * RULEXDB_NOPREFIX - internal flag used in the recursive call
-      * for the words with prefix stripped.
+      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL
+      * when the cache is not enabled, or negative error code.
       */
 {
-  int i, j, rc = RULEXDB_SPECIAL;
-  char *s;
+  const CACHE_STATS *counters;
 
-  (void)strcpy(value, key);
+  if ((!rulexdb) || (!stats))
+    return RULEXDB_EPARM;
+  if (!rulexdb->cache)
+    return RULEXDB_SPECIAL;
+  counters = cache_stats(rulexdb->cache);
+  stats->hits = counters->hits;
+  stats->misses = counters->misses;
+  stats->evictions = counters->evictions;
+  stats->invalidations = counters->invalidations;
+  stats->entries = counters->entries;
+  stats->size = counters->size;
+  return RULEXDB_SUCCESS;
+}
 
-  /* The first stage: looking up in the exceptions dictionary */
-  if ((!flags) || (flags & RULEXDB_EXCEPTIONS))
-    {
+int rulexdb_compile_ruleset(RULEXDB *rulexdb, int rule_type)
+     /*
+      * Store precompiled form of the ruleset in the database.
+      *
+      * This routine compiles all the rules of specified ruleset
+      * that can be handled by the bit-parallel matcher and stores
+      * the result in the database, so the ruleset can be loaded
+      * without compiling later. The rules that cannot be precompiled
+      * are compiled when loading as usual. Stale precompiled rules
+      * are detected and ignored, so this routine should be called
+      * after modifying the ruleset only to keep loading fast.
+      * Rule type specifies target ruleset
+      * (RULEXDB_RULE, RULEXDB_LEXCLASS, RULEXDB_PREFIX or RULEXDB_CORRECTOR).
+      *
+      * Returns number of precompiled rules or negative error code.
+      */
+{
+  int i, nrules, rc = 0;
+  char *rule_src;
+  char *image, *p;
+  size_t size, offset;
+  PATTERN *pattern;
+  RULEX_BITMATCH *matcher;
+  RULES_IMAGE_HEADER *header;
+  RULES_IMAGE_ENTRY *entry;
+  RULEX_RULESET *rules;
+
+  if (!rulexdb) return RULEXDB_EPARM;
+  if (rulexdb->mode == RULEXDB_SEARCH) return RULEXDB_EACCESS;
+  rules = choose_ruleset(rulexdb, rule_type);
+  if (!rules) return RULEXDB_EPARM;
 #ifdef USE_BDB
-      DB **db = choose_dictionary(rulexdb, NULL, RULEXDB_EXCEPTION);
-      if (!db) return RULEXDB_EPARM;
-      if (*db)
-	{
-	  rc = db_get(*db, key, value);
-	  if (rc < 0) return rc;
-	}
+  if (!rules->db) return RULEXDB_EACCESS;
+  nrules = db_nrecs(rules->db);
 #else
-      DictHandle h = choose_dictionary(rulexdb, NULL, RULEXDB_EXCEPTION);
-      if (!h.dbi) return RULEXDB_EPARM;
-      if (*(h.dbi_open))
-	{
-	  rc = lmdb_get(rulexdb->txn, *(h.dbi), key, value);
-	  if (rc < 0) return rc;
-	}
+  if (!rules->dbi_open) return RULEXDB_EACCESS;
+  nrules = (int)lmdb_rules_count(rulexdb, rules);
 #endif
-    }
-
-  /* The second stage: treating the word as an implicit form */
-  if ((rc == RULEXDB_SPECIAL) && ((!flags) || (flags & RULEXDB_FORMS)))
+  if (nrules < 0) return RULEXDB_FAILURE;
+
+  /* Build the image */
+  size = sizeof(RULES_IMAGE_HEADER) + nrules * sizeof(RULES_IMAGE_ENTRY);
+  image = calloc(1, size);
+  if (!image) return RULEXDB_EMALLOC;
+  header = (RULES_IMAGE_HEADER *)image;
+  header->magic = RULES_IMAGE_MAGIC;
+  header->version = RULES_IMAGE_VERSION;
+  header->matcher_version = BITMATCH_VERSION;
+  header->nrules = nrules;
+  for (i = 0; i < nrules; i++)
     {
-#ifdef USE_BDB
-      DB **db = choose_dictionary(rulexdb, NULL, RULEXDB_LEXBASE);
-      if (!db) return RULEXDB_EPARM;
-      if (*db)
+      rule_src = rule_source(rulexdb, rules, i);
+      if (!rule_src)
 	{
-	  s = malloc(strlen(key) + 32);
-	  if (s)
-	    for (i = 1; rc == RULEXDB_SPECIAL; i++)
-	      {
-		i = rulexdb_lexbase(rulexdb, key, s, i);
-		if (!i) break;
-		if (i < 0)
-		  {
-		    free(s);
-		    return i;
-		  }
-		if (strlen(key) < strlen(s))
-		  {
-		    for (j = strlen(key); j < strlen(s); j++)
-		      value[j] ='_';
-		    value[strlen(s)] = 0;
-		  }
-		else value[strlen(key)] = 0;
-		rc = db_get(*db, s, value);
-		if (rc < 0)
-		  {
-		    free(s);
-		    return rc;
-		  }
-	      }
-	  else return RULEXDB_EMALLOC;
-	  free(s);
+	  free(image);
+	  return RULEXDB_FAILURE;
 	}
-#else
-      DictHandle h = choose_dictionary(rulexdb, NULL, RULEXDB_LEXBASE);
-      if (!h.dbi) return RULEXDB_EPARM;
-      if (*(h.dbi_open))
+      pattern = pattern_parse(rule_src);
+      if (!pattern) continue;
+      matcher = bitmatch_compile(pattern);
+      pattern_free(pattern);
+      if (!matcher) continue;
+      offset = (size + 7) & ~(size_t)7;
+      p = realloc(image, offset + bitmatch_size(matcher));
+      if (!p)
 	{
-	  s = malloc(strlen(key) + 32);
-	  if (s)
-	    for (i = 1; rc == RULEXDB_SPECIAL; i++)
-	      {
-		i = rulexdb_lexbase(rulexdb, key, s, i);
-		if (!i) break;
-		if (i < 0)
-		  {
-		    free(s);
-		    return i;
-		  }
-		if (strlen(key) < strlen(s))
-		  {
-		    for (j = strlen(key); j < strlen(s); j++)
-		      value[j] ='_';
-		    value[strlen(s)] = 0;
-		  }
-		else value[strlen(key)] = 0;
-		rc = lmdb_get(rulexdb->txn, *(h.dbi), s, value);
-		if (rc < 0)
-		  {
-		    free(s);
-		    return rc;
-		  }
-	      }
-	  else return RULEXDB_EMALLOC;
-	  free(s);
+	  bitmatch_free(matcher);
+	  free(image);
+	  return RULEXDB_EMALLOC;
 	}
-#endif
-
-      /* Prefix detection stage */
-      if ((rc == RULEXDB_SPECIAL) &&
-          !rules_init(rulexdb, &rulexdb->prefixes))
-        {
-          s = malloc(strlen(key));
-          if (s)
-            {
-              regmatch_t match;
-              for (i = 0; (rc == RULEXDB_SPECIAL) && (i < rulexdb->prefixes.nrules); i++)
-                if ((!rule_load(rulexdb, &rulexdb->prefixes, i)) &&
-                    (!regexec(rulexdb->prefixes.pattern[i], key, 1, &match, 0)) &&
-                    (!match.rm_so) &&
-                    (match.rm_eo < strlen(key)))
-                  {
-                    if (rulexdb->prefixes.replacement[i])
-                      (void)strcpy(s, rulexdb->prefixes.replacement[i]);
-                    else *s = 0;
-                    j = strlen(s);
-                    (void)strcat(s, key + match.rm_eo);
-                    rc = rulexdb_search(rulexdb, s, value + match.rm_eo - j, RULEXDB_FORMS | RULEXDB_NOPREFIX);
-                    if (rc == RULEXDB_EINVKEY)
-                      rc = RULEXDB_SPECIAL;
-                    (void)strncpy(value, key, match.rm_eo);
-                  }
-              free(s);
-            }
-          else rc = RULEXDB_EMALLOC;
-        }
+      image = p;
+      (void)memset(image + size, 0, offset - size);
+      (void)memcpy(image + offset, matcher, bitmatch_size(matcher));
+      size = offset + bitmatch_size(matcher);
+      entry = (RULES_IMAGE_ENTRY *)(image + sizeof(RULES_IMAGE_HEADER)) + i;
+      entry->hash = rule_hash(rule_src);
+      entry->offset = offset;
+      entry->size = bitmatch_size(matcher);
+      bitmatch_free(matcher);
+      rc++;
     }
 
-  /* The last resort: trying to use a general rule */
-  if (rc == RULEXDB_SPECIAL)
-    {
-      value[strlen(key)] = 0;
-      if ((!flags) || (flags & RULEXDB_RULES))
-	rc = lexguess(rulexdb, key, value);
-    }
+  /* Store it */
+#ifdef USE_BDB
+  {
+    DB *db = db_open(rulexdb->env, compiled_db_name,
+		     COMPILED_DB_TYPE, RULEXDB_CREATE);
+    DBT inKey, inVal;
 
-  /* Applying a post-correction if needed */
-  if (!rc && !(flags & RULEXDB_NOPREFIX))
-    rc = postcorrect(rulexdb, value);
+    if (!db)
+      {
+	free(image);
+	return RULEXDB_FAILURE;
+      }
+    (void)memset(&inKey, 0, sizeof(DBT));
+    (void)memset(&inVal, 0, sizeof(DBT));
+    inKey.data = (char *)rules->db_name;
+    inKey.size = strlen(rules->db_name) + 1;
+    inVal.data = image;
+    inVal.size = size;
+    if (db->put(db, NULL, &inKey, &inVal, 0))
+      rc = RULEXDB_FAILURE;
+    db_close(db);
+  }
+#else
+  {
+    MDB_dbi dbi;
+    MDB_val key, data;
 
+    if (mdb_dbi_open(rulexdb->txn, compiled_db_name, MDB_CREATE, &dbi))
+      {
+	free(image);
+	return RULEXDB_FAILURE;
+      }
+    key.mv_data = (char *)rules->db_name;
+    key.mv_size = strlen(rules->db_name) + 1;
+    data.mv_data = image;
+    data.mv_size = size;
+    if (mdb_put(rulexdb->txn, dbi, &key, &data, 0))
+      rc = RULEXDB_FAILURE;
+  }
+#endif
+  free(image);
   return rc;
 }
 
-int rulexdb_seq(RULEXDB *rulexdb, char *key, char *value, int item_type, int mode)
+int rulexdb_build_filter(RULEXDB *rulexdb, int item_type)
      /*
-      * Sequential retrieving dictionary items.
-      *
-      * This routine sequentially fetches lexical records one by one.
-      * its operations are not disturbed by the key-based search.
+      * Store the keys membership filter of the dictionary in the database.
       *
-      * Arguments key and value must point to the buffers with enough space
-      * for retrieved data. Argument item_type specifies the dictionary.
-      * The dictionary must be specified explicitly: RULEXDB_EXCEPTION
-      * or RULEXDB_LEXBASE (RULEXDB_DEFAULT is not allowed in this case).
-      * When fetching data from the exception dictionary the correction
-      * will be applied. To prevent this feature you can specify
-      * RULEXDB_EXCEPTION_RAW instead of RULEXDB_EXCEPTION.
-      * The last argument specifies direction of the dictionary scanning.
-      * Allowed values are: RULEXDB_SEQ_FIRST, RULEXDB_SEQ_NEXT,
-      * RULEXDB_SEQ_PREV or RULEXDB_SEQ_LAST.
+      * This routine scans all the keys of the dictionary
+      * and stores the filter built over them, so the searching
+      * can skip most of the lookups for absent keys.
+      * The filter is stamped with the dictionary modification
+      * counter.
+      * Item type specifies the dictionary
+      * (RULEXDB_EXCEPTION or RULEXDB_LEXBASE).
       *
-      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL when
-      * no more records can be fetched, or an appropriate error code
-      * in the case of absolute failure.
+      * Returns number of keys in the filter or negative error code.
       */
 {
   int rc;
+  unsigned int n = 0;
+  size_t size;
+  void *image;
+  const char *db_name;
+  RULEX_IMAGE *filter;
+  unsigned int generation;
 
-#ifdef USE_BDB
-  DBT inKey, inVal;
-  DBC *dbc;
-  int seq_mode;
-  DB **db = choose_dictionary(rulexdb, NULL, item_type);
-
-  if (!db) return RULEXDB_EPARM;
-  if (!(*db)) return RULEXDB_FAILURE;
-
-  switch (mode)
+  if (!rulexdb) return RULEXDB_EPARM;
+  if (rulexdb->mode == RULEXDB_SEARCH) return RULEXDB_EACCESS;
+  switch (item_type)
     {
-      case RULEXDB_SEQ_FIRST:
-        seq_mode = DB_FIRST;
-        break;
-      case RULEXDB_SEQ_NEXT:
-        seq_mode = DB_NEXT;
-        break;
-      case RULEXDB_SEQ_PREV:
-        seq_mode = DB_PREV;
-        break;
-      case RULEXDB_SEQ_LAST:
-        seq_mode = DB_LAST;
-        break;
+      case RULEXDB_EXCEPTION:
+	filter = &rulexdb->exceptions_filter;
+	db_name = exceptions_db_name;
+	generation = generation_stamp(rulexdb, GENERATION_EXCEPTIONS);
+	break;
+      case RULEXDB_LEXBASE:
+	filter = &rulexdb->lexicon_filter;
+	db_name = lexicon_db_name;
+	generation = generation_stamp(rulexdb, GENERATION_LEXBASES);
+	break;
       default:
-        return RULEXDB_EPARM;
+	return RULEXDB_EPARM;
     }
 
-  dbc = (*db)->app_private;
-  /* Initialize cursor if it is not done already */
-  if (!dbc)
+#ifdef USE_BDB
+  {
+    DB **db = choose_dictionary(rulexdb, NULL, item_type);
+    DBC *dbc;
+    DBT inKey, inVal;
+
+    if (!db) return RULEXDB_EPARM;
+    if (!(*db)) return RULEXDB_EACCESS;
+    if ((*db)->cursor(*db, NULL, &dbc, 0))
+      return RULEXDB_FAILURE;
+    (void)memset(&inKey, 0, sizeof(DBT));
+    (void)memset(&inVal, 0, sizeof(DBT));
+    while (!(rc = dbc->c_get(dbc, &inKey, &inVal, DB_NEXT)))
+      n++;
+    if (rc != DB_NOTFOUND)
+      {
+	(void)dbc->c_close(dbc);
+	return RULEXDB_FAILURE;
+      }
+    size = filter_size(n);
+    image = malloc(size);
+    if (!image)
+      {
+	(void)dbc->c_close(dbc);
+	return RULEXDB_EMALLOC;
+      }
+    filter_init(image, size, n, generation);
+    while (!(rc = dbc->c_get(dbc, &inKey, &inVal, DB_NEXT)))
+      filter_add(image, inKey.data, inKey.size);
+    (void)dbc->c_close(dbc);
+    rc = (rc == DB_NOTFOUND) ? RULEXDB_SUCCESS : RULEXDB_FAILURE;
+  }
+#else
+  {
+    DictHandle h = choose_dictionary(rulexdb, NULL, item_type);
+    MDB_cursor *cursor;
+    MDB_val key, data;
+
+    if (!h.dbi) return RULEXDB_EPARM;
+    if (!*(h.dbi_open)) return RULEXDB_EACCESS;
+    n = lmdb_nrecs(rulexdb->txn, *(h.dbi));
+    size = filter_size(n);
+    image = malloc(size);
+    if (!image) return RULEXDB_EMALLOC;
+    filter_init(image, size, n, generation);
+    if (mdb_cursor_open(rulexdb->txn, *(h.dbi), &cursor))
+      {
+	free(image);
+	return RULEXDB_FAILURE;
+      }
+    while (!(rc = mdb_cursor_get(cursor, &key, &data, MDB_NEXT)))
+      filter_add(image, key.mv_data, key.mv_size);
+    mdb_cursor_close(cursor);
+    rc = (rc == MDB_NOTFOUND) ? RULEXDB_SUCCESS : RULEXDB_FAILURE;
+  }
+#endif
+  if (!rc)
+    rc = compiled_store(rulexdb, db_name, image, size);
+  free(image);
+  if (rc)
+    return RULEXDB_FAILURE;
+
+  /* Further changes must drop the new filter */
+  filter->checked = 0;
+  return (int)n;
+}
+
+static int freeze_by_word(const void *a, const void *b)
+     /*
+      * Compare words referenced by the array items for qsort().
+      */
+{
+  return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+static int freeze_add(char ***list, int *n, int *size, const char *word)
+     /*
+      * Append a copy of the word to the list growing it if needed.
+      */
+{
+  char **p;
+
+  if (*n == *size)
     {
-      rc = (*db)->cursor(*db, NULL, &dbc, 0);
-      if (rc)
-	{
-	  dbc = NULL;
-	  return RULEXDB_FAILURE;
-	}
-      else (*db)->app_private = dbc;
+      p = realloc(*list, 2 * (*size) * sizeof(char *));
+      if (!p) return RULEXDB_EMALLOC;
+      *list = p;
+      *size *= 2;
     }
-  (void)memset(&inKey, 0, sizeof(DBT));
-  (void)memset(&inVal, 0, sizeof(DBT));
-  rc = dbc->c_get(dbc, &inKey, &inVal, seq_mode);
-  switch (rc)
+  (*list)[*n] = strdup(word);
+  if (!(*list)[*n]) return RULEXDB_EMALLOC;
+  (*n)++;
+  return RULEXDB_SUCCESS;
+}
+
+int rulexdb_freeze(RULEXDB *rulexdb, const char * const *words, int n)
+     /*
+      * Store the frozen search results table in the database.
+      *
+      * The words are gathered from both dictionaries and
+      * specified array, sorted and deduplicated. Then every word
+      * is searched as usual and the results are put into the table.
+      *
+      * Returns number of words in the table or negative error code.
+      */
+{
+  static const int datasets[2] = { RULEXDB_EXCEPTION_RAW, RULEXDB_LEXBASE };
+  char key[RULEXDB_BUFSIZE], value[RULEXDB_BUFSIZE];
+  char **list, **results = NULL, *codes = NULL;
+  int i, k, m = 0, nwords = 0, size = FREEZE_CHUNK, rc = RULEXDB_SUCCESS;
+  size_t text = 0, image_size;
+  void *image;
+
+  if ((!rulexdb) || (n < 0) || (n && !words)) return RULEXDB_EPARM;
+  if (rulexdb->mode == RULEXDB_SEARCH) return RULEXDB_EACCESS;
+  list = malloc(size * sizeof(char *));
+  if (!list) return RULEXDB_EMALLOC;
+
+  /* Gather the words */
+  for (k = 0; (k < 2) && !rc; k++)
+    for (i = rulexdb_seq(rulexdb, key, value, datasets[k], RULEXDB_SEQ_FIRST);
+	 (i == RULEXDB_SUCCESS) && !rc;
+	 i = rulexdb_seq(rulexdb, key, value, datasets[k], RULEXDB_SEQ_NEXT))
+      rc = freeze_add(&list, &m, &size, key);
+  for (i = 0; (i < n) && !rc; i++)
+    if (words[i] && (strlen(words[i]) <= RULEXDB_MAX_KEY_SIZE))
+      rc = freeze_add(&list, &m, &size, words[i]);
+  if (!rc)
     {
-      case 0:
-	if (unpack_key(inKey.data, inKey.size, key, RULEXDB_MAX_KEY_SIZE))
-	  return RULEXDB_FAILURE;
-	(void)strcpy(value, key);
-	unpack_data(value, inVal.data, inVal.size);
-	if (item_type == RULEXDB_EXCEPTION)
-	  return postcorrect(rulexdb, value);
-	return RULEXDB_SUCCESS;
-      case DB_NOTFOUND:
-	return RULEXDB_SPECIAL;
-      default:
-	break;
+      qsort(list, m, sizeof(char *), freeze_by_word);
+      for (i = k = 0; i < m; i++)
+	if (k && !strcmp(list[k - 1], list[i]))
+	  free(list[i]);
+	else list[k++] = list[i];
+      m = k;
+      results = calloc(m ? m : 1, sizeof(char *));
+      codes = malloc(m ? m : 1);
+      if (!(results && codes))
+	rc = RULEXDB_EMALLOC;
     }
-#else
-  MDB_val inKey, inVal;
-  MDB_cursor_op seq_mode;
-  DictHandle h = choose_dictionary(rulexdb, NULL, item_type);
-
-  if (!h.dbi) return RULEXDB_EPARM;
-  if (!*(h.dbi_open)) return RULEXDB_FAILURE;
 
-  switch (mode)
+  /* Search them as usual */
+  for (i = 0; (i < m) && !rc; i++)
     {
-      case RULEXDB_SEQ_FIRST:
-        seq_mode = MDB_FIRST;
-        break;
-      case RULEXDB_SEQ_NEXT:
-        seq_mode = MDB_NEXT;
-        break;
-      case RULEXDB_SEQ_PREV:
-        seq_mode = MDB_PREV;
-        break;
-      case RULEXDB_SEQ_LAST:
-        seq_mode = MDB_LAST;
-        break;
-      default:
-        return RULEXDB_EPARM;
+      k = rulexdb_search(rulexdb, list[i], value, 0);
+      if (k < 0) /* Such a word cannot be frozen */
+	continue;
+      results[i] = strdup(value);
+      if (!results[i])
+	rc = RULEXDB_EMALLOC;
+      codes[i] = (char)k;
+      text += strlen(list[i]) + strlen(value);
+      nwords++;
     }
 
-  if (!*(h.cursor))
+  /* Build the table and store it */
+  if (!rc)
     {
-      rc = mdb_cursor_open(rulexdb->txn, *(h.dbi), h.cursor);
-      if (rc)
+      image_size = frozen_size(nwords, text);
+      image = malloc(image_size);
+      if (image)
 	{
-	  *(h.cursor) = NULL;
-	  return RULEXDB_FAILURE;
+	  frozen_init(image, image_size, nwords,
+		      frozen_generation(rulexdb, 1));
+	  for (i = 0; i < m; i++)
+	    if (results[i])
+	      (void)frozen_add(image, list[i], results[i], codes[i]);
+	  rc = compiled_store(rulexdb, frozen_record_name, image, image_size);
+	  free(image);
 	}
+      else rc = RULEXDB_EMALLOC;
     }
-  rc = mdb_cursor_get(*(h.cursor), &inKey, &inVal, seq_mode);
-  switch (rc)
+
+  for (i = 0; i < m; i++)
     {
-      case 0:
-	if (unpack_key(inKey.mv_data, (unsigned int)inKey.mv_size,
-		       key, RULEXDB_MAX_KEY_SIZE))
-	  return RULEXDB_FAILURE;
-	(void)strcpy(value, key);
-	unpack_data(value, inVal.mv_data, (int)inVal.mv_size);
-	if (item_type == RULEXDB_EXCEPTION)
-	  return postcorrect(rulexdb, value);
-	return RULEXDB_SUCCESS;
-      case MDB_NOTFOUND:
-	return RULEXDB_SPECIAL;
-      default:
-	break;
+      free(list[i]);
+      if (results)
+	free(results[i]);
     }
-#endif
-  return RULEXDB_FAILURE;
+  free(list);
+  free(results);
+  free(codes);
+  if (rc)
+    return rc;
+
+  /* Further changes must drop the new table */
+  rulexdb->frozen.checked = 0;
+  return nwords;
 }
 
-int rulexdb_remove_item(RULEXDB *rulexdb, const char *key, int item_type)
+static int dictionary_records(RULEXDB *rulexdb, int item_type,
+			      LEXFILE_RECORD **records, char **pool)
      /*
-      * Remove specified record from the dictionary.
-      *
-      This routine removes lexical item for specified key.
-      * Item type must be specified explicitly:
-      * only RULEXDB_LEXBASE or RULEXDB_EXCEPTION are allowed.
+      * Gather the raw records of the dictionary in the keys order.
+      * The array of records is allocated and placed in the location
+      * pointed by records. With Berkeley DB the record data
+      * are copied into the allocated pool, otherwise they point
+      * to the mapped data, and the pool is set to NULL.
+      * Both of them must be freed by the caller
+      * even in the case of failure. The absent dictionary
+      * gives no records.
       *
-      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL
-      * when no record exists for specified key, or an appropriate
-      * error code when other failure.
+      * Returns number of records or negative error code.
       */
 {
   int rc;
-  char packed_key[RULEXDB_BUFSIZE];
-
+  unsigned int i, n = 0;
 #ifdef USE_BDB
-  DBT inKey;
-  DB **db = choose_dictionary(rulexdb, key, item_type);
+  size_t pool_size = 0;
+  char *p;
+  DB **db = choose_dictionary(rulexdb, NULL, item_type);
+  DBC *dbc;
+  DBT inKey, inVal;
 
+  *records = NULL;
+  *pool = NULL;
   if (!db) return RULEXDB_EPARM;
-  if (!(*db)) return RULEXDB_EACCESS;
-  (void)memset(&inKey, 0, sizeof(DBT));
-  inKey.size = pack_key(key, packed_key);
-  if ((signed int)(inKey.size) <= 0)
-    return RULEXDB_EINVKEY;
-  inKey.data = packed_key;
-  rc = (*db)->del(*db, NULL, &inKey, 0);
-  if (rc)
+  rc = RULEXDB_SUCCESS;
+  if (*db)
     {
+      /* Record data are valid only until the next cursor move */
+      if ((*db)->cursor(*db, NULL, &dbc, 0))
+	return RULEXDB_FAILURE;
+      (void)memset(&inKey, 0, sizeof(DBT));
+      (void)memset(&inVal, 0, sizeof(DBT));
+      while (!(rc = dbc->c_get(dbc, &inKey, &inVal, DB_NEXT)))
+	{
+	  pool_size += inKey.size + inVal.size;
+	  n++;
+	}
       if (rc == DB_NOTFOUND)
-	return RULEXDB_SPECIAL;
-      return RULEXDB_FAILURE;
+	{
+	  *records = malloc((n ? n : 1) * sizeof(LEXFILE_RECORD));
+	  *pool = malloc(pool_size ? pool_size : 1);
+	  rc = (*records && *pool) ? RULEXDB_SUCCESS : RULEXDB_EMALLOC;
+	}
+      else rc = RULEXDB_FAILURE;
+      for (i = 0, p = *pool; (i < n) && !rc; i++)
+	if (!dbc->c_get(dbc, &inKey, &inVal, DB_NEXT))
+	  {
+	    (*records)[i].key = memcpy(p, inKey.data, inKey.size);
+	    (*records)[i].keylen = inKey.size;
+	    p += inKey.size;
+	    (*records)[i].value = memcpy(p, inVal.data, inVal.size);
+	    (*records)[i].size = inVal.size;
+	    p += inVal.size;
+	  }
+	else rc = RULEXDB_FAILURE;
+      (void)dbc->c_close(dbc);
     }
 #else
-  MDB_val inKey;
-  DictHandle h = choose_dictionary(rulexdb, key, item_type);
+  DictHandle h = choose_dictionary(rulexdb, NULL, item_type);
+  MDB_cursor *cursor = NULL;
+  MDB_val key, data;
 
+  *records = NULL;
+  *pool = NULL;
   if (!h.dbi) return RULEXDB_EPARM;
-  if (!*(h.dbi_open)) return RULEXDB_EACCESS;
-  inKey.mv_size = (size_t)pack_key(key, packed_key);
-  if ((signed int)inKey.mv_size <= 0)
-    return RULEXDB_EINVKEY;
-  inKey.mv_data = packed_key;
-  rc = mdb_del(rulexdb->txn, *(h.dbi), &inKey, NULL);
-  if (rc)
+  rc = RULEXDB_SUCCESS;
+  if (*(h.dbi_open))
     {
-      if (rc == MDB_NOTFOUND)
-	return RULEXDB_SPECIAL;
-      return RULEXDB_FAILURE;
+      /* Mapped records stay in place until the transaction ends */
+      n = lmdb_nrecs(rulexdb->txn, *(h.dbi));
+      *records = malloc((n ? n : 1) * sizeof(LEXFILE_RECORD));
+      if (!*records) return RULEXDB_EMALLOC;
+      if (mdb_cursor_open(rulexdb->txn, *(h.dbi), &cursor))
+	rc = RULEXDB_FAILURE;
+      for (i = 0; (i < n) && !rc; i++)
+	if (!mdb_cursor_get(cursor, &key, &data, MDB_NEXT))
+	  {
+	    (*records)[i].key = key.mv_data;
+	    (*records)[i].keylen = key.mv_size;
+	    (*records)[i].value = data.mv_data;
+	    (*records)[i].size = data.mv_size;
+	  }
+	else rc = RULEXDB_FAILURE;
+      if (cursor)
+	mdb_cursor_close(cursor);
     }
 #endif
-  return RULEXDB_SUCCESS;
+  return rc ? rc : (int)n;
 }
 
-int rulexdb_remove_this_item(RULEXDB *rulexdb, int item_type)
+static int compile_dictionary(RULEXDB *rulexdb, int item_type,
+			      void **table, size_t *size)
      /*
-      * Remove sequentially retrieved item.
-      *
-      * This routine removes from the dictionary the item retrieved
-      * by the rulexdb_seq() routine, that is the item
-      * pointed by cursor.
-      *
-      * The item type must be specified explicitly:
-      * only RULEXDB_LEXBASE or RULEXDB_EXCEPTION are allowed.
+      * Build the compiled lexicon file table of the dictionary
+      * from its raw records. The absent dictionary gives
+      * an empty table.
       *
-      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL
-      * when pointed record is already deleted, or an appropriate
-      * error code when other failure. If specified dictionary
-      * never was accessed sequentially, so it has no initialized
-      * cursor, the code RULEXDB_EACCESS is returned.
+      * Returns number of records in the table or negative error code.
       */
 {
   int rc;
+  unsigned int n = 0;
+  LEXFILE_RECORD *records;
+  char *pool;
 
-#ifdef USE_BDB
-  DBC *dbc;
-  DB **db = choose_dictionary(rulexdb, NULL, item_type);
-
-  if (!db) return RULEXDB_EPARM;
-  if (!(*db)) return RULEXDB_EACCESS;
-  dbc = (*db)->app_private;
-  if(!dbc) return RULEXDB_EACCESS;
-  rc = dbc->c_del(dbc, 0);
-  if (rc)
+  rc = dictionary_records(rulexdb, item_type, &records, &pool);
+  if (rc >= 0)
     {
-      if (rc == DB_NOTFOUND)
-	return RULEXDB_SPECIAL;
-      return RULEXDB_FAILURE;
+      n = (unsigned int)rc;
+      rc = RULEXDB_SUCCESS;
     }
-#else
-  DictHandle h = choose_dictionary(rulexdb, NULL, item_type);
-
-  if (!h.dbi) return RULEXDB_EPARM;
-  if (!*(h.dbi_open)) return RULEXDB_EACCESS;
-  if (!*(h.cursor)) return RULEXDB_EACCESS;
-  rc = mdb_cursor_del(*(h.cursor), 0);
-  if (rc)
+  if (!rc)
     {
-      if (rc == MDB_NOTFOUND)
-	return RULEXDB_SPECIAL;
-      return RULEXDB_FAILURE;
+      *size = lexfile_table_size(records, n);
+      if (!*size)
+	rc = RULEXDB_EINVREC;
     }
-#endif
-  return RULEXDB_SUCCESS;
+  if (!rc)
+    {
+      *table = malloc(*size);
+      if (!*table)
+	rc = RULEXDB_EMALLOC;
+      else if (lexfile_table_build(*table, records, n))
+	{
+	  free(*table);
+	  rc = RULEXDB_FAILURE;
+	}
+    }
+  free(pool);
+  free(records);
+  return rc ? rc : (int)n;
 }
 
-int rulexdb_classify(RULEXDB *rulexdb, const char *s)
+int rulexdb_compile(RULEXDB *rulexdb, const char *path)
      /*
-      * Test specified word whether it represents a lexical base.
+      * Write the compiled lexicon file.
       *
-      * Returns 0 (RULEXDB_SUCCESS) when the word does not represent
-      * a lexical base, RULEXDB_SPECIAL if it does, or an appropriate
-      * error code when failure.
+      * The dictionaries records are stored as is, so the file
+      * gives exactly the same search results as the database.
+      * Their keys packing format is stamped in the file as well.
+      * The rules are stored in their text representation along
+      * with the precompiled rulesets if they are there.
+      *
+      * Returns number of the dictionaries records stored in the file
+      * or negative error code.
       */
 {
-  int i;
-  char *t = malloc(strlen(s) + 32);
+  const void *sections[LEXFILE_SECTIONS];
+  void *data[LEXFILE_SECTIONS];
+  size_t sizes[LEXFILE_SECTIONS], size;
+  RULEX_IMAGE images[4];
+  char **list, *rule_src;
+  int i, k, n, m = 0, rc = RULEXDB_SUCCESS;
+  uint32_t keys_format[2];
+  void *image;
+  FILE *f;
+
+  if ((!rulexdb) || (!path)) return RULEXDB_EPARM;
+  if (rulexdb->lexfile.image) return RULEXDB_EACCESS;
+  keys_format[0] = (uint32_t)rulexdb->keycoder->format;
+  keys_format[1] = rulexdb->keycoder->model;
+  (void)memset(data, 0, sizeof(data));
+  (void)memset(sizes, 0, sizeof(sizes));
+  (void)memset(images, 0, sizeof(images));
+
+  /* Dictionaries */
+  rc = compile_dictionary(rulexdb, RULEXDB_EXCEPTION,
+			  &data[LEXFILE_EXCEPTIONS], &sizes[LEXFILE_EXCEPTIONS]);
+  if (rc >= 0)
+    {
+      m = rc;
+      rc = compile_dictionary(rulexdb, RULEXDB_LEXBASE,
+			      &data[LEXFILE_LEXBASES], &sizes[LEXFILE_LEXBASES]);
+    }
+  if (rc >= 0)
+    {
+      m += rc;
+      rc = RULEXDB_SUCCESS;
+    }
 
-  if (!t)
-    return RULEXDB_EMALLOC;
-  for (i = 1; i > 0; i++)
+  /* Rulesets */
+  for (i = 0; (i < 4) && !rc; i++)
     {
-      i = rulexdb_lexbase(rulexdb, s, t, i);
-      if (i < 0)
+      n = 0;
+      k = FREEZE_CHUNK;
+      list = malloc(k * sizeof(char *));
+      if (!list)
 	{
-	  free(t);
-	  return i;
+	  rc = RULEXDB_EMALLOC;
+	  break;
+	}
+      while ((!rc) && (rule_src = rulexdb_fetch_rule(rulexdb, rule_types[i],
+						     n + 1)))
+	rc = freeze_add(&list, &n, &k, rule_src);
+      if (!rc)
+	{
+	  sizes[LEXFILE_RULES + i] =
+	    lexfile_list_size((const char * const *)list, n);
+	  data[LEXFILE_RULES + i] = malloc(sizes[LEXFILE_RULES + i]);
+	  if (data[LEXFILE_RULES + i])
+	    lexfile_list_build(data[LEXFILE_RULES + i],
+			       (const char * const *)list, n);
+	  else rc = RULEXDB_EMALLOC;
+	}
+      while (n--)
+	free(list[n]);
+      free(list);
+      if ((!rc) &&
+	  !compiled_fetch(rulexdb, get_ruleset_handler(rulexdb,
+						       rule_types[i])->db_name,
+			  &images[i]))
+	{
+	  data[LEXFILE_IMAGES + i] = (void *)images[i].image;
+	  sizes[LEXFILE_IMAGES + i] = images[i].size;
 	}
-      if (i)
+    }
+
+  /* Assemble the file and write it */
+  if (!rc)
+    {
+      for (i = 0; i < LEXFILE_SECTIONS; i++)
+	sections[i] = data[i];
+      sections[LEXFILE_KEYS_FORMAT] = keys_format;
+      sizes[LEXFILE_KEYS_FORMAT] = sizeof(keys_format);
+      size = lexfile_size(sizes);
+      image = malloc(size);
+      if (image)
 	{
-	  if (!strcmp(s, t))
+	  lexfile_init(image, sections, sizes);
+	  f = fopen(path, "wb");
+	  if (f)
 	    {
-	      free(t);
-	      return RULEXDB_SPECIAL;
+	      if (fwrite(image, size, 1, f) != 1)
+		rc = RULEXDB_FAILURE;
+	      if (fclose(f))
+		rc = RULEXDB_FAILURE;
 	    }
+	  else rc = RULEXDB_FAILURE;
+	  free(image);
 	}
-      else i--;
+      else rc = RULEXDB_EMALLOC;
     }
-  free(t);
-  return RULEXDB_SUCCESS;
+
+  for (i = 0; i < LEXFILE_IMAGES; i++)
+    free(data[i]);
+  for (i = 0; i < 4; i++)
+    free(images[i].buf);
+  return rc ? rc : m;
 }
 
-int rulexdb_discard_dictionary(RULEXDB *rulexdb, int item_type)
+static int fst_by_word(const void *a, const void *b)
      /*
-      * Discard the dictionary.
+      * Compare transducer records for qsort() as fst_build()
+      * expects them with the characters order table fst_order.
+      */
+{
+  return fst_compare(fst_order, ((const FST_RECORD *)a)->word,
+		     ((const FST_RECORD *)b)->word);
+}
+
+int rulexdb_build_fst(RULEXDB *rulexdb, int item_type)
+     /*
+      * Store the dictionary transducer in the database.
       *
-      * This routine deletes all data from specified dictionary.
-      * Returns number of deleted records or negative error code.
-      * Item type specifies a dictionary
+      * The keys of all the dictionary records are unpacked
+      * and sorted in the packed keys order, so the words listed
+      * by prefix follow the dictionary one. The values are taken
+      * as they are stored.
+      * The transducer is stamped with the dictionary modification
+      * counter.
+      * Item type specifies the dictionary
       * (RULEXDB_EXCEPTION or RULEXDB_LEXBASE).
-      * RULEXDB_DEFAULT is not allowed here.
+      *
+      * Returns number of words in the transducer or negative error code.
       */
 {
   int rc;
-
-#ifdef USE_BDB
-  u_int32_t n;
-  DB **db = choose_dictionary(rulexdb, NULL, item_type);
-  DBC *dbc;
-
-  if (!db) return RULEXDB_EPARM;
-  if (!(*db)) return RULEXDB_EACCESS;
-  dbc = (*db)->app_private;
-  if (dbc) /* Close cursor at first if it was opened */
+  unsigned int i, n = 0;
+  size_t size;
+  void *image = NULL;
+  const char *name;
+  RULEX_IMAGE *fst;
+  LEXFILE_RECORD *records;
+  FST_RECORD *words = NULL;
+  char *pool, *text = NULL, *word;
+  unsigned char order[256];
+  unsigned int generation;
+  int counter;
+
+  if (!rulexdb) return RULEXDB_EPARM;
+  if (rulexdb->mode == RULEXDB_SEARCH) return RULEXDB_EACCESS;
+  switch (item_type)
     {
-      (void)dbc->c_close(dbc);
-      (*db)->app_private = NULL;
+      case RULEXDB_EXCEPTION:
+	fst = &rulexdb->exceptions_fst;
+	name = exceptions_fst_name;
+	counter = GENERATION_EXCEPTIONS;
+	break;
+      case RULEXDB_LEXBASE:
+	fst = &rulexdb->lexicon_fst;
+	name = lexicon_fst_name;
+	counter = GENERATION_LEXBASES;
+	break;
+      default:
+	return RULEXDB_EPARM;
     }
-  rc = (*db)->truncate(*db, NULL, &n, 0);
-  if (rc)
-    return RULEXDB_FAILURE;
-  return n;
-#else
-  unsigned int n;
-  MDB_stat st;
-  DictHandle h = choose_dictionary(rulexdb, NULL, item_type);
+  if (dictionary_check(rulexdb, item_type))
+    return RULEXDB_EACCESS;
+  generation = generation_stamp(rulexdb, counter);
 
-  if (!h.dbi) return RULEXDB_EPARM;
-  if (!*(h.dbi_open)) return RULEXDB_EACCESS;
-  if (*(h.cursor))
+  rc = dictionary_records(rulexdb, item_type, &records, &pool);
+  if (rc >= 0)
     {
-      mdb_cursor_close(*(h.cursor));
-      *(h.cursor) = NULL;
+      n = (unsigned int)rc;
+      words = malloc((n ? n : 1) * sizeof(FST_RECORD));
+      text = malloc((n ? n : 1) * (RULEXDB_MAX_KEY_SIZE + 1));
+      rc = (words && text) ? RULEXDB_SUCCESS : RULEXDB_EMALLOC;
     }
-  rc = mdb_stat(rulexdb->txn, *(h.dbi), &st);
-  n = rc ? 0 : (unsigned int)st.ms_entries;
-  rc = mdb_drop(rulexdb->txn, *(h.dbi), 0);
+  for (i = 0; (i < n) && !rc; i++)
+    {
+      word = text + i * (RULEXDB_MAX_KEY_SIZE + 1);
+      if (rulexdb->keycoder->unpack(records[i].key, records[i].keylen,
+				    word, RULEXDB_MAX_KEY_SIZE + 1))
+	rc = RULEXDB_EINVREC;
+      words[i].word = word;
+      words[i].value = records[i].value;
+      words[i].size = records[i].size;
+    }
+  if (!rc)
+    {
+      for (i = 0; i < sizeof(order); i++)
+	order[i] = (unsigned char)key_order((unsigned char)i);
+      fst_order = order;
+      qsort(words, n, sizeof(FST_RECORD), fst_by_word);
+      image = fst_build(words, n, order, generation, &size);
+      if (!image)
+	rc = RULEXDB_EMALLOC;
+    }
+  if (!rc)
+    rc = compiled_store(rulexdb, name, image, size);
+  free(image);
+  free(text);
+  free(words);
+  free(pool);
+  free(records);
   if (rc)
-    return RULEXDB_FAILURE;
+    return rc;
+
+  /* Further changes must drop the new transducer */
+  fst->checked = 0;
   return (int)n;
-#endif
 }
 
-int rulexdb_load_ruleset(RULEXDB *rulexdb, int rule_type)
+int rulexdb_enumerate(RULEXDB *rulexdb, const char *prefix,
+		      char *key, char *value, int item_type, int n)
      /*
-      * Load ruleset data.
+      * Fetch the dictionary record by prefix.
       *
-      * This routine initializes specified ruleset
-      * and preloads all its data.
-      * Returns number of loaded records or negative error code.
-      * Rule type specifies target ruleset
-      * (RULEXDB_RULE, RULEXDB_LEXCLASS, RULEXDB_PREFIX or RULEXDB_CORRECTOR).
+      * The words starting with the prefix occupy a contiguous
+      * range of ranks in the dictionary transducer, so the record
+      * is fetched directly without scanning the preceding ones.
       *
-      * Loaded ruleset cannot be modified.
+      * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL when
+      * there are no more records with this prefix,
+      * or an appropriate error code in the case of failure.
       */
 {
-  int i, rc;
-  RULEX_RULESET *rules = get_ruleset_handler(rulexdb, rule_type);
+  const RULEX_IMAGE *fst;
+  const char *data;
+  unsigned int first, size;
+
+  if ((!rulexdb) || (!prefix) || (!key) || (!value) || (n < 0))
+    return RULEXDB_EPARM;
+  if ((item_type != RULEXDB_EXCEPTION) &&
+      (item_type != RULEXDB_EXCEPTION_RAW) &&
+      (item_type != RULEXDB_LEXBASE))
+    return RULEXDB_EPARM;
+  fst = dictionary_fst(rulexdb, (item_type == RULEXDB_LEXBASE) ?
+		       RULEXDB_LEXBASE : RULEXDB_EXCEPTION);
+  if (!fst)
+    return RULEXDB_EACCESS;
+  if ((unsigned int)n >= fst_prefix(fst->image, prefix, &first))
+    return RULEXDB_SPECIAL;
+  if (!fst_fetch(fst->image, first + n, key, RULEXDB_MAX_KEY_SIZE + 1,
+		 &data, &size))
+    return RULEXDB_FAILURE;
+  (void)strcpy(value, key);
+  unpack_data(value, data, (int)size);
+  if (item_type == RULEXDB_EXCEPTION)
+    return postcorrect(rulexdb, value);
+  return RULEXDB_SUCCESS;
+}
 
+int rulexdb_reorder_ruleset(RULEXDB *rulexdb, int rule_type,
+			    const unsigned long *weights, int size)
+     /*
+      * Reorder rules by their weights preserving search results.
+      *
+      * This routine rearranges the rules of specified ruleset,
+      * so the rules with greater weights are tried earlier.
+      * Two rules may change their relative order only when
+      * it is proven that no word can be matched by both of them.
+      * The rules which patterns cannot be analyzed keep their
+      * relative order with respect to all other rules.
+      *
+      * The array pointed by weights contains size elements.
+      * The element i corresponds to the rule number i + 1.
+      * Missing weights are treated as zero.
+      * Rule type specifies target ruleset
+      * (RULEXDB_RULE, RULEXDB_LEXCLASS or RULEXDB_PREFIX).
+      * Correction rules are applied one after another,
+      * so their order always matters.
+      *
+      * Returns number of rules that have changed their positions
+      * or negative error code.
+      */
+{
+  int i, j, k, n, nrules, best, rc = 0;
+  unsigned long total, best_total = 0;
+  char *rule_src, **text = NULL, *before = NULL, *placed = NULL;
+  PATTERN **pattern = NULL;
+  int *order = NULL, best_n = 0;
+  RULEX_RULESET *rules;
+
+  if ((!rulexdb) || (size < 0) || (size && !weights) ||
+      (rule_type == RULEXDB_CORRECTOR))
+    return RULEXDB_EPARM;
+  if (rulexdb->mode == RULEXDB_SEARCH) return RULEXDB_EACCESS;
+  rules = choose_ruleset(rulexdb, rule_type);
   if (!rules) return RULEXDB_EPARM;
-  rc = rules_init(rulexdb, rules);
-  if (!rc)
-    for (i = 0; (i < rules->nrules) && !rc; i++)
-      rc = rule_load(rulexdb, rules, i);
+#ifdef USE_BDB
+  if (!rules->db) return RULEXDB_EACCESS;
+  nrules = db_nrecs(rules->db);
+#else
+  if (!rules->dbi_open) return RULEXDB_EACCESS;
+  nrules = (int)lmdb_rules_count(rulexdb, rules);
+#endif
+  if (nrules < 0) return RULEXDB_FAILURE;
+  if (nrules < 2) return 0;
+  if (size > nrules)
+    size = nrules;
+
+  text = calloc(nrules, sizeof(char *));
+  pattern = calloc(nrules, sizeof(PATTERN *));
+  before = calloc(nrules, nrules);
+  placed = calloc(nrules, 1);
+  order = malloc(nrules * sizeof(int));
+  if (!(text && pattern && before && placed && order))
+    {
+      rc = RULEXDB_EMALLOC;
+      goto done;
+    }
 
-  return rc ? rc : rules->nrules;
+  /* Fetch and parse all the rules */
+  for (i = 0; i < nrules; i++)
+    {
+      rule_src = rule_text(rulexdb, rules, i);
+      if (!rule_src)
+	{
+	  rc = RULEXDB_FAILURE;
+	  goto done;
+	}
+      text[i] = strdup(rule_src);
+      if (!text[i])
+	{
+	  rc = RULEXDB_EMALLOC;
+	  goto done;
+	}
+      rule_src = strtok(rule_src, " ");
+      if (rule_src)
+	pattern[i] = pattern_parse(rule_src);
+    }
+
+  /*
+   * The rules that can match the same word must keep their order.
+   * The element before[j * nrules + i] tells whether the rule j
+   * must precede the rule i, directly or through other rules.
+   */
+  for (i = 1; i < nrules; i++)
+    for (j = 0; j < i; j++)
+      if ((!pattern[i]) || (!pattern[j]) ||
+	  dfa_overlap(pattern[j], pattern[i]))
+	before[j * nrules + i] = 1;
+  for (k = 0; k < nrules; k++)
+    for (j = 0; j < k; j++)
+      if (before[j * nrules + k])
+	for (i = k + 1; i < nrules; i++)
+	  if (before[k * nrules + i])
+	    before[j * nrules + i] = 1;
+
+  /*
+   * Arrange the rules. At every step the rule is chosen
+   * that has the greatest mean weight along with all its
+   * predecessors not placed yet. Then all of them are placed
+   * in their original order.
+   */
+  for (k = 0; k < nrules; )
+    {
+      best = -1;
+      for (i = 0; i < nrules; i++)
+	if (!placed[i])
+	  {
+	    total = (i < size) ? weights[i] : 0;
+	    n = 1;
+	    for (j = 0; j < i; j++)
+	      if (before[j * nrules + i] && !placed[j])
+		{
+		  if (j < size)
+		    total += weights[j];
+		  n++;
+		}
+	    if ((best < 0) ||
+		((double)total * best_n > (double)best_total * n))
+	      {
+		best = i;
+		best_total = total;
+		best_n = n;
+	      }
+	  }
+      for (j = 0; j < best; j++)
+	if (before[j * nrules + best] && !placed[j])
+	  {
+	    placed[j] = 1;
+	    order[k++] = j;
+	  }
+      placed[best] = 1;
+      order[k++] = best;
+    }
+
+  /* Store the rules in the new order */
+  for (k = 0; k < nrules; k++)
+    if (order[k] != k)
+      {
+	if (rule_put(rulexdb, rules, k, text[order[k]]))
+	  {
+	    rc = RULEXDB_FAILURE;
+	    goto done;
+	  }
+	rc++;
+      }
+
+ done:
+  if (text)
+    for (i = 0; i < nrules; i++)
+      free(text[i]);
+  if (pattern)
+    for (i = 0; i < nrules; i++)
+      pattern_free(pattern[i]);
+  free(text);
+  free(pattern);
+  free(before);
+  free(placed);
+  free(order);
+  return rc;
 }
 
 int rulexdb_discard_ruleset(RULEXDB *rulexdb, int rule_type)
@@ -1877,6 +5870,8 @@ int rulexdb_discard_ruleset(RULEXDB *rulexdb, int rule_type)
   RULEX_RULESET *rules = choose_ruleset(rulexdb, rule_type);
 
   if (!rules) return RULEXDB_EPARM;
+  results_invalidate(rulexdb);
+  (void)generation_bump(rulexdb, GENERATION_RULES);
 
 #ifdef USE_BDB
   {
@@ -1890,13 +5885,15 @@ int rulexdb_discard_ruleset(RULEXDB *rulexdb, int rule_type)
 #else
   {
     unsigned int n;
-    MDB_stat st;
     if (!rules->dbi_open) return RULEXDB_EACCESS;
-    rc = mdb_stat(rulexdb->txn, rules->dbi, &st);
-    n = rc ? 0 : (unsigned int)st.ms_entries;
+    n = lmdb_rules_count(rulexdb, rules);
     rc = mdb_drop(rulexdb->txn, rules->dbi, 0);
     if (rc)
       return RULEXDB_FAILURE;
+    rules->format = 0;
+    free(rules->keys);
+    rules->keys = NULL;
+    rules->nkeys = 0;
     return (int)n;
   }
 #endif
@@ -1925,6 +5922,8 @@ const char *rulexdb_dataset_name(int item_type)
 	return lexclasses_db_name;
       case RULEXDB_RULE:
 	return rules_db_name;
+      case RULEXDB_PREFIX:
+	return prefixes_db_name;
       case RULEXDB_CORRECTOR:
 	return corrections_db_name;
       default:
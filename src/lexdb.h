@@ -31,12 +31,34 @@
 #include <regex.h>
 #endif
 
+#ifdef USE_PCRE2
+#ifndef PCRE2_CODE_UNIT_WIDTH
+#define PCRE2_CODE_UNIT_WIDTH 8
+#endif
+#include <pcre2.h>
+#endif
+
 #ifdef USE_BDB
 #include <db.h>
 #else
 #include <lmdb.h>
 #endif
 
+/* Multi-pattern rules matching automaton */
+struct RULEX_DFA;
+
+/* Rules index by the word endings */
+struct RULEX_SUFFIX;
+
+/* Bit-parallel single pattern matcher */
+struct RULEX_BITMATCH;
+
+/* Search results cache */
+struct RULEX_CACHE;
+
+/* Dictionary keys packing format */
+struct RULEX_KEYCODER;
+
 /* BEGIN_C_DECLS should be used at the beginning of C declarations,
    so that C++ compilers don't mangle their names.  Use END_C_DECLS at
    the end of C declarations. */
@@ -65,6 +87,12 @@ BEGIN_C_DECLS
 #define RULEXDB_UPDATE 1
 #define RULEXDB_CREATE 2
 
+/* Database open options (may be or'ed with the access mode) */
+#define RULEXDB_DFA 0x10 /* Match general rules by the deterministic automaton */
+#define RULEXDB_PRELOAD 0x20 /* Load and compile all rulesets at open time */
+#define RULEXDB_STATS 0x40 /* Collect rules matching statistics */
+#define RULEXDB_SHARED 0x80 /* Allow searching in parallel threads by sessions */
+
 /* Return codes */
 #define RULEXDB_SUCCESS 0
 #define RULEXDB_SPECIAL 1
@@ -96,9 +124,52 @@ BEGIN_C_DECLS
 #define RULEXDB_SEQ_PREV   3
 #define RULEXDB_SEQ_LAST   4
 
+/* Search stages reported by rulexdb_search_traced() */
+#define RULEXDB_STAGE_NONE -1
+#define RULEXDB_STAGE_EXCEPTIONS 0
+#define RULEXDB_STAGE_FORMS 1
+#define RULEXDB_STAGE_PREFIXES 2
+#define RULEXDB_STAGE_RULES 3
+#define RULEXDB_STAGE_CORRECTIONS 4
+#define RULEXDB_STAGES 5
+
+/* Maximum numbers of rules recorded in the search trace */
+#define RULEXDB_TRACE_PREFIXES 8
+#define RULEXDB_TRACE_CORRECTIONS 8
+
 
 /* Data structures */
 
+typedef struct /* Rule matching statistics */
+{
+  unsigned long attempts; /* Number of matching attempts */
+  unsigned long matches; /* Number of successful matches */
+  unsigned long long time; /* Total matching time in nanoseconds */
+} RULEXDB_RULE_STATS;
+
+typedef struct /* Search results cache statistics */
+{
+  unsigned long hits; /* Number of words found in the cache */
+  unsigned long misses; /* Number of words not found in the cache */
+  unsigned long evictions; /* Number of results replaced by others */
+  unsigned long invalidations; /* Number of cache clearings on writes */
+  int entries; /* Number of results currently cached */
+  int size; /* Maximum number of cached results */
+} RULEXDB_CACHE_STATS;
+
+typedef struct /* Search path of a word */
+{
+  int stage; /* Stage that produced the result or RULEXDB_STAGE_NONE */
+  int lexclass; /* Lexclasses rule giving the found lexical base or 0 */
+  int prefixes[RULEXDB_TRACE_PREFIXES]; /* Stripped prefixes rules */
+  int nprefixes; /* Number of stripped prefixes */
+  int rule; /* Applied general rule or 0 */
+  int corrections[RULEXDB_TRACE_CORRECTIONS]; /* Applied correction rules */
+  int ncorrections; /* Number of applied correction rules */
+  unsigned long long time[RULEXDB_STAGES]; /* Nanoseconds spent in every stage */
+  unsigned int probes[RULEXDB_STAGES]; /* Dictionary lookups in every stage */
+} RULEXDB_TRACE;
+
 typedef struct /* Ruleset handler */
 {
 #ifdef USE_BDB
@@ -107,15 +178,41 @@ typedef struct /* Ruleset handler */
 #else
   MDB_dbi dbi;
   int dbi_open;
-  char rule_buf[RULEXDB_BUFSIZE];
+  int format; /* Records ordering format (0 when not checked yet) */
+  unsigned int *keys; /* Records keys in the rules order if loaded */
+  unsigned int nkeys; /* Number of the loaded keys */
 #endif
+  char rule_buf[RULEXDB_BUFSIZE];
   const char *db_name; /* Dataset name */
+  const void *list; /* Rules list of the compiled lexicon file */
+#ifdef USE_PCRE2
+  pcre2_code **pattern; /* Array of compiled patterns */
+  pcre2_match_data *match_data; /* Match results shared by all the rules */
+#else
   regex_t **pattern; /* Array of compiled patterns */
+#endif
+  struct RULEX_BITMATCH **bitmatch; /* Array of bit-parallel matchers */
+  const void *image; /* Precompiled form of the ruleset */
+  size_t image_size; /* Size of the precompiled form */
+  void *image_buf; /* Memory allocated for the precompiled form if any */
   char **replacement; /* Array of replacement strings */
   int nrules; /* Number of rules in the ruleset */
+  struct RULEX_DFA *dfa; /* Combined automaton for all the patterns */
+  struct RULEX_SUFFIX *suffix; /* Index of the rules by their tails */
+  struct RULEX_PREFIX *prefix; /* Trie of the prefixes matched by the rules */
+  long load_time; /* Time spent for loading the ruleset (microseconds) */
+  RULEXDB_RULE_STATS *stats; /* Matching statistics for every rule if any */
 } RULEX_RULESET;
 
-typedef struct /* Lexical database handler */
+typedef struct /* Data derived from the database and stored along with it */
+{
+  const void *image; /* Data image or NULL if it is absent or stale */
+  size_t size; /* Size of the data image */
+  void *buf; /* Memory allocated for the data image if any */
+  int checked; /* The stored data were looked for (or dropped) */
+} RULEX_IMAGE;
+
+typedef struct RULEXDB /* Lexical database handler */
 {
   RULEX_RULESET rules; /* General rules */
   RULEX_RULESET lexclasses; /* Lexical class defining rules */
@@ -135,9 +232,37 @@ typedef struct /* Lexical database handler */
   MDB_env *env;
   MDB_txn *txn;
 #endif
+#ifdef USE_PCRE2
+  pcre2_compile_context *pcre2_context; /* Rule patterns compiling context */
+  const unsigned char *pcre2_tables; /* Locale specific character tables */
+#endif
+  RULEX_IMAGE lexicon_filter; /* Filter of the lexical bases keys */
+  RULEX_IMAGE exceptions_filter; /* Filter of the exceptions keys */
+  RULEX_IMAGE lexicon_fst; /* Transducer of the lexical bases dictionary */
+  RULEX_IMAGE exceptions_fst; /* Transducer of the exceptions dictionary */
+  RULEX_IMAGE frozen; /* Frozen search results table */
+  unsigned int generation[3]; /* Dictionaries and rules modification counters */
+  int generation_known; /* The counters have been read already */
+  int generation_bumped; /* Counters bumped by this handler (bit mask) */
+  RULEX_IMAGE lexfile; /* Compiled lexicon file if it is opened instead */
+  size_t lexfile_seq[2]; /* Sequential access positions in its dictionaries */
+  const struct RULEX_KEYCODER *keycoder; /* Dictionary keys packing format */
   int mode; /* Access mode */
+  int options; /* Open options */
+  struct RULEXDB *shared; /* Shared handler if this one is a session */
+  struct RULEX_CACHE *cache; /* Search results cache if enabled */
+  char scratch[RULEXDB_BUFSIZE]; /* Search result assembling area */
+  RULEXDB_TRACE *trace; /* Search path record if it is requested */
+  int trace_stage; /* Currently traced search stage */
+  unsigned long long trace_clock; /* Time when this stage was entered */
 } RULEXDB;
 
+typedef struct /* Lexical base found by rulexdb_lexbases() */
+{
+  int rule; /* Number of the matched lexclasses rule */
+  char base[RULEXDB_BUFSIZE]; /* Lexical base itself */
+} RULEXDB_BASE;
+
 
 /* Database access routines */
 
@@ -150,10 +275,38 @@ extern RULEXDB *rulexdb_open(const char *path, int mode);
  * but it allocates and initializes new RULEXDB structure
  * and opens the database environment. By the way
  * this routine checks accessibility of the database file.
+ * The compiled lexicon file made by rulexdb_compile()
+ * is recognized and opened in RULEXDB_SEARCH mode as well.
  *
  * Arguments description:
  * path - path to the database file;
  * mode - Access mode: RULEXDB_SEARCH, RULEXDB_UPDATE or RULEXDB_CREATE.
+ *        It may be or'ed with following options:
+ *        RULEXDB_DFA - match general rules by the combined deterministic
+ *        automaton instead of trying them one by one;
+ *        RULEXDB_PRELOAD - load all the rulesets at once, so no rule
+ *        is compiled while searching (for RULEXDB_SEARCH mode only);
+ *        RULEXDB_STATS - collect matching statistics for every rule;
+ *        RULEXDB_SHARED - prepare the handler to be shared by parallel
+ *        threads through sessions (for RULEXDB_SEARCH mode only,
+ *        implies RULEXDB_PRELOAD).
+ *
+ * Returns pointer to the new RULEXDB structure when success
+ * or NULL otherwise.
+ */
+
+extern RULEXDB *rulexdb_session(RULEXDB *rulexdb);
+/*
+ * Open new session for the database handler opened
+ * with RULEXDB_SHARED option.
+ *
+ * The session is a lightweight handler having its own
+ * read transaction and scratch buffers, while the datasets
+ * and loaded rulesets are shared with the origin one.
+ * Different sessions as well as the origin handler itself
+ * may be used in parallel threads. Every session must be closed
+ * by rulexdb_close() before closing the origin handler.
+ * Rules matching statistics are not collected through sessions.
  *
  * Returns pointer to the new RULEXDB structure when success
  * or NULL otherwise.
@@ -161,7 +314,7 @@ extern RULEXDB *rulexdb_open(const char *path, int mode);
 
 extern void rulexdb_close(RULEXDB *rulexdb);
 /*
- * Close lexical database and free all resources
+ * Close lexical database or session and free all resources
  * allocated for its sake.
  */
 
@@ -279,6 +432,37 @@ extern int rulexdb_lexbase(RULEXDB *rulexdb, const char *s, char *t, int n);
  * In the case of error an appropriate error code is returned.
  */
 
+extern int rulexdb_prefix(RULEXDB *rulexdb, const char *s, char *t,
+			  int *len, int n);
+/*
+ * Strip a prefix from the word.
+ *
+ * This routine scans prefixes ruleset beginning from n
+ * trying to match the beginning of the word pointed by s.
+ * When match succeeds leaving some part of the word unmatched,
+ * the word stem is constructed in memory area pointed by t,
+ * which must have enough space for it, the length of the stripped
+ * prefix is placed in the location pointed by len unless it is NULL,
+ * and the number of matched rule is returned. If no match has occurred
+ * 0 is returned. In the case of error an appropriate error code
+ * is returned.
+ */
+
+extern int rulexdb_lexbases(RULEXDB *rulexdb, const char *s,
+			    RULEXDB_BASE *bases, int size, int n);
+/*
+ * Find all lexical bases for the specified word in one pass.
+ *
+ * This routine scans lexclasses ruleset beginning from n
+ * and stores numbers of all rules matching the word pointed by s
+ * along with the lexical bases constructed by them in the array
+ * pointed by bases, which can hold up to size items. The items
+ * follow in the rules order. The number of stored items is returned.
+ * If it is equal to size, the scan may be continued from the rule
+ * following the last found one. In the case of error
+ * an appropriate error code is returned.
+ */
+
 extern int rulexdb_search(RULEXDB *rulexdb, const char * key, char *value, int flags);
 /*
  * Search lexical database for specified word.
@@ -322,6 +506,57 @@ extern int rulexdb_search(RULEXDB *rulexdb, const char * key, char *value, int f
  * should be performed.
  */
 
+extern int rulexdb_search_ex(RULEXDB *rulexdb, const char *key, char *value,
+			     int size, int *status, int flags);
+/*
+ * Search lexical database for specified word as rulexdb_search() does,
+ * but with the explicit capacity of the value buffer.
+ *
+ * The result is assembled in the scratch buffer of the handler
+ * (every session has its own one) unless the value buffer
+ * can hold RULEXDB_BUFSIZE bytes, and then no more than size - 1
+ * bytes of it are copied to the value buffer followed by a zero byte.
+ * The code rulexdb_search() would return (RULEXDB_SUCCESS
+ * or RULEXDB_SPECIAL) is placed in the location pointed by status
+ * unless it is NULL. No memory is allocated while searching.
+ *
+ * Returns the length of the result (so it was truncated
+ * if the value is not less than size) or negative error code.
+ */
+
+extern int rulexdb_search_traced(RULEXDB *rulexdb, const char *key,
+				 char *value, int flags, RULEXDB_TRACE *trace);
+/*
+ * Search lexical database for specified word as rulexdb_search() does
+ * and record the search path in the structure pointed by trace.
+ *
+ * The stage that produced the result is recorded along with the numbers
+ * (counting from 1) of the rules applied on the way: the lexclasses rule
+ * giving the found lexical base, the stripped prefixes rules, the general
+ * rule and the correction rules. When more rules are applied than
+ * the arrays can hold, only the first ones are recorded, but they all
+ * are counted. Time spent in every stage and the number of dictionary
+ * lookups it has made are recorded as well. The search results cache
+ * is not consulted here.
+ *
+ * Returns the same codes as rulexdb_search().
+ */
+
+extern int rulexdb_search_batch(RULEXDB *rulexdb, const char * const *keys,
+				char **values, int *results, int n, int flags);
+/*
+ * Search lexical database for several words at once.
+ *
+ * This routine does the same as rulexdb_search() called
+ * for every word keys[i] with the result placed in values[i]
+ * and the return code in results[i], but the dictionaries
+ * are looked up for all the words together walking them
+ * in the key order. Repeated words are searched only once.
+ * It is useful for processing a sentence or a whole document.
+ *
+ * Returns the number of processed words or negative error code.
+ */
+
 extern int rulexdb_seq(RULEXDB *rulexdb, char *key, char *value,
 		     int item_type, int mode);
 /*
@@ -408,6 +643,194 @@ extern int rulexdb_load_ruleset(RULEXDB *rulexdb, int rule_type);
  * (RULEXDB_RULE, RULEXDB_LEXCLASS, RULEXDB_PREFIX or RULEXDB_CORRECTOR).
  *
  * Loaded ruleset cannot be modified.
+ *
+ * The rules are fetched by a single pass over the dataset
+ * and compiled by several threads in parallel when possible.
+ */
+
+extern long rulexdb_load_time(RULEXDB *rulexdb, int rule_type);
+/*
+ * Get time spent for loading the ruleset.
+ *
+ * Returns time in microseconds spent by rulexdb_load_ruleset()
+ * or by rulexdb_open() with RULEXDB_PRELOAD option
+ * for specified ruleset, 0 if the ruleset was not loaded
+ * this way or negative error code.
+ */
+
+extern int rulexdb_ruleset_stats(RULEXDB *rulexdb, int rule_type,
+				 RULEXDB_RULE_STATS *stats, int size);
+/*
+ * Get rules matching statistics.
+ *
+ * This routine copies statistics collected for the rules
+ * of specified ruleset into the array pointed by stats,
+ * which must have space for size elements. The element i
+ * corresponds to the rule number i + 1. The statistics
+ * are collected only when the database is opened
+ * with RULEXDB_STATS option.
+ * Rule type specifies target ruleset
+ * (RULEXDB_RULE, RULEXDB_LEXCLASS, RULEXDB_PREFIX or RULEXDB_CORRECTOR).
+ *
+ * Returns number of rules in the ruleset or negative error code.
+ */
+
+extern int rulexdb_cache(RULEXDB *rulexdb, int size);
+/*
+ * Enable search results cache.
+ *
+ * This routine allocates the cache for up to size results
+ * of rulexdb_search() and rulexdb_search_batch() keyed
+ * by the word and search flags. When the cache is full,
+ * the least useful results are replaced by the CLOCK algorithm.
+ * Any change of the dictionaries or rules through this handler
+ * clears the cache. Previously enabled cache is dropped.
+ * Zero size disables the cache. Every session has its own cache.
+ *
+ * Note that the rules matching statistics are not collected
+ * for the words found in the cache.
+ *
+ * Returns 0 (RULEXDB_SUCCESS) on success or negative error code.
+ */
+
+extern int rulexdb_cache_stats(RULEXDB *rulexdb, RULEXDB_CACHE_STATS *stats);
+/*
+ * Get search results cache statistics.
+ *
+ * The counters are accumulated since the cache was enabled.
+ *
+ * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL
+ * when the cache is not enabled, or negative error code.
+ */
+
+extern int rulexdb_compile_ruleset(RULEXDB *rulexdb, int rule_type);
+/*
+ * Store precompiled form of the ruleset in the database.
+ *
+ * This routine compiles all the rules of specified ruleset
+ * that can be handled by the bit-parallel matcher and stores
+ * the result in the database, so the ruleset can be loaded
+ * without compiling later. The rules that cannot be precompiled
+ * are compiled when loading as usual. Stale precompiled rules
+ * are detected and ignored, so this routine should be called
+ * after modifying the ruleset only to keep loading fast.
+ * Rule type specifies target ruleset
+ * (RULEXDB_RULE, RULEXDB_LEXCLASS, RULEXDB_PREFIX or RULEXDB_CORRECTOR).
+ *
+ * Returns number of precompiled rules or negative error code.
+ */
+
+extern int rulexdb_build_filter(RULEXDB *rulexdb, int item_type);
+/*
+ * Store the keys membership filter of the dictionary in the database.
+ *
+ * The filter lets searching skip most of the dictionary lookups
+ * for absent words. It is used only when the database is opened
+ * for searching. Any change of the dictionary made by this library
+ * drops its filter, and a filter left stale by other means
+ * is ignored when the number of records differs, so this routine
+ * should be called after modifying the dictionary to keep
+ * searching fast.
+ * Item type specifies the dictionary
+ * (RULEXDB_EXCEPTION or RULEXDB_LEXBASE).
+ *
+ * Returns number of keys in the filter or negative error code.
+ */
+
+extern int rulexdb_freeze(RULEXDB *rulexdb, const char * const *words, int n);
+/*
+ * Store the frozen search results table in the database.
+ *
+ * The full search results are computed for all the keys
+ * of both dictionaries and for n words from the array pointed
+ * by words (it may be NULL if n is 0), so they are found
+ * by a single hash lookup afterwards. The table is consulted
+ * only for the full search when the database is opened
+ * for searching without collecting rules statistics.
+ * The words absent in it are searched as usual.
+ * Any change of the dictionaries or rules made by this library
+ * drops the table, and a table left stale by other means
+ * is ignored when the number of dictionaries records differs.
+ *
+ * Returns number of words in the table or negative error code.
+ */
+
+extern int rulexdb_compile(RULEXDB *rulexdb, const char *path);
+/*
+ * Write the compiled lexicon file.
+ *
+ * The file holds both dictionaries addressed by the minimal
+ * perfect hash functions, all the rulesets and their precompiled
+ * forms found in the database. It is never modified, but
+ * it can be opened by rulexdb_open() for searching instead
+ * of the database itself, so the dictionaries are looked up
+ * in the mapped file directly without any transaction.
+ * The precompiled rulesets are taken only when the database
+ * is opened for searching.
+ *
+ * Returns number of the dictionaries records stored in the file
+ * or negative error code.
+ */
+
+extern int rulexdb_build_fst(RULEXDB *rulexdb, int item_type);
+/*
+ * Store the dictionary transducer in the database.
+ *
+ * The whole dictionary is compiled into the minimal finite-state
+ * transducer mapping every word to its packed value. It is small
+ * enough to be kept in memory, so the dictionary is looked up
+ * there instead of the database when it is opened for searching.
+ * The transducer also allows listing the words by prefix
+ * via rulexdb_enumerate(). Any change of the dictionary made
+ * by this library drops its transducer, and a transducer left stale
+ * by other means is ignored when the number of records differs.
+ * Item type specifies the dictionary
+ * (RULEXDB_EXCEPTION or RULEXDB_LEXBASE).
+ *
+ * Returns number of words in the transducer or negative error code.
+ */
+
+extern int rulexdb_enumerate(RULEXDB *rulexdb, const char *prefix,
+			     char *key, char *value, int item_type, int n);
+/*
+ * Fetch the dictionary record by prefix.
+ *
+ * This routine fetches the record number n (counting from 0)
+ * among the records which keys begin with the string pointed
+ * by prefix (it may be empty) in the keys order. Arguments key
+ * and value must point to the buffers with enough space
+ * for retrieved data. The dictionary is specified by item_type
+ * as for rulexdb_seq(). Its transducer stored by rulexdb_build_fst()
+ * is used, so the database must be opened for searching.
+ *
+ * Returns 0 (RULEXDB_SUCCESS) on success, RULEXDB_SPECIAL when
+ * there are no more records with this prefix, RULEXDB_EACCESS
+ * when the dictionary transducer is not available,
+ * or an appropriate error code in the case of other failure.
+ */
+
+extern int rulexdb_reorder_ruleset(RULEXDB *rulexdb, int rule_type,
+				   const unsigned long *weights, int size);
+/*
+ * Reorder rules by their weights preserving search results.
+ *
+ * This routine rearranges the rules of specified ruleset,
+ * so the rules with greater weights are tried earlier.
+ * Two rules may change their relative order only when
+ * it is proven that no word can be matched by both of them.
+ * The rules which patterns cannot be analyzed keep their
+ * relative order with respect to all other rules.
+ *
+ * The array pointed by weights contains size elements.
+ * The element i corresponds to the rule number i + 1.
+ * Missing weights are treated as zero.
+ * Rule type specifies target ruleset
+ * (RULEXDB_RULE, RULEXDB_LEXCLASS or RULEXDB_PREFIX).
+ * Correction rules are applied one after another,
+ * so their order always matters.
+ *
+ * Returns number of rules that have changed their positions
+ * or negative error code.
  */
 
 extern int rulexdb_discard_ruleset(RULEXDB *rulexdb, int rule_type);
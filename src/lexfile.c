@@ -0,0 +1,703 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Compiled lexicon file implementation.
+ *
+ * The file begins with the header followed by the sections
+ * directory. Every section is aligned at 8 bytes boundary.
+ *
+ * The dictionary table consists of the header, the pilots array,
+ * the slots array and the records area. The keys are distributed
+ * among the buckets by their hash values, and every bucket
+ * has its pilot chosen when building the table, so the keys
+ * of all the buckets are mapped to distinct slots. The buckets
+ * are processed in the order of decreasing size, so the large
+ * ones are placed while most of the slots are still free.
+ * There are as many slots as the keys, so the hash function
+ * is minimal and perfect.
+ *
+ * Every record holds the packed key length and the value size
+ * both before and after the key and value themselves,
+ * so the records can be walked in either direction.
+ *
+ * The rules list consists of the strings number followed
+ * by their offsets array and the zero terminated strings.
+ */
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lexfile.h"
+
+
+/* Local constants */
+
+/* File image format stamp */
+#define LEXFILE_MAGIC 0x52554c43
+#define LEXFILE_VERSION 1
+
+/*
+ * Number of sections in the files written before the keys
+ * format section was added. Such files are still accepted,
+ * and the missing sections are treated as empty ones.
+ */
+#define ORIGINAL_SECTIONS 10
+
+/* Dictionary table format stamp */
+#define TABLE_MAGIC 0x52554c48
+
+/* Average number of keys in a bucket */
+#define BUCKET_LOAD 4
+
+/* Number of hash functions tried when building the table */
+#define MAX_SEEDS 16
+
+/* Number of pilots tried for a bucket */
+#define MAX_PILOTS 0x1000000
+
+/* Maximum packed key length and value size */
+#define MAX_FIELD 0xff
+
+/* Record size besides the key and value themselves */
+#define RECORD_OVERHEAD 4
+
+
+/* Data structures */
+
+typedef struct /* File image header */
+{
+  uint32_t magic; /* LEXFILE_MAGIC */
+  uint32_t version; /* LEXFILE_VERSION */
+  uint32_t nsections; /* LEXFILE_SECTIONS or ORIGINAL_SECTIONS */
+  uint32_t reserved;
+} HEADER;
+
+typedef struct /* Sections directory entry */
+{
+  uint32_t offset; /* Section offset from the file beginning */
+  uint32_t size; /* Section size or 0 if it is empty */
+} SECTION;
+
+typedef struct /* Dictionary table header */
+{
+  uint32_t magic; /* TABLE_MAGIC */
+  uint32_t nkeys; /* Number of the keys (and the slots) */
+  uint32_t nbuckets; /* Number of the buckets (and the pilots) */
+  uint32_t seed; /* Hash function seed */
+  uint32_t records_size; /* Size of the records area */
+  uint32_t reserved;
+} TABLE;
+
+typedef struct /* Dictionary table slot */
+{
+  uint32_t fingerprint; /* Low bits of the key hash value */
+  uint32_t offset; /* Record offset in the records area */
+} SLOT;
+
+
+/* Local routines */
+
+static size_t align(size_t size)
+     /*
+      * Round the size up to 8 bytes boundary.
+      */
+{
+  return (size + 7) & ~(size_t)7;
+}
+
+static uint64_t mix(uint64_t h)
+     /*
+      * Scramble the bits of the hash value.
+      */
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+static uint64_t hash(const char *key, unsigned int keylen, uint32_t seed)
+     /*
+      * Compute the seeded hash value of the packed key
+      * (64-bit FNV-1a with the bits scrambled).
+      */
+{
+  uint64_t h = 14695981039346656037ULL ^ seed;
+
+  while (keylen--)
+    h = (h ^ (unsigned char)*key++) * 1099511628211ULL;
+  return mix(h);
+}
+
+static uint32_t bucket(uint64_t h, uint32_t nbuckets)
+     /*
+      * Get the bucket of the key by its hash value.
+      */
+{
+  return (uint32_t)(((h >> 32) * nbuckets) >> 32);
+}
+
+static uint32_t place(uint64_t h, uint32_t pilot, uint32_t nkeys)
+     /*
+      * Get the slot of the key by its hash value
+      * and the pilot of its bucket.
+      */
+{
+  h = mix(h ^ (pilot * 0x9e3779b97f4a7c15ULL));
+  return (uint32_t)(((h & 0xffffffffU) * nkeys) >> 32);
+}
+
+static void table_get(const void *image, TABLE *table)
+     /*
+      * Fetch the table header from possibly misaligned image.
+      */
+{
+  (void)memcpy(table, image, sizeof(TABLE));
+}
+
+static const unsigned char *records_ptr(const void *image,
+                                        const TABLE *table)
+     /*
+      * Get pointer to the records area of the table.
+      */
+{
+  return (const unsigned char *)image + sizeof(TABLE)
+    + (size_t)table->nbuckets * sizeof(uint32_t)
+    + (size_t)table->nkeys * sizeof(SLOT);
+}
+
+static int record_get(const void *image, const TABLE *table,
+                      uint32_t offset, LEXFILE_RECORD *record)
+     /*
+      * Fetch the record at specified offset of the records area.
+      * Returns 1 on success or 0 if the record does not fit in.
+      */
+{
+  const unsigned char *p = records_ptr(image, table) + offset;
+
+  if ((offset >= table->records_size) ||
+      (table->records_size - offset < RECORD_OVERHEAD))
+    return 0;
+  record->keylen = p[0];
+  record->size = p[1];
+  if (table->records_size - offset - RECORD_OVERHEAD
+      < record->keylen + record->size)
+    return 0;
+  record->key = (const char *)p + 2;
+  record->value = record->key + record->keylen;
+  return 1;
+}
+
+static int table_valid(const void *image, size_t size)
+     /*
+      * Check the format of the dictionary table of specified size.
+      */
+{
+  TABLE table;
+
+  if (size < sizeof(TABLE))
+    return 0;
+  table_get(image, &table);
+  if ((table.magic != TABLE_MAGIC) ||
+      (table.nbuckets != table.nkeys / BUCKET_LOAD + 1))
+    return 0;
+  size -= sizeof(TABLE);
+  if (size / sizeof(uint32_t) < table.nbuckets)
+    return 0;
+  size -= (size_t)table.nbuckets * sizeof(uint32_t);
+  if (size / sizeof(SLOT) < table.nkeys)
+    return 0;
+  size -= (size_t)table.nkeys * sizeof(SLOT);
+  return size == table.records_size;
+}
+
+static int list_valid(const void *image, size_t size)
+     /*
+      * Check the format of the rules list of specified size.
+      */
+{
+  uint32_t n, i, offset;
+  const char *p = image;
+
+  if (size < sizeof(uint32_t))
+    return 0;
+  (void)memcpy(&n, p, sizeof(uint32_t));
+  if ((size / sizeof(uint32_t) <= n) ||
+      (n && p[size - 1]))
+    return 0;
+  for (i = 1; i <= n; i++)
+    {
+      (void)memcpy(&offset, p + i * sizeof(uint32_t), sizeof(uint32_t));
+      if ((offset < (n + 1) * sizeof(uint32_t)) || (offset >= size))
+        return 0;
+    }
+  return 1;
+}
+
+static int table_hash(const uint64_t *hashes, unsigned int n,
+                      uint32_t nbuckets, uint32_t *pilots, uint32_t *slots)
+     /*
+      * Find the pilots mapping the keys having specified hash values
+      * to distinct slots. The slot of every key is placed
+      * in the slots array.
+      *
+      * Returns 0 on success, 1 if no suitable pilots are found
+      * or -1 when memory allocation fails.
+      */
+{
+  uint32_t *count, *order, *start, *keys, *taken;
+  uint32_t i, j, k, m, b, pilot, size;
+  int rc = 0;
+
+  count = calloc(n + nbuckets + 1, sizeof(uint32_t));
+  start = calloc(nbuckets + 1, sizeof(uint32_t));
+  order = malloc(nbuckets * sizeof(uint32_t));
+  keys = malloc(n * sizeof(uint32_t));
+  taken = calloc(n / 32 + 1, sizeof(uint32_t));
+  if (!(count && start && order && keys && taken))
+    {
+      free(taken);
+      free(keys);
+      free(order);
+      free(start);
+      free(count);
+      return -1;
+    }
+
+  /* Group the keys by the buckets */
+  for (i = 0; i < n; i++)
+    count[bucket(hashes[i], nbuckets)]++;
+  for (b = 0; b < nbuckets; b++)
+    start[b + 1] = start[b] + count[b];
+  for (i = 0; i < n; i++)
+    {
+      b = bucket(hashes[i], nbuckets);
+      keys[start[b] + --count[b]] = i;
+    }
+
+  /* Order the buckets by decreasing size */
+  size = 0;
+  for (b = 0; b < nbuckets; b++)
+    {
+      k = start[b + 1] - start[b];
+      if (size < k)
+        size = k;
+      count[k]++;
+    }
+  for (k = size, j = 0; k > 0; k--)
+    {
+      i = count[k];
+      count[k] = j;
+      j += i;
+    }
+  for (b = 0, m = 0; b < nbuckets; b++)
+    {
+      k = start[b + 1] - start[b];
+      pilots[b] = 0;
+      if (k)
+        {
+          order[count[k]++] = b;
+          m++;
+        }
+    }
+
+  /* Choose the pilots */
+  for (j = 0; (j < m) && !rc; j++)
+    {
+      b = order[j];
+      for (pilot = 0; pilot < MAX_PILOTS; pilot++)
+        {
+          for (i = start[b]; i < start[b + 1]; i++)
+            {
+              slots[keys[i]] = place(hashes[keys[i]], pilot, n);
+              if (taken[slots[keys[i]] / 32] &
+                  (1U << (slots[keys[i]] % 32)))
+                break;
+              for (k = start[b]; k < i; k++)
+                if (slots[keys[k]] == slots[keys[i]])
+                  break;
+              if (k < i)
+                break;
+            }
+          if (i == start[b + 1])
+            break;
+        }
+      if (pilot == MAX_PILOTS)
+        rc = 1;
+      else
+        {
+          pilots[b] = pilot;
+          for (i = start[b]; i < start[b + 1]; i++)
+            taken[slots[keys[i]] / 32] |= 1U << (slots[keys[i]] % 32);
+        }
+    }
+
+  free(taken);
+  free(keys);
+  free(order);
+  free(start);
+  free(count);
+  return rc;
+}
+
+
+/* Global routines */
+
+size_t lexfile_size(const size_t *sizes)
+     /*
+      * Get the file image size for the sections of specified sizes.
+      */
+{
+  size_t size = align(sizeof(HEADER) + LEXFILE_SECTIONS * sizeof(SECTION));
+  int i;
+
+  for (i = 0; i < LEXFILE_SECTIONS; i++)
+    size += align(sizes[i]);
+  return size;
+}
+
+void lexfile_init(void *image, const void * const *sections,
+                  const size_t *sizes)
+     /*
+      * Assemble the file image.
+      */
+{
+  HEADER header;
+  SECTION section;
+  size_t offset = align(sizeof(HEADER) + LEXFILE_SECTIONS * sizeof(SECTION));
+  char *p = image;
+  int i;
+
+  header.magic = LEXFILE_MAGIC;
+  header.version = LEXFILE_VERSION;
+  header.nsections = LEXFILE_SECTIONS;
+  header.reserved = 0;
+  (void)memset(image, 0, lexfile_size(sizes));
+  (void)memcpy(p, &header, sizeof(HEADER));
+  for (i = 0; i < LEXFILE_SECTIONS; i++)
+    {
+      section.offset = sizes[i] ? offset : 0;
+      section.size = sizes[i];
+      (void)memcpy(p + sizeof(HEADER) + i * sizeof(SECTION),
+                   &section, sizeof(SECTION));
+      if (sizes[i])
+        (void)memcpy(p + offset, sections[i], sizes[i]);
+      offset += align(sizes[i]);
+    }
+}
+
+int lexfile_valid(const void *image, size_t size)
+     /*
+      * Check the format of the file image. The dictionaries
+      * and rules lists are checked as well.
+      */
+{
+  HEADER header;
+  SECTION section;
+  const char *p = image;
+  int i;
+
+  if ((!image) || (size < sizeof(HEADER)))
+    return 0;
+  (void)memcpy(&header, p, sizeof(HEADER));
+  if ((header.magic != LEXFILE_MAGIC) ||
+      (header.version != LEXFILE_VERSION) ||
+      (header.nsections < ORIGINAL_SECTIONS) ||
+      (header.nsections > LEXFILE_SECTIONS) ||
+      (size < sizeof(HEADER) + header.nsections * sizeof(SECTION)))
+    return 0;
+  for (i = 0; i < (int)header.nsections; i++)
+    {
+      (void)memcpy(&section, p + sizeof(HEADER) + i * sizeof(SECTION),
+                   sizeof(SECTION));
+      if ((section.offset > size) || (section.size > size - section.offset))
+        return 0;
+      if (!section.size)
+        continue;
+      if ((i <= LEXFILE_LEXBASES) ?
+          !table_valid(p + section.offset, section.size) :
+          ((i < LEXFILE_IMAGES) &&
+           !list_valid(p + section.offset, section.size)))
+        return 0;
+    }
+  return 1;
+}
+
+const void *lexfile_section(const void *image, int n, size_t *size)
+     /*
+      * Get the section of the file image.
+      */
+{
+  HEADER header;
+  SECTION section;
+
+  (void)memcpy(&header, image, sizeof(HEADER));
+  if ((unsigned int)n >= header.nsections)
+    {
+      *size = 0;
+      return NULL;
+    }
+  (void)memcpy(&section, (const char *)image + sizeof(HEADER)
+               + n * sizeof(SECTION), sizeof(SECTION));
+  *size = section.size;
+  return section.size ? (const char *)image + section.offset : NULL;
+}
+
+size_t lexfile_table_size(const LEXFILE_RECORD *records, unsigned int n)
+     /*
+      * Get the dictionary table size for n records.
+      */
+{
+  size_t size = sizeof(TABLE) + (n / BUCKET_LOAD + 1) * sizeof(uint32_t)
+    + (size_t)n * sizeof(SLOT);
+  unsigned int i;
+
+  for (i = 0; i < n; i++)
+    {
+      if ((records[i].keylen > MAX_FIELD) || (records[i].size > MAX_FIELD))
+        return 0;
+      size += RECORD_OVERHEAD + records[i].keylen + records[i].size;
+    }
+  return size;
+}
+
+int lexfile_table_build(void *image, const LEXFILE_RECORD *records,
+                        unsigned int n)
+     /*
+      * Build the dictionary table of n records.
+      */
+{
+  TABLE table;
+  SLOT slot;
+  uint64_t *hashes;
+  uint32_t *pilots, *slots;
+  unsigned char *p;
+  unsigned int i;
+  int rc = 1;
+
+  table.magic = TABLE_MAGIC;
+  table.nkeys = n;
+  table.nbuckets = n / BUCKET_LOAD + 1;
+  table.seed = 0;
+  table.records_size = 0;
+  table.reserved = 0;
+  for (i = 0; i < n; i++)
+    table.records_size += RECORD_OVERHEAD
+      + records[i].keylen + records[i].size;
+
+  /* Find the perfect hash function */
+  hashes = malloc((n + 1) * sizeof(uint64_t));
+  pilots = malloc(table.nbuckets * sizeof(uint32_t));
+  slots = malloc((n + 1) * sizeof(uint32_t));
+  if (hashes && pilots && slots)
+    for (table.seed = 0; (rc > 0) && (table.seed < MAX_SEEDS); table.seed++)
+      {
+        for (i = 0; i < n; i++)
+          hashes[i] = hash(records[i].key, records[i].keylen, table.seed);
+        rc = table_hash(hashes, n, table.nbuckets, pilots, slots);
+        if (!rc)
+          break;
+      }
+  else rc = -1;
+  if (rc)
+    {
+      free(slots);
+      free(pilots);
+      free(hashes);
+      return -1;
+    }
+
+  /* Store it along with the records */
+  p = image;
+  (void)memcpy(p, &table, sizeof(TABLE));
+  p += sizeof(TABLE);
+  (void)memcpy(p, pilots, table.nbuckets * sizeof(uint32_t));
+  p += table.nbuckets * sizeof(uint32_t);
+  slot.offset = 0;
+  for (i = 0; i < n; i++)
+    {
+      slot.fingerprint = (uint32_t)hashes[i];
+      (void)memcpy(p + (size_t)slots[i] * sizeof(SLOT), &slot, sizeof(SLOT));
+      slot.offset += RECORD_OVERHEAD + records[i].keylen + records[i].size;
+    }
+  p += (size_t)n * sizeof(SLOT);
+  for (i = 0; i < n; i++)
+    {
+      *p++ = (unsigned char)records[i].keylen;
+      *p++ = (unsigned char)records[i].size;
+      (void)memcpy(p, records[i].key, records[i].keylen);
+      p += records[i].keylen;
+      (void)memcpy(p, records[i].value, records[i].size);
+      p += records[i].size;
+      *p++ = (unsigned char)records[i].keylen;
+      *p++ = (unsigned char)records[i].size;
+    }
+  free(slots);
+  free(pilots);
+  free(hashes);
+  return 0;
+}
+
+unsigned int lexfile_table_keys(const void *image)
+     /*
+      * Get the number of records in the dictionary table.
+      */
+{
+  TABLE table;
+
+  table_get(image, &table);
+  return table.nkeys;
+}
+
+int lexfile_table_get(const void *image, const char *key,
+                      unsigned int keylen, LEXFILE_RECORD *record)
+     /*
+      * Look up the packed key in the dictionary table.
+      */
+{
+  TABLE table;
+  SLOT slot;
+  uint64_t h;
+  uint32_t pilot;
+  const char *p = image;
+
+  table_get(image, &table);
+  if (!table.nkeys)
+    return 0;
+  h = hash(key, keylen, table.seed);
+  (void)memcpy(&pilot, p + sizeof(TABLE)
+               + bucket(h, table.nbuckets) * sizeof(uint32_t),
+               sizeof(uint32_t));
+  (void)memcpy(&slot, p + sizeof(TABLE)
+               + (size_t)table.nbuckets * sizeof(uint32_t)
+               + (size_t)place(h, pilot, table.nkeys) * sizeof(SLOT),
+               sizeof(SLOT));
+  return (slot.fingerprint == (uint32_t)h) &&
+    record_get(image, &table, slot.offset, record) &&
+    (record->keylen == keylen) && !memcmp(record->key, key, keylen);
+}
+
+int lexfile_table_step(const void *image, size_t *position,
+                       int direction, LEXFILE_RECORD *record)
+     /*
+      * Fetch the dictionary record in the keys order.
+      * The position holds the current record offset
+      * increased by 1 or 0 if there is no current record.
+      */
+{
+  TABLE table;
+  const unsigned char *records;
+  size_t offset;
+
+  table_get(image, &table);
+  if (!table.nkeys)
+    return 0;
+  records = records_ptr(image, &table);
+  if ((direction == LEXFILE_NEXT) && !*position)
+    direction = LEXFILE_FIRST;
+  else if ((direction == LEXFILE_PREV) && !*position)
+    direction = LEXFILE_LAST;
+  switch (direction)
+    {
+      case LEXFILE_FIRST:
+        offset = 0;
+        break;
+      case LEXFILE_LAST:
+        offset = table.records_size;
+        /* Fall through */
+      case LEXFILE_PREV:
+        if (direction == LEXFILE_PREV)
+          offset = *position - 1;
+        if (offset < RECORD_OVERHEAD)
+          return 0;
+        offset -= RECORD_OVERHEAD + records[offset - 2] + records[offset - 1];
+        break;
+      case LEXFILE_NEXT:
+        offset = *position - 1;
+        offset += RECORD_OVERHEAD + records[offset] + records[offset + 1];
+        break;
+      default:
+        return 0;
+    }
+  if ((offset > table.records_size) ||
+      !record_get(image, &table, (uint32_t)offset, record))
+    return 0;
+  *position = offset + 1;
+  return 1;
+}
+
+size_t lexfile_list_size(const char * const *strings, unsigned int n)
+     /*
+      * Get the list size for n strings.
+      */
+{
+  size_t size = (n + 1) * sizeof(uint32_t);
+  unsigned int i;
+
+  for (i = 0; i < n; i++)
+    size += strlen(strings[i]) + 1;
+  return size;
+}
+
+void lexfile_list_build(void *image, const char * const *strings,
+                        unsigned int n)
+     /*
+      * Store n strings.
+      */
+{
+  char *p = image;
+  uint32_t i, count = n, offset = (n + 1) * sizeof(uint32_t);
+  size_t len;
+
+  (void)memcpy(p, &count, sizeof(uint32_t));
+  for (i = 0; i < n; i++)
+    {
+      (void)memcpy(p + (i + 1) * sizeof(uint32_t), &offset, sizeof(uint32_t));
+      len = strlen(strings[i]) + 1;
+      (void)memcpy(p + offset, strings[i], len);
+      offset += len;
+    }
+}
+
+unsigned int lexfile_list_count(const void *image)
+     /*
+      * Get the number of strings in the list.
+      */
+{
+  uint32_t n;
+
+  (void)memcpy(&n, image, sizeof(uint32_t));
+  return n;
+}
+
+const char *lexfile_list_get(const void *image, unsigned int n)
+     /*
+      * Get the string number n of the list.
+      */
+{
+  uint32_t offset;
+
+  (void)memcpy(&offset, (const char *)image + (n + 1) * sizeof(uint32_t),
+               sizeof(uint32_t));
+  return (const char *)image + offset;
+}
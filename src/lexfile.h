@@ -0,0 +1,179 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Compiled lexicon file.
+ *
+ * A database deployed for searching only does not need
+ * the B-trees suitable for editing. The compiled lexicon is
+ * a single immutable file holding everything the search needs:
+ * both dictionaries, the rules sources and the precompiled rulesets.
+ * It is mapped into memory and used in place without decoding.
+ *
+ * Every dictionary is stored as a table addressed by the minimal
+ * perfect hash function over the packed keys. The slot of a key
+ * holds its fingerprint and the offset of the record with the key
+ * and value exactly as they are stored in the database, so a lookup
+ * takes the slot and, unless the fingerprint rejects the key,
+ * the record itself. The records are kept in the keys order
+ * to allow sequential access.
+ */
+
+
+#ifndef LEXFILE_H
+#define LEXFILE_H
+
+#include <stddef.h>
+
+/* BEGIN_C_DECLS should be used at the beginning of C declarations,
+   so that C++ compilers don't mangle their names.  Use END_C_DECLS at
+   the end of C declarations. */
+#undef BEGIN_C_DECLS
+#undef END_C_DECLS
+#ifdef __cplusplus
+# define BEGIN_C_DECLS extern "C" {
+# define END_C_DECLS }
+#else
+# define BEGIN_C_DECLS /* empty */
+# define END_C_DECLS /* empty */
+#endif
+
+BEGIN_C_DECLS
+
+/* Sections of the file */
+#define LEXFILE_EXCEPTIONS 0 /* Exceptions dictionary table */
+#define LEXFILE_LEXBASES 1 /* Lexical bases dictionary table */
+#define LEXFILE_RULES 2 /* General rules list */
+#define LEXFILE_LEXCLASSES 3 /* Lexical classification rules list */
+#define LEXFILE_PREFIXES 4 /* Prefix detection rules list */
+#define LEXFILE_CORRECTIONS 5 /* Correction rules list */
+#define LEXFILE_IMAGES 6 /* Precompiled rulesets in the same order */
+#define LEXFILE_KEYS_FORMAT 10 /* Dictionary keys packing format and model */
+#define LEXFILE_SECTIONS 11
+
+/* Directions of the dictionary records walk */
+#define LEXFILE_FIRST 1
+#define LEXFILE_NEXT 2
+#define LEXFILE_PREV 3
+#define LEXFILE_LAST 4
+
+typedef struct /* Dictionary record */
+{
+  const char *key; /* Packed key */
+  unsigned int keylen; /* Packed key length */
+  const char *value; /* Packed value */
+  unsigned int size; /* Packed value size */
+} LEXFILE_RECORD;
+
+
+extern size_t lexfile_size(const size_t *sizes);
+/*
+ * Get the file image size for the sections of specified sizes.
+ * The sizes array holds LEXFILE_SECTIONS elements.
+ */
+
+extern void lexfile_init(void *image, const void * const *sections,
+                         const size_t *sizes);
+/*
+ * Assemble the file image in the memory area of the size
+ * obtained by lexfile_size() from the sections data and sizes.
+ * Empty sections may be specified by NULL pointers.
+ */
+
+extern int lexfile_valid(const void *image, size_t size);
+/*
+ * Check the format of the file image of specified size.
+ * Returns 1 if it can be used or 0 otherwise.
+ */
+
+extern const void *lexfile_section(const void *image, int n, size_t *size);
+/*
+ * Get the section number n of the file image. Its size
+ * is placed in the location pointed by size.
+ * Returns NULL if the section is empty or the file
+ * was written before such sections were introduced.
+ */
+
+extern size_t lexfile_table_size(const LEXFILE_RECORD *records,
+                                 unsigned int n);
+/*
+ * Get the dictionary table size for n records.
+ * Returns 0 if some record is too long to be stored.
+ */
+
+extern int lexfile_table_build(void *image, const LEXFILE_RECORD *records,
+                               unsigned int n);
+/*
+ * Build the dictionary table of n records in the memory area
+ * of the size obtained by lexfile_table_size(). The records
+ * must be sorted by their keys, and the keys must be distinct.
+ *
+ * Returns 0 on success or -1 when memory allocation fails
+ * or no perfect hash function is found.
+ */
+
+extern unsigned int lexfile_table_keys(const void *image);
+/*
+ * Get the number of records in the dictionary table.
+ */
+
+extern int lexfile_table_get(const void *image, const char *key,
+                             unsigned int keylen, LEXFILE_RECORD *record);
+/*
+ * Look up the packed key in the dictionary table. If found,
+ * the record is placed in the location pointed by record.
+ * Returns 1 if the key is found or 0 otherwise.
+ */
+
+extern int lexfile_table_step(const void *image, size_t *position,
+                              int direction, LEXFILE_RECORD *record);
+/*
+ * Fetch the dictionary record in the keys order. The location
+ * pointed by position holds the current place of the walk
+ * and must be zeroed at the beginning. The direction is
+ * LEXFILE_FIRST, LEXFILE_NEXT, LEXFILE_PREV or LEXFILE_LAST.
+ * Returns 1 when the record is fetched or 0 when there is
+ * no more records in this direction.
+ */
+
+extern size_t lexfile_list_size(const char * const *strings, unsigned int n);
+/*
+ * Get the list size for n strings.
+ */
+
+extern void lexfile_list_build(void *image, const char * const *strings,
+                               unsigned int n);
+/*
+ * Store n strings in the memory area of the size
+ * obtained by lexfile_list_size().
+ */
+
+extern unsigned int lexfile_list_count(const void *image);
+/*
+ * Get the number of strings in the list.
+ */
+
+extern const char *lexfile_list_get(const void *image, unsigned int n);
+/*
+ * Get the string number n (counting from 0) of the list.
+ */
+
+END_C_DECLS
+
+#endif
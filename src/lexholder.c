@@ -30,6 +30,52 @@
 #define CS_CONFLICT 1
 #define NO_DB_FILE 2
 
+/* Number of lexical bases acquired at once */
+#define BASES_CHUNK 16
+
+/* Maximum number of prefixes stripped from a word */
+#define MAX_PREFIXES 8
+
+/* Initial number of corpus words storage slots */
+#define CORPUS_CHUNK 1024
+
+/* All the rulesets */
+#define NRULESETS 4
+static const int rulesets[NRULESETS] =
+  {
+    RULEXDB_RULE,
+    RULEXDB_LEXCLASS,
+    RULEXDB_PREFIX,
+    RULEXDB_CORRECTOR
+  };
+
+/* All the dictionaries */
+#define NDICTIONARIES 2
+static const int dictionaries[NDICTIONARIES] =
+  {
+    RULEXDB_EXCEPTION,
+    RULEXDB_LEXBASE
+  };
+
+/* Search stages names */
+static const char *stages[RULEXDB_STAGES] =
+  {
+    "Explicit dictionary",
+    "Implicit form",
+    "Prefix detection",
+    "General rules",
+    "Correction"
+  };
+
+
+typedef struct /* Sample corpus word */
+{
+  char *key; /* The word itself */
+  char *value; /* Its search result */
+  int rc; /* Search return code */
+  unsigned long count; /* Number of occurrences */
+} CORPUS_WORD;
+
 
 #ifdef _WIN32
 static const char *charset = "Russian_Russia.20866";
@@ -61,9 +107,16 @@ static const char *usage =
 
 "-h -- Print this help (the only option not requiring the database path)\n"
 "-l -- List database content\n"
+"-p <prefix> -- List dictionary records with keys starting by specified prefix\n"
 "-t <dictionary_file> -- Test the database against specified dictionary\n"
 "-c -- Clean the database (get rid of redundant records)\n"
+"-k -- Store precompiled rulesets and dictionary filters in the database\n"
+"-T -- Store dictionary transducers for listing by prefix in the database\n"
+"-o <corpus_file> -- Reorder rules by their usage in specified corpus\n"
+"-z <word_list> -- Freeze search results for the dictionaries and listed words\n"
+"-K <lexicon_file> -- Compile the database into the read-only lexicon file\n"
 "-s <key> -- Search specified key\n"
+"-e <key> -- Search specified key and explain the search path\n"
 "-b <key> -- Retrieve basic forms (if any) for specified word\n"
 "-d <key> -- Delete record for specified key\n"
 "-D -- Discard the dataset\n\n"
@@ -90,7 +143,9 @@ static const char *usage =
 
 "-x -- Search in the explicit dictionary\n"
 "-m -- Try to treat the word as an implicit form\n"
-"-g -- Try to apply general rules\n\n"
+"-g -- Try to apply general rules\n"
+"-a -- Match general rules by the combined automaton\n"
+"-S <file> -- Collect rules matching statistics and dump them into the file\n\n"
 
 "The last group contains several options affecting program behaviour\n"
 "in general.\n\n"
@@ -102,38 +157,312 @@ static const char *usage =
 "-v -- Be more verbose than usual (print final statistical information)\n\n";
 
 
-static int detect_implicit(RULEXDB *db, char *key, char *value)
+static int detect_implicit(RULEXDB *db, const char *key, const char *value)
 {
-  regmatch_t match;
-  char s[RULEXDB_BUFSIZE], t[RULEXDB_BUFSIZE];
-  int i, k;
-
-  for (i = 0; i < db->prefixes.nrules; i++)
-    if ((!regexec(db->prefixes.pattern[i], key, 1, &match, 0)) &&
-        (!match.rm_so) &&
-        (match.rm_eo < strlen(key)))
+  char s[MAX_PREFIXES + 1][RULEXDB_BUFSIZE], v[MAX_PREFIXES + 1][RULEXDB_BUFSIZE];
+  char t[RULEXDB_BUFSIZE];
+  int next[MAX_PREFIXES + 1];
+  int d = 0, i, k, len;
+
+  (void)strcpy(s[0], key);
+  (void)strcpy(v[0], value);
+  next[0] = 1;
+  for (;;)
+    {
+      i = (d < MAX_PREFIXES) ?
+        rulexdb_prefix(db, s[d], s[d + 1], &len, next[d]) : 0;
+      if (i <= 0) /* No more prefixes here */
+        {
+          if (!d) return 0;
+          d--;
+          continue;
+        }
+      next[d] = i + 1;
+      k = strlen(s[d + 1]) - strlen(s[d] + len);
+      if (rulexdb_retrieve_item(db, s[d + 1], t + len - k, RULEXDB_LEXBASE))
+        {
+          (void)strncpy(t, s[d + 1], k);
+          (void)strcpy(t + k, v[d] + len);
+          (void)strcpy(v[d + 1], t);
+          next[++d] = 1;
+        }
+      else
+        {
+          (void)strncpy(t, s[d], len);
+          return strcmp(t, v[d]) ? -1 : 1;
+        }
+    }
+}
+
+static int dump_stats(RULEXDB *db, int dataset, const char *path)
+{
+  RULEXDB_RULE_STATS *stats;
+  FILE *f;
+  int i, k, n, rc = 0;
+
+  f = fopen(path, "w");
+  if (!f)
+    {
+      (void)fprintf(stderr, "Cannot open %s for output\n", path);
+      return -1;
+    }
+  for (i = 0; i < (int)(sizeof(rulesets) / sizeof(rulesets[0])); i++)
+    if ((dataset == RULEXDB_DEFAULT) || (dataset == rulesets[i]))
       {
-        if (db->prefixes.replacement[i])
-          (void)strcpy(s, db->prefixes.replacement[i]);
-        else s[0] = 0;
-        k = strlen(s);
-        (void)strcat(s, key + match.rm_eo);
-        if (rulexdb_retrieve_item(db, s, t + match.rm_eo - k, RULEXDB_LEXBASE))
+        n = rulexdb_ruleset_stats(db, rulesets[i], NULL, 0);
+        if (n <= 0)
           {
-            if (db->prefixes.replacement[i])
-              (void)strcpy(t, db->prefixes.replacement[i]);
-            else t[0] = 0;
-            (void)strcat(t, value + match.rm_eo);
-            k = detect_implicit(db, s, t);
-            if (k) return k;
+            if (n < 0) rc = n;
+            continue;
           }
-        else
+        stats = calloc(n, sizeof(RULEXDB_RULE_STATS));
+        if (!stats)
           {
-            (void)strncpy(t, key, match.rm_eo);
-            return strcmp(t, value) ? -1 : 1;
+            rc = RULEXDB_EMALLOC;
+            break;
           }
+        n = rulexdb_ruleset_stats(db, rulesets[i], stats, n);
+        for (k = 0; k < n; k++)
+          (void)fprintf(f, "%s\t%d\t%lu\t%lu\t%llu\n",
+                        rulexdb_dataset_name(rulesets[i]), k + 1,
+                        stats[k].attempts, stats[k].matches, stats[k].time);
+        free(stats);
       }
-  return 0;
+  if (fclose(f))
+    rc = -1;
+  if (rc)
+    (void)fprintf(stderr, "Cannot dump rules statistics\n");
+  return rc;
+}
+
+static void free_corpus(CORPUS_WORD *words, int nwords)
+{
+  int i;
+
+  for (i = 0; i < nwords; i++)
+    {
+      free(words[i].key);
+      free(words[i].value);
+    }
+  free(words);
+}
+
+static CORPUS_WORD *read_corpus(const char *path, int *nwords)
+{
+  CORPUS_WORD *words, *w;
+  FILE *f;
+  char line[256], *s, *t;
+  int k, n = 0, size = CORPUS_CHUNK;
+
+  f = fopen(path, "r");
+  if (!f)
+    {
+      (void)fprintf(stderr, "Cannot open %s for input\n", path);
+      return NULL;
+    }
+  words = malloc(size * sizeof(CORPUS_WORD));
+  while (words && fgets(line, 256, f))
+    {
+      for (k = 0; line[k]; k++)
+	if (isupper(line[k]))
+	  line[k] = tolower(line[k]);
+      s = strtok(line, " \t\n");
+      if ((!s) || (strlen(s) > RULEXDB_MAX_KEY_SIZE))
+	continue;
+      if (n == size)
+	{
+	  size *= 2;
+	  w = realloc(words, size * sizeof(CORPUS_WORD));
+	  if (!w)
+	    {
+	      free_corpus(words, n);
+	      words = NULL;
+	      break;
+	    }
+	  words = w;
+	}
+      words[n].key = strdup(s);
+      words[n].value = NULL;
+      words[n].rc = RULEXDB_SPECIAL;
+      words[n].count = 1;
+      if (!words[n].key)
+	{
+	  free_corpus(words, n);
+	  words = NULL;
+	  break;
+	}
+      s = strtok(NULL, " \t\n");
+      if (s && isdigit((unsigned char)*s))
+	{
+	  words[n].count = strtoul(s, &t, 10);
+	  if (*t)
+	    words[n].count = 1;
+	}
+      n++;
+    }
+  (void)fclose(f);
+  if (!words)
+    (void)fprintf(stderr, "Memory allocation error\n");
+  *nwords = n;
+  return words;
+}
+
+static int collect_weights(RULEXDB *db, CORPUS_WORD *words, int nwords,
+			   int search_mode, int dataset,
+			   unsigned long **weights, int *nrules)
+{
+  RULEXDB_RULE_STATS *before[NRULESETS], *after[NRULESETS];
+  char value[RULEXDB_BUFSIZE];
+  int i, k, n, rc = 0;
+
+  for (i = 0; i < NRULESETS; i++)
+    {
+      weights[i] = NULL;
+      before[i] = after[i] = NULL;
+      nrules[i] = 0;
+    }
+  for (i = 0; i < NRULESETS; i++)
+    if ((rulesets[i] != RULEXDB_CORRECTOR) &&
+	((dataset == RULEXDB_DEFAULT) || (dataset == rulesets[i])))
+      {
+	nrules[i] = rulexdb_ruleset_stats(db, rulesets[i], NULL, 0);
+	if (nrules[i] < 0)
+	  {
+	    rc = nrules[i];
+	    nrules[i] = 0;
+	    goto done;
+	  }
+	weights[i] = calloc(nrules[i] + 1, sizeof(unsigned long));
+	before[i] = calloc(nrules[i] + 1, sizeof(RULEXDB_RULE_STATS));
+	after[i] = calloc(nrules[i] + 1, sizeof(RULEXDB_RULE_STATS));
+	if (!(weights[i] && before[i] && after[i]))
+	  {
+	    rc = RULEXDB_EMALLOC;
+	    goto done;
+	  }
+      }
+
+  for (n = 0; n < nwords; n++)
+    {
+      for (i = 0; i < NRULESETS; i++)
+	if (nrules[i])
+	  (void)rulexdb_ruleset_stats(db, rulesets[i], before[i], nrules[i]);
+      words[n].rc = rulexdb_search(db, words[n].key, value, search_mode);
+      words[n].value = strdup(value);
+      if (!words[n].value)
+	{
+	  rc = RULEXDB_EMALLOC;
+	  goto done;
+	}
+      for (i = 0; i < NRULESETS; i++)
+	if (nrules[i])
+	  {
+	    (void)rulexdb_ruleset_stats(db, rulesets[i], after[i], nrules[i]);
+	    for (k = 0; k < nrules[i]; k++)
+	      weights[i][k] += (after[i][k].matches - before[i][k].matches) *
+		words[n].count;
+	  }
+    }
+
+ done:
+  for (i = 0; i < NRULESETS; i++)
+    {
+      free(before[i]);
+      free(after[i]);
+    }
+  return rc;
+}
+
+static int verify_corpus(RULEXDB *db, CORPUS_WORD *words, int nwords,
+			 int search_mode)
+{
+  char value[RULEXDB_BUFSIZE];
+  int n, mismatches = 0;
+
+  for (n = 0; n < nwords; n++)
+    if ((rulexdb_search(db, words[n].key, value, search_mode) != words[n].rc)
+	|| strcmp(value, words[n].value))
+      mismatches++;
+  return mismatches;
+}
+
+static int restore_rules(RULEXDB *db, int rule_type, char **rules, int nrules)
+{
+  int k, rc;
+
+  rc = rulexdb_discard_ruleset(db, rule_type);
+  if (rc < 0) return rc;
+  for (k = 0; k < nrules; k++)
+    {
+      rc = rulexdb_subscribe_rule(db, rules[k], rule_type, 0);
+      if (rc) return rc;
+    }
+  rc = rulexdb_compile_ruleset(db, rule_type);
+  return (rc < 0) ? rc : RULEXDB_SUCCESS;
+}
+
+static int dictionary_bit(RULEXDB *db, const char *key, int dataset)
+{
+  int i;
+
+  if (dataset == RULEXDB_DEFAULT) /* Chosen by the key as the library does */
+    dataset = (rulexdb_classify(db, key) == RULEXDB_SPECIAL) ?
+      RULEXDB_LEXBASE : RULEXDB_EXCEPTION;
+  for (i = 0; (i < NDICTIONARIES) && (dataset != dictionaries[i]); i++);
+  return (i < NDICTIONARIES) ? (1 << i) : 0;
+}
+
+static int build_indexes(RULEXDB *db, int changed)
+{
+  int i, rc = RULEXDB_SUCCESS;
+
+  for (i = 0; i < NDICTIONARIES; i++)
+    if (changed & (1 << i))
+      {
+	if (rulexdb_build_filter(db, dictionaries[i]) < 0)
+	  {
+	    (void)fprintf(stderr, "Cannot build %s dictionary filter\n",
+			  rulexdb_dataset_name(dictionaries[i]));
+	    rc = RULEXDB_FAILURE;
+	  }
+      }
+  return rc;
+}
+
+static void print_trace(const RULEXDB_TRACE *trace)
+{
+  int i, n;
+
+  (void)printf("Stage: %s\n", (trace->stage == RULEXDB_STAGE_NONE) ?
+	       "none" : stages[trace->stage]);
+  if (trace->lexclass)
+    (void)printf("Lexical classification rule: %d\n", trace->lexclass);
+  if (trace->nprefixes)
+    {
+      (void)fputs("Prefix rules:", stdout);
+      n = (trace->nprefixes < RULEXDB_TRACE_PREFIXES) ?
+	trace->nprefixes : RULEXDB_TRACE_PREFIXES;
+      for (i = 0; i < n; i++)
+	(void)printf(" %d", trace->prefixes[i]);
+      (void)putchar('\n');
+    }
+  if (trace->rule)
+    (void)printf("General rule: %d\n", trace->rule);
+  if (trace->ncorrections)
+    {
+      (void)fputs("Correction rules:", stdout);
+      n = (trace->ncorrections < RULEXDB_TRACE_CORRECTIONS) ?
+	trace->ncorrections : RULEXDB_TRACE_CORRECTIONS;
+      for (i = 0; i < n; i++)
+	(void)printf(" %d", trace->corrections[i]);
+      if (n < trace->ncorrections)
+	(void)fputs(" ...", stdout);
+      (void)putchar('\n');
+    }
+  for (i = 0; i < RULEXDB_STAGES; i++)
+    if (trace->time[i] || trace->probes[i])
+      (void)printf("%s: %llu ns, %u lookup(s)\n",
+		   stages[i], trace->time[i], trace->probes[i]);
 }
 
 
@@ -143,12 +472,16 @@ int main(int argc, char *argv[])
 
   char key[RULEXDB_BUFSIZE], value[RULEXDB_BUFSIZE];
   char *s = NULL, *d = NULL, *t = NULL, line[256];
-  char *db_path = NULL, *srcf = NULL;
+  char *db_path = NULL, *srcf = NULL, *stats_file = NULL, *corpus = NULL;
+  char *freeze = NULL, *lexicon = NULL, *prefix = NULL;
+  RULEXDB_BASE bases[BASES_CHUNK];
+  RULEXDB_TRACE trace;
 
   int ret, n, k, i = 0;
   int invalid = 0, duplicate = 0;
   int verbose = 0, quiet = 0, rules_data = 0;
   int replace_mode = 0, dataset = RULEXDB_DEFAULT, search_mode = 0;
+  int open_options = 0, compile = 0, explain = 0, changed = 0;
 
   if (!setlocale(LC_CTYPE, charset))
     {
@@ -165,7 +498,7 @@ int main(int argc, char *argv[])
       return EXIT_FAILURE;
     }
   ret = NO_DB_FILE;
-  while((n = getopt(argc,argv,"f:b:s:d:t:CDGLMPXgmxclrqvh")) != -1)
+  while((n = getopt(argc,argv,"f:b:s:e:d:t:o:z:K:S:p:CDGLMPTXagmxcklrqvh")) != -1)
     switch(n)
       {
 	case 'X':
@@ -193,6 +526,13 @@ int main(int argc, char *argv[])
 	case 'g':
 	  search_mode |= RULEXDB_RULES;
 	  break;
+	case 'a':
+	  open_options |= RULEXDB_DFA;
+	  break;
+	case 'S':
+	  open_options |= RULEXDB_STATS;
+	  stats_file = optarg;
+	  break;
 	case 'L':
 	  if (dataset != RULEXDB_DEFAULT)
 	    ret = CS_CONFLICT;
@@ -216,32 +556,68 @@ int main(int argc, char *argv[])
 	    srcf = optarg;
 	  break;
 	case 'd':
-	  if (d || s || t) ret = CS_CONFLICT;
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
 	  else d = optarg;
 	  break;
 	case 'b':
-	  if (d || s || t) ret = CS_CONFLICT;
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
 	  s = key;
 	  t = optarg;
 	  break;
 	case 's':
-	  if (d || s || t) ret = CS_CONFLICT;
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
 	  else s = optarg;
 	  break;
+	case 'e':
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
+	  else
+	    {
+	      s = optarg;
+	      explain = 1;
+	    }
+	  break;
 	case 'l':
-	  if (d || s || t) ret = CS_CONFLICT;
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
 	  else s = line;
 	  break;
+	case 'p':
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
+	  else
+	    {
+	      s = line;
+	      prefix = optarg;
+	    }
+	  break;
 	case 't':
-	  if (d || s || t) ret = CS_CONFLICT;
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
 	  else t = optarg;
 	  break;
 	case 'c':
-	  if (d || s || t) ret = CS_CONFLICT;
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
 	  else d = line;
 	  break;
+	case 'k':
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
+	  else compile = 1;
+	  break;
+	case 'T':
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
+	  else compile = 2;
+	  break;
+	case 'o':
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
+	  else corpus = optarg;
+	  break;
+	case 'z':
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
+	  else freeze = optarg;
+	  break;
+	case 'K':
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
+	  else lexicon = optarg;
+	  break;
 	case 'D':
-	  if (d || s || t) ret = CS_CONFLICT;
+	  if (d || s || t || compile || corpus || freeze || lexicon) ret = CS_CONFLICT;
 	  else d = key;
 	  break;
 	case 'r':
@@ -288,7 +664,7 @@ int main(int argc, char *argv[])
 	    (void)fprintf(stderr, "Cannot open %s for output\n", srcf);
 	    return EXIT_FAILURE;
 	  }
-      db = rulexdb_open(db_path, RULEXDB_SEARCH);
+      db = rulexdb_open(db_path, RULEXDB_SEARCH | open_options);
       if (!db)
 	{
 	  perror(db_path);
@@ -303,9 +679,38 @@ int main(int argc, char *argv[])
 	      rulexdb_close(db);
 	      return EXIT_FAILURE;
 	    }
+	  if (prefix && rules_data)
+	    {
+	      (void)fprintf(stderr, "Only dictionaries can be listed by prefix\n");
+	      rulexdb_close(db);
+	      return EXIT_FAILURE;
+	    }
 	  n = 0;
 	  ret = 0;
-	  if (rules_data)
+	  if (prefix)
+	    {
+	      if (verbose)
+		(void)fprintf(stderr, "Listing %s dictionary by prefix \"%s\"\n",
+			      rulexdb_dataset_name(dataset), prefix);
+	      if (RULEXDB_EXCEPTION == dataset)
+		dataset = RULEXDB_EXCEPTION_RAW;
+	      while ((ret = rulexdb_enumerate(db, prefix, key, value,
+					      dataset, n)) == RULEXDB_SUCCESS)
+		{
+		  (void)printf("%s %s\n", key, value);
+		  n++;
+		}
+	      if (ret == RULEXDB_EACCESS)
+		{
+		  (void)fprintf(stderr,
+				"No %s dictionary transducer in the database"
+				" (it is stored by -T action)\n",
+				rulexdb_dataset_name(dataset));
+		  rulexdb_close(db);
+		  return EXIT_FAILURE;
+		}
+	    }
+	  else if (rules_data)
 	    {
 	      if (verbose)
 		(void)fprintf(stderr, "Listing %s ruleset\n",
@@ -345,23 +750,27 @@ int main(int argc, char *argv[])
       else if (s == key) /* Discover basic forms */
 	{
 	  ret = RULEXDB_SPECIAL;
-	  for (k = 1; k > 0; k++)
+	  for (k = 1; ; k = bases[n - 1].rule + 1)
 	    {
-	      k = rulexdb_lexbase(db, t, key, k);
-	      if (k > 0)
+	      n = rulexdb_lexbases(db, t, bases, BASES_CHUNK, k);
+	      if (n < 0)
+		{
+		  ret = n;
+		  break;
+		}
+	      for (i = 0; i < n; i++)
 		{
 		  ret = RULEXDB_SUCCESS;
 		  if (!quiet)
-		    (void)printf("%d\t%s\n", k, key);
+		    (void)printf("%d\t%s\n", bases[i].rule, bases[i].base);
 		}
-	      else if (!k) k--;
-	      else ret = k;
+	      if (n < BASES_CHUNK) break;
 	    }
 	}
 
       else if (s) /* Search record for specified key */
 	{
-	  if (rules_data)
+	  if (rules_data && !explain)
 	    {
 	      k = atoi(s);
 	      if (k)
@@ -381,15 +790,21 @@ int main(int argc, char *argv[])
 	      for (k = 0; s[k]; k++)
 		if (isupper(s[k]))
 		  s[k] = tolower(s[k]);
-	      ret = rulexdb_search(db, s, value, search_mode);
+	      if (explain)
+		ret = rulexdb_search_traced(db, s, value, search_mode, &trace);
+	      else ret = rulexdb_search(db, s, value, search_mode);
 	    }
 	  switch (ret)
 	    {
 	      case RULEXDB_SPECIAL:
-		if (rules_data) quiet = 1;
+		if (rules_data && !explain) quiet = 1;
 	      case RULEXDB_SUCCESS:
 		if (!quiet)
-		  (void)printf("%s\n", value);
+		  {
+		    (void)printf("%s\n", value);
+		    if (explain)
+		      print_trace(&trace);
+		  }
 		break;
 	      case RULEXDB_EINVKEY:
 		(void)fprintf(stderr, "Invalid key: %s\n", s);
@@ -511,6 +926,9 @@ int main(int argc, char *argv[])
 	  ret = 0;
 	}
 
+      if (stats_file && dump_stats(db, rules_data ? dataset : RULEXDB_DEFAULT,
+                                   stats_file))
+        ret = RULEXDB_FAILURE;
       rulexdb_close(db);
       if (ret) return EXIT_FAILURE;
       else return EXIT_SUCCESS;
@@ -552,6 +970,7 @@ int main(int argc, char *argv[])
                   n++;
               }
         }
+      k = n ? dictionary_bit(db, NULL, RULEXDB_LEXBASE) : 0;
       if ((dataset == RULEXDB_DEFAULT) || (dataset == RULEXDB_EXCEPTION))
 	for (ret = rulexdb_seq(db, key, value, RULEXDB_EXCEPTION, RULEXDB_SEQ_FIRST);
 	     ret == RULEXDB_SUCCESS;
@@ -560,8 +979,12 @@ int main(int argc, char *argv[])
 	    (void)rulexdb_search(db, key, line, search_mode);
 	    if (!strcmp(line, value))
 	      if (!rulexdb_remove_this_item(db, RULEXDB_EXCEPTION))
-		n++;
+		{
+		  k |= dictionary_bit(db, NULL, RULEXDB_EXCEPTION);
+		  n++;
+		}
 	  }
+      (void)build_indexes(db, k);
       if (!quiet)
 	{
 	  if (n)
@@ -640,7 +1063,322 @@ int main(int argc, char *argv[])
 	}
       if (ret == RULEXDB_EINVKEY)
 	(void)fprintf(stderr, "Invalid key: %s\n", d);
+      else if (rules_data && !ret &&
+	       (rulexdb_compile_ruleset(db, dataset) < 0))
+	(void)fprintf(stderr, "Cannot compile %s ruleset\n",
+		      rulexdb_dataset_name(dataset));
+      else if (!(rules_data || ret) && ((d != key) || k))
+	(void)build_indexes(db, dictionary_bit(db, NULL, dataset));
+      rulexdb_close(db);
+      if (ret) return EXIT_FAILURE;
+      else return EXIT_SUCCESS;
+    }
+
+  else if (compile) /* Store precompiled rulesets and dictionary indexes */
+    {
+      db = rulexdb_open(db_path, RULEXDB_UPDATE);
+      if (!db)
+	{
+	  perror(db_path);
+	  return EXIT_FAILURE;
+	}
+      ret = 0;
+      for (i = 0; i < (int)(sizeof(rulesets) / sizeof(rulesets[0])); i++)
+	if ((compile == 1) &&
+	    ((dataset == RULEXDB_DEFAULT) || (dataset == rulesets[i])))
+	  {
+	    if (verbose)
+	      (void)fprintf(stderr, "Compiling %s ruleset\n",
+			    rulexdb_dataset_name(rulesets[i]));
+	    k = rulexdb_compile_ruleset(db, rulesets[i]);
+	    if (k < 0)
+	      {
+		(void)fprintf(stderr, "Cannot compile %s ruleset\n",
+			      rulexdb_dataset_name(rulesets[i]));
+		ret = k;
+	      }
+	    else if (!quiet)
+	      {
+		(void)fprintf(stderr, "%d rule", k);
+		if (k == 1)
+		  (void)fputs(" has", stderr);
+		else (void)fputs("s have", stderr);
+		(void)fprintf(stderr, " been precompiled in %s ruleset\n",
+			      rulexdb_dataset_name(rulesets[i]));
+	      }
+	  }
+      for (i = 0; i < NDICTIONARIES; i++)
+	if ((compile == 1) &&
+	    ((dataset == RULEXDB_DEFAULT) || (dataset == dictionaries[i])))
+	  {
+	    if (verbose)
+	      (void)fprintf(stderr, "Building %s dictionary filter\n",
+			    rulexdb_dataset_name(dictionaries[i]));
+	    k = rulexdb_build_filter(db, dictionaries[i]);
+	    if (k < 0)
+	      {
+		(void)fprintf(stderr, "Cannot build %s dictionary filter\n",
+			      rulexdb_dataset_name(dictionaries[i]));
+		ret = k;
+	      }
+	    else if (!quiet)
+	      {
+		(void)fprintf(stderr, "%d key", k);
+		if (k == 1)
+		  (void)fputs(" has", stderr);
+		else (void)fputs("s have", stderr);
+		(void)fprintf(stderr, " been put into %s dictionary filter\n",
+			      rulexdb_dataset_name(dictionaries[i]));
+	      }
+	  }
+	else if ((compile == 2) &&
+		 ((dataset == RULEXDB_DEFAULT) || (dataset == dictionaries[i])))
+	  {
+	    if (verbose)
+	      (void)fprintf(stderr, "Building %s dictionary transducer\n",
+			    rulexdb_dataset_name(dictionaries[i]));
+	    k = rulexdb_build_fst(db, dictionaries[i]);
+	    if (k < 0)
+	      {
+		(void)fprintf(stderr, "Cannot build %s dictionary transducer\n",
+			      rulexdb_dataset_name(dictionaries[i]));
+		ret = k;
+	      }
+	    else if (!quiet)
+	      {
+		(void)fprintf(stderr, "%d word", k);
+		if (k == 1)
+		  (void)fputs(" has", stderr);
+		else (void)fputs("s have", stderr);
+		(void)fprintf(stderr, " been put into %s dictionary transducer\n",
+			      rulexdb_dataset_name(dictionaries[i]));
+	      }
+	  }
+      rulexdb_close(db);
+      if (ret) return EXIT_FAILURE;
+      else return EXIT_SUCCESS;
+    }
+
+  else if (lexicon) /* Write the compiled lexicon file */
+    {
+      db = rulexdb_open(db_path, RULEXDB_SEARCH);
+      if (!db)
+	{
+	  perror(db_path);
+	  return EXIT_FAILURE;
+	}
+      if (verbose)
+	(void)fprintf(stderr, "Compiling lexicon file %s\n", lexicon);
+      k = rulexdb_compile(db, lexicon);
+      if (k < 0)
+	(void)fprintf(stderr, "Cannot compile lexicon file %s\n", lexicon);
+      else if (!quiet)
+	{
+	  (void)fprintf(stderr, "%d record", k);
+	  if (k == 1)
+	    (void)fputs(" has", stderr);
+	  else (void)fputs("s have", stderr);
+	  (void)fputs(" been stored in the lexicon file\n", stderr);
+	}
+      rulexdb_close(db);
+      if (k < 0) return EXIT_FAILURE;
+      else return EXIT_SUCCESS;
+    }
+
+  else if (freeze) /* Store frozen search results */
+    {
+      CORPUS_WORD *words;
+      const char **list;
+      int nwords;
+
+      words = read_corpus(freeze, &nwords);
+      if (!words)
+	return EXIT_FAILURE;
+      list = malloc((nwords ? nwords : 1) * sizeof(char *));
+      if (!list)
+	{
+	  (void)fprintf(stderr, "Memory allocation error\n");
+	  free_corpus(words, nwords);
+	  return EXIT_FAILURE;
+	}
+      for (i = 0; i < nwords; i++)
+	list[i] = words[i].key;
+      db = rulexdb_open(db_path, RULEXDB_UPDATE | open_options);
+      if (!db)
+	{
+	  perror(db_path);
+	  free(list);
+	  free_corpus(words, nwords);
+	  return EXIT_FAILURE;
+	}
+      if (verbose)
+	(void)fputs("Freezing search results\n", stderr);
+      k = rulexdb_freeze(db, list, nwords);
+      if (k < 0)
+	(void)fputs("Cannot freeze search results\n", stderr);
+      else if (!quiet)
+	{
+	  (void)fprintf(stderr, "%d word", k);
+	  if (k == 1)
+	    (void)fputs(" has", stderr);
+	  else (void)fputs("s have", stderr);
+	  (void)fputs(" been frozen in the database\n", stderr);
+	}
+      rulexdb_close(db);
+      free(list);
+      free_corpus(words, nwords);
+      if (k < 0) return EXIT_FAILURE;
+      else return EXIT_SUCCESS;
+    }
+
+  else if (corpus) /* Reorder rules by their usage */
+    {
+      CORPUS_WORD *words;
+      unsigned long *weights[NRULESETS];
+      char **backup[NRULESETS];
+      int nrules[NRULESETS], moved[NRULESETS], nwords;
+
+      if ((dataset == RULEXDB_CORRECTOR) ||
+	  ((dataset != RULEXDB_DEFAULT) && !rules_data))
+	{
+	  (void)fprintf(stderr, "Invalid dataset specification\n");
+	  return EXIT_FAILURE;
+	}
+      words = read_corpus(corpus, &nwords);
+      if (!words)
+	return EXIT_FAILURE;
+
+      /* Collect rules usage statistics */
+      if (verbose)
+	(void)fprintf(stderr, "Collecting rules usage on %s\n", corpus);
+      db = rulexdb_open(db_path, RULEXDB_SEARCH | RULEXDB_STATS | open_options);
+      if (!db)
+	{
+	  perror(db_path);
+	  free_corpus(words, nwords);
+	  return EXIT_FAILURE;
+	}
+      ret = collect_weights(db, words, nwords, search_mode, dataset,
+			    weights, nrules);
       rulexdb_close(db);
+
+      /* Rearrange the rules keeping the original order for rollback */
+      db = NULL;
+      for (i = 0; i < NRULESETS; i++)
+	{
+	  backup[i] = NULL;
+	  moved[i] = 0;
+	}
+      if (!ret)
+	{
+	  db = rulexdb_open(db_path, RULEXDB_UPDATE);
+	  if (!db)
+	    {
+	      perror(db_path);
+	      ret = RULEXDB_FAILURE;
+	    }
+	}
+      for (i = 0; (i < NRULESETS) && !ret; i++)
+	if (nrules[i])
+	  {
+	    backup[i] = calloc(nrules[i], sizeof(char *));
+	    if (!backup[i])
+	      {
+		ret = RULEXDB_EMALLOC;
+		break;
+	      }
+	    for (k = 0; k < nrules[i]; k++)
+	      {
+		s = rulexdb_fetch_rule(db, rulesets[i], k + 1);
+		if (s)
+		  backup[i][k] = strdup(s);
+		if (!(s && backup[i][k]))
+		  {
+		    ret = RULEXDB_FAILURE;
+		    break;
+		  }
+	      }
+	    if (ret) break;
+	    if (verbose)
+	      (void)fprintf(stderr, "Reordering %s ruleset\n",
+			    rulexdb_dataset_name(rulesets[i]));
+	    k = rulexdb_reorder_ruleset(db, rulesets[i], weights[i], nrules[i]);
+	    moved[i] = k;
+	    if (k < 0)
+	      ret = k;
+	    else
+	      {
+		if (k && (rulexdb_compile_ruleset(db, rulesets[i]) < 0))
+		  (void)fprintf(stderr, "Cannot compile %s ruleset\n",
+				rulexdb_dataset_name(rulesets[i]));
+		if (!quiet)
+		  {
+		    (void)fprintf(stderr, "%d rule", k);
+		    if (k == 1)
+		      (void)fputs(" has", stderr);
+		    else (void)fputs("s have", stderr);
+		    (void)fprintf(stderr, " been moved in %s ruleset\n",
+				  rulexdb_dataset_name(rulesets[i]));
+		  }
+	      }
+	  }
+      if (db)
+	rulexdb_close(db);
+
+      /* Make sure that search results are not affected */
+      if (!ret)
+	{
+	  if (verbose)
+	    (void)fputs("Verifying search results\n", stderr);
+	  db = rulexdb_open(db_path, RULEXDB_SEARCH | open_options);
+	  if (db)
+	    {
+	      n = verify_corpus(db, words, nwords, search_mode);
+	      rulexdb_close(db);
+	      if (n)
+		{
+		  (void)fprintf(stderr, "%d mismatch", n);
+		  if (n != 1) (void)fputs("es", stderr);
+		  (void)fputs(" found\n", stderr);
+		  ret = RULEXDB_FAILURE;
+		}
+	    }
+	  else
+	    {
+	      perror(db_path);
+	      ret = RULEXDB_FAILURE;
+	    }
+	}
+      if (ret)
+	{
+	  (void)fprintf(stderr, "Cannot reorder rules\n");
+	  for (i = 0; (i < NRULESETS) && !moved[i]; i++);
+	  if (i < NRULESETS)
+	    {
+	      (void)fputs("Restoring original rules order\n", stderr);
+	      db = rulexdb_open(db_path, RULEXDB_UPDATE);
+	      if (db)
+		{
+		  for (i = 0; i < NRULESETS; i++)
+		    if (moved[i] &&
+			restore_rules(db, rulesets[i], backup[i], nrules[i]))
+		      (void)fprintf(stderr, "Cannot restore %s ruleset\n",
+				    rulexdb_dataset_name(rulesets[i]));
+		  rulexdb_close(db);
+		}
+	      else perror(db_path);
+	    }
+	}
+
+      for (i = 0; i < NRULESETS; i++)
+	{
+	  if (backup[i])
+	    for (k = 0; k < nrules[i]; k++)
+	      free(backup[i][k]);
+	  free(backup[i]);
+	  free(weights[i]);
+	}
+      free_corpus(words, nwords);
       if (ret) return EXIT_FAILURE;
       else return EXIT_SUCCESS;
     }
@@ -711,10 +1449,17 @@ int main(int argc, char *argv[])
       switch(ret)
 	{
 	  case RULEXDB_SUCCESS:
+	    if (!rules_data)
+	      changed |= dictionary_bit(db, s, dataset);
 	    i++;
 	    break;
 	  case RULEXDB_SPECIAL:
-	    if (replace_mode) i++;
+	    if (replace_mode)
+	      {
+		if (!rules_data)
+		  changed |= dictionary_bit(db, s, dataset);
+		i++;
+	      }
 	    if (!(quiet || rules_data))
 	      {
 		if (srcf)
@@ -772,6 +1517,11 @@ int main(int argc, char *argv[])
     }
   n--;
 
+  if (rules_data && (rulexdb_compile_ruleset(db, dataset) < 0))
+    (void)fprintf(stderr, "Cannot compile %s ruleset\n",
+		  rulexdb_dataset_name(dataset));
+  else if (!rules_data)
+    (void)build_indexes(db, changed);
   rulexdb_close(db);
 
   if (!quiet)
@@ -0,0 +1,322 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Keys packing context model generator.
+ *
+ * This program trains the order-1 statistical model for keys packing
+ * on the dictionaries specified in the command line and writes
+ * the model tables in C to the standard output. Every letter
+ * is coded in the context of the previous one (or of the key start),
+ * so the model holds a separate set of symbol frequencies
+ * for every context. The frequencies of each context are scaled
+ * to the same power of two total, and every symbol gets at least
+ * the minimal frequency, so the words not seen in the training data
+ * can be packed as well.
+ *
+ * The average key length of the training words as estimated by
+ * the entropy of the original order-0 model and of the new one
+ * is reported on the standard error.
+ *
+ * Note that the keys packed by the model must be unpacked by
+ * exactly the same one. The model is identified by the checksum
+ * of its tables, which is stamped in the databases using it,
+ * so the databases made by other model are refused instead of
+ * being misread.
+ */
+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Local constants */
+
+/* Number of the letters and symbols (including the end of string) */
+#define LETTERS 33
+#define SYMBOLS (LETTERS + 1)
+
+/* Context of the key start */
+#define KEY_START LETTERS
+
+/* Scaled frequencies total of every context (a power of two) */
+#define SCALE_BITS 12
+#define SCALE (1 << SCALE_BITS)
+
+/* Decoding table granularity */
+#define DECODE_BITS 4
+#define DECODE_SIZE (1 << (SCALE_BITS - DECODE_BITS))
+
+/* Maximum line length in the dictionaries */
+#define MAX_LINE 256
+
+
+/* Local data */
+
+/* Letters in the order of the model symbols */
+static const unsigned char alphabet[LETTERS] =
+  {
+    0xC1, 0xC2, 0xD7, /* а, б, в, */
+    0xC7, 0xC4, 0xC5, /* г, д, е, */
+    0xA3, 0xD6, 0xDA, /* ё, ж, з, */
+    0xC9, 0xCA, 0xCB, /* и, й, к, */
+    0xCC, 0xCD, 0xCE, /* л, м, н, */
+    0xCF, 0xD0, 0xD2, /* о, п, р, */
+    0xD3, 0xD4, 0xD5, /* с, т, у, */
+    0xC6, 0xC8, 0xC3, /* ф, х, ц, */
+    0xDE, 0xDB, 0xDD, /* ч, ш, щ, */
+    0xDF, 0xD9, 0xD8, /* ъ, ы, ь, */
+    0xDC, 0xC0, 0xD1 /* э, ю, я */
+  };
+
+/* Frequencies of the original order-0 model */
+static const unsigned int order0[SYMBOLS] =
+  {
+    185, 34, 101, 34, 50, 176, 2, 16, 39, 160, 31,
+    72, 95, 73, 146, 205, 69, 121, 115, 114, 62,
+    7, 22, 10, 26, 26, 14, 1, 47, 36, 2, 23, 48, 228
+  };
+
+/* Symbols counts in every context */
+static unsigned long counts[SYMBOLS][SYMBOLS];
+
+/* Scaled frequencies */
+static unsigned int freqs[SYMBOLS][SYMBOLS];
+
+
+/* Local routines */
+
+static int symbol(unsigned char c)
+     /*
+      * Get the model symbol of the letter.
+      * Returns -1 if it is not a letter.
+      */
+{
+  int i;
+
+  for (i = 0; i < LETTERS; i++)
+    if (alphabet[i] == c)
+      return i;
+  return -1;
+}
+
+static int train(const char *path)
+     /*
+      * Count the symbols of the keys from the dictionary file.
+      * The keys with foreign characters are skipped.
+      * Returns number of the keys counted or -1 on failure.
+      */
+{
+  char line[MAX_LINE];
+  int word[MAX_LINE];
+  FILE *f = fopen(path, "r");
+  int i, j, n = 0;
+
+  if (!f)
+    return -1;
+  while (fgets(line, sizeof(line), f))
+    {
+      for (i = 0; line[i] && !strchr(" \t\r\n", line[i]); i++)
+        {
+          word[i] = symbol((unsigned char)line[i]);
+          if (word[i] < 0)
+            break;
+        }
+      if ((!i) || (line[i] && !strchr(" \t\r\n", line[i])))
+        continue;
+      word[i] = LETTERS;
+      for (j = 0; j <= i; j++)
+        counts[j ? word[j - 1] : KEY_START][word[j]]++;
+      n++;
+    }
+  (void)fclose(f);
+  return n;
+}
+
+static void scale(unsigned long *count, unsigned int *freq)
+     /*
+      * Scale the symbols counts of a context to the SCALE total
+      * keeping every frequency non-zero. The rest left by rounding
+      * is given to the most frequent symbols.
+      */
+{
+  unsigned long total = 0;
+  unsigned int sum = 0, k;
+  int i, j;
+
+  for (i = 0; i < SYMBOLS; i++)
+    total += count[i];
+  for (i = 0; i < SYMBOLS; i++)
+    {
+      freq[i] = 1;
+      if (total)
+        freq[i] += (unsigned int)(count[i] * (SCALE - SYMBOLS) / total);
+      sum += freq[i];
+    }
+  for (k = 0; sum < SCALE; k++, sum++)
+    {
+      for (i = 0, j = 0; i < SYMBOLS; i++)
+        if (count[i] > count[j])
+          j = i;
+      freq[total ? j : (int)(k % SYMBOLS)]++;
+      if (total)
+        count[j] = 0;
+    }
+}
+
+static double entropy(const unsigned int *freq, unsigned int total,
+                      const unsigned long *count)
+     /*
+      * Estimate the code length in bits for the counted symbols
+      * coded by specified frequencies.
+      */
+{
+  double bits = 0;
+  int i;
+
+  for (i = 0; i < SYMBOLS; i++)
+    if (count[i])
+      bits += count[i] * log2((double)total / freq[i]);
+  return bits;
+}
+
+static unsigned long model_id(void)
+     /*
+      * Compute the model identifier as 32-bit FNV-1a hash
+      * of the scaled frequencies and the decoding granularity.
+      */
+{
+  unsigned long h = 2166136261UL;
+  int i, j;
+
+  for (i = 0; i < SYMBOLS; i++)
+    for (j = 0; j < SYMBOLS; j++)
+      {
+        h = ((h ^ (freqs[i][j] & 0xff)) * 16777619UL) & 0xffffffffUL;
+        h = ((h ^ (freqs[i][j] >> 8)) * 16777619UL) & 0xffffffffUL;
+      }
+  h = ((h ^ SCALE_BITS) * 16777619UL) & 0xffffffffUL;
+  h = ((h ^ DECODE_BITS) * 16777619UL) & 0xffffffffUL;
+  return h;
+}
+
+static void print_table(void)
+     /*
+      * Write the model tables.
+      */
+{
+  unsigned int low, block;
+  int i, j;
+
+  (void)printf("/* Symbols intervals low bounds in every context */\n");
+  (void)printf("static const unsigned short int context_low[%d][%d] =\n  {\n",
+               SYMBOLS, SYMBOLS + 1);
+  for (i = 0; i < SYMBOLS; i++)
+    {
+      (void)printf("    {");
+      for (j = 0, low = 0; j <= SYMBOLS; j++)
+        {
+          (void)printf("%s%s%4u", j ? "," : "",
+                       (j && !(j % 12)) ? "\n     " : " ", low);
+          if (j < SYMBOLS)
+            low += freqs[i][j];
+        }
+      (void)printf(" }%s\n", (i < SYMBOLS - 1) ? "," : "");
+    }
+  (void)printf("  };\n\n");
+
+  (void)printf("/* Symbols by the counts blocks of %d in every context */\n",
+               1 << DECODE_BITS);
+  (void)printf("static const unsigned char context_decode[%d][%d] =\n  {\n",
+               SYMBOLS, DECODE_SIZE);
+  for (i = 0; i < SYMBOLS; i++)
+    {
+      (void)printf("    {");
+      for (block = 0, j = 0, low = 0; block < DECODE_SIZE; block++)
+        {
+          while (low + freqs[i][j] <= (block << DECODE_BITS))
+            low += freqs[i][j++];
+          (void)printf("%s%s%2d", block ? "," : "",
+                       (block && !(block % 16)) ? "\n     " : " ", j);
+        }
+      (void)printf(" }%s\n", (i < SYMBOLS - 1) ? "," : "");
+    }
+  (void)printf("  };\n");
+}
+
+
+/* Main program */
+
+int main(int argc, char *argv[])
+{
+  unsigned long count[SYMBOLS], keys = 0, all[SYMBOLS];
+  unsigned int total0 = 0;
+  double bits0 = 0, bits1 = 0;
+  int i, j, n;
+
+  if (argc < 2)
+    {
+      (void)fprintf(stderr, "Usage: %s <dictionary> ...\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  for (i = 1; i < argc; i++)
+    {
+      n = train(argv[i]);
+      if (n < 0)
+        {
+          (void)fprintf(stderr, "Cannot open %s for input\n", argv[i]);
+          return EXIT_FAILURE;
+        }
+      keys += n;
+    }
+  if (!keys)
+    {
+      (void)fprintf(stderr, "No keys found\n");
+      return EXIT_FAILURE;
+    }
+
+  (void)memset(all, 0, sizeof(all));
+  for (i = 0; i < SYMBOLS; i++)
+    {
+      total0 += order0[i];
+      for (j = 0; j < SYMBOLS; j++)
+        all[j] += counts[i][j];
+      (void)memcpy(count, counts[i], sizeof(count));
+      scale(count, freqs[i]);
+      bits1 += entropy(freqs[i], SCALE, counts[i]);
+    }
+  bits0 = entropy(order0, total0, all);
+  (void)fprintf(stderr, "%lu keys, average length %.2f bytes by order-0 model"
+                " and %.2f bytes by order-1 model\n",
+                keys, bits0 / keys / 8, bits1 / keys / 8);
+
+  (void)printf("/*\n * Order-1 keys packing model.\n *\n"
+               " * This file is generated by mkkeymodel, do not edit it.\n"
+               " */\n\n");
+  (void)printf("/* Total of the symbols frequencies in every context */\n"
+               "#define CONTEXT_SCALE_BITS %d\n\n", SCALE_BITS);
+  (void)printf("/* Decoding table granularity */\n"
+               "#define CONTEXT_DECODE_BITS %d\n\n", DECODE_BITS);
+  (void)printf("/* Model identifier stamped in the databases */\n"
+               "#define CONTEXT_MODEL_ID 0x%08lXU\n\n", model_id());
+  print_table();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,363 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Rule patterns analysis routines implementation.
+ *
+ * The regular expression is parsed by recursive descent
+ * into the syntax tree. All unsupported constructions are rejected,
+ * so the callers can fall back to the POSIX regex routines
+ * for such patterns.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "pattern.h"
+
+
+/* Maximum nesting depth of parenthesized subexpressions */
+#define MAX_DEPTH 64
+
+
+/* Case folding table (koi8-r) */
+const unsigned char pattern_fold[256] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+    0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+    0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+    0x40, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67,
+    0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77,
+    0x78, 0x79, 0x7A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,
+    0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67,
+    0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77,
+    0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F,
+    0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8D, 0x8E, 0x8F,
+    0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
+    0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x9E, 0x9F,
+    0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+    0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF,
+    0xB0, 0xB1, 0xB2, 0xA3, 0xB4, 0xB5, 0xB6, 0xB7, /* Ё -> ё */
+    0xB8, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0xBF,
+    0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7,
+    0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF,
+    0xD0, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7,
+    0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF,
+    0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, /* Ю .. Ж */
+    0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF, /* Х .. О */
+    0xD0, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, /* П .. В */
+    0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF  /* Ь .. Ъ */
+  };
+
+
+/* Parser state */
+typedef struct
+{
+  const char *p; /* Current position in the source */
+  PATTERN *pattern; /* Pattern being constructed */
+  int depth; /* Current nesting depth */
+} PARSER;
+
+
+/* Local routines */
+
+static int new_node(PARSER *parser, int type, int left, int right, int arg)
+     /*
+      * Allocate new syntax tree node.
+      * Returns node index or -1 when memory allocation fails.
+      */
+{
+  PATTERN *pattern = parser->pattern;
+  PATTERN_NODE *node;
+
+  if (!(pattern->nnodes & 15))
+    {
+      node = realloc(pattern->node, (pattern->nnodes + 16) * sizeof(PATTERN_NODE));
+      if (!node) return -1;
+      pattern->node = node;
+    }
+  node = &pattern->node[pattern->nnodes];
+  node->type = type;
+  node->left = left;
+  node->right = right;
+  node->arg = arg;
+  return pattern->nnodes++;
+}
+
+static PATTERN_SET *new_set(PARSER *parser)
+     /*
+      * Allocate new empty character set.
+      * Returns pointer to it or NULL when memory allocation fails.
+      * The set number is the last one in the pattern sets array.
+      */
+{
+  PATTERN *pattern = parser->pattern;
+  PATTERN_SET *set;
+
+  if (!(pattern->nsets & 15))
+    {
+      set = realloc(pattern->set, (pattern->nsets + 16) * sizeof(PATTERN_SET));
+      if (!set) return NULL;
+      pattern->set = set;
+    }
+  set = &pattern->set[pattern->nsets++];
+  (void)memset(set, 0, sizeof(PATTERN_SET));
+  return set;
+}
+
+static void set_add(PATTERN_SET *set, unsigned char c)
+     /*
+      * Add character to the set along with its folded form.
+      */
+{
+  set->bits[c >> 3] |= 1 << (c & 7);
+  c = pattern_fold[c];
+  set->bits[c >> 3] |= 1 << (c & 7);
+  return;
+}
+
+static int parse_alternation(PARSER *parser);
+
+static int parse_bracket(PARSER *parser)
+     /*
+      * Parse bracket expression. The opening bracket
+      * is already consumed.
+      */
+{
+  PATTERN_SET *set = new_set(parser);
+  const char *start;
+  int i, negate = 0;
+
+  if (!set) return -1;
+  if (*parser->p == '^')
+    {
+      negate = 1;
+      parser->p++;
+    }
+  start = parser->p;
+  if (*parser->p == ']') /* Leading bracket is a literal */
+    set_add(set, *parser->p++);
+  while (*parser->p != ']')
+    {
+      switch (*parser->p)
+        {
+          case 0: /* Unterminated expression */
+            return -1;
+          case '[': /* Character classes and collating elements */
+            if ((parser->p[1] == ':') || (parser->p[1] == '=') ||
+                (parser->p[1] == '.'))
+              return -1;
+            break;
+          case '-': /* Ranges depend on the collation order */
+            if ((parser->p != start) && (parser->p[1] != ']'))
+              return -1;
+            break;
+          default:
+            break;
+        }
+      set_add(set, *parser->p++);
+    }
+  parser->p++;
+  if (negate)
+    for (i = 0; i < 32; i++)
+      set->bits[i] = ~set->bits[i];
+  set->bits[0] &= ~1; /* String terminator never matches */
+  return new_node(parser, PAT_SET, -1, -1, parser->pattern->nsets - 1);
+}
+
+static int parse_atom(PARSER *parser)
+     /*
+      * Parse a single atom: literal, any character, bracket expression,
+      * anchor or parenthesized subexpression.
+      */
+{
+  PATTERN_SET *set;
+  int i, n;
+
+  switch (*parser->p)
+    {
+      case '(':
+        if (++parser->depth > MAX_DEPTH)
+          return -1;
+        parser->p++;
+        n = ++parser->pattern->ngroups;
+        i = parse_alternation(parser);
+        if ((i < 0) || (*parser->p != ')'))
+          return -1;
+        parser->p++;
+        parser->depth--;
+        return new_node(parser, PAT_GROUP, i, -1, n);
+      case '[':
+        parser->p++;
+        return parse_bracket(parser);
+      case '^':
+        parser->p++;
+        return new_node(parser, PAT_BOL, -1, -1, 0);
+      case '$':
+        parser->p++;
+        return new_node(parser, PAT_EOL, -1, -1, 0);
+      case '.':
+        parser->p++;
+        set = new_set(parser);
+        if (!set) return -1;
+        (void)memset(set->bits, 0xff, sizeof(set->bits));
+        set->bits[0] &= ~1;
+        return new_node(parser, PAT_SET, -1, -1, parser->pattern->nsets - 1);
+      case '\\':
+        parser->p++;
+        /* Only escaped punctuation is treated as a literal */
+        if ((!*parser->p) || (*parser->p & 0x80) ||
+            ((*parser->p >= '0') && (*parser->p <= '9')) ||
+            ((*parser->p >= 'A') && (*parser->p <= 'Z')) ||
+            ((*parser->p >= 'a') && (*parser->p <= 'z')))
+          return -1;
+        break;
+      case 0:
+      case ')':
+      case '|':
+      case '*':
+      case '+':
+      case '?':
+      case '{':
+        return -1;
+      default:
+        break;
+    }
+  set = new_set(parser);
+  if (!set) return -1;
+  set_add(set, *parser->p++);
+  return new_node(parser, PAT_SET, -1, -1, parser->pattern->nsets - 1);
+}
+
+static int parse_repetition(PARSER *parser)
+     /*
+      * Parse an atom with optional repetition operators.
+      */
+{
+  int i = parse_atom(parser);
+
+  while (i >= 0)
+    switch (*parser->p)
+      {
+        case '*':
+          parser->p++;
+          i = new_node(parser, PAT_STAR, i, -1, 0);
+          break;
+        case '+':
+          parser->p++;
+          i = new_node(parser, PAT_PLUS, i, -1, 0);
+          break;
+        case '?':
+          parser->p++;
+          i = new_node(parser, PAT_QUEST, i, -1, 0);
+          break;
+        case '{': /* Intervals are not supported */
+          return -1;
+        default:
+          return i;
+      }
+  return i;
+}
+
+static int parse_concatenation(PARSER *parser)
+     /*
+      * Parse a sequence of atoms. An empty sequence is allowed.
+      */
+{
+  int i, n = -1;
+
+  while (*parser->p && (*parser->p != '|') && (*parser->p != ')'))
+    {
+      i = parse_repetition(parser);
+      if (i < 0) return -1;
+      if (n < 0) n = i;
+      else
+        {
+          n = new_node(parser, PAT_CAT, n, i, 0);
+          if (n < 0) return -1;
+        }
+    }
+  if (n < 0)
+    n = new_node(parser, PAT_EMPTY, -1, -1, 0);
+  return n;
+}
+
+static int parse_alternation(PARSER *parser)
+     /*
+      * Parse the list of alternatives.
+      */
+{
+  int i, n = parse_concatenation(parser);
+
+  while ((n >= 0) && (*parser->p == '|'))
+    {
+      parser->p++;
+      i = parse_concatenation(parser);
+      if (i < 0) return -1;
+      n = new_node(parser, PAT_ALT, n, i, 0);
+    }
+  return n;
+}
+
+
+/* Externally visible routines */
+
+PATTERN *pattern_parse(const char *src)
+     /*
+      * This routine parses regular expression pointed by src
+      * and returns pointer to the newly allocated syntax tree
+      * or NULL if the expression contains unsupported constructions
+      * or memory allocation fails.
+      */
+{
+  PARSER parser;
+
+  parser.pattern = calloc(1, sizeof(PATTERN));
+  if (!parser.pattern)
+    return NULL;
+  parser.p = src;
+  parser.depth = 0;
+  parser.pattern->root = parse_alternation(&parser);
+  if ((parser.pattern->root < 0) || *parser.p)
+    {
+      pattern_free(parser.pattern);
+      return NULL;
+    }
+  return parser.pattern;
+}
+
+void pattern_free(PATTERN *pattern)
+     /*
+      * Free all memory allocated for the parsed pattern.
+      */
+{
+  if (!pattern) return;
+  free(pattern->node);
+  free(pattern->set);
+  free(pattern);
+  return;
+}
@@ -0,0 +1,111 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Rule patterns analysis routines.
+ *
+ * These routines parse the regular expressions used in the rulesets
+ * into the syntax tree suitable for building specialized matchers.
+ * Only the subset of POSIX extended regular expressions that is
+ * actually used in the rules is supported: literal characters,
+ * bracket expressions without ranges and character classes,
+ * any character, anchors, grouping, alternation and the "*", "+"
+ * and "?" repetition operators. All character sets are folded
+ * to the lower case according to the koi8-r charset, so the input
+ * must be folded by the pattern_fold[] table when matching.
+ */
+
+
+#ifndef PATTERN_H
+#define PATTERN_H
+
+/* BEGIN_C_DECLS should be used at the beginning of C declarations,
+   so that C++ compilers don't mangle their names.  Use END_C_DECLS at
+   the end of C declarations. */
+#undef BEGIN_C_DECLS
+#undef END_C_DECLS
+#ifdef __cplusplus
+# define BEGIN_C_DECLS extern "C" {
+# define END_C_DECLS }
+#else
+# define BEGIN_C_DECLS /* empty */
+# define END_C_DECLS /* empty */
+#endif
+
+BEGIN_C_DECLS
+
+/* Syntax tree node types */
+#define PAT_EMPTY 0 /* Empty string */
+#define PAT_SET 1 /* Single character from the set */
+#define PAT_BOL 2 /* Beginning of line anchor */
+#define PAT_EOL 3 /* End of line anchor */
+#define PAT_CAT 4 /* Concatenation of left and right */
+#define PAT_ALT 5 /* Alternation of left and right */
+#define PAT_STAR 6 /* Zero or more repetitions of left */
+#define PAT_PLUS 7 /* One or more repetitions of left */
+#define PAT_QUEST 8 /* Optional left */
+#define PAT_GROUP 9 /* Parenthesized subexpression left */
+
+/* Check whether the set contains specified (folded) character */
+#define pattern_set_has(set, c) \
+  ((set)->bits[(unsigned char)(c) >> 3] & (1 << ((unsigned char)(c) & 7)))
+
+typedef struct /* Character set */
+{
+  unsigned char bits[32];
+} PATTERN_SET;
+
+typedef struct /* Syntax tree node */
+{
+  int type; /* Node type */
+  int left; /* Left (or the only) operand node */
+  int right; /* Right operand node */
+  int arg; /* Character set for PAT_SET or group number for PAT_GROUP */
+} PATTERN_NODE;
+
+typedef struct /* Parsed pattern */
+{
+  PATTERN_NODE *node; /* Array of the syntax tree nodes */
+  int nnodes; /* Number of nodes */
+  PATTERN_SET *set; /* Array of character sets */
+  int nsets; /* Number of character sets */
+  int root; /* The syntax tree root node */
+  int ngroups; /* Number of parenthesized subexpressions */
+} PATTERN;
+
+
+/* Case folding table (koi8-r) */
+extern const unsigned char pattern_fold[256];
+
+extern PATTERN *pattern_parse(const char *src);
+/*
+ * This routine parses regular expression pointed by src
+ * and returns pointer to the newly allocated syntax tree
+ * or NULL if the expression contains unsupported constructions
+ * or memory allocation fails.
+ */
+
+extern void pattern_free(PATTERN *pattern);
+/*
+ * Free all memory allocated for the parsed pattern.
+ */
+
+END_C_DECLS
+
+#endif
@@ -0,0 +1,401 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Prefix rules matching by the trie implementation.
+ *
+ * The pattern syntax tree is expanded into the list of all strings
+ * it can match. Character sets are expanded into the folded
+ * characters only, since the input is folded when walking the trie.
+ * Patterns containing repetitions, end anchors or the beginning
+ * anchors anywhere except at the very beginning, as well as
+ * the patterns producing too many or too long strings, are not
+ * expanded.
+ *
+ * Since the matched prefix must start at the beginning of the word,
+ * the patterns not anchored at the beginning are treated the same way.
+ * The leftmost-longest match starting there is represented
+ * by the deepest trie node on the word path that accepts the rule.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "prefix.h"
+
+
+/* Local constants */
+
+/* Maximum length of the indexed strings */
+#define PREFIX_DEPTH 32
+
+/* Maximum number of strings per subexpression */
+#define PREFIX_MAX_STRINGS 256
+
+
+/* Data structures */
+
+typedef struct /* Literal string */
+{
+  unsigned char c[PREFIX_DEPTH]; /* Characters */
+  int len; /* Number of characters */
+} STRING;
+
+typedef struct /* Trie node */
+{
+  int child; /* The first child node or 0 if none */
+  int sibling; /* The next sibling node or 0 if none */
+  int c; /* The character leading to this node */
+  int *rules; /* Ascending list of the rules accepting here */
+  int nrules; /* Number of rules in the list */
+} NODE;
+
+struct RULEX_PREFIX
+{
+  NODE *node; /* Trie nodes (the first one is the root) */
+  int nnodes; /* Number of nodes */
+  int *any; /* Ascending list of the rules to be tried for every word */
+  int nany; /* Number of rules in this list */
+  int size; /* Number of rules in the ruleset */
+  PREFIX_MATCH *list; /* Search result buffer */
+  const RULEX_PREFIX *origin; /* Trie sharing its nodes with this one */
+};
+
+
+/* Local routines */
+
+static int string_add(STRING *t, int n, int max, const STRING *x)
+     /*
+      * Add string x to the list t of n items if it is not there yet.
+      * Returns new number of items or -1 if the list overflows.
+      */
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    if ((t[i].len == x->len) && !memcmp(t[i].c, x->c, x->len))
+      return n;
+  if (n >= max)
+    return -1;
+  t[n] = *x;
+  return n + 1;
+}
+
+static int strings(const PATTERN *pattern, int node, int start,
+                   STRING *t, int max)
+     /*
+      * Collect all strings matched by the subtree into the array t
+      * of max items. The start flag tells whether the subtree
+      * is matched at the beginning of the string only.
+      *
+      * Returns the number of strings or -1 if the subtree
+      * cannot be expanded or memory allocation fails.
+      */
+{
+  const PATTERN_NODE *p = &pattern->node[node];
+  STRING x, *l, *r;
+  int i, j, n = 0, nl, nr;
+
+  (void)memset(&x, 0, sizeof(STRING));
+  switch (p->type)
+    {
+      case PAT_EMPTY:
+        break;
+      case PAT_SET:
+        x.len = 1;
+        for (i = 1; i < 256; i++)
+          if ((pattern_fold[i] == i) &&
+              pattern_set_has(&pattern->set[p->arg], i))
+            {
+              x.c[0] = i;
+              n = string_add(t, n, max, &x);
+              if (n < 0) break;
+            }
+        return n;
+      case PAT_BOL:
+        if (!start) return -1;
+        break;
+      case PAT_CAT:
+        l = malloc(2 * PREFIX_MAX_STRINGS * sizeof(STRING));
+        if (!l) return -1;
+        r = l + PREFIX_MAX_STRINGS;
+        nl = strings(pattern, p->left, start, l, PREFIX_MAX_STRINGS);
+        nr = (nl < 0) ? -1 :
+          strings(pattern, p->right, start && (nl == 1) && !l[0].len,
+                  r, PREFIX_MAX_STRINGS);
+        n = (nr < 0) ? -1 : 0;
+        for (i = 0; (i < nl) && (n >= 0); i++)
+          for (j = 0; j < nr; j++)
+            {
+              if (l[i].len + r[j].len > PREFIX_DEPTH)
+                {
+                  n = -1;
+                  break;
+                }
+              x = l[i];
+              (void)memcpy(x.c + x.len, r[j].c, r[j].len);
+              x.len += r[j].len;
+              n = string_add(t, n, max, &x);
+              if (n < 0) break;
+            }
+        free(l);
+        return n;
+      case PAT_ALT:
+        nl = strings(pattern, p->left, start, t, max);
+        if (nl < 0) return -1;
+        r = malloc(PREFIX_MAX_STRINGS * sizeof(STRING));
+        if (!r) return -1;
+        nr = strings(pattern, p->right, start, r, PREFIX_MAX_STRINGS);
+        n = (nr < 0) ? -1 : nl;
+        for (i = 0; i < nr; i++)
+          {
+            n = string_add(t, n, max, &r[i]);
+            if (n < 0) break;
+          }
+        free(r);
+        return n;
+      case PAT_QUEST:
+        n = strings(pattern, p->left, start, t, max);
+        if (n < 0) return -1;
+        break;
+      case PAT_GROUP:
+        return strings(pattern, p->left, start, t, max);
+      default: /* Repetitions and the end anchor */
+        return -1;
+    }
+  return string_add(t, n, max, &x);
+}
+
+static int node_add(RULEX_PREFIX *index, int parent, int c)
+     /*
+      * Find the child node of parent for character c.
+      * Create it if it does not exist yet.
+      * Returns the node number or -1 when memory allocation fails.
+      */
+{
+  NODE *node;
+  int i;
+
+  for (i = index->node[parent].child; i; i = index->node[i].sibling)
+    if (index->node[i].c == c)
+      return i;
+  if (!(index->nnodes & 63))
+    {
+      node = realloc(index->node, (index->nnodes + 64) * sizeof(NODE));
+      if (!node) return -1;
+      index->node = node;
+    }
+  node = &index->node[index->nnodes];
+  (void)memset(node, 0, sizeof(NODE));
+  node->c = c;
+  node->sibling = index->node[parent].child;
+  index->node[parent].child = index->nnodes;
+  return index->nnodes++;
+}
+
+static int rule_add(int **rules, int *nrules, int n)
+     /*
+      * Append rule number n to the list.
+      * Returns 0 on success or -1 when memory allocation fails.
+      */
+{
+  int *list;
+
+  if (*nrules && ((*rules)[*nrules - 1] == n))
+    return 0;
+  if (!(*nrules & 7))
+    {
+      list = realloc(*rules, (*nrules + 8) * sizeof(int));
+      if (!list) return -1;
+      *rules = list;
+    }
+  (*rules)[(*nrules)++] = n;
+  return 0;
+}
+
+
+/* Global routines */
+
+RULEX_PREFIX *prefix_create(int nrules)
+     /*
+      * Allocate new empty trie for the ruleset of nrules rules.
+      * Returns NULL when memory allocation fails.
+      */
+{
+  RULEX_PREFIX *index = calloc(1, sizeof(RULEX_PREFIX));
+
+  if (!index)
+    return NULL;
+  index->size = nrules;
+  index->list = malloc((nrules + 1) * sizeof(PREFIX_MATCH));
+  index->node = calloc(64, sizeof(NODE));
+  if (!index->list || !index->node)
+    {
+      prefix_free(index);
+      return NULL;
+    }
+  index->nnodes = 1;
+  return index;
+}
+
+RULEX_PREFIX *prefix_clone(const RULEX_PREFIX *index)
+     /*
+      * Create new trie sharing the nodes with specified one.
+      * Returns NULL when memory allocation fails.
+      */
+{
+  RULEX_PREFIX *clone = malloc(sizeof(RULEX_PREFIX));
+
+  if (!clone)
+    return NULL;
+  *clone = *index;
+  clone->list = malloc((index->size + 1) * sizeof(PREFIX_MATCH));
+  if (!clone->list)
+    {
+      free(clone);
+      return NULL;
+    }
+  clone->origin = index;
+  return clone;
+}
+
+int prefix_add(RULEX_PREFIX *index, const PATTERN *pattern, int n)
+     /*
+      * Add parsed pattern to the trie as rule number n.
+      * Rules must be added in ascending order. If pattern is NULL
+      * or cannot be expanded, the rule will be tried
+      * for every word.
+      *
+      * Returns 0 on success or -1 when memory allocation fails.
+      */
+{
+  STRING *t;
+  NODE *node;
+  int i, j, k = 0, nt = -1;
+
+  if ((n < 0) || (n >= index->size) || index->origin)
+    return -1;
+  t = malloc(PREFIX_MAX_STRINGS * sizeof(STRING));
+  if (!t)
+    return -1;
+  if (pattern)
+    nt = strings(pattern, pattern->root, 1, t, PREFIX_MAX_STRINGS);
+  if (nt < 0)
+    {
+      free(t);
+      return rule_add(&index->any, &index->nany, n);
+    }
+  for (i = 0; i < nt; i++)
+    {
+      for (j = k = 0; j < t[i].len; j++)
+        {
+          k = node_add(index, k, t[i].c[j]);
+          if (k < 0) break;
+        }
+      if (k < 0) break;
+      node = &index->node[k];
+      if (rule_add(&node->rules, &node->nrules, n))
+        {
+          k = -1;
+          break;
+        }
+    }
+  free(t);
+  return (k < 0) ? -1 : 0;
+}
+
+int prefix_search(RULEX_PREFIX *index, const char *s,
+                  const PREFIX_MATCH **matches)
+     /*
+      * Find all rules that can match the beginning of the string s.
+      * The pointer to the list of candidates ascending by the rule
+      * numbers is placed in the location pointed by matches.
+      * For the rules found in the trie the length of the longest
+      * matched prefix is specified. The rules to be tried otherwise
+      * have PREFIX_UNKNOWN length. This list is valid until next search.
+      *
+      * Returns the number of candidates in the list.
+      */
+{
+  const NODE *path[PREFIX_DEPTH + 1];
+  int pos[PREFIX_DEPTH + 2];
+  int i, k, c, n = 0, depth = 0, best, len;
+
+  path[depth++] = &index->node[0];
+  for (k = 0; *s && (depth <= PREFIX_DEPTH); depth++)
+    {
+      c = pattern_fold[(unsigned char)*s++];
+      for (k = index->node[k].child; k; k = index->node[k].sibling)
+        if (index->node[k].c == c)
+          break;
+      if (!k) break;
+      path[depth] = &index->node[k];
+    }
+
+  /*
+   * Merge the rule lists of the nodes along the path
+   * and the list of the rules to be tried for every word.
+   * The deepest node accepting a rule gives the match length.
+   */
+  (void)memset(pos, 0, sizeof(pos));
+  for (;;)
+    {
+      best = -1;
+      for (i = 0; i < depth; i++)
+        if ((pos[i] < path[i]->nrules) &&
+            ((best < 0) || (path[i]->rules[pos[i]] < best)))
+          best = path[i]->rules[pos[i]];
+      if ((pos[depth] < index->nany) &&
+          ((best < 0) || (index->any[pos[depth]] < best)))
+        best = index->any[pos[depth]];
+      if (best < 0) break;
+      len = PREFIX_UNKNOWN;
+      for (i = 0; i < depth; i++)
+        if ((pos[i] < path[i]->nrules) && (path[i]->rules[pos[i]] == best))
+          {
+            len = i;
+            pos[i]++;
+          }
+      if ((pos[depth] < index->nany) && (index->any[pos[depth]] == best))
+        pos[depth]++;
+      index->list[n].rule = best;
+      index->list[n++].len = len;
+    }
+  *matches = index->list;
+  return n;
+}
+
+void prefix_free(RULEX_PREFIX *index)
+     /*
+      * Free all memory allocated for the trie.
+      */
+{
+  int i;
+
+  if (!index) return;
+  if (!index->origin)
+    {
+      for (i = 0; i < index->nnodes; i++)
+        free(index->node[i].rules);
+      free(index->node);
+      free(index->any);
+    }
+  free(index->list);
+  free(index);
+}
@@ -0,0 +1,112 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Prefix rules matching by the trie.
+ *
+ * Prefix rules match the beginning of the word and most of them
+ * can match only a limited set of strings. All these strings
+ * are gathered into the trie, so the prefixes present at the beginning
+ * of a particular word along with the rules matching them are found
+ * by a single walk from the start of the word. The rules which patterns
+ * cannot be expanded this way are left for the regular expressions
+ * matching.
+ */
+
+
+#ifndef PREFIX_H
+#define PREFIX_H
+
+#include "pattern.h"
+
+/* BEGIN_C_DECLS should be used at the beginning of C declarations,
+   so that C++ compilers don't mangle their names.  Use END_C_DECLS at
+   the end of C declarations. */
+#undef BEGIN_C_DECLS
+#undef END_C_DECLS
+#ifdef __cplusplus
+# define BEGIN_C_DECLS extern "C" {
+# define END_C_DECLS }
+#else
+# define BEGIN_C_DECLS /* empty */
+# define END_C_DECLS /* empty */
+#endif
+
+BEGIN_C_DECLS
+
+/* Unknown match length marker */
+#define PREFIX_UNKNOWN -1
+
+typedef struct RULEX_PREFIX RULEX_PREFIX;
+
+typedef struct /* Prefix rule candidate */
+{
+  int rule; /* Rule number */
+  int len; /* Length of the matched prefix or PREFIX_UNKNOWN */
+} PREFIX_MATCH;
+
+
+extern RULEX_PREFIX *prefix_create(int nrules);
+/*
+ * Allocate new empty trie for the ruleset of nrules rules.
+ * Returns NULL when memory allocation fails.
+ */
+
+extern RULEX_PREFIX *prefix_clone(const RULEX_PREFIX *index);
+/*
+ * Create new trie sharing the nodes with specified one,
+ * but having its own search result buffer, so both
+ * can be searched in parallel threads. No rules can be added
+ * to the clone. The original trie must not be modified
+ * or freed while the clone is in use.
+ *
+ * Returns NULL when memory allocation fails.
+ */
+
+extern int prefix_add(RULEX_PREFIX *index, const PATTERN *pattern, int n);
+/*
+ * Add parsed pattern to the trie as rule number n.
+ * Rules must be added in ascending order. If pattern is NULL
+ * or cannot be expanded, the rule will be tried
+ * for every word.
+ *
+ * Returns 0 on success or -1 when memory allocation fails.
+ */
+
+extern int prefix_search(RULEX_PREFIX *index, const char *s,
+                         const PREFIX_MATCH **matches);
+/*
+ * Find all rules that can match the beginning of the string s.
+ * The pointer to the list of candidates ascending by the rule
+ * numbers is placed in the location pointed by matches.
+ * For the rules found in the trie the length of the longest
+ * matched prefix is specified. The rules to be tried otherwise
+ * have PREFIX_UNKNOWN length. This list is valid until next search.
+ *
+ * Returns the number of candidates in the list.
+ */
+
+extern void prefix_free(RULEX_PREFIX *index);
+/*
+ * Free all memory allocated for the trie.
+ */
+
+END_C_DECLS
+
+#endif
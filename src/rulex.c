@@ -116,9 +116,10 @@ int main(int argc, char **argv)
       s = text + strlen(text) - 1;
       if (*s == '\n')
 	{
-          char *stressed = xmalloc(strlen(text) << 1);
-          char *t;
-          unsigned int n;
+          unsigned int n, room = strlen(text) << 1;
+          char *stressed = xmalloc(room);
+          char *t, key[RULEXDB_MAX_KEY_SIZE + 1];
+          int rc;
           for (s = text; *s; s++)
             if (isupper(*s))
               *s = tolower(*s);
@@ -136,13 +137,13 @@ int main(int argc, char **argv)
                 {
                   if ((n <= RULEXDB_MAX_KEY_SIZE) && (n <= strspn(s, alphabet)))
                     {
-                      char *key = xmalloc(RULEXDB_BUFSIZE);
                       strncpy(key, s, n);
                       key[n] = 0;
-                      if (rulexdb_search(db, key, t, 0)
-                          == RULEXDB_SPECIAL)
+                      if (rulexdb_search_ex(db, key, t, stressed + room - t,
+                                            &rc, 0) < 0)
+                        strcpy(t, key);
+                      else if (rc == RULEXDB_SPECIAL)
                         if (slog) (void)fprintf(slog, "%s\n", key);
-                      free(key);
                     }
                   else
                     {
@@ -0,0 +1,416 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Rules dispatching by the word endings implementation.
+ *
+ * The tails are extracted from the pattern syntax tree from right
+ * to left. Every tail is a reversed string of the characters
+ * the matched text must end with. When some subexpression can match
+ * only a bounded number of strings, the tails are extended by
+ * the preceding subexpression. If too many tails emerge, the analysis
+ * is repeated with the shorter tails limit.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "suffix.h"
+
+
+/* Local constants */
+
+/* Maximum length of the indexed tails */
+#define SUFFIX_DEPTH 4
+
+/* Maximum number of tails per subexpression */
+#define SUFFIX_MAX_TAILS 256
+
+
+/* Data structures */
+
+typedef struct /* Reversed literal tail */
+{
+  unsigned char c[SUFFIX_DEPTH]; /* Characters from the end */
+  int len; /* Number of characters */
+  int open; /* Unknown characters may precede the tail */
+} TAIL;
+
+typedef struct /* Trie node */
+{
+  int child; /* The first child node or 0 if none */
+  int sibling; /* The next sibling node or 0 if none */
+  int c; /* The character leading to this node */
+  int *rules; /* Ascending list of the rules having this tail */
+  int nrules; /* Number of rules in the list */
+} NODE;
+
+struct RULEX_SUFFIX
+{
+  NODE *node; /* Trie nodes (the first one is the root) */
+  int nnodes; /* Number of nodes */
+  int size; /* Number of rules in the ruleset */
+  int *list; /* Search result buffer */
+  const RULEX_SUFFIX *origin; /* Index sharing its trie with this one */
+};
+
+
+/* Local routines */
+
+static int tail_add(TAIL *t, int n, int max, const TAIL *x)
+     /*
+      * Add tail x to the list t of n items if it is not there yet.
+      * Returns new number of items or -1 if the list overflows.
+      */
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    if ((t[i].len == x->len) && !memcmp(t[i].c, x->c, x->len))
+      {
+        t[i].open |= x->open;
+        return n;
+      }
+  if (n >= max)
+    return -1;
+  t[n] = *x;
+  return n + 1;
+}
+
+static int anchored(const PATTERN *pattern, int node)
+     /*
+      * Check whether every match of the subtree ends
+      * at the end of the string.
+      */
+{
+  const PATTERN_NODE *p = &pattern->node[node];
+
+  switch (p->type)
+    {
+      case PAT_EOL:
+        return 1;
+      case PAT_CAT:
+        return anchored(pattern, p->right);
+      case PAT_ALT:
+        return anchored(pattern, p->left) && anchored(pattern, p->right);
+      case PAT_PLUS:
+      case PAT_GROUP:
+        return anchored(pattern, p->left);
+      default:
+        break;
+    }
+  return 0;
+}
+
+static int tails(const PATTERN *pattern, int node, int depth,
+                 TAIL *t, int max)
+     /*
+      * Collect the tails of the subtree not longer than depth
+      * into the array t of max items. Returns the number of tails
+      * or -1 if there are too many of them or memory allocation fails.
+      */
+{
+  const PATTERN_NODE *p = &pattern->node[node];
+  TAIL x, *l, *r;
+  int i, j, k, n = 0, nl, nr;
+
+  (void)memset(&x, 0, sizeof(TAIL));
+  switch (p->type)
+    {
+      case PAT_SET:
+        x.len = 1;
+        for (i = 1; i < 256; i++)
+          if (pattern_set_has(&pattern->set[p->arg], i))
+            {
+              x.c[0] = i;
+              n = tail_add(t, n, max, &x);
+              if (n < 0) break;
+            }
+        return n;
+      case PAT_CAT:
+        r = malloc(2 * SUFFIX_MAX_TAILS * sizeof(TAIL));
+        if (!r) return -1;
+        l = r + SUFFIX_MAX_TAILS;
+        nr = tails(pattern, p->right, depth, r, SUFFIX_MAX_TAILS);
+        nl = 0;
+        for (i = 0; i < nr; i++)
+          if (!r[i].open && (r[i].len < depth))
+            break;
+        if (i < nr)
+          nl = tails(pattern, p->left, depth, l, SUFFIX_MAX_TAILS);
+        if (nl < 0) nr = -1;
+        for (i = 0; i < nr; i++)
+          if (r[i].open || (r[i].len >= depth))
+            {
+              n = tail_add(t, n, max, &r[i]);
+              if (n < 0) break;
+            }
+          else
+            {
+              for (j = 0; j < nl; j++)
+                {
+                  x = r[i];
+                  for (k = 0; (k < l[j].len) && (x.len < depth); k++)
+                    x.c[x.len++] = l[j].c[k];
+                  x.open = l[j].open || (k < l[j].len);
+                  n = tail_add(t, n, max, &x);
+                  if (n < 0) break;
+                }
+              if (n < 0) break;
+            }
+        free(r);
+        return (nr < 0) ? -1 : n;
+      case PAT_ALT:
+        nl = tails(pattern, p->left, depth, t, max);
+        if (nl < 0) return -1;
+        r = malloc(SUFFIX_MAX_TAILS * sizeof(TAIL));
+        if (!r) return -1;
+        nr = tails(pattern, p->right, depth, r, SUFFIX_MAX_TAILS);
+        n = (nr < 0) ? -1 : nl;
+        for (i = 0; i < nr; i++)
+          {
+            n = tail_add(t, n, max, &r[i]);
+            if (n < 0) break;
+          }
+        free(r);
+        return n;
+      case PAT_STAR:
+      case PAT_PLUS:
+      case PAT_QUEST:
+        n = tails(pattern, p->left, depth, t, max);
+        if (n < 0) return -1;
+        if (p->type != PAT_QUEST) /* Repetitions may precede */
+          for (i = 0; i < n; i++)
+            t[i].open = 1;
+        if (p->type != PAT_PLUS) /* May match the empty string */
+          n = tail_add(t, n, max, &x);
+        return n;
+      case PAT_GROUP:
+        return tails(pattern, p->left, depth, t, max);
+      default: /* Empty string or anchor */
+        break;
+    }
+  return tail_add(t, n, max, &x);
+}
+
+static int node_add(RULEX_SUFFIX *index, int parent, int c)
+     /*
+      * Find the child node of parent for character c.
+      * Create it if it does not exist yet.
+      * Returns the node number or -1 when memory allocation fails.
+      */
+{
+  NODE *node;
+  int i;
+
+  for (i = index->node[parent].child; i; i = index->node[i].sibling)
+    if (index->node[i].c == c)
+      return i;
+  if (!(index->nnodes & 63))
+    {
+      node = realloc(index->node, (index->nnodes + 64) * sizeof(NODE));
+      if (!node) return -1;
+      index->node = node;
+    }
+  node = &index->node[index->nnodes];
+  (void)memset(node, 0, sizeof(NODE));
+  node->c = c;
+  node->sibling = index->node[parent].child;
+  index->node[parent].child = index->nnodes;
+  return index->nnodes++;
+}
+
+static int rule_add(NODE *node, int n)
+     /*
+      * Append rule number n to the node list.
+      * Returns 0 on success or -1 when memory allocation fails.
+      */
+{
+  int *rules;
+
+  if (node->nrules && (node->rules[node->nrules - 1] == n))
+    return 0;
+  if (!(node->nrules & 7))
+    {
+      rules = realloc(node->rules, (node->nrules + 8) * sizeof(int));
+      if (!rules) return -1;
+      node->rules = rules;
+    }
+  node->rules[node->nrules++] = n;
+  return 0;
+}
+
+
+/* Global routines */
+
+RULEX_SUFFIX *suffix_create(int nrules)
+     /*
+      * Allocate new empty index for the ruleset of nrules rules.
+      * Returns NULL when memory allocation fails.
+      */
+{
+  RULEX_SUFFIX *index = calloc(1, sizeof(RULEX_SUFFIX));
+
+  if (!index)
+    return NULL;
+  index->size = nrules;
+  index->list = malloc((nrules + 1) * sizeof(int));
+  index->node = calloc(64, sizeof(NODE));
+  if (!index->list || !index->node)
+    {
+      suffix_free(index);
+      return NULL;
+    }
+  index->nnodes = 1;
+  return index;
+}
+
+RULEX_SUFFIX *suffix_clone(const RULEX_SUFFIX *index)
+     /*
+      * Create new index sharing the trie with specified one.
+      * Returns NULL when memory allocation fails.
+      */
+{
+  RULEX_SUFFIX *clone = malloc(sizeof(RULEX_SUFFIX));
+
+  if (!clone)
+    return NULL;
+  *clone = *index;
+  clone->list = malloc((index->size + 1) * sizeof(int));
+  if (!clone->list)
+    {
+      free(clone);
+      return NULL;
+    }
+  clone->origin = index;
+  return clone;
+}
+
+int suffix_add(RULEX_SUFFIX *index, const PATTERN *pattern, int n)
+     /*
+      * Add parsed pattern to the index as rule number n.
+      * Rules must be added in ascending order. If pattern is NULL
+      * or its tail cannot be analysed, the rule will be tried
+      * for every word.
+      *
+      * Returns 0 on success or -1 when memory allocation fails.
+      */
+{
+  TAIL *t;
+  int i, j, k, nt = -1, depth;
+
+  if ((n < 0) || (n >= index->size) || index->origin)
+    return -1;
+  if (!pattern || !anchored(pattern, pattern->root))
+    return rule_add(&index->node[0], n);
+  t = malloc(SUFFIX_MAX_TAILS * sizeof(TAIL));
+  if (!t)
+    return -1;
+  for (depth = SUFFIX_DEPTH; depth > 0; depth--)
+    {
+      nt = tails(pattern, pattern->root, depth, t, SUFFIX_MAX_TAILS);
+      if (nt >= 0) break;
+    }
+  for (i = 0; i < nt; i++)
+    if (!t[i].len) /* Matches any word */
+      break;
+  if ((nt < 0) || (i < nt))
+    {
+      free(t);
+      return rule_add(&index->node[0], n);
+    }
+  for (i = 0; i < nt; i++)
+    {
+      for (j = k = 0; j < t[i].len; j++)
+        {
+          k = node_add(index, k, t[i].c[j]);
+          if (k < 0) break;
+        }
+      if ((k < 0) || rule_add(&index->node[k], n))
+        {
+          free(t);
+          return -1;
+        }
+    }
+  free(t);
+  return 0;
+}
+
+int suffix_search(RULEX_SUFFIX *index, const char *s, const int **rules)
+     /*
+      * Find all rules that can match the string s.
+      * The pointer to the ascending list of their numbers is placed
+      * in the location pointed by rules. This list is valid
+      * until next search.
+      *
+      * Returns the number of rules in the list.
+      */
+{
+  const NODE *path[SUFFIX_DEPTH + 1];
+  int pos[SUFFIX_DEPTH + 1];
+  const char *p = s + strlen(s);
+  int i, k, c, n = 0, depth = 0, best;
+
+  path[depth++] = &index->node[0];
+  for (k = 0; (p > s) && (depth <= SUFFIX_DEPTH); depth++)
+    {
+      c = pattern_fold[(unsigned char)*--p];
+      for (k = index->node[k].child; k; k = index->node[k].sibling)
+        if (index->node[k].c == c)
+          break;
+      if (!k) break;
+      path[depth] = &index->node[k];
+    }
+
+  /* Merge the rule lists of the nodes along the path */
+  (void)memset(pos, 0, sizeof(pos));
+  for (;;)
+    {
+      best = -1;
+      for (i = 0; i < depth; i++)
+        if ((pos[i] < path[i]->nrules) &&
+            ((best < 0) || (path[i]->rules[pos[i]] < best)))
+          best = path[i]->rules[pos[i]];
+      if (best < 0) break;
+      index->list[n++] = best;
+      for (i = 0; i < depth; i++)
+        if ((pos[i] < path[i]->nrules) && (path[i]->rules[pos[i]] == best))
+          pos[i]++;
+    }
+  *rules = index->list;
+  return n;
+}
+
+void suffix_free(RULEX_SUFFIX *index)
+     /*
+      * Free all memory allocated for the index.
+      */
+{
+  int i;
+
+  if (!index) return;
+  if (!index->origin)
+    {
+      for (i = 0; i < index->nnodes; i++)
+        free(index->node[i].rules);
+      free(index->node);
+    }
+  free(index->list);
+  free(index);
+}
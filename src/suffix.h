@@ -0,0 +1,100 @@
+/* This file is part of the rulexdb library.
+ *
+ * Copyright (C) 2006 Igor B. Poretsky <poretsky@mlbox.ru>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Rules dispatching by the word endings.
+ *
+ * Most of the rules are anchored at the end of the word and can match
+ * only a limited set of the word endings. The literal tails
+ * of such rules are gathered into the trie of reversed strings,
+ * so only the rules which tails are present at the end
+ * of a particular word are to be tried for it. The rules which tails
+ * cannot be analysed are tried for every word.
+ */
+
+
+#ifndef SUFFIX_H
+#define SUFFIX_H
+
+#include "pattern.h"
+
+/* BEGIN_C_DECLS should be used at the beginning of C declarations,
+   so that C++ compilers don't mangle their names.  Use END_C_DECLS at
+   the end of C declarations. */
+#undef BEGIN_C_DECLS
+#undef END_C_DECLS
+#ifdef __cplusplus
+# define BEGIN_C_DECLS extern "C" {
+# define END_C_DECLS }
+#else
+# define BEGIN_C_DECLS /* empty */
+# define END_C_DECLS /* empty */
+#endif
+
+BEGIN_C_DECLS
+
+typedef struct RULEX_SUFFIX RULEX_SUFFIX;
+
+
+extern RULEX_SUFFIX *suffix_create(int nrules);
+/*
+ * Allocate new empty index for the ruleset of nrules rules.
+ * Returns NULL when memory allocation fails.
+ */
+
+extern RULEX_SUFFIX *suffix_clone(const RULEX_SUFFIX *index);
+/*
+ * Create new index sharing the trie with specified one,
+ * but having its own search result buffer, so both
+ * can be searched in parallel threads. No rules can be added
+ * to the clone. The original index must not be modified
+ * or freed while the clone is in use.
+ *
+ * Returns NULL when memory allocation fails.
+ */
+
+extern int suffix_add(RULEX_SUFFIX *index, const PATTERN *pattern, int n);
+/*
+ * Add parsed pattern to the index as rule number n.
+ * Rules must be added in ascending order. If pattern is NULL
+ * or its tail cannot be analysed, the rule will be tried
+ * for every word.
+ *
+ * Returns 0 on success or -1 when memory allocation fails.
+ */
+
+extern int suffix_search(RULEX_SUFFIX *index, const char *s,
+                         const int **rules);
+/*
+ * Find all rules that can match the string s.
+ * The pointer to the ascending list of their numbers is placed
+ * in the location pointed by rules. This list is valid
+ * until next search.
+ *
+ * Returns the number of rules in the list.
+ */
+
+extern void suffix_free(RULEX_SUFFIX *index);
+/*
+ * Free all memory allocated for the index.
+ */
+
+END_C_DECLS
+
+#endif